@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2013 Hochschule fuer Technik Rapperswil
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.  See <http://www.fsf.org/copyleft/gpl.txt>.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include <library.h>
+#include <collections/linked_list.h>
+#include <collections/array.h>
+
+static void start_timing(struct timespec *start)
+{
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, start);
+}
+
+static double end_timing(struct timespec *start)
+{
+	struct timespec end;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &end);
+	return (end.tv_nsec - start->tv_nsec) / 1000000000.0 +
+			(end.tv_sec - start->tv_sec) * 1.0;
+}
+
+/**
+ * Element type stored in the collections, similar to proposal algorithms
+ */
+typedef struct {
+	u_int16_t alg;
+	u_int16_t size;
+} elem_t;
+
+/**
+ * Run a linked_list_t round with malloc()ed elements, return checksum
+ */
+static u_int run_list(int elems)
+{
+	linked_list_t *list;
+	enumerator_t *enumerator;
+	elem_t *elem;
+	u_int sum = 0;
+	int i;
+
+	list = linked_list_create();
+	for (i = 0; i < elems; i++)
+	{
+		INIT(elem,
+			.alg = i,
+			.size = 128,
+		);
+		list->insert_last(list, elem);
+	}
+	enumerator = list->create_enumerator(list);
+	while (enumerator->enumerate(enumerator, &elem))
+	{
+		sum += elem->alg + elem->size;
+	}
+	enumerator->destroy(enumerator);
+	list->destroy_function(list, free);
+	return sum;
+}
+
+/**
+ * Run an array_t round with elements stored by value, return checksum
+ */
+static u_int run_array(int elems)
+{
+	array_t *array;
+	elem_t elem;
+	u_int sum = 0;
+	int i;
+
+	array = array_create(sizeof(elem_t), 0);
+	for (i = 0; i < elems; i++)
+	{
+		elem.alg = i;
+		elem.size = 128;
+		array_insert(array, ARRAY_TAIL, &elem);
+	}
+	array_foreach(array, i, &elem)
+	{
+		sum += elem.alg + elem.size;
+	}
+	array_destroy(array);
+	return sum;
+}
+
+#define ROUNDS 100000
+
+int main(int argc, char *argv[])
+{
+	struct timespec timing;
+	int round, elems, sizes[] = { 1, 4, 8, 16, 64, 256 }, i;
+	u_int sum1 = 0, sum2 = 0;
+	double t1, t2;
+
+	library_init(NULL);
+	atexit(library_deinit);
+
+	for (i = 0; i < countof(sizes); i++)
+	{
+		elems = sizes[i];
+
+		start_timing(&timing);
+		for (round = 0; round < ROUNDS; round++)
+		{
+			sum1 += run_list(elems);
+		}
+		t1 = end_timing(&timing);
+
+		start_timing(&timing);
+		for (round = 0; round < ROUNDS; round++)
+		{
+			sum2 += run_array(elems);
+		}
+		t2 = end_timing(&timing);
+
+		printf("%3d elements, %d rounds: linked_list %.4fs, array %.4fs%s\n",
+			   elems, ROUNDS, t1, t2, sum1 == sum2 ? "" : " (MISMATCH)");
+	}
+	return 0;
+}
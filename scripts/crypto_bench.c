@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2013 Hochschule fuer Technik Rapperswil
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.  See <http://www.fsf.org/copyleft/gpl.txt>.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+
+#include <stdio.h>
+#include <library.h>
+#include <utils/debug.h>
+
+/**
+ * Run the crypto_tester benchmark for all algorithms registered by the
+ * loaded plugins. Each algorithm is verified against the test vectors and
+ * benchmarked with buffers of the given size; the tester logs the number of
+ * operations completed in the benchmark time as "points".
+ */
+int main(int argc, char *argv[])
+{
+	char *plugins = "test-vectors " PLUGINS;
+
+	library_init(NULL);
+	atexit(library_deinit);
+
+	if (argc > 1 && (streq(argv[1], "-h") || streq(argv[1], "--help")))
+	{
+		fprintf(stderr, "usage: %s [bench_size] [bench_time] [plugins]\n",
+				argv[0]);
+		return 1;
+	}
+	lib->settings->set_bool(lib->settings,
+							"libstrongswan.crypto_test.on_add", TRUE);
+	lib->settings->set_bool(lib->settings,
+							"libstrongswan.crypto_test.bench", TRUE);
+	if (argc > 1)
+	{
+		lib->settings->set_int(lib->settings,
+						"libstrongswan.crypto_test.bench_size", atoi(argv[1]));
+	}
+	if (argc > 2)
+	{
+		lib->settings->set_int(lib->settings,
+						"libstrongswan.crypto_test.bench_time", atoi(argv[2]));
+	}
+	if (argc > 3)
+	{
+		plugins = argv[3];
+	}
+
+	/* recreate the factory to apply the test settings, no plugins loaded */
+	lib->crypto->destroy(lib->crypto);
+	lib->crypto = crypto_factory_create();
+
+	dbg_default_set_level(1);
+	dbg_default_set_stream(stdout);
+	lib->plugins->load(lib->plugins, NULL, plugins);
+	printf("loaded: %s\n", lib->plugins->loaded_plugins(lib->plugins));
+	return 0;
+}
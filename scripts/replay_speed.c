@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2013 Hochschule fuer Technik Rapperswil
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.  See <http://www.fsf.org/copyleft/gpl.txt>.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include <limits.h>
+#include <library.h>
+#include <esp_context.h>
+
+static void start_timing(struct timespec *start)
+{
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, start);
+}
+
+static double end_timing(struct timespec *start)
+{
+	struct timespec end;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &end);
+	return (end.tv_nsec - start->tv_nsec) / 1000000000.0 +
+			(end.tv_sec - start->tv_sec) * 1.0;
+}
+
+/**
+ * Anti-replay window shifted bit by bit, as previously used by esp_context_t
+ */
+typedef struct {
+	u_int32_t last_seqno;
+	u_int seqno_index;
+	u_int window_size;
+	u_char *window;
+} bitwise_t;
+
+static inline void set_bit(bitwise_t *this, u_int index, bool set)
+{
+	if (set)
+	{
+		this->window[index / CHAR_BIT] |= 1 << (index % CHAR_BIT);
+	}
+	else
+	{
+		this->window[index / CHAR_BIT] &= ~(1 << (index % CHAR_BIT));
+	}
+}
+
+static bool bitwise_verify(bitwise_t *this, u_int32_t seqno)
+{
+	u_int offset;
+
+	if (seqno > this->last_seqno)
+	{
+		return TRUE;
+	}
+	if (seqno > 0 && this->window_size > this->last_seqno - seqno)
+	{
+		offset = this->last_seqno - seqno;
+		offset = (this->seqno_index - offset) % this->window_size;
+		return !(this->window[offset / CHAR_BIT] & (1 << offset % CHAR_BIT));
+	}
+	return FALSE;
+}
+
+static void bitwise_set(bitwise_t *this, u_int32_t seqno)
+{
+	u_int i, shift;
+
+	if (seqno > this->last_seqno)
+	{
+		shift = seqno - this->last_seqno;
+		shift = shift < this->window_size ? shift : this->window_size;
+		for (i = 0; i < shift; ++i)
+		{
+			this->seqno_index = (this->seqno_index + 1) % this->window_size;
+			set_bit(this, this->seqno_index, FALSE);
+		}
+		set_bit(this, this->seqno_index, TRUE);
+		this->last_seqno = seqno;
+	}
+	else
+	{
+		i = this->last_seqno - seqno;
+		set_bit(this, (this->seqno_index - i) % this->window_size, TRUE);
+	}
+}
+
+/**
+ * Run the sequence numbers through the bitwise window, return accepted
+ */
+static u_int run_bitwise(u_int32_t *seqnos, int count, u_int window_size)
+{
+	bitwise_t this = {
+		.window_size = window_size,
+		.window = calloc(window_size / CHAR_BIT + 1, 1),
+	};
+	u_int accepted = 0;
+	int i;
+
+	for (i = 0; i < count; i++)
+	{
+		if (bitwise_verify(&this, seqnos[i]))
+		{
+			bitwise_set(&this, seqnos[i]);
+			accepted++;
+		}
+	}
+	free(this.window);
+	return accepted;
+}
+
+/**
+ * Run the sequence numbers through an inbound esp_context_t, return accepted
+ */
+static u_int run_context(u_int32_t *seqnos, int count, u_int window_size)
+{
+	esp_context_t *context;
+	char enc[16] = {}, integ[20] = {};
+	u_int accepted = 0;
+	int i;
+
+	lib->settings->set_int(lib->settings, "libipsec.replay_window",
+						   window_size);
+	context = esp_context_create(ENCR_AES_CBC, chunk_from_thing(enc),
+						AUTH_HMAC_SHA1_96, chunk_from_thing(integ), TRUE);
+	if (!context)
+	{
+		fprintf(stderr, "creating ESP context failed\n");
+		exit(1);
+	}
+	for (i = 0; i < count; i++)
+	{
+		if (context->verify_seqno(context, seqnos[i]))
+		{
+			context->set_authenticated_seqno(context, seqnos[i]);
+			accepted++;
+		}
+	}
+	context->destroy(context);
+	return accepted;
+}
+
+/**
+ * Generate sequence numbers with bursts of lost packets every 1024 packets,
+ * some reordering and duplicates, all of them within the window
+ */
+static void generate(u_int32_t *seqnos, int count, u_int window_size)
+{
+	u_int32_t tmp, seqno = 0;
+	int i, j, distance;
+
+	srandom(count);
+	for (i = 0; i < count; i++)
+	{
+		if (i % 1024 == 0)
+		{
+			seqno += window_size / 4;
+		}
+		seqnos[i] = ++seqno;
+	}
+	distance = min(window_size / 4, 1024) + 1;
+	for (i = 0; i < count; i++)
+	{
+		switch (random() % 16)
+		{
+			case 0:
+				j = min(i + (int)(random() % distance), count - 1);
+				tmp = seqnos[i];
+				seqnos[i] = seqnos[j];
+				seqnos[j] = tmp;
+				break;
+			case 1:
+				j = max(i - (int)(random() % distance), 0);
+				seqnos[i] = seqnos[j];
+				break;
+			default:
+				break;
+		}
+	}
+}
+
+#define COUNT (1 << 20)
+
+int main(int argc, char *argv[])
+{
+	struct timespec timing;
+	u_int sizes[] = { 32, 128, 1024, 4096, 16384 }, accepted1, accepted2;
+	u_int32_t *seqnos;
+	double t1, t2;
+	int i;
+
+	library_init(NULL);
+	atexit(library_deinit);
+	lib->plugins->load(lib->plugins, NULL, PLUGINS);
+
+	seqnos = malloc(sizeof(u_int32_t) * COUNT);
+	for (i = 0; i < countof(sizes); i++)
+	{
+		generate(seqnos, COUNT, sizes[i]);
+
+		start_timing(&timing);
+		accepted1 = run_bitwise(seqnos, COUNT, sizes[i]);
+		t1 = end_timing(&timing);
+
+		start_timing(&timing);
+		accepted2 = run_context(seqnos, COUNT, sizes[i]);
+		t2 = end_timing(&timing);
+
+		printf("window %5u, %d packets: bitwise %.4fs, blocks %.4fs, "
+			   "%u accepted%s\n", sizes[i], COUNT, t1, t2, accepted2,
+			   accepted1 == accepted2 ? "" : " (MISMATCH)");
+	}
+	free(seqnos);
+	return 0;
+}
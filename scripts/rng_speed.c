@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2013 Hochschule fuer Technik Rapperswil
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.  See <http://www.fsf.org/copyleft/gpl.txt>.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include <library.h>
+#include <threading/thread.h>
+
+static void start_timing(struct timespec *start)
+{
+	clock_gettime(CLOCK_MONOTONIC, start);
+}
+
+static double end_timing(struct timespec *start)
+{
+	struct timespec end;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_nsec - start->tv_nsec) / 1000000000.0 +
+			(end.tv_sec - start->tv_sec) * 1.0;
+}
+
+/**
+ * Benchmark parameters, shared by all threads
+ */
+static rng_quality_t quality;
+static size_t request;
+static int rounds;
+
+/**
+ * Thread generating random bytes, returns TRUE on success
+ */
+static void* run(void *data)
+{
+	u_int8_t buf[request];
+	rng_t *rng;
+	int i;
+
+	rng = lib->crypto->create_rng(lib->crypto, quality);
+	if (!rng)
+	{
+		return (void*)FALSE;
+	}
+	for (i = 0; i < rounds; i++)
+	{
+		if (!rng->get_bytes(rng, request, buf))
+		{
+			rng->destroy(rng);
+			return (void*)FALSE;
+		}
+	}
+	rng->destroy(rng);
+	return (void*)TRUE;
+}
+
+int main(int argc, char *argv[])
+{
+	struct timespec timing;
+	int count, i, sizes[] = { 16, 32, 256, 4096 }, s;
+	thread_t **threads;
+	bool ok = TRUE;
+	double t;
+
+	library_init(NULL);
+	lib->plugins->load(lib->plugins, NULL, PLUGINS);
+	atexit(library_deinit);
+
+	if (argc < 2)
+	{
+		fprintf(stderr, "usage: %s weak|strong [threads] [rounds]\n", argv[0]);
+		return 1;
+	}
+	quality = streq(argv[1], "strong") ? RNG_STRONG : RNG_WEAK;
+	count = argc > 2 ? max(atoi(argv[2]), 1) : 1;
+	rounds = argc > 3 ? max(atoi(argv[3]), 1) : 100000;
+
+	printf("loaded: %s\n", lib->plugins->loaded_plugins(lib->plugins));
+
+	threads = calloc(count, sizeof(thread_t*));
+	for (s = 0; s < countof(sizes); s++)
+	{
+		request = sizes[s];
+		start_timing(&timing);
+		for (i = 0; i < count; i++)
+		{
+			threads[i] = thread_create(run, NULL);
+		}
+		for (i = 0; i < count; i++)
+		{
+			ok = threads[i]->join(threads[i]) && ok;
+		}
+		t = end_timing(&timing);
+		if (!ok)
+		{
+			fprintf(stderr, "generating %N random bytes failed!\n",
+					rng_quality_names, quality);
+			return 1;
+		}
+		printf("%4zu byte requests, %d threads: %8.0f requests/s, %8.2f MB/s\n",
+			   request, count, count * rounds / t,
+			   count * rounds * request / t / 1024 / 1024);
+	}
+	free(threads);
+	return 0;
+}
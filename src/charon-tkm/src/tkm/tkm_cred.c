@@ -109,7 +109,7 @@ METHOD(tkm_cred_t, destroy, void,
  */
 static u_int hash(identification_t *id)
 {
-	return chunk_hash(id->get_encoding(id));
+	return id->hash(id, 0);
 }
 
 /**
@@ -54,6 +54,7 @@ processing/jobs/migrate_job.c processing/jobs/migrate_job.h \
 processing/jobs/process_message_job.c processing/jobs/process_message_job.h \
 processing/jobs/rekey_child_sa_job.c processing/jobs/rekey_child_sa_job.h \
 processing/jobs/rekey_ike_sa_job.c processing/jobs/rekey_ike_sa_job.h \
+processing/jobs/resume_message_job.c processing/jobs/resume_message_job.h \
 processing/jobs/retransmit_job.c processing/jobs/retransmit_job.h \
 processing/jobs/retry_initiate_job.c processing/jobs/retry_initiate_job.h \
 processing/jobs/send_dpd_job.c processing/jobs/send_dpd_job.h \
@@ -72,8 +73,10 @@ sa/ike_sa.c sa/ike_sa.h \
 sa/ike_sa_id.c sa/ike_sa_id.h \
 sa/keymat.h sa/keymat.c \
 sa/ike_sa_manager.c sa/ike_sa_manager.h \
+sa/ike_sa_timer.c sa/ike_sa_timer.h \
 sa/task_manager.h sa/task_manager.c \
 sa/shunt_manager.c sa/shunt_manager.h \
+sa/verify_manager.c sa/verify_manager.h \
 sa/trap_manager.c sa/trap_manager.h \
 sa/task.c sa/task.h
 
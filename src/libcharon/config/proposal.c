@@ -20,6 +20,7 @@
 
 #include <daemon.h>
 #include <collections/linked_list.h>
+#include <collections/array.h>
 #include <utils/identification.h>
 
 #include <crypto/transform.h>
@@ -54,29 +55,29 @@ struct private_proposal_t {
 	protocol_id_t protocol;
 
 	/**
-	 * priority ordered list of encryption algorithms
+	 * priority ordered array of encryption algorithms
 	 */
-	linked_list_t *encryption_algos;
+	array_t *encryption_algos;
 
 	/**
-	 * priority ordered list of integrity algorithms
+	 * priority ordered array of integrity algorithms
 	 */
-	linked_list_t *integrity_algos;
+	array_t *integrity_algos;
 
 	/**
-	 * priority ordered list of pseudo random functions
+	 * priority ordered array of pseudo random functions
 	 */
-	linked_list_t *prf_algos;
+	array_t *prf_algos;
 
 	/**
-	 * priority ordered list of dh groups
+	 * priority ordered array of dh groups
 	 */
-	linked_list_t *dh_groups;
+	array_t *dh_groups;
 
 	/**
-	 * priority ordered list of extended sequence number flags
+	 * priority ordered array of extended sequence number flags
 	 */
-	linked_list_t *esns;
+	array_t *esns;
 
 	/**
 	 * senders SPI
@@ -107,14 +108,14 @@ struct algorithm_t {
 /**
  * Add algorithm/keysize to a algorithm list
  */
-static void add_algo(linked_list_t *list, u_int16_t algo, u_int16_t key_size)
+static void add_algo(array_t *list, u_int16_t algo, u_int16_t key_size)
 {
-	algorithm_t *algo_key;
+	algorithm_t algo_key = {
+		.algorithm = algo,
+		.key_size = key_size,
+	};
 
-	algo_key = malloc_thing(algorithm_t);
-	algo_key->algorithm = algo;
-	algo_key->key_size = key_size;
-	list->insert_last(list, (void*)algo_key);
+	array_insert(list, ARRAY_TAIL, &algo_key);
 }
 
 METHOD(proposal_t, add_algorithm, void,
@@ -158,32 +159,39 @@ static bool alg_filter(void *null, algorithm_t **in, u_int16_t *alg,
 	return TRUE;
 }
 
-METHOD(proposal_t, create_enumerator, enumerator_t*,
-	private_proposal_t *this, transform_type_t type)
+/**
+ * Get the algorithm array for a transform type, NULL if unsupported
+ */
+static array_t *get_algo_array(private_proposal_t *this, transform_type_t type)
 {
-	linked_list_t *list;
-
 	switch (type)
 	{
 		case ENCRYPTION_ALGORITHM:
-			list = this->encryption_algos;
-			break;
+			return this->encryption_algos;
 		case INTEGRITY_ALGORITHM:
-			list = this->integrity_algos;
-			break;
+			return this->integrity_algos;
 		case PSEUDO_RANDOM_FUNCTION:
-			list = this->prf_algos;
-			break;
+			return this->prf_algos;
 		case DIFFIE_HELLMAN_GROUP:
-			list = this->dh_groups;
-			break;
+			return this->dh_groups;
 		case EXTENDED_SEQUENCE_NUMBERS:
-			list = this->esns;
-			break;
+			return this->esns;
 		default:
 			return NULL;
 	}
-	return enumerator_create_filter(list->create_enumerator(list),
+}
+
+METHOD(proposal_t, create_enumerator, enumerator_t*,
+	private_proposal_t *this, transform_type_t type)
+{
+	array_t *list;
+
+	list = get_algo_array(this, type);
+	if (!list)
+	{
+		return NULL;
+	}
+	return enumerator_create_filter(array_create_enumerator(list),
 									(void*)alg_filter, NULL, NULL);
 }
 
@@ -191,16 +199,18 @@ METHOD(proposal_t, get_algorithm, bool,
 	private_proposal_t *this, transform_type_t type,
 	u_int16_t *alg, u_int16_t *key_size)
 {
-	enumerator_t *enumerator;
-	bool found = FALSE;
+	algorithm_t algo;
 
-	enumerator = create_enumerator(this, type);
-	if (enumerator->enumerate(enumerator, alg, key_size))
+	if (!array_get(get_algo_array(this, type), ARRAY_HEAD, &algo))
 	{
-		found = TRUE;
+		return FALSE;
 	}
-	enumerator->destroy(enumerator);
-	return found;
+	*alg = algo.algorithm;
+	if (key_size)
+	{
+		*key_size = algo.key_size;
+	}
+	return TRUE;
 }
 
 METHOD(proposal_t, has_dh_group, bool,
@@ -208,21 +218,19 @@ METHOD(proposal_t, has_dh_group, bool,
 {
 	bool result = FALSE;
 
-	if (this->dh_groups->get_count(this->dh_groups))
+	if (array_count(this->dh_groups))
 	{
-		algorithm_t *current;
-		enumerator_t *enumerator;
+		algorithm_t current;
+		int i;
 
-		enumerator = this->dh_groups->create_enumerator(this->dh_groups);
-		while (enumerator->enumerate(enumerator, (void**)&current))
+		array_foreach(this->dh_groups, i, &current)
 		{
-			if (current->algorithm == group)
+			if (current.algorithm == group)
 			{
 				result = TRUE;
 				break;
 			}
 		}
-		enumerator->destroy(enumerator);
 	}
 	else if (group == MODP_NONE)
 	{
@@ -237,47 +245,42 @@ METHOD(proposal_t, strip_dh, void,
 	enumerator_t *enumerator;
 	algorithm_t *alg;
 
-	enumerator = this->dh_groups->create_enumerator(this->dh_groups);
+	enumerator = array_create_enumerator(this->dh_groups);
 	while (enumerator->enumerate(enumerator, (void**)&alg))
 	{
 		if (alg->algorithm != keep)
 		{
-			this->dh_groups->remove_at(this->dh_groups, enumerator);
-			free(alg);
+			array_remove_at(this->dh_groups, enumerator);
 		}
 	}
 	enumerator->destroy(enumerator);
 }
 
 /**
- * Find a matching alg/keysize in two linked lists
+ * Find a matching alg/keysize in two algorithm arrays
  */
-static bool select_algo(linked_list_t *first, linked_list_t *second, bool priv,
+static bool select_algo(array_t *first, array_t *second, bool priv,
 						bool *add, u_int16_t *alg, size_t *key_size)
 {
-	enumerator_t *e1, *e2;
-	algorithm_t *alg1, *alg2;
+	algorithm_t alg1, alg2;
+	int i, j;
 
 	/* if in both are zero algorithms specified, we HAVE a match */
-	if (first->get_count(first) == 0 && second->get_count(second) == 0)
+	if (array_count(first) == 0 && array_count(second) == 0)
 	{
 		*add = FALSE;
 		return TRUE;
 	}
 
-	e1 = first->create_enumerator(first);
-	e2 = second->create_enumerator(second);
 	/* compare algs, order of algs in "first" is preferred */
-	while (e1->enumerate(e1, &alg1))
+	array_foreach(first, i, &alg1)
 	{
-		e2->destroy(e2);
-		e2 = second->create_enumerator(second);
-		while (e2->enumerate(e2, &alg2))
+		array_foreach(second, j, &alg2)
 		{
-			if (alg1->algorithm == alg2->algorithm &&
-				alg1->key_size == alg2->key_size)
+			if (alg1.algorithm == alg2.algorithm &&
+				alg1.key_size == alg2.key_size)
 			{
-				if (!priv && alg1->algorithm >= 1024)
+				if (!priv && alg1.algorithm >= 1024)
 				{
 					/* accept private use algorithms only if requested */
 					DBG1(DBG_CFG, "an algorithm from private space would match, "
@@ -285,18 +288,14 @@ static bool select_algo(linked_list_t *first, linked_list_t *second, bool priv,
 					continue;
 				}
 				/* ok, we have an algorithm */
-				*alg = alg1->algorithm;
-				*key_size = alg1->key_size;
+				*alg = alg1.algorithm;
+				*key_size = alg1.key_size;
 				*add = TRUE;
-				e1->destroy(e1);
-				e2->destroy(e2);
 				return TRUE;
 			}
 		}
 	}
 	/* no match in all comparisons */
-	e1->destroy(e1);
-	e2->destroy(e2);
 	return FALSE;
 }
 
@@ -433,51 +432,41 @@ METHOD(proposal_t, get_spi, u_int64_t,
 }
 
 /**
- * Clone a algorithm list
+ * Clone a algorithm array
  */
-static void clone_algo_list(linked_list_t *list, linked_list_t *clone_list)
+static void clone_algo_list(array_t *list, array_t *clone_list)
 {
-	algorithm_t *algo, *clone_algo;
-	enumerator_t *enumerator;
+	algorithm_t algo;
+	int i;
 
-	enumerator = list->create_enumerator(list);
-	while (enumerator->enumerate(enumerator, &algo))
+	array_foreach(list, i, &algo)
 	{
-		clone_algo = malloc_thing(algorithm_t);
-		memcpy(clone_algo, algo, sizeof(algorithm_t));
-		clone_list->insert_last(clone_list, (void*)clone_algo);
+		array_insert(clone_list, ARRAY_TAIL, &algo);
 	}
-	enumerator->destroy(enumerator);
 }
 
 /**
- * check if an algorithm list equals
+ * check if an algorithm array equals
  */
-static bool algo_list_equals(linked_list_t *l1, linked_list_t *l2)
+static bool algo_list_equals(array_t *l1, array_t *l2)
 {
-	enumerator_t *e1, *e2;
-	algorithm_t *alg1, *alg2;
-	bool equals = TRUE;
+	algorithm_t alg1, alg2;
+	int i;
 
-	if (l1->get_count(l1) != l2->get_count(l2))
+	if (array_count(l1) != array_count(l2))
 	{
 		return FALSE;
 	}
-
-	e1 = l1->create_enumerator(l1);
-	e2 = l2->create_enumerator(l2);
-	while (e1->enumerate(e1, &alg1) && e2->enumerate(e2, &alg2))
+	array_foreach(l1, i, &alg1)
 	{
-		if (alg1->algorithm != alg2->algorithm ||
-			alg1->key_size != alg2->key_size)
+		if (!array_get(l2, i, &alg2) ||
+			alg1.algorithm != alg2.algorithm ||
+			alg1.key_size != alg2.key_size)
 		{
-			equals = FALSE;
-			break;
+			return FALSE;
 		}
 	}
-	e1->destroy(e1);
-	e2->destroy(e2);
-	return equals;
+	return TRUE;
 }
 
 METHOD(proposal_t, get_number, u_int,
@@ -543,21 +532,18 @@ static const struct {
  */
 static void check_proposal(private_proposal_t *this)
 {
-	enumerator_t *e;
-	algorithm_t *alg;
+	algorithm_t alg;
 	bool all_aead = TRUE;
-	int i;
+	int i, j;
 
-	if (this->protocol == PROTO_IKE &&
-		this->prf_algos->get_count(this->prf_algos) == 0)
+	if (this->protocol == PROTO_IKE && array_count(this->prf_algos) == 0)
 	{	/* No explicit PRF found. We assume the same algorithm as used
 		 * for integrity checking */
-		e = this->integrity_algos->create_enumerator(this->integrity_algos);
-		while (e->enumerate(e, &alg))
+		array_foreach(this->integrity_algos, j, &alg)
 		{
 			for (i = 0; i < countof(integ_prf_map); i++)
 			{
-				if (alg->algorithm == integ_prf_map[i].integ)
+				if (alg.algorithm == integ_prf_map[i].integ)
 				{
 					add_algorithm(this, PSEUDO_RANDOM_FUNCTION,
 								  integ_prf_map[i].prf, 0);
@@ -565,39 +551,31 @@ static void check_proposal(private_proposal_t *this)
 				}
 			}
 		}
-		e->destroy(e);
 	}
 
-	e = this->encryption_algos->create_enumerator(this->encryption_algos);
-	while (e->enumerate(e, &alg))
+	array_foreach(this->encryption_algos, i, &alg)
 	{
-		if (!encryption_algorithm_is_aead(alg->algorithm))
+		if (!encryption_algorithm_is_aead(alg.algorithm))
 		{
 			all_aead = FALSE;
 			break;
 		}
 	}
-	e->destroy(e);
 
 	if (all_aead)
 	{
 		/* if all encryption algorithms in the proposal are authenticated encryption
 		 * algorithms we MUST NOT propose any integrity algorithms */
-		while (this->integrity_algos->remove_last(this->integrity_algos,
-												  (void**)&alg) == SUCCESS)
-		{
-			free(alg);
-		}
+		array_destroy(this->integrity_algos);
+		this->integrity_algos = array_create(sizeof(algorithm_t), 0);
 	}
 
 	if (this->protocol == PROTO_AH || this->protocol == PROTO_ESP)
 	{
-		e = this->esns->create_enumerator(this->esns);
-		if (!e->enumerate(e, &alg))
+		if (array_count(this->esns) == 0)
 		{	/* ESN not specified, assume not supported */
 			add_algorithm(this, EXTENDED_SEQUENCE_NUMBERS, NO_EXT_SEQ_NUMBERS, 0);
 		}
-		e->destroy(e);
 	}
 }
 
@@ -704,11 +682,11 @@ int proposal_printf_hook(printf_hook_data_t *data, printf_hook_spec_t *spec,
 METHOD(proposal_t, destroy, void,
 	private_proposal_t *this)
 {
-	this->encryption_algos->destroy_function(this->encryption_algos, free);
-	this->integrity_algos->destroy_function(this->integrity_algos, free);
-	this->prf_algos->destroy_function(this->prf_algos, free);
-	this->dh_groups->destroy_function(this->dh_groups, free);
-	this->esns->destroy_function(this->esns, free);
+	array_destroy(this->encryption_algos);
+	array_destroy(this->integrity_algos);
+	array_destroy(this->prf_algos);
+	array_destroy(this->dh_groups);
+	array_destroy(this->esns);
 	free(this);
 }
 
@@ -737,11 +715,11 @@ proposal_t *proposal_create(protocol_id_t protocol, u_int number)
 		},
 		.protocol = protocol,
 		.number = number,
-		.encryption_algos = linked_list_create(),
-		.integrity_algos = linked_list_create(),
-		.prf_algos = linked_list_create(),
-		.dh_groups = linked_list_create(),
-		.esns = linked_list_create(),
+		.encryption_algos = array_create(sizeof(algorithm_t), 0),
+		.integrity_algos = array_create(sizeof(algorithm_t), 0),
+		.prf_algos = array_create(sizeof(algorithm_t), 0),
+		.dh_groups = array_create(sizeof(algorithm_t), 0),
+		.esns = array_create(sizeof(algorithm_t), 0),
 	);
 
 	return &this->public;
@@ -452,6 +452,8 @@ static void destroy(private_daemon_t *this)
 		this->public.sender->flush(this->public.sender);
 	}
 
+	/* stop verifier threads, they queue jobs to the processor */
+	DESTROY_IF(this->public.verifier);
 	/* cancel all threads and wait for their termination */
 	lib->processor->cancel(lib->processor);
 
@@ -546,6 +548,7 @@ METHOD(daemon_t, initialize, bool,
 	{
 		return FALSE;
 	}
+	this->public.verifier = verify_manager_create();
 
 	/* Queue start_action job */
 	lib->processor->queue_job(lib->processor, (job_t*)start_action_job_create());
@@ -160,6 +160,7 @@ typedef struct daemon_t daemon_t;
 #include <sa/ike_sa_manager.h>
 #include <sa/trap_manager.h>
 #include <sa/shunt_manager.h>
+#include <sa/verify_manager.h>
 #include <config/backend_manager.h>
 #include <sa/eap/eap_manager.h>
 #include <sa/xauth/xauth_manager.h>
@@ -225,6 +226,11 @@ struct daemon_t {
 	 */
 	shunt_manager_t *shunts;
 
+	/**
+	 * Manager for asynchronous signature verification
+	 */
+	verify_manager_t *verifier;
+
 	/**
 	 * Manager for the different configuration backends.
 	 */
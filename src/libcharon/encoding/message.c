@@ -24,6 +24,7 @@
 
 #include <library.h>
 #include <daemon.h>
+#include <collections/array.h>
 #include <sa/ikev1/keymat_v1.h>
 #include <encoding/generator.h>
 #include <encoding/parser.h>
@@ -876,9 +877,9 @@ struct private_message_t {
 	packet_t *packet;
 
 	/**
-	 * Linked List where payload data are stored in.
+	 * Array of payload_t, in the order they appear in the message.
 	 */
-	linked_list_t *payloads;
+	array_t *payloads;
 
 	 /**
 	  * Assigned parser to parse Header and Body of this message.
@@ -1054,9 +1055,8 @@ METHOD(message_t, add_payload, void,
 {
 	payload_t *last_payload;
 
-	if (this->payloads->get_count(this->payloads) > 0)
+	if (array_get(this->payloads, ARRAY_TAIL, &last_payload))
 	{
-		this->payloads->get_last(this->payloads, (void **)&last_payload);
 		last_payload->set_next_type(last_payload, payload->get_type(payload));
 	}
 	else
@@ -1064,7 +1064,7 @@ METHOD(message_t, add_payload, void,
 		this->first_payload = payload->get_type(payload);
 	}
 	payload->set_next_type(payload, NO_PAYLOAD);
-	this->payloads->insert_last(this->payloads, payload);
+	array_insert(this->payloads, ARRAY_TAIL, payload);
 
 	DBG2(DBG_ENC ,"added payload of type %N to message",
 		 payload_type_names, payload->get_type(payload));
@@ -1078,8 +1078,7 @@ METHOD(message_t, add_notify, void,
 
 	if (flush)
 	{
-		while (this->payloads->remove_last(this->payloads,
-												(void**)&payload) == SUCCESS)
+		while (array_remove(this->payloads, ARRAY_TAIL, &payload))
 		{
 			payload->destroy(payload);
 		}
@@ -1124,32 +1123,29 @@ METHOD(message_t, get_destination, host_t*,
 METHOD(message_t, create_payload_enumerator, enumerator_t*,
 	private_message_t *this)
 {
-	return this->payloads->create_enumerator(this->payloads);
+	return array_create_enumerator(this->payloads);
 }
 
 METHOD(message_t, remove_payload_at, void,
 	private_message_t *this, enumerator_t *enumerator)
 {
-	this->payloads->remove_at(this->payloads, enumerator);
+	array_remove_at(this->payloads, enumerator);
 }
 
 METHOD(message_t, get_payload, payload_t*,
 	private_message_t *this, payload_type_t type)
 {
-	payload_t *current, *found = NULL;
-	enumerator_t *enumerator;
+	payload_t *current;
+	int i;
 
-	enumerator = create_payload_enumerator(this);
-	while (enumerator->enumerate(enumerator, &current))
+	array_foreach(this->payloads, i, &current)
 	{
 		if (current->get_type(current) == type)
 		{
-			found = current;
-			break;
+			return current;
 		}
 	}
-	enumerator->destroy(enumerator);
-	return found;
+	return NULL;
 }
 
 METHOD(message_t, get_notify, notify_payload_t*,
@@ -1314,17 +1310,13 @@ static char* get_string(private_message_t *this, char *buf, int len)
  */
 static void order_payloads(private_message_t *this)
 {
-	linked_list_t *list;
+	array_t *list;
 	payload_t *payload;
 	int i;
 
-	/* move to temp list */
-	list = linked_list_create();
-	while (this->payloads->remove_last(this->payloads,
-									   (void**)&payload) == SUCCESS)
-	{
-		list->insert_first(list, payload);
-	}
+	/* move to temp array */
+	list = this->payloads;
+	this->payloads = array_create(0, 0);
 	/* for each rule, ... */
 	for (i = 0; i < this->rule->order_count; i++)
 	{
@@ -1335,7 +1327,7 @@ static void order_payloads(private_message_t *this)
 		order = this->rule->order[i];
 
 		/* ... find all payload ... */
-		enumerator = list->create_enumerator(list);
+		enumerator = array_create_enumerator(list);
 		while (enumerator->enumerate(enumerator, &payload))
 		{
 			/* ... with that type ... */
@@ -1347,7 +1339,7 @@ static void order_payloads(private_message_t *this)
 				if (order.type != NOTIFY || order.notify == 0 ||
 					order.notify == notify->get_notify_type(notify))
 				{
-					list->remove_at(list, enumerator);
+					array_remove_at(list, enumerator);
 					add_payload(this, payload);
 				}
 			}
@@ -1355,7 +1347,7 @@ static void order_payloads(private_message_t *this)
 		enumerator->destroy(enumerator);
 	}
 	/* append all payloads without a rule to the end */
-	while (list->remove_last(list, (void**)&payload) == SUCCESS)
+	while (array_remove(list, ARRAY_TAIL, &payload))
 	{
 		/* do not complain about payloads in private use space */
 		if (payload->get_type(payload) < 128)
@@ -1367,7 +1359,7 @@ static void order_payloads(private_message_t *this)
 		}
 		add_payload(this, payload);
 	}
-	list->destroy(list);
+	array_destroy(list);
 }
 
 /**
@@ -1376,16 +1368,12 @@ static void order_payloads(private_message_t *this)
 static encryption_payload_t* wrap_payloads(private_message_t *this)
 {
 	encryption_payload_t *encryption;
-	linked_list_t *payloads;
+	array_t *payloads;
 	payload_t *current;
 
-	/* copy all payloads in a temporary list */
-	payloads = linked_list_create();
-	while (this->payloads->remove_first(this->payloads,
-										(void**)&current) == SUCCESS)
-	{
-		payloads->insert_last(payloads, current);
-	}
+	/* move all payloads to a temporary array */
+	payloads = this->payloads;
+	this->payloads = array_create(0, 0);
 
 	if (this->is_encrypted)
 	{
@@ -1395,7 +1383,7 @@ static encryption_payload_t* wrap_payloads(private_message_t *this)
 	{
 		encryption = encryption_payload_create(ENCRYPTED);
 	}
-	while (payloads->remove_first(payloads, (void**)&current) == SUCCESS)
+	while (array_remove(payloads, ARRAY_HEAD, &current))
 	{
 		payload_rule_t *rule;
 		payload_type_t type;
@@ -1420,7 +1408,7 @@ static encryption_payload_t* wrap_payloads(private_message_t *this)
 			add_payload(this, current);
 		}
 	}
-	payloads->destroy(payloads);
+	array_destroy(payloads);
 
 	return encryption;
 }
@@ -1481,7 +1469,7 @@ METHOD(message_t, generate, status_t,
 
 			hash_payload = hash_payload_create(HASH_V1);
 			hash_payload->set_hash(hash_payload, hash);
-			this->payloads->insert_first(this->payloads, hash_payload);
+			array_insert(this->payloads, ARRAY_HEAD, hash_payload);
 			if (this->exchange_type == INFORMATIONAL_V1)
 			{
 				this->is_encrypted = encrypted = TRUE;
@@ -1497,7 +1485,7 @@ METHOD(message_t, generate, status_t,
 	{
 		/* If at least one payload requires encryption, encrypt the message.
 		 * If no key material is available, the flag will be reset below. */
-		enumerator = this->payloads->create_enumerator(this->payloads);
+		enumerator = array_create_enumerator(this->payloads);
 		while (enumerator->enumerate(enumerator, (void**)&payload))
 		{
 			payload_rule_t *rule;
@@ -1600,7 +1588,7 @@ METHOD(message_t, generate, status_t,
 			/* fill in length, including encryption payload */
 			htoun32(lenpos, chunk.len + encryption->get_length(encryption));
 		}
-		this->payloads->insert_last(this->payloads, encryption);
+		array_insert(this->payloads, ARRAY_TAIL, encryption);
 		if (encryption->encrypt(encryption, chunk) != SUCCESS)
 		{
 			generator->destroy(generator);
@@ -1772,7 +1760,7 @@ static status_t parse_payloads(private_message_t *this)
 		}
 		encryption->payload_interface.set_next_type((payload_t*)encryption,
 													this->first_payload);
-		this->payloads->insert_last(this->payloads, encryption);
+		array_insert(this->payloads, ARRAY_TAIL, encryption);
 		return SUCCESS;
 	}
 
@@ -1801,7 +1789,7 @@ static status_t parse_payloads(private_message_t *this)
 
 		DBG2(DBG_ENC, "%N payload verified. Adding to payload list",
 			 payload_type_names, type);
-		this->payloads->insert_last(this->payloads, payload);
+		array_insert(this->payloads, ARRAY_TAIL, payload);
 
 		/* an encryption payload is the last one, so STOP here. decryption is
 		 * done later */
@@ -1829,7 +1817,7 @@ static status_t decrypt_payloads(private_message_t *this, keymat_t *keymat)
 	aead_t *aead;
 	status_t status = SUCCESS;
 
-	enumerator = this->payloads->create_enumerator(this->payloads);
+	enumerator = array_create_enumerator(this->payloads);
 	while (enumerator->enumerate(enumerator, &payload))
 	{
 		type = payload->get_type(payload);
@@ -1839,7 +1827,7 @@ static status_t decrypt_payloads(private_message_t *this, keymat_t *keymat)
 		if (type == ENCRYPTED || type == ENCRYPTED_V1)
 		{
 			encryption_payload_t *encryption;
-			payload_t *encrypted;
+			payload_t *encrypted, *last;
 			chunk_t chunk;
 			size_t bs;
 
@@ -1847,7 +1835,7 @@ static status_t decrypt_payloads(private_message_t *this, keymat_t *keymat)
 
 			DBG2(DBG_ENC, "found an encryption payload");
 
-			if (this->payloads->has_more(this->payloads, enumerator))
+			if (array_get(this->payloads, ARRAY_TAIL, &last) && last != payload)
 			{
 				DBG1(DBG_ENC, "encrypted payload is not last payload");
 				status = VERIFY_ERROR;
@@ -1910,7 +1898,7 @@ static status_t decrypt_payloads(private_message_t *this, keymat_t *keymat)
 			}
 
 			was_encrypted = TRUE;
-			this->payloads->remove_at(this->payloads, enumerator);
+			array_remove_at(this->payloads, enumerator);
 
 			while ((encrypted = encryption->remove_payload(encryption)))
 			{
@@ -1925,7 +1913,7 @@ static status_t decrypt_payloads(private_message_t *this, keymat_t *keymat)
 				}
 				DBG2(DBG_ENC, "insert decrypted payload of type "
 					 "%N at end of list", payload_type_names, type);
-				this->payloads->insert_last(this->payloads, encrypted);
+				array_insert(this->payloads, ARRAY_TAIL, encrypted);
 				previous = encrypted;
 			}
 			encryption->destroy(encryption);
@@ -2095,7 +2083,7 @@ METHOD(message_t, destroy, void,
 	private_message_t *this)
 {
 	DESTROY_IF(this->ike_sa_id);
-	this->payloads->destroy_offset(this->payloads, offsetof(payload_t, destroy));
+	array_destroy_offset(this->payloads, offsetof(payload_t, destroy));
 	this->packet->destroy(this->packet);
 	this->parser->destroy(this->parser);
 	free(this);
@@ -2151,7 +2139,7 @@ message_t *message_create_from_packet(packet_t *packet)
 		.is_request = TRUE,
 		.first_payload = NO_PAYLOAD,
 		.packet = packet,
-		.payloads = linked_list_create(),
+		.payloads = array_create(0, 0),
 		.parser = parser_create(packet->get_data(packet)),
 	);
 
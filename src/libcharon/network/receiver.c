@@ -44,9 +44,38 @@
 #define SECRET_LENGTH 16
 /** Length of a notify payload header */
 #define NOTIFY_PAYLOAD_HEADER_LENGTH 8
+/** Offsets of fields in the IKE header */
+#define IKE_HEADER_NEXT_PAYLOAD 16
+#define IKE_HEADER_VERSION 17
+#define IKE_HEADER_EXCHANGE 18
+#define IKE_HEADER_FLAGS 19
+#define IKE_HEADER_MESSAGE_LENGTH 24
+/** Response flag in the IKEv2 header */
+#define IKEV2_FLAG_RESPONSE 0x20
+/** number of token buckets limiting the IKE_SA_INIT rate, a power of 2 */
+#define RATE_BUCKETS 4096
+
+ENUM(receiver_drop_names, RECEIVER_DROP_RATE_LIMIT, RECEIVER_DROP_INITIATOR_ONLY,
+	"rate limit",
+	"cookie",
+	"blocked",
+	"half open limit",
+	"job load",
+	"initiator only",
+);
 
 typedef struct private_receiver_t private_receiver_t;
 
+/**
+ * Token bucket limiting the rate of IKE_SA_INIT requests of peers
+ */
+typedef struct {
+	/** time of the last refill, in ms */
+	u_int32_t last;
+	/** available tokens, in thousandths */
+	u_int32_t credit;
+} bucket_t;
+
 /**
  * Private data of a receiver_t object.
  */
@@ -104,6 +133,11 @@ struct private_receiver_t {
 	 */
 	hasher_t *hasher;
 
+	/**
+	 * length of a cookie, timestamp and hash
+	 */
+	size_t cookie_len;
+
 	/**
 	 * require cookies after this many half open IKE_SAs
 	 */
@@ -129,6 +163,26 @@ struct private_receiver_t {
 	 */
 	u_int init_limit_half_open;
 
+	/**
+	 * Drop IKE_SA_INIT requests of peers exceeding this rate per second
+	 */
+	u_int init_limit_peer_rate;
+
+	/**
+	 * Token buckets for init_limit_peer_rate, indexed by peer address hash
+	 */
+	bucket_t *buckets;
+
+	/**
+	 * Random key to hash peer addresses to buckets
+	 */
+	u_int32_t bucket_key;
+
+	/**
+	 * Number of dropped IKE_SA_INIT requests, per receiver_drop_t
+	 */
+	u_int drops[RECEIVER_DROP_MAX];
+
 	/**
 	 * Delay for receiving incoming packets, to simulate larger RTT
 	 */
@@ -190,43 +244,34 @@ static void send_notify(message_t *request, int major, exchange_type_t exchange,
 }
 
 /**
- * build a cookie
+ * build a cookie into a buffer of cookie_len bytes
  */
-static bool cookie_build(private_receiver_t *this, message_t *message,
-						 u_int32_t t, chunk_t secret, chunk_t *cookie)
+static bool cookie_build(private_receiver_t *this, host_t *ip, chunk_t spi,
+						 u_int32_t t, chunk_t secret, u_char *cookie)
 {
-	u_int64_t spi = message->get_initiator_spi(message);
-	host_t *ip = message->get_source(message);
-	chunk_t input, hash;
+	chunk_t input;
 
 	/* COOKIE = t | sha1( IPi | SPIi | t | secret ) */
-	input = chunk_cata("cccc", ip->get_address(ip), chunk_from_thing(spi),
-					  chunk_from_thing(t), secret);
-	hash = chunk_alloca(this->hasher->get_hash_size(this->hasher));
-	if (!this->hasher->get_hash(this->hasher, input, hash.ptr))
-	{
-		return FALSE;
-	}
-	*cookie = chunk_cat("cc", chunk_from_thing(t), hash);
-	return TRUE;
+	input = chunk_cata("cccc", ip->get_address(ip), spi,
+					   chunk_from_thing(t), secret);
+	memcpy(cookie, &t, sizeof(t));
+	return this->hasher->get_hash(this->hasher, input, cookie + sizeof(t));
 }
 
 /**
  * verify a received cookie
  */
-static bool cookie_verify(private_receiver_t *this, message_t *message,
+static bool cookie_verify(private_receiver_t *this, host_t *ip, chunk_t spi,
 						  chunk_t cookie)
 {
+	u_char reference[sizeof(u_int32_t) + HASH_SIZE_SHA512];
 	u_int32_t t, now;
-	chunk_t reference;
 	chunk_t secret;
 
 	now = time_monotonic(NULL);
-	t = *(u_int32_t*)cookie.ptr;
+	memcpy(&t, cookie.ptr, sizeof(t));
 
-	if (cookie.len != sizeof(u_int32_t) +
-			this->hasher->get_hash_size(this->hasher) ||
-		t < now - this->secret_offset - COOKIE_LIFETIME)
+	if (t < now - this->secret_offset - COOKIE_LIFETIME)
 	{
 		DBG2(DBG_NET, "received cookie lifetime expired, rejecting");
 		return FALSE;
@@ -243,54 +288,103 @@ static bool cookie_verify(private_receiver_t *this, message_t *message,
 	}
 
 	/* compare own calculation against received */
-	if (!cookie_build(this, message, t, secret, &reference))
-	{
-		return FALSE;
-	}
-	if (chunk_equals(reference, cookie))
-	{
-		chunk_free(&reference);
-		return TRUE;
-	}
-	chunk_free(&reference);
-	return FALSE;
+	return cookie_build(this, ip, spi, t, secret, reference) &&
+		   memeq(reference, cookie.ptr, cookie.len);
 }
 
 /**
- * Check if a valid cookie found
+ * Check if a valid cookie found in a raw IKE_SA_INIT request
  */
-static bool check_cookie(private_receiver_t *this, message_t *message)
+static bool check_cookie(private_receiver_t *this, packet_t *packet,
+						 chunk_t data)
 {
-	packet_t *packet;
-	chunk_t data;
+	chunk_t cookie;
 
 	/* check for a cookie. We don't use our parser here and do it
 	 * quick and dirty for performance reasons.
 	 * we assume the cookie is the first payload (which is a MUST), and
 	 * the cookie's SPI length is zero. */
-	packet = message->get_packet(message);
-	data = packet->get_data(packet);
 	if (data.len <
-		 IKE_HEADER_LENGTH + NOTIFY_PAYLOAD_HEADER_LENGTH +
-		 sizeof(u_int32_t) + this->hasher->get_hash_size(this->hasher) ||
-		*(data.ptr + 16) != NOTIFY ||
-		*(u_int16_t*)(data.ptr + IKE_HEADER_LENGTH + 6) != htons(COOKIE))
+		 IKE_HEADER_LENGTH + NOTIFY_PAYLOAD_HEADER_LENGTH + this->cookie_len ||
+		data.ptr[IKE_HEADER_NEXT_PAYLOAD] != NOTIFY ||
+		untoh16(data.ptr + IKE_HEADER_LENGTH + 6) != COOKIE)
 	{
 		/* no cookie found */
-		packet->destroy(packet);
 		return FALSE;
 	}
-	data.ptr += IKE_HEADER_LENGTH + NOTIFY_PAYLOAD_HEADER_LENGTH;
-	data.len = sizeof(u_int32_t) + this->hasher->get_hash_size(this->hasher);
-	if (!cookie_verify(this, message, data))
+	cookie = chunk_create(data.ptr + IKE_HEADER_LENGTH +
+						  NOTIFY_PAYLOAD_HEADER_LENGTH, this->cookie_len);
+	if (!cookie_verify(this, packet->get_source(packet),
+					   chunk_create(data.ptr, sizeof(u_int64_t)), cookie))
 	{
 		DBG2(DBG_NET, "found cookie, but content invalid");
-		packet->destroy(packet);
 		return FALSE;
 	}
 	return TRUE;
 }
 
+/**
+ * Answer a raw IKE_SA_INIT request with a COOKIE notify, without parsing the
+ * request or generating a message
+ */
+static void send_cookie(private_receiver_t *this, packet_t *packet,
+						chunk_t data, u_int32_t now)
+{
+	u_char cookie[sizeof(u_int32_t) + HASH_SIZE_SHA512];
+	host_t *src, *dst;
+	chunk_t response;
+
+	src = packet->get_destination(packet);
+	dst = packet->get_source(packet);
+	if (!cookie_build(this, dst, chunk_create(data.ptr, sizeof(u_int64_t)),
+					  now - this->secret_offset,
+					  chunk_from_thing(this->secret), cookie))
+	{
+		return;
+	}
+	response = chunk_alloc(IKE_HEADER_LENGTH + NOTIFY_PAYLOAD_HEADER_LENGTH +
+						   this->cookie_len);
+	memset(response.ptr, 0, response.len);
+	/* IKE header with the initiator's SPI, responder SPI and message ID 0 */
+	memcpy(response.ptr, data.ptr, sizeof(u_int64_t));
+	response.ptr[IKE_HEADER_NEXT_PAYLOAD] = NOTIFY;
+	response.ptr[IKE_HEADER_VERSION] = IKEV2_MAJOR_VERSION << 4 |
+									   IKEV2_MINOR_VERSION;
+	response.ptr[IKE_HEADER_EXCHANGE] = IKE_SA_INIT;
+	response.ptr[IKE_HEADER_FLAGS] = IKEV2_FLAG_RESPONSE;
+	htoun32(response.ptr + IKE_HEADER_MESSAGE_LENGTH, response.len);
+	/* notify payload without SPI, followed by the cookie */
+	htoun16(response.ptr + IKE_HEADER_LENGTH + 2,
+			NOTIFY_PAYLOAD_HEADER_LENGTH + this->cookie_len);
+	htoun16(response.ptr + IKE_HEADER_LENGTH + 6, COOKIE);
+	memcpy(response.ptr + IKE_HEADER_LENGTH + NOTIFY_PAYLOAD_HEADER_LENGTH,
+		   cookie, this->cookie_len);
+
+	DBG2(DBG_NET, "sending COOKIE notify to %H", dst);
+	charon->sender->send(charon->sender,
+			packet_create_from_data(src->clone(src), dst->clone(dst), response));
+
+	if (++this->secret_used > COOKIE_REUSE)
+	{
+		char secret[SECRET_LENGTH];
+
+		DBG1(DBG_NET, "generating new cookie secret after %d uses",
+			 this->secret_used);
+		if (this->rng->get_bytes(this->rng, SECRET_LENGTH, secret))
+		{
+			memcpy(this->secret_old, this->secret, SECRET_LENGTH);
+			memcpy(this->secret, secret, SECRET_LENGTH);
+			memwipe(secret, SECRET_LENGTH);
+			this->secret_switch = now;
+			this->secret_used = 0;
+		}
+		else
+		{
+			DBG1(DBG_NET, "failed to allocated cookie secret, keeping old");
+		}
+	}
+}
+
 /**
  * Check if we currently require cookies
  */
@@ -322,64 +416,110 @@ static bool cookie_required(private_receiver_t *this,
 }
 
 /**
- * Check if we should drop IKE_SA_INIT because of cookie/overload checking
+ * Check if a peer exceeds its IKE_SA_INIT rate, using a token bucket
+ */
+static bool rate_exceeded(private_receiver_t *this, host_t *src)
+{
+	bucket_t *bucket;
+	timeval_t tv;
+	u_int64_t credit;
+	u_int32_t now, row;
+
+	time_monotonic(&tv);
+	now = tv.tv_sec * 1000 + tv.tv_usec / 1000;
+	row = chunk_hash_inc(src->get_address(src), this->bucket_key);
+	bucket = &this->buckets[row & (RATE_BUCKETS - 1)];
+
+	/* refill the bucket, it holds up to one second worth of tokens */
+	credit = bucket->credit +
+			 (u_int64_t)(now - bucket->last) * this->init_limit_peer_rate;
+	bucket->credit = min(credit, this->init_limit_peer_rate * 1000ULL);
+	bucket->last = now;
+
+	if (bucket->credit < 1000)
+	{
+		return TRUE;
+	}
+	bucket->credit -= 1000;
+	return FALSE;
+}
+
+/**
+ * Check if a raw packet is a request initiating a new IKE_SA with an IKE
+ * version we support
+ */
+static bool initiates_ike_sa(chunk_t data, u_int8_t *major)
+{
+	if (data.len < IKE_HEADER_LENGTH)
+	{
+		return FALSE;
+	}
+	*major = data.ptr[IKE_HEADER_VERSION] >> 4;
+	switch (*major)
+	{
+#ifdef USE_IKEV2
+		case IKEV2_MAJOR_VERSION:
+			return data.ptr[IKE_HEADER_EXCHANGE] == IKE_SA_INIT &&
+				   !(data.ptr[IKE_HEADER_FLAGS] & IKEV2_FLAG_RESPONSE);
+#endif /* USE_IKEV2 */
+#ifdef USE_IKEV1
+		case IKEV1_MAJOR_VERSION:
+			/* no responder SPI yet */
+			return (data.ptr[IKE_HEADER_EXCHANGE] == ID_PROT ||
+					data.ptr[IKE_HEADER_EXCHANGE] == AGGRESSIVE) &&
+				   untoh64(data.ptr + sizeof(u_int64_t)) == 0;
+#endif /* USE_IKEV1 */
+		default:
+			return FALSE;
+	}
+}
+
+/**
+ * Check if we should drop IKE_SA_INIT because of cookie/overload checking,
+ * based on the raw packet only
  */
-static bool drop_ike_sa_init(private_receiver_t *this, message_t *message)
+static bool drop_ike_sa_init(private_receiver_t *this, packet_t *packet,
+							 chunk_t data, u_int8_t major)
 {
+	host_t *src;
 	u_int half_open;
 	u_int32_t now;
 
+	src = packet->get_source(packet);
+
+	/* check if peer exceeds its rate of IKE_SA_INIT requests */
+	if (this->buckets && rate_exceeded(this, src))
+	{
+		DBG2(DBG_NET, "ignoring IKE_SA setup from %H, rate of %d requests/s "
+			 "exceeded", src, this->init_limit_peer_rate);
+		this->drops[RECEIVER_DROP_RATE_LIMIT]++;
+		return TRUE;
+	}
+
 	now = time_monotonic(NULL);
 	half_open = charon->ike_sa_manager->get_half_open_count(
 										charon->ike_sa_manager, NULL);
 
 	/* check for cookies in IKEv2 */
-	if (message->get_major_version(message) == IKEV2_MAJOR_VERSION &&
-		cookie_required(this, half_open, now) && !check_cookie(this, message))
+	if (major == IKEV2_MAJOR_VERSION &&
+		cookie_required(this, half_open, now) &&
+		!check_cookie(this, packet, data))
 	{
-		chunk_t cookie;
-
 		DBG2(DBG_NET, "received packet from: %#H to %#H",
-			 message->get_source(message),
-			 message->get_destination(message));
-		if (!cookie_build(this, message, now - this->secret_offset,
-						  chunk_from_thing(this->secret), &cookie))
-		{
-			return TRUE;
-		}
-		DBG2(DBG_NET, "sending COOKIE notify to %H",
-			 message->get_source(message));
-		send_notify(message, IKEV2_MAJOR_VERSION, IKE_SA_INIT, COOKIE, cookie);
-		chunk_free(&cookie);
-		if (++this->secret_used > COOKIE_REUSE)
-		{
-			char secret[SECRET_LENGTH];
-
-			DBG1(DBG_NET, "generating new cookie secret after %d uses",
-				 this->secret_used);
-			if (this->rng->get_bytes(this->rng, SECRET_LENGTH, secret))
-			{
-				memcpy(this->secret_old, this->secret, SECRET_LENGTH);
-				memcpy(this->secret, secret, SECRET_LENGTH);
-				memwipe(secret, SECRET_LENGTH);
-				this->secret_switch = now;
-				this->secret_used = 0;
-			}
-			else
-			{
-				DBG1(DBG_NET, "failed to allocated cookie secret, keeping old");
-			}
-		}
+			 src, packet->get_destination(packet));
+		send_cookie(this, packet, data, now);
+		this->drops[RECEIVER_DROP_COOKIE]++;
 		return TRUE;
 	}
 
 	/* check if peer has too many IKE_SAs half open */
 	if (this->block_threshold &&
 		charon->ike_sa_manager->get_half_open_count(charon->ike_sa_manager,
-				message->get_source(message)) >= this->block_threshold)
+				src) >= this->block_threshold)
 	{
 		DBG1(DBG_NET, "ignoring IKE_SA setup from %H, "
-			 "peer too aggressive", message->get_source(message));
+			 "peer too aggressive", src);
+		this->drops[RECEIVER_DROP_BLOCKED]++;
 		return TRUE;
 	}
 
@@ -388,8 +528,9 @@ static bool drop_ike_sa_init(private_receiver_t *this, message_t *message)
 		half_open >= this->init_limit_half_open)
 	{
 		DBG1(DBG_NET, "ignoring IKE_SA setup from %H, half open IKE_SA "
-			 "count of %d exceeds limit of %d", message->get_source(message),
+			 "count of %d exceeds limit of %d", src,
 			 half_open, this->init_limit_half_open);
+		this->drops[RECEIVER_DROP_HALF_OPEN]++;
 		return TRUE;
 	}
 
@@ -405,8 +546,9 @@ static bool drop_ike_sa_init(private_receiver_t *this, message_t *message)
 		if (jobs > this->init_limit_job_load)
 		{
 			DBG1(DBG_NET, "ignoring IKE_SA setup from %H, job load of %d "
-				 "exceeds limit of %d", message->get_source(message),
+				 "exceeds limit of %d", src,
 				 jobs, this->init_limit_job_load);
+			this->drops[RECEIVER_DROP_JOB_LOAD]++;
 			return TRUE;
 		}
 	}
@@ -418,12 +560,12 @@ static bool drop_ike_sa_init(private_receiver_t *this, message_t *message)
  */
 static job_requeue_t receive_packets(private_receiver_t *this)
 {
-	ike_sa_id_t *id;
 	packet_t *packet;
 	message_t *message;
 	host_t *src, *dst;
 	status_t status;
 	bool supported = TRUE;
+	u_int8_t major;
 	chunk_t data, marker = chunk_from_chars(0x00, 0x00, 0x00, 0x00);
 
 	/* read in a packet */
@@ -488,6 +630,23 @@ static job_requeue_t receive_packets(private_receiver_t *this)
 		}
 	}
 
+	/* check requests initiating new IKE_SAs before parsing anything */
+	data = packet->get_data(packet);
+	if (initiates_ike_sa(data, &major))
+	{
+		if (this->initiator_only)
+		{
+			this->drops[RECEIVER_DROP_INITIATOR_ONLY]++;
+			packet->destroy(packet);
+			return JOB_REQUEUE_DIRECT;
+		}
+		if (drop_ike_sa_init(this, packet, data, major))
+		{
+			packet->destroy(packet);
+			return JOB_REQUEUE_DIRECT;
+		}
+	}
+
 	/* parse message header */
 	message = message_create_from_packet(packet);
 	if (message->parse_header(message) != SUCCESS)
@@ -544,26 +703,6 @@ static job_requeue_t receive_packets(private_receiver_t *this)
 		message->destroy(message);
 		return JOB_REQUEUE_DIRECT;
 	}
-	if (message->get_request(message) &&
-		message->get_exchange_type(message) == IKE_SA_INIT)
-	{
-		if (this->initiator_only || drop_ike_sa_init(this, message))
-		{
-			message->destroy(message);
-			return JOB_REQUEUE_DIRECT;
-		}
-	}
-	if (message->get_exchange_type(message) == ID_PROT ||
-		message->get_exchange_type(message) == AGGRESSIVE)
-	{
-		id = message->get_ike_sa_id(message);
-		if (id->get_responder_spi(id) == 0 &&
-		   (this->initiator_only || drop_ike_sa_init(this, message)))
-		{
-			message->destroy(message);
-			return JOB_REQUEUE_DIRECT;
-		}
-	}
 
 	if (this->receive_delay)
 	{
@@ -608,12 +747,23 @@ METHOD(receiver_t, del_esp_cb, void,
 	this->esp_cb_mutex->unlock(this->esp_cb_mutex);
 }
 
+METHOD(receiver_t, get_drops, u_int,
+	private_receiver_t *this, receiver_drop_t reason)
+{
+	if (reason < RECEIVER_DROP_MAX)
+	{
+		return this->drops[reason];
+	}
+	return 0;
+}
+
 METHOD(receiver_t, destroy, void,
 	private_receiver_t *this)
 {
 	this->rng->destroy(this->rng);
 	this->hasher->destroy(this->hasher);
 	this->esp_cb_mutex->destroy(this->esp_cb_mutex);
+	free(this->buckets);
 	free(this);
 }
 
@@ -629,6 +779,7 @@ receiver_t *receiver_create()
 		.public = {
 			.add_esp_cb = _add_esp_cb,
 			.del_esp_cb = _del_esp_cb,
+			.get_drops = _get_drops,
 			.destroy = _destroy,
 		},
 		.esp_cb_mutex = mutex_create(MUTEX_TYPE_DEFAULT),
@@ -648,6 +799,12 @@ receiver_t *receiver_create()
 				"%s.init_limit_job_load", 0, charon->name);
 	this->init_limit_half_open = lib->settings->get_int(lib->settings,
 				"%s.init_limit_half_open", 0, charon->name);
+	this->init_limit_peer_rate = lib->settings->get_int(lib->settings,
+				"%s.init_limit_peer_rate", 0, charon->name);
+	if (this->init_limit_peer_rate)
+	{
+		this->buckets = calloc(RATE_BUCKETS, sizeof(bucket_t));
+	}
 	this->receive_delay = lib->settings->get_int(lib->settings,
 				"%s.receive_delay", 0, charon->name);
 	this->receive_delay_type = lib->settings->get_int(lib->settings,
@@ -663,14 +820,18 @@ receiver_t *receiver_create()
 	if (!this->hasher)
 	{
 		DBG1(DBG_NET, "creating cookie hasher failed, no hashers supported");
+		free(this->buckets);
 		free(this);
 		return NULL;
 	}
+	this->cookie_len = sizeof(u_int32_t) +
+					   this->hasher->get_hash_size(this->hasher);
 	this->rng = lib->crypto->create_rng(lib->crypto, RNG_STRONG);
 	if (!this->rng)
 	{
 		DBG1(DBG_NET, "creating cookie RNG failed, no RNG supported");
 		this->hasher->destroy(this->hasher);
+		free(this->buckets);
 		free(this);
 		return NULL;
 	}
@@ -681,6 +842,14 @@ receiver_t *receiver_create()
 		return NULL;
 	}
 	memcpy(this->secret_old, this->secret, SECRET_LENGTH);
+	if (this->buckets &&
+		!this->rng->get_bytes(this->rng, sizeof(this->bucket_key),
+							  (u_int8_t*)&this->bucket_key))
+	{
+		DBG1(DBG_NET, "creating rate limiting bucket key failed");
+		destroy(this);
+		return NULL;
+	}
 
 	lib->processor->queue_job(lib->processor,
 		(job_t*)callback_job_create_with_prio((callback_job_cb_t)receive_packets,
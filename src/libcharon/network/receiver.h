@@ -24,6 +24,7 @@
 #define RECEIVER_H_
 
 typedef struct receiver_t receiver_t;
+typedef enum receiver_drop_t receiver_drop_t;
 
 #include <library.h>
 #include <networking/host.h>
@@ -40,6 +41,31 @@ typedef struct receiver_t receiver_t;
  */
 typedef void (*receiver_esp_cb_t)(void *data, packet_t *packet);
 
+/**
+ * Reasons for dropping a request initiating a new IKE_SA.
+ */
+enum receiver_drop_t {
+	/** peer exceeded its rate of IKE_SA_INIT requests */
+	RECEIVER_DROP_RATE_LIMIT,
+	/** cookies required, answered with a COOKIE notify */
+	RECEIVER_DROP_COOKIE,
+	/** peer has too many half open IKE_SAs */
+	RECEIVER_DROP_BLOCKED,
+	/** global half open IKE_SA limit reached */
+	RECEIVER_DROP_HALF_OPEN,
+	/** job load limit reached */
+	RECEIVER_DROP_JOB_LOAD,
+	/** we act as initiator only */
+	RECEIVER_DROP_INITIATOR_ONLY,
+	/** number of drop reasons */
+	RECEIVER_DROP_MAX,
+};
+
+/**
+ * enum names for receiver_drop_t.
+ */
+extern enum_name_t *receiver_drop_names;
+
 /**
  * Receives packets from the socket and adds them to the job queue.
  *
@@ -62,6 +88,11 @@ typedef void (*receiver_esp_cb_t)(void *data, packet_t *packet);
  *
  * Further, the number of half-initiated IKE_SAs is limited per peer. This
  * makes it impossible for a peer to flood the server with its real IP address.
+ * Optionally, the rate of IKE_SA_INIT requests per peer address is limited
+ * using token buckets.
+ *
+ * All these checks are done on the raw packet header, before a message gets
+ * parsed or a job is queued. COOKIE notifies are built from the raw request.
  */
 struct receiver_t {
 
@@ -83,6 +114,14 @@ struct receiver_t {
 	 */
 	void (*del_esp_cb)(receiver_t *this, receiver_esp_cb_t callback);
 
+	/**
+	 * Get the number of dropped requests initiating a new IKE_SA.
+	 *
+	 * @param reason		reason the requests were dropped for
+	 * @return				number of requests dropped
+	 */
+	u_int (*get_drops)(receiver_t *this, receiver_drop_t reason);
+
 	/**
 	 * Destroys a receiver_t object.
 	 */
@@ -79,7 +79,7 @@ static void entry_destroy(entry_t *this)
  */
 static u_int hash(identification_t *key)
 {
-	return chunk_hash(key->get_encoding(key));
+	return key->hash(key, 0);
 }
 
 /**
@@ -15,12 +15,48 @@
 
 #include "ha_cache.h"
 
+#include "ha_segments.h"
+
 #include <collections/hashtable.h>
 #include <collections/linked_list.h>
+#include <threading/thread.h>
 #include <threading/mutex.h>
+#include <threading/condvar.h>
 #include <processing/jobs/callback_job.h>
 
+#define DEFAULT_BULK_SIZE 8192
+#define DEFAULT_BULK_WINDOW 8
+#define DEFAULT_BULK_TIMEOUT 5000
+#define DEFAULT_BULK_RETRIES 3
+
+/**
+ * Encoding overhead of a bulk entry in a batch, attribute type and length
+ */
+#define BULK_ENTRY_OVERHEAD (sizeof(u_int8_t) + sizeof(u_int16_t))
+
 typedef struct private_ha_cache_t private_ha_cache_t;
+typedef struct cache_ref_t cache_ref_t;
+
+/**
+ * Reference to the cache held by scheduled jobs, invalidated by destroy()
+ */
+struct cache_ref_t {
+
+	/**
+	 * Cache, NULL once destroyed
+	 */
+	private_ha_cache_t *cache;
+
+	/**
+	 * Lock held while a job uses the cache
+	 */
+	mutex_t *mutex;
+
+	/**
+	 * Held by the cache and each scheduled job
+	 */
+	refcount_t refs;
+};
 
 /**
  * Private data of an ha_cache_t object.
@@ -56,6 +92,66 @@ struct private_ha_cache_t {
 	 * Mutex to lock cache
 	 */
 	mutex_t *mutex;
+
+	/**
+	 * Condvar to wait for bulk resync acknowledgements
+	 */
+	condvar_t *condvar;
+
+	/**
+	 * Resync segments using bulk transfers instead of single messages
+	 */
+	bool bulk;
+
+	/**
+	 * Segments currently resynced using a bulk transfer
+	 */
+	segment_mask_t bulk_active;
+
+	/**
+	 * Segments to resync again once the active bulk transfer ended
+	 */
+	segment_mask_t bulk_restart;
+
+	/**
+	 * Segments having a retry of an aborted bulk transfer scheduled
+	 */
+	segment_mask_t bulk_retry;
+
+	/**
+	 * Number of aborted bulk transfers in a row, per segment
+	 */
+	u_int bulk_tries[SEGMENTS_MAX + 1];
+
+	/**
+	 * Number of acknowledged bulk batches, per segment
+	 */
+	u_int32_t bulk_acked[SEGMENTS_MAX + 1];
+
+	/**
+	 * Size in bytes of a bulk batch
+	 */
+	u_int bulk_size;
+
+	/**
+	 * Number of unacknowledged bulk batches in flight
+	 */
+	u_int bulk_window;
+
+	/**
+	 * Timeout in ms to wait for bulk acknowledgements
+	 */
+	u_int bulk_timeout;
+
+	/**
+	 * Number of retries of an aborted bulk transfer
+	 */
+	u_int bulk_retries;
+
+	/**
+	 * Reference held by scheduled jobs
+	 */
+	cache_ref_t *ref;
 };
 
 /**
@@ -291,16 +387,16 @@ static void rekey_segment(private_ha_cache_t *this, u_int segment)
 	list->destroy(list);
 }
 
-METHOD(ha_cache_t, resync, void,
-	private_ha_cache_t *this, u_int segment)
+/**
+ * Resync a segment by pushing all cached messages one by one
+ */
+static void resync_messages(private_ha_cache_t *this, u_int segment)
 {
 	enumerator_t *enumerator, *updates;
 	ike_sa_t *ike_sa;
 	entry_t *entry;
 	ha_message_t *message;
 
-	DBG1(DBG_CFG, "resyncing HA segment %d", segment);
-
 	this->mutex->lock(this->mutex);
 	enumerator = this->cache->create_enumerator(this->cache);
 	while (enumerator->enumerate(enumerator, &ike_sa, &entry))
@@ -335,29 +431,406 @@ METHOD(ha_cache_t, resync, void,
 }
 
 /**
- * Request a resync of all segments
+ * Data for a bulk resync job
  */
-static job_requeue_t request_resync(private_ha_cache_t *this)
+typedef struct {
+	/** cache we resync from */
+	private_ha_cache_t *this;
+	/** segment to resync */
+	u_int segment;
+	/** snapshot of cached message encodings, as chunk_t* */
+	linked_list_t *entries;
+	/** has the job released the segment already? */
+	bool done;
+} bulk_t;
+
+static void resync_bulk(private_ha_cache_t *this, u_int segment);
+
+/**
+ * Destroy a bulk resync job
+ */
+static void bulk_destroy(bulk_t *bulk)
 {
-	ha_message_t *message;
-	int i;
+	private_ha_cache_t *this = bulk->this;
+	chunk_t *chunk;
+
+	while (bulk->entries->remove_first(bulk->entries,
+									   (void**)&chunk) == SUCCESS)
+	{
+		chunk_free(chunk);
+		free(chunk);
+	}
+	bulk->entries->destroy(bulk->entries);
+
+	if (!bulk->done)
+	{	/* job got canceled */
+		this->mutex->lock(this->mutex);
+		this->bulk_active &= ~SEGMENTS_BIT(bulk->segment);
+		this->bulk_restart &= ~SEGMENTS_BIT(bulk->segment);
+		this->mutex->unlock(this->mutex);
+	}
+	free(bulk);
+}
+
+/**
+ * Add a copy of a cached message to a bulk snapshot
+ */
+static void snapshot(bulk_t *bulk, ha_message_t *message)
+{
+	chunk_t *chunk;
+
+	INIT(chunk);
+	*chunk = chunk_clone(message->get_encoding(message));
+	bulk->entries->insert_last(bulk->entries, chunk);
+}
+
+/**
+ * Wait for window space and push a bulk batch, FALSE if the transfer has to
+ * be aborted
+ */
+static bool push_batch(private_ha_cache_t *this, u_int segment,
+					   ha_message_t *message, u_int32_t seq)
+{
+	bool timeout = FALSE, restart, oldstate;
+
+	this->mutex->lock(this->mutex);
+	thread_cleanup_push((void*)this->mutex->unlock, this->mutex);
+	oldstate = thread_cancelability(TRUE);
+	while (!(restart = this->bulk_restart & SEGMENTS_BIT(segment)) &&
+		   seq - this->bulk_acked[segment] >= this->bulk_window && !timeout)
+	{
+		timeout = this->condvar->timed_wait(this->condvar, this->mutex,
+											this->bulk_timeout);
+	}
+	thread_cancelability(oldstate);
+	thread_cleanup_pop(TRUE);
+
+	if (restart)
+	{
+		DBG1(DBG_CFG, "HA bulk resync of segment %d requested again at "
+			 "batch %u", segment, seq);
+	}
+	else if (timeout)
+	{
+		DBG1(DBG_CFG, "HA bulk resync of segment %d timed out at batch %u",
+			 segment, seq);
+	}
+	else
+	{
+		this->socket->push(this->socket, message);
+	}
+	message->destroy(message);
+	return !timeout && !restart;
+}
+
+/**
+ * Get a reference to the cache for a scheduled job
+ */
+static cache_ref_t *ref_cache(private_ha_cache_t *this)
+{
+	ref_get(&this->ref->refs);
+	return this->ref;
+}
+
+/**
+ * Release a reference to the cache
+ */
+static void unref_cache(cache_ref_t *ref)
+{
+	if (ref_put(&ref->refs))
+	{
+		ref->mutex->destroy(ref->mutex);
+		free(ref);
+	}
+}
+
+/**
+ * Data for a job retrying an aborted bulk resync
+ */
+typedef struct {
+	/** reference to the cache we resync from */
+	cache_ref_t *ref;
+	/** segment to resync */
+	u_int segment;
+} retry_t;
+
+/**
+ * Destroy a retry job
+ */
+static void retry_destroy(retry_t *retry)
+{
+	unref_cache(retry->ref);
+	free(retry);
+}
+
+/**
+ * Retry an aborted bulk resync, if not superseded by a resync request
+ */
+static job_requeue_t retry_bulk(retry_t *retry)
+{
+	private_ha_cache_t *this;
+	bool pending = FALSE;
 
-	DBG1(DBG_CFG, "requesting HA resynchronization");
+	retry->ref->mutex->lock(retry->ref->mutex);
+	this = retry->ref->cache;
+	if (this)
+	{
+		this->mutex->lock(this->mutex);
+		pending = this->bulk_retry & SEGMENTS_BIT(retry->segment);
+		this->bulk_retry &= ~SEGMENTS_BIT(retry->segment);
+		this->mutex->unlock(this->mutex);
+		if (pending)
+		{
+			resync_bulk(this, retry->segment);
+		}
+	}
+	retry->ref->mutex->unlock(retry->ref->mutex);
+	return JOB_REQUEUE_NONE;
+}
+
+/**
+ * Stream the snapshot of a segment in batches with flow control
+ */
+static job_requeue_t send_bulk(bulk_t *bulk)
+{
+	private_ha_cache_t *this = bulk->this;
+	ha_message_t *message = NULL;
+	u_int32_t seq = 0, count = 0, checksum = 0;
+	chunk_t *chunk;
+	retry_t *retry;
+	bool ok = TRUE, restart;
+	u_int tries;
+
+	while (ok && bulk->entries->remove_first(bulk->entries,
+											 (void**)&chunk) == SUCCESS)
+	{
+		if (message && message->get_encoding(message).len +
+					BULK_ENTRY_OVERHEAD + chunk->len > this->bulk_size)
+		{
+			ok = push_batch(this, bulk->segment, message, seq++);
+			message = NULL;
+		}
+		if (ok)
+		{
+			if (!message)
+			{
+				message = ha_message_create(HA_BULK_DATA);
+				message->add_attribute(message, HA_SEGMENT, bulk->segment);
+				message->add_attribute(message, HA_BULK_SEQ, seq);
+			}
+			message->add_attribute(message, HA_BULK_ENTRY, *chunk);
+			checksum = chunk_hash_inc(*chunk, checksum);
+			count++;
+		}
+		chunk_free(chunk);
+		free(chunk);
+	}
+	if (ok && message)
+	{
+		ok = push_batch(this, bulk->segment, message, seq++);
+	}
 
-	message = ha_message_create(HA_RESYNC);
-	for (i = 1; i <= this->count; i++)
+	/* a BULK_END without count and checksum aborts the transfer */
+	message = ha_message_create(HA_BULK_END);
+	message->add_attribute(message, HA_SEGMENT, bulk->segment);
+	message->add_attribute(message, HA_BULK_SEQ, seq);
+	if (ok)
 	{
-		message->add_attribute(message, HA_SEGMENT, i);
+		message->add_attribute(message, HA_BULK_COUNT, count);
+		message->add_attribute(message, HA_BULK_CHECKSUM, checksum);
 	}
 	this->socket->push(this->socket, message);
 	message->destroy(message);
+
+	this->mutex->lock(this->mutex);
+	restart = this->bulk_restart & SEGMENTS_BIT(bulk->segment);
+	this->bulk_restart &= ~SEGMENTS_BIT(bulk->segment);
+	this->bulk_active &= ~SEGMENTS_BIT(bulk->segment);
+	tries = this->bulk_tries[bulk->segment] = ok || restart ? 0 :
+										this->bulk_tries[bulk->segment] + 1;
+	if (tries && tries <= this->bulk_retries)
+	{
+		this->bulk_retry |= SEGMENTS_BIT(bulk->segment);
+	}
+	else
+	{
+		this->bulk_tries[bulk->segment] = 0;
+	}
+	bulk->done = TRUE;
+	this->mutex->unlock(this->mutex);
+
+	if (ok)
+	{
+		DBG1(DBG_CFG, "HA bulk resync of segment %d sent %u entries in %u "
+			 "batches", bulk->segment, count, seq);
+		rekey_segment(this, bulk->segment);
+	}
+	if (restart)
+	{
+		resync_bulk(this, bulk->segment);
+	}
+	else if (tries > this->bulk_retries)
+	{
+		DBG1(DBG_CFG, "HA bulk resync of segment %d aborted %u times, "
+			 "resyncing with single messages", bulk->segment, tries);
+		resync_messages(this, bulk->segment);
+	}
+	else if (tries)
+	{	/* back off exponentially */
+		DBG1(DBG_CFG, "HA bulk resync of segment %d aborted, retrying in "
+			 "%u ms", bulk->segment, this->bulk_timeout << (tries - 1));
+		INIT(retry,
+			.ref = ref_cache(this),
+			.segment = bulk->segment,
+		);
+		lib->scheduler->schedule_job_ms(lib->scheduler, (job_t*)
+			callback_job_create_with_prio((callback_job_cb_t)retry_bulk,
+						retry, (void*)retry_destroy, NULL, JOB_PRIO_CRITICAL),
+			this->bulk_timeout << (tries - 1));
+	}
+	return JOB_REQUEUE_NONE;
+}
+
+/**
+ * Resync a segment by streaming a snapshot of cached messages in batches
+ */
+static void resync_bulk(private_ha_cache_t *this, u_int segment)
+{
+	enumerator_t *enumerator, *updates;
+	ike_sa_t *ike_sa;
+	entry_t *entry;
+	ha_message_t *message;
+	bulk_t *bulk;
+
+	INIT(bulk,
+		.this = this,
+		.segment = segment,
+		.entries = linked_list_create(),
+	);
+
+	this->mutex->lock(this->mutex);
+	if (this->bulk_active & SEGMENTS_BIT(segment))
+	{	/* the peer might have missed a batch, restart the transfer */
+		this->bulk_restart |= SEGMENTS_BIT(segment);
+		this->condvar->broadcast(this->condvar);
+		this->mutex->unlock(this->mutex);
+		DBG1(DBG_CFG, "HA bulk resync of segment %d in progress, restarting",
+			 segment);
+		bulk->entries->destroy(bulk->entries);
+		free(bulk);
+		return;
+	}
+	this->bulk_active |= SEGMENTS_BIT(segment);
+	this->bulk_acked[segment] = 0;
+
+	enumerator = this->cache->create_enumerator(this->cache);
+	while (enumerator->enumerate(enumerator, &ike_sa, &entry))
+	{
+		if (entry->segment == segment)
+		{
+			snapshot(bulk, entry->add);
+			updates = entry->updates->create_enumerator(entry->updates);
+			while (updates->enumerate(updates, &message))
+			{
+				snapshot(bulk, message);
+			}
+			updates->destroy(updates);
+			if (entry->midi)
+			{
+				snapshot(bulk, entry->midi);
+			}
+			if (entry->midr)
+			{
+				snapshot(bulk, entry->midr);
+			}
+			if (entry->iv)
+			{
+				snapshot(bulk, entry->iv);
+			}
+		}
+	}
+	enumerator->destroy(enumerator);
+	this->mutex->unlock(this->mutex);
+
+	lib->processor->queue_job(lib->processor,
+		(job_t*)callback_job_create_with_prio((callback_job_cb_t)send_bulk,
+			bulk, (void*)bulk_destroy, (callback_job_cancel_t)return_false,
+			JOB_PRIO_CRITICAL));
+}
+
+METHOD(ha_cache_t, resync, void,
+	private_ha_cache_t *this, u_int segment)
+{
+	DBG1(DBG_CFG, "resyncing HA segment %d", segment);
+
+	if (this->bulk && segment > 0 && segment <= SEGMENTS_MAX)
+	{
+		this->mutex->lock(this->mutex);
+		/* supersedes a scheduled retry */
+		this->bulk_retry &= ~SEGMENTS_BIT(segment);
+		this->bulk_tries[segment] = 0;
+		this->mutex->unlock(this->mutex);
+		resync_bulk(this, segment);
+	}
+	else
+	{
+		resync_messages(this, segment);
+	}
+}
+
+METHOD(ha_cache_t, bulk_ack, void,
+	private_ha_cache_t *this, u_int segment, u_int32_t seq)
+{
+	if (segment == 0 || segment > SEGMENTS_MAX)
+	{
+		return;
+	}
+	this->mutex->lock(this->mutex);
+	if ((this->bulk_active & SEGMENTS_BIT(segment)) &&
+		seq + 1 > this->bulk_acked[segment])
+	{
+		this->bulk_acked[segment] = seq + 1;
+		this->condvar->broadcast(this->condvar);
+	}
+	this->mutex->unlock(this->mutex);
+}
+
+/**
+ * Request a resync of all segments
+ */
+static job_requeue_t request_resync(cache_ref_t *ref)
+{
+	private_ha_cache_t *this;
+	ha_message_t *message;
+	int i;
+
+	ref->mutex->lock(ref->mutex);
+	this = ref->cache;
+	if (this)
+	{
+		DBG1(DBG_CFG, "requesting HA resynchronization");
+
+		message = ha_message_create(HA_RESYNC);
+		for (i = 1; i <= this->count; i++)
+		{
+			message->add_attribute(message, HA_SEGMENT, i);
+		}
+		this->socket->push(this->socket, message);
+		message->destroy(message);
+	}
+	ref->mutex->unlock(ref->mutex);
 	return JOB_REQUEUE_NONE;
 }
 
 METHOD(ha_cache_t, destroy, void,
 	private_ha_cache_t *this)
 {
+	this->ref->mutex->lock(this->ref->mutex);
+	this->ref->cache = NULL;
+	this->ref->mutex->unlock(this->ref->mutex);
+	unref_cache(this->ref);
 	this->cache->destroy(this->cache);
+	this->condvar->destroy(this->condvar);
 	this->mutex->destroy(this->mutex);
 	free(this);
 }
@@ -366,7 +839,7 @@ METHOD(ha_cache_t, destroy, void,
  * See header
  */
 ha_cache_t *ha_cache_create(ha_kernel_t *kernel, ha_socket_t *socket,
-							bool sync, u_int count)
+							bool sync, bool bulk, u_int count)
 {
 	private_ha_cache_t *this;
 
@@ -375,6 +848,7 @@ ha_cache_t *ha_cache_create(ha_kernel_t *kernel, ha_socket_t *socket,
 			.cache = _cache,
 			.delete = _delete_,
 			.resync = _resync,
+			.bulk_ack = _bulk_ack,
 			.destroy = _destroy,
 		},
 		.count = count,
@@ -382,6 +856,25 @@ ha_cache_t *ha_cache_create(ha_kernel_t *kernel, ha_socket_t *socket,
 		.socket = socket,
 		.cache = hashtable_create(hash, equals, 8),
 		.mutex = mutex_create(MUTEX_TYPE_DEFAULT),
+		.condvar = condvar_create(CONDVAR_TYPE_DEFAULT),
+		.bulk = bulk,
+		.bulk_size = min(HA_SOCKET_MAX_MESSAGE, lib->settings->get_int(
+				lib->settings, "%s.plugins.ha.bulk_size", DEFAULT_BULK_SIZE,
+				charon->name)),
+		.bulk_window = max(1, lib->settings->get_int(lib->settings,
+				"%s.plugins.ha.bulk_window", DEFAULT_BULK_WINDOW,
+				charon->name)),
+		.bulk_timeout = lib->settings->get_int(lib->settings,
+				"%s.plugins.ha.bulk_timeout", DEFAULT_BULK_TIMEOUT,
+				charon->name),
+		.bulk_retries = lib->settings->get_int(lib->settings,
+				"%s.plugins.ha.bulk_retries", DEFAULT_BULK_RETRIES,
+				charon->name),
+	);
+	INIT(this->ref,
+		.cache = this,
+		.mutex = mutex_create(MUTEX_TYPE_DEFAULT),
+		.refs = 1,
 	);
 
 	if (sync)
@@ -389,7 +882,8 @@ ha_cache_t *ha_cache_create(ha_kernel_t *kernel, ha_socket_t *socket,
 		/* request a resync as soon as we are up */
 		lib->scheduler->schedule_job(lib->scheduler, (job_t*)
 			callback_job_create_with_prio((callback_job_cb_t)request_resync,
-									this, NULL, NULL, JOB_PRIO_CRITICAL), 1);
+					ref_cache(this), (void*)unref_cache, NULL,
+					JOB_PRIO_CRITICAL), 1);
 	}
 	return &this->public;
 }
@@ -58,6 +58,14 @@ struct ha_cache_t {
 	 */
 	void (*resync)(ha_cache_t *this, u_int segment);
 
+	/**
+	 * Process the acknowledgement of a bulk resync batch.
+	 *
+	 * @param segment		segment the batch belongs to
+	 * @param seq			sequence number of the acknowledged batch
+	 */
+	void (*bulk_ack)(ha_cache_t *this, u_int segment, u_int32_t seq);
+
 	/**
 	 * Destroy a ha_cache_t.
 	 */
@@ -70,9 +78,10 @@ struct ha_cache_t {
  * @param kernel		kernel helper
  * @param socket		socket to send resync messages
  * @param resync 		request a resync during startup?
+ * @param bulk			resync segments using bulk transfers
  * @param count			total number of segments
  */
 ha_cache_t *ha_cache_create(ha_kernel_t *kernel, ha_socket_t *socket,
-							bool resync, u_int count);
+							bool resync, bool bulk, u_int count);
 
 #endif /** HA_CACHE_H_ @}*/
@@ -58,6 +58,20 @@ struct private_ha_dispatcher_t {
 	 * HA enabled pool
 	 */
 	ha_attribute_t *attr;
+
+	/**
+	 * State of bulk resyncs received, per segment
+	 */
+	struct {
+		/** sequence number of the next expected batch */
+		u_int32_t seq;
+		/** number of entries received */
+		u_int32_t count;
+		/** checksum over all entries received */
+		u_int32_t checksum;
+		/** did we miss a batch and requested a resync? */
+		bool failed;
+	} bulk[SEGMENTS_MAX + 1];
 };
 
 /**
@@ -981,14 +995,220 @@ static void process_resync(private_ha_dispatcher_t *this,
 }
 
 /**
- * Dispatcher job function
+ * Request a resync of a single segment
  */
-static job_requeue_t dispatch(private_ha_dispatcher_t *this)
+static void request_resync(private_ha_dispatcher_t *this, u_int segment)
 {
 	ha_message_t *message;
+
+	message = ha_message_create(HA_RESYNC);
+	message->add_attribute(message, HA_SEGMENT, segment);
+	this->socket->push(this->socket, message);
+	message->destroy(message);
+}
+
+static void process_message(private_ha_dispatcher_t *this,
+							ha_message_t *message, bool bulk);
+
+/**
+ * Process messages of type BULK_DATA
+ */
+static void process_bulk_data(private_ha_dispatcher_t *this,
+							  ha_message_t *message)
+{
+	ha_message_attribute_t attribute;
+	ha_message_value_t value;
+	enumerator_t *enumerator;
+	ha_message_t *entry;
+	u_int segment = 0;
+	u_int32_t seq = 0;
+	bool ok = TRUE, resync = FALSE;
+
+	enumerator = message->create_attribute_enumerator(message);
+	while (ok && enumerator->enumerate(enumerator, &attribute, &value))
+	{
+		switch (attribute)
+		{
+			case HA_SEGMENT:
+				segment = value.u16;
+				if (segment == 0 || segment > SEGMENTS_MAX)
+				{
+					DBG1(DBG_CFG, "received HA bulk batch for invalid "
+						 "segment %d", segment);
+					ok = FALSE;
+				}
+				break;
+			case HA_BULK_SEQ:
+				seq = value.u32;
+				if (seq == 0)
+				{	/* a new bulk transfer starts */
+					memset(&this->bulk[segment], 0,
+						   sizeof(this->bulk[segment]));
+				}
+				else if (this->bulk[segment].failed)
+				{
+					DBG2(DBG_CFG, "ignoring HA bulk batch %u for segment %d, "
+						 "resync requested", seq, segment);
+					ok = FALSE;
+				}
+				else if (seq != this->bulk[segment].seq)
+				{
+					DBG1(DBG_CFG, "received HA bulk batch %u for segment %d, "
+						 "expected %u, requesting resync", seq, segment,
+						 this->bulk[segment].seq);
+					this->bulk[segment].failed = TRUE;
+					resync = TRUE;
+					ok = FALSE;
+				}
+				break;
+			case HA_BULK_ENTRY:
+				if (!segment)
+				{
+					ok = FALSE;
+					break;
+				}
+				this->bulk[segment].checksum = chunk_hash_inc(value.chunk,
+											this->bulk[segment].checksum);
+				this->bulk[segment].count++;
+				entry = ha_message_parse(value.chunk);
+				if (entry)
+				{
+					process_message(this, entry, TRUE);
+				}
+				break;
+			default:
+				break;
+		}
+	}
+	enumerator->destroy(enumerator);
+	message->destroy(message);
+
+	if (resync)
+	{
+		request_resync(this, segment);
+	}
+	if (ok && segment)
+	{
+		this->bulk[segment].seq++;
+		message = ha_message_create(HA_BULK_ACK);
+		message->add_attribute(message, HA_SEGMENT, segment);
+		message->add_attribute(message, HA_BULK_SEQ, seq);
+		this->socket->push(this->socket, message);
+		message->destroy(message);
+	}
+}
+
+/**
+ * Process messages of type BULK_END
+ */
+static void process_bulk_end(private_ha_dispatcher_t *this,
+							 ha_message_t *message)
+{
+	ha_message_attribute_t attribute;
+	ha_message_value_t value;
+	enumerator_t *enumerator;
+	u_int segment = 0;
+	u_int32_t seq = 0, count = 0, checksum = 0;
+	bool aborted = TRUE;
+
+	enumerator = message->create_attribute_enumerator(message);
+	while (enumerator->enumerate(enumerator, &attribute, &value))
+	{
+		switch (attribute)
+		{
+			case HA_SEGMENT:
+				segment = value.u16;
+				break;
+			case HA_BULK_SEQ:
+				seq = value.u32;
+				break;
+			case HA_BULK_COUNT:
+				count = value.u32;
+				aborted = FALSE;
+				break;
+			case HA_BULK_CHECKSUM:
+				checksum = value.u32;
+				break;
+			default:
+				break;
+		}
+	}
+	enumerator->destroy(enumerator);
+	message->destroy(message);
+
+	if (segment == 0 || segment > SEGMENTS_MAX)
+	{
+		return;
+	}
+	if (aborted)
+	{	/* the peer retries or restarts the transfer on its own */
+		DBG1(DBG_CFG, "HA bulk resync of segment %d aborted by peer after "
+			 "%u batches", segment, seq);
+	}
+	else if (this->bulk[segment].failed)
+	{
+		DBG1(DBG_CFG, "HA bulk resync of segment %d incomplete, resync "
+			 "already requested", segment);
+	}
+	else if (seq != this->bulk[segment].seq ||
+		count != this->bulk[segment].count ||
+		checksum != this->bulk[segment].checksum)
+	{
+		DBG1(DBG_CFG, "HA bulk resync of segment %d incomplete (%u/%u "
+			 "entries, checksum %smatching), requesting resync", segment,
+			 this->bulk[segment].count, count,
+			 checksum == this->bulk[segment].checksum ? "" : "not ");
+		request_resync(this, segment);
+	}
+	else
+	{
+		DBG1(DBG_CFG, "HA bulk resync of segment %d completed, %u entries",
+			 segment, count);
+	}
+	memset(&this->bulk[segment], 0, sizeof(this->bulk[segment]));
+}
+
+/**
+ * Process messages of type BULK_ACK
+ */
+static void process_bulk_ack(private_ha_dispatcher_t *this,
+							 ha_message_t *message)
+{
+	ha_message_attribute_t attribute;
+	ha_message_value_t value;
+	enumerator_t *enumerator;
+	u_int segment = 0;
+	u_int32_t seq = 0;
+
+	enumerator = message->create_attribute_enumerator(message);
+	while (enumerator->enumerate(enumerator, &attribute, &value))
+	{
+		switch (attribute)
+		{
+			case HA_SEGMENT:
+				segment = value.u16;
+				break;
+			case HA_BULK_SEQ:
+				seq = value.u32;
+				break;
+			default:
+				break;
+		}
+	}
+	enumerator->destroy(enumerator);
+	message->destroy(message);
+
+	this->cache->bulk_ack(this->cache, segment, seq);
+}
+
+/**
+ * Process a received message, or an entry contained in a bulk batch
+ */
+static void process_message(private_ha_dispatcher_t *this,
+							ha_message_t *message, bool bulk)
+{
 	ha_message_type_t type;
 
-	message = this->socket->pull(this->socket);
 	type = message->get_type(message);
 	if (type != HA_STATUS)
 	{
@@ -999,19 +1219,31 @@ static job_requeue_t dispatch(private_ha_dispatcher_t *this)
 	{
 		case HA_IKE_ADD:
 			process_ike_add(this, message);
-			break;
+			return;
 		case HA_IKE_UPDATE:
 			process_ike_update(this, message);
-			break;
+			return;
 		case HA_IKE_MID_INITIATOR:
 			process_ike_mid(this, message, TRUE);
-			break;
+			return;
 		case HA_IKE_MID_RESPONDER:
 			process_ike_mid(this, message, FALSE);
-			break;
+			return;
 		case HA_IKE_IV:
 			process_ike_iv(this, message);
+			return;
+		default:
 			break;
+	}
+	if (bulk)
+	{
+		DBG1(DBG_CFG, "received HA %N message in bulk batch, ignored",
+			 ha_message_type_names, type);
+		message->destroy(message);
+		return;
+	}
+	switch (type)
+	{
 		case HA_IKE_DELETE:
 			process_ike_delete(this, message);
 			break;
@@ -1033,11 +1265,28 @@ static job_requeue_t dispatch(private_ha_dispatcher_t *this)
 		case HA_RESYNC:
 			process_resync(this, message);
 			break;
+		case HA_BULK_DATA:
+			process_bulk_data(this, message);
+			break;
+		case HA_BULK_END:
+			process_bulk_end(this, message);
+			break;
+		case HA_BULK_ACK:
+			process_bulk_ack(this, message);
+			break;
 		default:
 			DBG1(DBG_CFG, "received unknown HA message type %d", type);
 			message->destroy(message);
 			break;
 	}
+}
+
+/**
+ * Dispatcher job function
+ */
+static job_requeue_t dispatch(private_ha_dispatcher_t *this)
+{
+	process_message(this, this->socket->pull(this->socket), FALSE);
 	return JOB_REQUEUE_DIRECT;
 }
 
@@ -46,7 +46,7 @@ struct private_ha_message_t {
 	chunk_t buf;
 };
 
-ENUM(ha_message_type_names, HA_IKE_ADD, HA_IKE_IV,
+ENUM(ha_message_type_names, HA_IKE_ADD, HA_BULK_ACK,
 	"IKE_ADD",
 	"IKE_UPDATE",
 	"IKE_MID_INITIATOR",
@@ -59,6 +59,9 @@ ENUM(ha_message_type_names, HA_IKE_ADD, HA_IKE_IV,
 	"STATUS",
 	"RESYNC",
 	"IKE_IV",
+	"BULK_DATA",
+	"BULK_END",
+	"BULK_ACK",
 );
 
 typedef struct ike_sa_id_encoding_t ike_sa_id_encoding_t;
@@ -254,6 +257,9 @@ METHOD(ha_message_t, add_attribute, void,
 		case HA_INBOUND_SPI:
 		case HA_OUTBOUND_SPI:
 		case HA_MID:
+		case HA_BULK_SEQ:
+		case HA_BULK_COUNT:
+		case HA_BULK_CHECKSUM:
 		{
 			u_int32_t val;
 
@@ -272,6 +278,7 @@ METHOD(ha_message_t, add_attribute, void,
 		case HA_PSK:
 		case HA_IV:
 		case HA_OLD_SKD:
+		case HA_BULK_ENTRY:
 		{
 			chunk_t chunk;
 
@@ -475,6 +482,9 @@ METHOD(enumerator_t, attribute_enumerate, bool,
 		case HA_INBOUND_SPI:
 		case HA_OUTBOUND_SPI:
 		case HA_MID:
+		case HA_BULK_SEQ:
+		case HA_BULK_COUNT:
+		case HA_BULK_CHECKSUM:
 		{
 			if (this->buf.len < sizeof(u_int32_t))
 			{
@@ -494,6 +504,7 @@ METHOD(enumerator_t, attribute_enumerate, bool,
 		case HA_PSK:
 		case HA_IV:
 		case HA_OLD_SKD:
+		case HA_BULK_ENTRY:
 		{
 			size_t len;
 
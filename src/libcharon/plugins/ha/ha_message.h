@@ -30,7 +30,7 @@
 /**
  * Protocol version of this implementation
  */
-#define HA_MESSAGE_VERSION 3
+#define HA_MESSAGE_VERSION 4
 
 typedef struct ha_message_t ha_message_t;
 typedef enum ha_message_type_t ha_message_type_t;
@@ -65,6 +65,12 @@ enum ha_message_type_t {
 	HA_RESYNC,
 	/** IV synchronization for IKEv1 Main/Aggressive mode */
 	HA_IKE_IV,
+	/** batch of cached messages of a segment during bulk resync */
+	HA_BULK_DATA,
+	/** end of a bulk resync, with entry count and checksum if not aborted */
+	HA_BULK_END,
+	/** acknowledgement of a received bulk resync batch */
+	HA_BULK_ACK,
 };
 
 /**
@@ -154,6 +160,14 @@ enum ha_message_attribute_t {
 	HA_PSK,
 	/** chunk_t, IV for next IKEv1 message */
 	HA_IV,
+	/** u_int32_t, sequence number of a bulk resync batch */
+	HA_BULK_SEQ,
+	/** u_int32_t, number of entries sent during a bulk resync */
+	HA_BULK_COUNT,
+	/** u_int32_t, checksum over all entries sent during a bulk resync */
+	HA_BULK_CHECKSUM,
+	/** chunk_t, encoded message contained in a bulk resync batch */
+	HA_BULK_ENTRY,
 };
 
 /**
@@ -125,7 +125,7 @@ plugin_t *ha_plugin_create()
 	private_ha_plugin_t *this;
 	char *local, *remote, *secret;
 	u_int count;
-	bool fifo, monitor, resync;
+	bool fifo, monitor, resync, bulk;
 
 	local = lib->settings->get_str(lib->settings,
 							"%s.plugins.ha.local", NULL, charon->name);
@@ -139,6 +139,8 @@ plugin_t *ha_plugin_create()
 							"%s.plugins.ha.monitor", TRUE, charon->name);
 	resync = lib->settings->get_bool(lib->settings,
 							"%s.plugins.ha.resync", TRUE, charon->name);
+	bulk = lib->settings->get_bool(lib->settings,
+							"%s.plugins.ha.bulk_resync", TRUE, charon->name);
 	count = min(SEGMENTS_MAX, lib->settings->get_int(lib->settings,
 							"%s.plugins.ha.segment_count", 1, charon->name));
 	if (!local || !remote)
@@ -161,7 +163,7 @@ plugin_t *ha_plugin_create()
 	{
 		this->tunnel = ha_tunnel_create(local, remote, secret);
 	}
-	this->socket = ha_socket_create(local, remote);
+	this->socket = ha_socket_create(local, remote, count);
 	if (!this->socket)
 	{
 		DESTROY_IF(this->tunnel);
@@ -171,7 +173,8 @@ plugin_t *ha_plugin_create()
 	this->kernel = ha_kernel_create(count);
 	this->segments = ha_segments_create(this->socket, this->kernel, this->tunnel,
 							count, strcmp(local, remote) > 0, monitor);
-	this->cache = ha_cache_create(this->kernel, this->socket, resync, count);
+	this->cache = ha_cache_create(this->kernel, this->socket, resync, bulk,
+								 count);
 	if (fifo)
 	{
 		this->ctl = ha_ctl_create(this->segments, this->cache);
@@ -18,15 +18,82 @@
 
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/time.h>
 #include <errno.h>
 #include <unistd.h>
 
 #include <daemon.h>
 #include <networking/host.h>
 #include <threading/thread.h>
+#include <threading/mutex.h>
+#include <threading/condvar.h>
+#include <collections/linked_list.h>
+#include <collections/hashtable.h>
 #include <processing/jobs/callback_job.h>
 
+/**
+ * Default maximum size of a frame containing batched messages
+ */
+#define DEFAULT_BATCH_SIZE 1400
+
+/**
+ * Default number of unacknowledged frames in flight
+ */
+#define DEFAULT_WINDOW 32
+
+/**
+ * Default retransmission timeout in ms
+ */
+#define DEFAULT_RETRANSMIT_TIMEOUT 500
+
+/**
+ * Default number of retransmissions before unacknowledged frames get dropped
+ */
+#define DEFAULT_RETRANSMIT_TRIES 5
+
+/**
+ * Maximum size of a received frame
+ */
+#define MAX_FRAME_SIZE 65536
+
+/**
+ * Maximum size of a frame we send, the maximum UDP payload
+ */
+#define MAX_DATAGRAM_SIZE 65507
+
 typedef struct private_ha_socket_t private_ha_socket_t;
+typedef struct frame_header_t frame_header_t;
+typedef enum frame_type_t frame_type_t;
+
+/**
+ * Type of a frame
+ */
+enum frame_type_t {
+	/** frame containing batched messages, carries an acknowledgement */
+	FRAME_DATA = 1,
+	/** acknowledgement only */
+	FRAME_ACK = 2,
+};
+
+/**
+ * Header of a frame, followed by count length-prefixed message encodings
+ */
+struct frame_header_t {
+	/** protocol version, HA_MESSAGE_VERSION */
+	u_int8_t version;
+	/** type of the frame, frame_type_t */
+	u_int8_t type;
+	/** number of messages contained in this frame */
+	u_int16_t count;
+	/** random session identifier of the sending daemon */
+	u_int32_t session;
+	/** sequence number of this frame, unused in FRAME_ACK */
+	u_int32_t seq;
+	/** session identifier of the peer acknowledged frames belong to */
+	u_int32_t ack_session;
+	/** sequence number of the last frame received from peer in order */
+	u_int32_t ack;
+} __attribute__((packed));
 
 /**
  * Private data of an ha_socket_t object.
@@ -52,65 +119,650 @@ struct private_ha_socket_t {
 	 * remote host to receive/send to
 	 */
 	host_t *remote;
+
+	/**
+	 * Mutex to lock transmit/receive state
+	 */
+	mutex_t *mutex;
+
+	/**
+	 * Condvar to signal the sending thread
+	 */
+	condvar_t *condvar;
+
+	/**
+	 * Messages waiting for transmission, as entry_t
+	 */
+	linked_list_t *queue;
+
+	/**
+	 * Queued messages that get superseded by newer ones, entry_t => entry_t
+	 */
+	hashtable_t *mergeable;
+
+	/**
+	 * Sent but not yet acknowledged frames, as frame_t
+	 */
+	linked_list_t *unacked;
+
+	/**
+	 * Received messages not yet pulled, as ha_message_t
+	 */
+	linked_list_t *received;
+
+	/**
+	 * Buffer to receive frames
+	 */
+	chunk_t buf;
+
+	/**
+	 * Our session identifier
+	 */
+	u_int32_t session;
+
+	/**
+	 * Sequence number of the last frame we sent
+	 */
+	u_int32_t seq;
+
+	/**
+	 * Session identifier of peer, if known
+	 */
+	u_int32_t peer_session;
+
+	/**
+	 * Sequence number of the last frame received in order from peer
+	 */
+	u_int32_t peer_seq;
+
+	/**
+	 * Have we seen a session from peer?
+	 */
+	bool peer_known;
+
+	/**
+	 * Do we have to acknowledge received frames?
+	 */
+	bool ack_pending;
+
+	/**
+	 * Time the oldest unacknowledged frame gets retransmitted
+	 */
+	timeval_t retransmit;
+
+	/**
+	 * Number of retransmissions without any acknowledgement progress
+	 */
+	u_int tries;
+
+	/**
+	 * Maximum size of a frame
+	 */
+	u_int batch_size;
+
+	/**
+	 * Maximum number of unacknowledged frames
+	 */
+	u_int window;
+
+	/**
+	 * Retransmission timeout in ms
+	 */
+	u_int timeout;
+
+	/**
+	 * Maximum number of retransmissions
+	 */
+	u_int max_tries;
+
+	/**
+	 * Number of segments
+	 */
+	u_int count;
 };
 
 /**
- * Data to pass to the send_message() callback job
+ * A message waiting for transmission
  */
 typedef struct {
-	chunk_t chunk;
-	int fd;
-} job_data_t;
+	/** type of the message */
+	ha_message_type_t type;
+	/** IKE_SA the message refers to, if it gets superseded by newer ones */
+	ike_sa_id_t *id;
+	/** message encoding */
+	chunk_t encoding;
+} entry_t;
+
+/**
+ * Destroy a queue entry
+ */
+static void entry_destroy(entry_t *this)
+{
+	DESTROY_IF(this->id);
+	free(this->encoding.ptr);
+	free(this);
+}
+
+/**
+ * Hashtable hash function for mergeable entries
+ */
+static u_int entry_hash(entry_t *key)
+{
+	u_int64_t spi_i, spi_r;
+
+	spi_i = key->id->get_initiator_spi(key->id);
+	spi_r = key->id->get_responder_spi(key->id);
+	return chunk_hash_inc(chunk_from_thing(spi_i),
+				chunk_hash_inc(chunk_from_thing(spi_r),
+					chunk_hash(chunk_from_thing(key->type))));
+}
+
+/**
+ * Hashtable equals function for mergeable entries
+ */
+static bool entry_equals(entry_t *key, entry_t *other_key)
+{
+	return key->type == other_key->type &&
+		   key->id->equals(key->id, other_key->id);
+}
 
 /**
- * Cleanup job data
+ * A sent frame waiting for acknowledgement
  */
-static void job_data_destroy(job_data_t *this)
+typedef struct {
+	/** sequence number of the frame */
+	u_int32_t seq;
+	/** frame encoding, including header */
+	chunk_t encoding;
+} frame_t;
+
+/**
+ * Destroy a frame
+ */
+static void frame_destroy(frame_t *this)
 {
-	free(this->chunk.ptr);
+	free(this->encoding.ptr);
 	free(this);
 }
 
 /**
- * Callback to asynchronously send messages
+ * Compare two sequence numbers, handling wrap-around
  */
-static job_requeue_t send_message(job_data_t *data)
+static inline int32_t seq_diff(u_int32_t a, u_int32_t b)
 {
-	if (send(data->fd, data->chunk.ptr, data->chunk.len, 0) < data->chunk.len)
+	return (int32_t)(a - b);
+}
+
+/**
+ * Check if a message gets superseded by a newer one of the same type, and
+ * return the IKE_SA it refers to.
+ */
+static ike_sa_id_t *get_mergeable_id(ha_message_t *message)
+{
+	ha_message_attribute_t attribute;
+	ha_message_value_t value;
+	enumerator_t *enumerator;
+	ike_sa_id_t *id = NULL;
+
+	switch (message->get_type(message))
 	{
-		DBG1(DBG_CFG, "pushing HA message failed: %s", strerror(errno));
+		case HA_IKE_MID_INITIATOR:
+		case HA_IKE_MID_RESPONDER:
+		case HA_IKE_IV:
+			break;
+		default:
+			return NULL;
+	}
+	enumerator = message->create_attribute_enumerator(message);
+	while (enumerator->enumerate(enumerator, &attribute, &value))
+	{
+		if (attribute == HA_IKE_ID)
+		{
+			id = value.ike_sa_id->clone(value.ike_sa_id);
+			break;
+		}
 	}
-	return JOB_REQUEUE_NONE;
+	enumerator->destroy(enumerator);
+	return id;
 }
 
 METHOD(ha_socket_t, push, void,
 	private_ha_socket_t *this, ha_message_t *message)
 {
-	chunk_t chunk;
+	entry_t *entry, *old;
+	chunk_t encoding;
+
+	encoding = message->get_encoding(message);
+	if (encoding.len > HA_SOCKET_MAX_MESSAGE)
+	{
+		DBG1(DBG_CFG, "HA message of %zu bytes exceeds maximum of %d bytes, "
+			 "dropped", encoding.len, HA_SOCKET_MAX_MESSAGE);
+		return;
+	}
+	INIT(entry,
+		.type = message->get_type(message),
+		.id = get_mergeable_id(message),
+		.encoding = chunk_clone(encoding),
+	);
+
+	this->mutex->lock(this->mutex);
+	if (entry->id)
+	{
+		old = this->mergeable->put(this->mergeable, entry, entry);
+		if (old)
+		{	/* drop the superseded message, append the new one to keep order */
+			this->queue->remove(this->queue, old, NULL);
+			entry_destroy(old);
+		}
+	}
+	this->queue->insert_last(this->queue, entry);
+	this->condvar->signal(this->condvar);
+	this->mutex->unlock(this->mutex);
+}
+
+/**
+ * Build a frame header
+ */
+static void build_header(private_ha_socket_t *this, frame_header_t *hdr,
+						 frame_type_t type, u_int16_t count, u_int32_t seq)
+{
+	*hdr = (frame_header_t){
+		.version = HA_MESSAGE_VERSION,
+		.type = type,
+		.count = htons(count),
+		.session = htonl(this->session),
+		.seq = htonl(seq),
+		.ack_session = htonl(this->peer_session),
+		.ack = htonl(this->peer_seq),
+	};
+}
+
+/**
+ * Build a data frame from queued messages, mutex must be held
+ */
+static frame_t *build_frame(private_ha_socket_t *this)
+{
+	enumerator_t *enumerator;
+	frame_header_t *hdr;
+	entry_t *entry;
+	frame_t *frame;
+	u_int16_t len;
+	size_t size = sizeof(frame_header_t);
+	u_char *pos;
+	int count = 0;
+
+	/* determine number of messages fitting into a frame, but at least one */
+	enumerator = this->queue->create_enumerator(this->queue);
+	while (enumerator->enumerate(enumerator, &entry))
+	{
+		if (count && (size + sizeof(len) + entry->encoding.len >
+					  this->batch_size || count == 0xFFFF))
+		{
+			break;
+		}
+		size += sizeof(len) + entry->encoding.len;
+		count++;
+	}
+	enumerator->destroy(enumerator);
+
+	INIT(frame,
+		.seq = ++this->seq,
+		.encoding = chunk_alloc(size),
+	);
+	hdr = (frame_header_t*)frame->encoding.ptr;
+	build_header(this, hdr, FRAME_DATA, count, frame->seq);
+	pos = frame->encoding.ptr + sizeof(frame_header_t);
+	while (count--)
+	{
+		this->queue->remove_first(this->queue, (void**)&entry);
+		if (entry->id)
+		{
+			this->mergeable->remove(this->mergeable, entry);
+		}
+		len = htons(entry->encoding.len);
+		memcpy(pos, &len, sizeof(len));
+		pos += sizeof(len);
+		memcpy(pos, entry->encoding.ptr, entry->encoding.len);
+		pos += entry->encoding.len;
+		entry_destroy(entry);
+	}
+	return frame;
+}
+
+/**
+ * Update the acknowledgement in sent frames, mutex must be held
+ */
+static void update_ack(private_ha_socket_t *this, chunk_t encoding)
+{
+	frame_header_t *hdr = (frame_header_t*)encoding.ptr;
+
+	hdr->ack_session = htonl(this->peer_session);
+	hdr->ack = htonl(this->peer_seq);
+}
+
+/**
+ * Send frames, blocking
+ */
+static void send_frames(private_ha_socket_t *this, linked_list_t *frames)
+{
+	chunk_t *encoding;
 
-	/* Try to send synchronously, but non-blocking. */
-	chunk = message->get_encoding(message);
-	if (send(this->fd, chunk.ptr, chunk.len, MSG_DONTWAIT) < chunk.len)
+	while (frames->remove_first(frames, (void**)&encoding) == SUCCESS)
 	{
-		if (errno == EAGAIN)
+		if (send(this->fd, encoding->ptr, encoding->len, 0) < encoding->len)
 		{
-			callback_job_t *job;
-			job_data_t *data;
+			DBG1(DBG_CFG, "pushing HA message failed: %s", strerror(errno));
+		}
+		chunk_free(encoding);
+		free(encoding);
+	}
+}
+
+/**
+ * Queue a copy of a frame encoding to send, mutex must be held
+ */
+static void queue_send(private_ha_socket_t *this, linked_list_t *frames,
+					   chunk_t encoding)
+{
+	chunk_t *copy;
+
+	update_ack(this, encoding);
+	INIT(copy);
+	*copy = chunk_clone(encoding);
+	frames->insert_last(frames, copy);
+}
+
+/**
+ * Check if the sending thread has work to do, mutex must be held
+ */
+static bool has_work(private_ha_socket_t *this, timeval_t *now)
+{
+	if (this->ack_pending)
+	{
+		return TRUE;
+	}
+	if (this->queue->get_count(this->queue) &&
+		this->unacked->get_count(this->unacked) < this->window)
+	{
+		return TRUE;
+	}
+	if (this->unacked->get_count(this->unacked) &&
+		!timercmp(now, &this->retransmit, <))
+	{
+		return TRUE;
+	}
+	return FALSE;
+}
+
+/**
+ * Generate a random session identifier and initial sequence number, the peer
+ * synchronizes to the sequence number of the first frame of a new session
+ */
+static bool init_session(private_ha_socket_t *this)
+{
+	rng_t *rng;
+	bool ok;
+
+	rng = lib->crypto->create_rng(lib->crypto, RNG_WEAK);
+	if (!rng)
+	{
+		DBG1(DBG_CFG, "no RNG found to initialize HA session");
+		return FALSE;
+	}
+	ok = rng->get_bytes(rng, sizeof(this->session), (u_int8_t*)&this->session) &&
+		 rng->get_bytes(rng, sizeof(this->seq), (u_int8_t*)&this->seq);
+	rng->destroy(rng);
+	return ok;
+}
+
+/**
+ * Sending thread, transmits queued messages and retransmits lost frames
+ */
+static job_requeue_t send_queued(private_ha_socket_t *this)
+{
+	enumerator_t *enumerator;
+	linked_list_t *frames;
+	frame_header_t ack;
+	frame_t *frame;
+	timeval_t now;
+	bool oldstate;
+
+	frames = linked_list_create();
 
-			/* Fallback to asynchronous transmission. This is required, as sendto()
-			 * is a blocking call if it acquires a policy. We could end up in a
-			 * deadlock, as we own an IKE_SA. */
-			INIT(data,
-				.chunk = chunk_clone(chunk),
-				.fd = this->fd,
-			);
+	this->mutex->lock(this->mutex);
+	thread_cleanup_push((void*)this->mutex->unlock, this->mutex);
+	oldstate = thread_cancelability(TRUE);
+	while (TRUE)
+	{
+		time_monotonic(&now);
+		if (has_work(this, &now))
+		{
+			break;
+		}
+		if (this->unacked->get_count(this->unacked))
+		{
+			this->condvar->timed_wait_abs(this->condvar, this->mutex,
+										  this->retransmit);
+		}
+		else
+		{
+			this->condvar->wait(this->condvar, this->mutex);
+		}
+	}
+	thread_cancelability(oldstate);
+	thread_cleanup_pop(FALSE);
 
-			job = callback_job_create_with_prio((callback_job_cb_t)send_message,
-							data, (void*)job_data_destroy, NULL, JOB_PRIO_HIGH);
-			lib->processor->queue_job(lib->processor, (job_t*)job);
-			return;
+	if (this->unacked->get_count(this->unacked) &&
+		!timercmp(&now, &this->retransmit, <))
+	{
+		if (this->tries++ >= this->max_tries)
+		{
+			DBG1(DBG_CFG, "HA peer did not acknowledge %d frames, dropping "
+				 "them and starting a new session",
+				 this->unacked->get_count(this->unacked));
+			this->unacked->destroy_function(this->unacked,
+											(void*)frame_destroy);
+			this->unacked = linked_list_create();
+			this->tries = 0;
+			/* the peer accepts frames in sequence only, so make it
+			 * synchronize to a new session, which requests a resync */
+			if (!init_session(this))
+			{
+				this->session++;
+			}
+		}
+		else
+		{	/* go-back-N, retransmit all unacknowledged frames */
+			DBG2(DBG_CFG, "retransmitting %d HA frames",
+				 this->unacked->get_count(this->unacked));
+			enumerator = this->unacked->create_enumerator(this->unacked);
+			while (enumerator->enumerate(enumerator, &frame))
+			{
+				queue_send(this, frames, frame->encoding);
+			}
+			enumerator->destroy(enumerator);
+			this->ack_pending = FALSE;
+		}
+		this->retransmit = now;
+		timeval_add_ms(&this->retransmit, this->timeout);
+	}
+	while (this->queue->get_count(this->queue) &&
+		   this->unacked->get_count(this->unacked) < this->window)
+	{
+		frame = build_frame(this);
+		if (!this->unacked->get_count(this->unacked))
+		{
+			this->retransmit = now;
+			timeval_add_ms(&this->retransmit, this->timeout);
+			this->tries = 0;
 		}
-		DBG1(DBG_CFG, "pushing HA message failed: %s", strerror(errno));
+		this->unacked->insert_last(this->unacked, frame);
+		queue_send(this, frames, frame->encoding);
+		this->ack_pending = FALSE;
+	}
+	if (this->ack_pending)
+	{
+		build_header(this, &ack, FRAME_ACK, 0, 0);
+		queue_send(this, frames, chunk_from_thing(ack));
+		this->ack_pending = FALSE;
+	}
+	this->mutex->unlock(this->mutex);
+
+	/* sendto() might block if it acquires a policy, so we send unlocked */
+	send_frames(this, frames);
+	frames->destroy(frames);
+
+	return JOB_REQUEUE_DIRECT;
+}
+
+/**
+ * Process the acknowledgement of a received frame, mutex must be held
+ */
+static void process_ack(private_ha_socket_t *this, u_int32_t ack)
+{
+	frame_t *frame;
+	bool progress = FALSE;
+
+	while (this->unacked->get_first(this->unacked, (void**)&frame) == SUCCESS &&
+		   seq_diff(frame->seq, ack) <= 0)
+	{
+		this->unacked->remove_first(this->unacked, (void**)&frame);
+		frame_destroy(frame);
+		progress = TRUE;
+	}
+	if (progress)
+	{
+		this->tries = 0;
+		time_monotonic(&this->retransmit);
+		timeval_add_ms(&this->retransmit, this->timeout);
+		this->condvar->signal(this->condvar);
+	}
+}
+
+/**
+ * Parse the messages contained in a data frame, mutex must be held.
+ * Returns TRUE if the peer started a new session, frames might have been lost.
+ */
+static bool process_data(private_ha_socket_t *this, frame_header_t *hdr,
+						 chunk_t data)
+{
+	ha_message_t *message;
+	u_int32_t session, seq;
+	u_int16_t count, len;
+	bool resync = FALSE;
+
+	session = ntohl(hdr->session);
+	seq = ntohl(hdr->seq);
+	count = ntohs(hdr->count);
+
+	if (!this->peer_known || this->peer_session != session)
+	{
+		DBG1(DBG_CFG, "HA peer started new session, synchronizing at %u", seq);
+		resync = this->peer_known;
+		this->peer_known = TRUE;
+		this->peer_session = session;
+		this->peer_seq = seq - 1;
+	}
+	/* acknowledge even if it is a retransmission we already have */
+	this->ack_pending = TRUE;
+	this->condvar->signal(this->condvar);
+
+	if (seq != this->peer_seq + 1)
+	{
+		DBG2(DBG_CFG, "dropping HA frame %u, expected %u",
+			 seq, this->peer_seq + 1);
+		return resync;
+	}
+	this->peer_seq = seq;
+
+	while (count--)
+	{
+		if (data.len < sizeof(len))
+		{
+			DBG1(DBG_CFG, "received truncated HA frame");
+			return resync;
+		}
+		memcpy(&len, data.ptr, sizeof(len));
+		len = ntohs(len);
+		data = chunk_skip(data, sizeof(len));
+		if (data.len < len)
+		{
+			DBG1(DBG_CFG, "received truncated HA frame");
+			return resync;
+		}
+		message = ha_message_parse(chunk_create(data.ptr, len));
+		if (message)
+		{
+			this->received->insert_last(this->received, message);
+		}
+		data = chunk_skip(data, len);
+	}
+	return resync;
+}
+
+/**
+ * Request a resync of all segments from the peer
+ */
+static void request_resync(private_ha_socket_t *this)
+{
+	ha_message_t *message;
+	int i;
+
+	DBG1(DBG_CFG, "HA frames from peer might have been lost, requesting "
+		 "resynchronization");
+
+	message = ha_message_create(HA_RESYNC);
+	for (i = 1; i <= this->count; i++)
+	{
+		message->add_attribute(message, HA_SEGMENT, i);
+	}
+	push(this, message);
+	message->destroy(message);
+}
+
+/**
+ * Process a received frame
+ */
+static void process_frame(private_ha_socket_t *this, chunk_t data)
+{
+	frame_header_t hdr;
+	bool resync = FALSE;
+
+	if (data.len < sizeof(hdr))
+	{
+		DBG1(DBG_CFG, "HA frame too short");
+		return;
+	}
+	memcpy(&hdr, data.ptr, sizeof(hdr));
+	if (hdr.version != HA_MESSAGE_VERSION)
+	{
+		DBG1(DBG_CFG, "HA frame has version %d, expected %d",
+			 hdr.version, HA_MESSAGE_VERSION);
+		return;
+	}
+	data = chunk_skip(data, sizeof(hdr));
+
+	this->mutex->lock(this->mutex);
+	if (ntohl(hdr.ack_session) == this->session)
+	{
+		process_ack(this, ntohl(hdr.ack));
+	}
+	switch (hdr.type)
+	{
+		case FRAME_DATA:
+			resync = process_data(this, &hdr, data);
+			break;
+		case FRAME_ACK:
+			break;
+		default:
+			DBG1(DBG_CFG, "received HA frame of unknown type %d", hdr.type);
+			break;
+	}
+	this->mutex->unlock(this->mutex);
+
+	if (resync)
+	{
+		request_resync(this);
 	}
 }
 
@@ -119,13 +771,20 @@ METHOD(ha_socket_t, pull, ha_message_t*,
 {
 	while (TRUE)
 	{
-		ha_message_t *message;
-		char buf[1024];
+		ha_message_t *message = NULL;
 		bool oldstate;
 		ssize_t len;
 
+		this->mutex->lock(this->mutex);
+		this->received->remove_first(this->received, (void**)&message);
+		this->mutex->unlock(this->mutex);
+		if (message)
+		{
+			return message;
+		}
+
 		oldstate = thread_cancelability(TRUE);
-		len = recv(this->fd, buf, sizeof(buf), 0);
+		len = recv(this->fd, this->buf.ptr, this->buf.len, 0);
 		thread_cancelability(oldstate);
 		if (len <= 0)
 		{
@@ -141,11 +800,7 @@ METHOD(ha_socket_t, pull, ha_message_t*,
 					continue;
 			}
 		}
-		message = ha_message_parse(chunk_create(buf, len));
-		if (message)
-		{
-			return message;
-		}
+		process_frame(this, chunk_create(this->buf.ptr, len));
 	}
 }
 
@@ -190,13 +845,21 @@ METHOD(ha_socket_t, destroy, void,
 	}
 	DESTROY_IF(this->local);
 	DESTROY_IF(this->remote);
+	free(this->buf.ptr);
+	this->queue->destroy_function(this->queue, (void*)entry_destroy);
+	this->mergeable->destroy(this->mergeable);
+	this->unacked->destroy_function(this->unacked, (void*)frame_destroy);
+	this->received->destroy_offset(this->received,
+								   offsetof(ha_message_t, destroy));
+	this->condvar->destroy(this->condvar);
+	this->mutex->destroy(this->mutex);
 	free(this);
 }
 
 /**
  * See header
  */
-ha_socket_t *ha_socket_create(char *local, char *remote)
+ha_socket_t *ha_socket_create(char *local, char *remote, u_int count)
 {
 	private_ha_socket_t *this;
 
@@ -209,6 +872,26 @@ ha_socket_t *ha_socket_create(char *local, char *remote)
 		.local = host_create_from_dns(local, 0, HA_PORT),
 		.remote = host_create_from_dns(remote, 0, HA_PORT),
 		.fd = -1,
+		.mutex = mutex_create(MUTEX_TYPE_DEFAULT),
+		.condvar = condvar_create(CONDVAR_TYPE_DEFAULT),
+		.queue = linked_list_create(),
+		.mergeable = hashtable_create((hashtable_hash_t)entry_hash,
+									  (hashtable_equals_t)entry_equals, 32),
+		.unacked = linked_list_create(),
+		.received = linked_list_create(),
+		.buf = chunk_alloc(MAX_FRAME_SIZE),
+		.count = count,
+		.batch_size = min(MAX_DATAGRAM_SIZE, lib->settings->get_int(
+					lib->settings, "%s.plugins.ha.batch_size",
+					DEFAULT_BATCH_SIZE, charon->name)),
+		.window = max(1, lib->settings->get_int(lib->settings,
+					"%s.plugins.ha.window", DEFAULT_WINDOW, charon->name)),
+		.timeout = lib->settings->get_int(lib->settings,
+					"%s.plugins.ha.retransmit_timeout",
+					DEFAULT_RETRANSMIT_TIMEOUT, charon->name),
+		.max_tries = lib->settings->get_int(lib->settings,
+					"%s.plugins.ha.retransmit_tries",
+					DEFAULT_RETRANSMIT_TRIES, charon->name),
 	);
 
 	if (!this->local || !this->remote)
@@ -217,11 +900,15 @@ ha_socket_t *ha_socket_create(char *local, char *remote)
 		destroy(this);
 		return NULL;
 	}
-	if (!open_socket(this))
+	if (!init_session(this) || !open_socket(this))
 	{
 		destroy(this);
 		return NULL;
 	}
+
+	lib->processor->queue_job(lib->processor,
+		(job_t*)callback_job_create_with_prio((callback_job_cb_t)send_queued,
+			this, NULL, (callback_job_cancel_t)return_false, JOB_PRIO_CRITICAL));
+
 	return &this->public;
 }
-
@@ -25,6 +25,12 @@
 
 #include <sa/ike_sa.h>
 
+/**
+ * Maximum size of a message, a frame containing it has to fit into a single
+ * UDP datagram
+ */
+#define HA_SOCKET_MAX_MESSAGE 65485
+
 typedef struct ha_socket_t ha_socket_t;
 
 /**
@@ -54,7 +60,12 @@ struct ha_socket_t {
 
 /**
  * Create a ha_socket instance.
+ *
+ * @param local		local address to bind to
+ * @param remote	remote address to send to
+ * @param count		number of segments to request a resync for if frames
+ *					from the peer got lost
  */
-ha_socket_t *ha_socket_create(char *local, char *remote);
+ha_socket_t *ha_socket_create(char *local, char *remote, u_int count);
 
 #endif /** HA_SOCKET_ @}*/
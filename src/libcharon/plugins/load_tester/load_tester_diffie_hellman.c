@@ -59,6 +59,7 @@ load_tester_diffie_hellman_t *load_tester_diffie_hellman_create(
 
 	this->dh.get_shared_secret = (status_t (*)(diffie_hellman_t *, chunk_t *))get_shared_secret;
 	this->dh.set_other_public_value = (void (*)(diffie_hellman_t *, chunk_t ))nop;
+	this->dh.set_private_value = (bool (*)(diffie_hellman_t *, chunk_t ))return_false;
 	this->dh.get_my_public_value = (void (*)(diffie_hellman_t *, chunk_t *))get_my_public_value;
 	this->dh.get_dh_group = (diffie_hellman_group_t (*)(diffie_hellman_t *))get_dh_group;
 	this->dh.destroy = (void (*)(diffie_hellman_t *))free;
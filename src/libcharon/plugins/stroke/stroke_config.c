@@ -19,6 +19,7 @@
 #include <hydra.h>
 #include <daemon.h>
 #include <threading/mutex.h>
+#include <collections/hashtable.h>
 #include <utils/lexparser.h>
 
 typedef struct private_stroke_config_t private_stroke_config_t;
@@ -1000,33 +1001,79 @@ static child_cfg_t *build_child_cfg(private_stroke_config_t *this,
 	return child_cfg;
 }
 
+/**
+ * Build the peer_cfg and child_cfg for a received add_conn message
+ */
+static bool build_config(private_stroke_config_t *this, stroke_msg_t *msg,
+						 peer_cfg_t **peer_cfg, child_cfg_t **child_cfg)
+{
+	ike_cfg_t *ike_cfg;
+
+	ike_cfg = build_ike_cfg(this, msg);
+	if (!ike_cfg)
+	{
+		return FALSE;
+	}
+	*peer_cfg = build_peer_cfg(this, msg, ike_cfg);
+	if (!*peer_cfg)
+	{
+		ike_cfg->destroy(ike_cfg);
+		return FALSE;
+	}
+	*child_cfg = build_child_cfg(this, msg);
+	if (!*child_cfg)
+	{
+		(*peer_cfg)->destroy(*peer_cfg);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * Check if two peer_cfgs and their ike_cfgs are equal
+ */
+static bool peer_cfg_equals(peer_cfg_t *a, peer_cfg_t *b)
+{
+	ike_cfg_t *ike_a, *ike_b;
+
+	ike_a = a->get_ike_cfg(a);
+	ike_b = b->get_ike_cfg(b);
+	return a->equals(a, b) && ike_a->equals(ike_a, ike_b);
+}
+
+/**
+ * Hash a peer_cfg by the addresses of its ike_cfg, consistent with
+ * peer_cfg_equals()
+ */
+static u_int peer_cfg_hash(peer_cfg_t *peer_cfg)
+{
+	ike_cfg_t *ike_cfg;
+	char *me, *other;
+
+	ike_cfg = peer_cfg->get_ike_cfg(peer_cfg);
+	me = ike_cfg->get_my_addr(ike_cfg, NULL);
+	other = ike_cfg->get_other_addr(ike_cfg, NULL);
+	return chunk_hash_inc(chunk_from_str(me ?: ""),
+						  chunk_hash(chunk_from_str(other ?: "")));
+}
+
 METHOD(stroke_config_t, add, void,
 	private_stroke_config_t *this, stroke_msg_t *msg)
 {
-	ike_cfg_t *ike_cfg, *existing_ike;
 	peer_cfg_t *peer_cfg, *existing;
 	child_cfg_t *child_cfg;
 	enumerator_t *enumerator;
 	bool use_existing = FALSE;
 
-	ike_cfg = build_ike_cfg(this, msg);
-	if (!ike_cfg)
-	{
-		return;
-	}
-	peer_cfg = build_peer_cfg(this, msg, ike_cfg);
-	if (!peer_cfg)
+	if (!build_config(this, msg, &peer_cfg, &child_cfg))
 	{
-		ike_cfg->destroy(ike_cfg);
 		return;
 	}
 
 	enumerator = create_peer_cfg_enumerator(this, NULL, NULL);
 	while (enumerator->enumerate(enumerator, &existing))
 	{
-		existing_ike = existing->get_ike_cfg(existing);
-		if (existing->equals(existing, peer_cfg) &&
-			existing_ike->equals(existing_ike, peer_cfg->get_ike_cfg(peer_cfg)))
+		if (peer_cfg_equals(existing, peer_cfg))
 		{
 			use_existing = TRUE;
 			peer_cfg->destroy(peer_cfg);
@@ -1039,12 +1086,6 @@ METHOD(stroke_config_t, add, void,
 	}
 	enumerator->destroy(enumerator);
 
-	child_cfg = build_child_cfg(this, msg);
-	if (!child_cfg)
-	{
-		peer_cfg->destroy(peer_cfg);
-		return;
-	}
 	peer_cfg->add_child_cfg(peer_cfg, child_cfg);
 
 	if (use_existing)
@@ -1061,6 +1102,72 @@ METHOD(stroke_config_t, add, void,
 	}
 }
 
+METHOD(stroke_config_t, add_batch, void,
+	private_stroke_config_t *this, linked_list_t *msgs, FILE *out)
+{
+	struct {
+		peer_cfg_t *peer_cfg;
+		child_cfg_t *child_cfg;
+		char *name;
+	} *configs;
+	enumerator_t *enumerator;
+	hashtable_t *index;
+	peer_cfg_t *peer_cfg, *existing;
+	stroke_msg_t *msg;
+	int count = 0, i;
+
+	/* build the configs without holding the lock, as this might load
+	 * certificates and keys */
+	configs = calloc(msgs->get_count(msgs), sizeof(*configs));
+	enumerator = msgs->create_enumerator(msgs);
+	while (enumerator->enumerate(enumerator, &msg))
+	{
+		if (!build_config(this, msg, &configs[count].peer_cfg,
+						  &configs[count].child_cfg))
+		{
+			fprintf(out, "adding connection '%s' failed\n", msg->add_conn.name);
+			continue;
+		}
+		configs[count++].name = msg->add_conn.name;
+	}
+	enumerator->destroy(enumerator);
+
+	this->mutex->lock(this->mutex);
+	index = hashtable_create((hashtable_hash_t)peer_cfg_hash,
+							 (hashtable_equals_t)peer_cfg_equals,
+							 this->list->get_count(this->list) + count);
+	enumerator = this->list->create_enumerator(this->list);
+	while (enumerator->enumerate(enumerator, &existing))
+	{
+		index->put(index, existing, existing);
+	}
+	enumerator->destroy(enumerator);
+
+	for (i = 0; i < count; i++)
+	{
+		peer_cfg = configs[i].peer_cfg;
+		existing = index->get(index, peer_cfg);
+		if (existing)
+		{
+			DBG1(DBG_CFG, "added child to existing configuration '%s'",
+				 existing->get_name(existing));
+			existing->add_child_cfg(existing, configs[i].child_cfg);
+			peer_cfg->destroy(peer_cfg);
+		}
+		else
+		{
+			DBG1(DBG_CFG, "added configuration '%s'", configs[i].name);
+			peer_cfg->add_child_cfg(peer_cfg, configs[i].child_cfg);
+			this->list->insert_last(this->list, peer_cfg);
+			index->put(index, peer_cfg, peer_cfg);
+		}
+	}
+	this->mutex->unlock(this->mutex);
+
+	index->destroy(index);
+	free(configs);
+}
+
 METHOD(stroke_config_t, del, void,
 	private_stroke_config_t *this, stroke_msg_t *msg)
 {
@@ -1315,6 +1422,7 @@ stroke_config_t *stroke_config_create(stroke_ca_t *ca, stroke_cred_t *cred,
 				.get_peer_cfg_by_name = _get_peer_cfg_by_name,
 			},
 			.add = _add,
+			.add_batch = _add_batch,
 			.del = _del,
 			.set_user_credentials = _set_user_credentials,
 			.destroy = _destroy,
@@ -23,6 +23,7 @@
 #define STROKE_CONFIG_H_
 
 #include <config/backend.h>
+#include <collections/linked_list.h>
 #include <stroke_msg.h>
 #include "stroke_ca.h"
 #include "stroke_cred.h"
@@ -47,6 +48,17 @@ struct stroke_config_t {
 	 */
 	void (*add)(stroke_config_t *this, stroke_msg_t *msg);
 
+	/**
+	 * Add a batch of configurations to the backend.
+	 *
+	 * All configurations get built first and are then added under a single
+	 * lock. Connections that fail to build are reported on out.
+	 *
+	 * @param msgs		list of received stroke_msg_t containing configs
+	 * @param out		stroke console stream
+	 */
+	void (*add_batch)(stroke_config_t *this, linked_list_t *msgs, FILE *out);
+
 	/**
 	 * Remove a configuration from the backend.
 	 *
@@ -26,6 +26,7 @@
 #include <hydra.h>
 #include <daemon.h>
 #include <collections/linked_list.h>
+#include <collections/array.h>
 #include <plugins/plugin.h>
 #include <credentials/certificates/x509.h>
 #include <credentials/certificates/ac.h>
@@ -442,6 +443,207 @@ static void log_auth_cfgs(FILE *out, peer_cfg_t *peer_cfg, bool local)
 	enumerator->destroy(enumerator);
 }
 
+/**
+ * Log worker thread and job queue counters
+ */
+static void log_workers(FILE *out)
+{
+	int i;
+
+	fprintf(out, "  worker threads: %d of %d idle, ",
+			lib->processor->get_idle_threads(lib->processor),
+			lib->processor->get_total_threads(lib->processor));
+	for (i = 0; i < JOB_PRIO_MAX; i++)
+	{
+		fprintf(out, "%s%d", i == 0 ? "" : "/",
+				lib->processor->get_working_threads(lib->processor, i));
+	}
+	fprintf(out, " working, job queue: ");
+	for (i = 0; i < JOB_PRIO_MAX; i++)
+	{
+		fprintf(out, "%s%d", i == 0 ? "" : "/",
+				lib->processor->get_job_load(lib->processor, i));
+	}
+	fprintf(out, ", scheduled: %d\n",
+			lib->scheduler->get_job_load(lib->scheduler));
+	if (charon->verifier->get_threads(charon->verifier))
+	{
+		u_int pending, done, latency, max;
+
+		charon->verifier->get_stats(charon->verifier, &pending, &done,
+									&latency, &max);
+		fprintf(out, "  signature verification: %u threads, %u pending, "
+				"%u done, %uus average / %uus max latency\n",
+				charon->verifier->get_threads(charon->verifier),
+				pending, done, latency, max);
+	}
+	for (i = 0; i < RECEIVER_DROP_MAX; i++)
+	{
+		if (charon->receiver->get_drops(charon->receiver, i))
+		{
+			break;
+		}
+	}
+	if (i < RECEIVER_DROP_MAX)
+	{
+		fprintf(out, "  dropped IKE_SA_INIT requests:");
+		for (i = 0; i < RECEIVER_DROP_MAX; i++)
+		{
+			fprintf(out, "%s %N %u", i == 0 ? "" : ",", receiver_drop_names,
+					i, charon->receiver->get_drops(charon->receiver, i));
+		}
+		fprintf(out, "\n");
+	}
+}
+
+/**
+ * Filter applied to IKE_SAs in status output
+ */
+typedef struct {
+	/** connection name of IKE_SA or any CHILD_SA, NULL for any */
+	char *name;
+	/** remote identity, may contain wildcards, NULL for any */
+	identification_t *id;
+	/** remote address, NULL for any */
+	host_t *address;
+} status_filter_t;
+
+/**
+ * Check if an IKE_SA matches a status filter
+ */
+static bool match_ike_sa(status_filter_t *filter, ike_sa_t *ike_sa)
+{
+	enumerator_t *enumerator;
+	child_sa_t *child_sa;
+	identification_t *id;
+	bool match;
+
+	if (filter->address &&
+		!filter->address->ip_equals(filter->address,
+									ike_sa->get_other_host(ike_sa)))
+	{
+		return FALSE;
+	}
+	if (filter->id)
+	{
+		id = ike_sa->get_other_eap_id(ike_sa);
+		if (!id || !id->matches(id, filter->id))
+		{
+			return FALSE;
+		}
+	}
+	if (!filter->name || streq(filter->name, ike_sa->get_name(ike_sa)))
+	{
+		return TRUE;
+	}
+	match = FALSE;
+	enumerator = ike_sa->create_child_sa_enumerator(ike_sa);
+	while (enumerator->enumerate(enumerator, &child_sa))
+	{
+		if (streq(filter->name, child_sa->get_name(child_sa)))
+		{
+			match = TRUE;
+			break;
+		}
+	}
+	enumerator->destroy(enumerator);
+	return match;
+}
+
+/**
+ * Log a matching IKE_SA and its CHILD_SAs, filtered by connection name
+ */
+static void log_ike_sa_filtered(FILE *out, ike_sa_t *ike_sa, char *name,
+								bool all)
+{
+	enumerator_t *enumerator;
+	child_sa_t *child_sa;
+	bool ike_match;
+
+	ike_match = !name || streq(name, ike_sa->get_name(ike_sa));
+	log_ike_sa(out, ike_sa, all);
+
+	enumerator = ike_sa->create_child_sa_enumerator(ike_sa);
+	while (enumerator->enumerate(enumerator, &child_sa))
+	{
+		if (ike_match || streq(name, child_sa->get_name(child_sa)))
+		{
+			log_child_sa(out, child_sa, all);
+		}
+	}
+	enumerator->destroy(enumerator);
+}
+
+/**
+ * Log the IKE_SAs matching a filter, honoring offset/limit of the request.
+ *
+ * To not hold IKE_SA manager segments locked while writing to a (possibly
+ * slow) stroke client, the matching IKE_SAs are collected first, and each
+ * IKE_SA is then checked out individually while it is logged. The
+ * non-blocking variant can't check out IKE_SAs, it logs while enumerating.
+ */
+static bool log_ike_sas(FILE *out, stroke_msg_t *msg, status_filter_t *filter,
+						bool all, bool wait)
+{
+	enumerator_t *enumerator;
+	ike_sa_id_t *id;
+	ike_sa_t *ike_sa;
+	array_t *ids;
+	u_int32_t matched = 0, shown = 0;
+	bool more = FALSE;
+
+	ids = array_create(0, 0);
+	enumerator = charon->controller->create_ike_sa_enumerator(
+													charon->controller, wait);
+	while (enumerator->enumerate(enumerator, &ike_sa))
+	{
+		if (!match_ike_sa(filter, ike_sa) || matched++ < msg->status.offset)
+		{
+			continue;
+		}
+		if (msg->status.limit && shown >= msg->status.limit)
+		{
+			more = TRUE;
+			break;
+		}
+		shown++;
+		if (wait)
+		{
+			id = ike_sa->get_id(ike_sa);
+			array_insert(ids, ARRAY_TAIL, id->clone(id));
+		}
+		else
+		{
+			log_ike_sa_filtered(out, ike_sa, filter->name, all);
+		}
+	}
+	enumerator->destroy(enumerator);
+
+	while (array_remove(ids, ARRAY_HEAD, &id))
+	{
+		ike_sa = charon->ike_sa_manager->checkout(charon->ike_sa_manager, id);
+		id->destroy(id);
+		if (!ike_sa)
+		{	/* gone in the meantime */
+			continue;
+		}
+		log_ike_sa_filtered(out, ike_sa, filter->name, all);
+		charon->ike_sa_manager->checkin(charon->ike_sa_manager, ike_sa);
+		if (fflush(out) != 0)
+		{	/* client disconnected, no need to continue */
+			break;
+		}
+	}
+	array_destroy_offset(ids, offsetof(ike_sa_id_t, destroy));
+
+	if (more)
+	{
+		fprintf(out, "  ... more IKE_SAs available, continue with --offset %u\n",
+				msg->status.offset + shown);
+	}
+	return shown > 0;
+}
+
 METHOD(stroke_list_t, status, void,
 	private_stroke_list_t *this, stroke_msg_t *msg, FILE *out,
 	bool all, bool wait)
@@ -450,8 +652,10 @@ METHOD(stroke_list_t, status, void,
 	ike_cfg_t *ike_cfg;
 	child_cfg_t *child_cfg;
 	child_sa_t *child_sa;
-	ike_sa_t *ike_sa;
 	linked_list_t *my_ts, *other_ts;
+	status_filter_t filter = {
+		.name = msg->status.name,
+	};
 	bool first, found = FALSE;
 	char *name = msg->status.name;
 	u_int half_open;
@@ -464,7 +668,7 @@ METHOD(stroke_list_t, status, void,
 		host_t *host;
 		u_int32_t dpd;
 		time_t since, now;
-		u_int size, online, offline, i;
+		u_int size, online, offline;
 		struct utsname utsname;
 
 		now = time_monotonic(NULL);
@@ -486,22 +690,7 @@ METHOD(stroke_list_t, status, void,
 				    mi.arena, mi.hblkhd, mi.uordblks, mi.fordblks);
 		}
 #endif /* HAVE_MALLINFO */
-		fprintf(out, "  worker threads: %d of %d idle, ",
-				lib->processor->get_idle_threads(lib->processor),
-				lib->processor->get_total_threads(lib->processor));
-		for (i = 0; i < JOB_PRIO_MAX; i++)
-		{
-			fprintf(out, "%s%d", i == 0 ? "" : "/",
-					lib->processor->get_working_threads(lib->processor, i));
-		}
-		fprintf(out, " working, job queue: ");
-		for (i = 0; i < JOB_PRIO_MAX; i++)
-		{
-			fprintf(out, "%s%d", i == 0 ? "" : "/",
-					lib->processor->get_job_load(lib->processor, i));
-		}
-		fprintf(out, ", scheduled: %d\n",
-				lib->scheduler->get_job_load(lib->scheduler));
+		log_workers(out);
 		fprintf(out, "  loaded plugins: %s\n",
 				lib->plugins->loaded_plugins(lib->plugins));
 
@@ -638,40 +827,28 @@ METHOD(stroke_list_t, status, void,
 	fprintf(out, "Security Associations (%u up, %u connecting):\n",
 		charon->ike_sa_manager->get_count(charon->ike_sa_manager) - half_open,
 		half_open);
-	enumerator = charon->controller->create_ike_sa_enumerator(
-													charon->controller, wait);
-	while (enumerator->enumerate(enumerator, &ike_sa))
+	if (msg->status.id)
 	{
-		bool ike_printed = FALSE;
-		enumerator_t *children = ike_sa->create_child_sa_enumerator(ike_sa);
-
-		if (name == NULL || streq(name, ike_sa->get_name(ike_sa)))
+		filter.id = identification_create_from_string(msg->status.id);
+	}
+	if (msg->status.address)
+	{
+		filter.address = host_create_from_string(msg->status.address, 0);
+		if (!filter.address)
 		{
-			log_ike_sa(out, ike_sa, all);
-			found = TRUE;
-			ike_printed = TRUE;
+			fprintf(out, "  invalid address filter '%s'\n", msg->status.address);
 		}
-
-		while (children->enumerate(children, (void**)&child_sa))
-		{
-			if (name == NULL || streq(name, child_sa->get_name(child_sa)))
-			{
-				if (!ike_printed)
-				{
-					log_ike_sa(out, ike_sa, all);
-					found = TRUE;
-					ike_printed = TRUE;
-				}
-				log_child_sa(out, child_sa, all);
-			}
-		}
-		children->destroy(children);
 	}
-	enumerator->destroy(enumerator);
+	if (!msg->status.address || filter.address)
+	{
+		found = log_ike_sas(out, msg, &filter, all, wait);
+	}
+	DESTROY_IF(filter.id);
+	DESTROY_IF(filter.address);
 
 	if (!found)
 	{
-		if (name)
+		if (name || filter.id || filter.address || msg->status.offset)
 		{
 			fprintf(out, "  no match\n");
 		}
@@ -1514,6 +1691,25 @@ METHOD(stroke_list_t, leases, void,
 	DESTROY_IF(address);
 }
 
+METHOD(stroke_list_t, summary, void,
+	private_stroke_list_t *this, stroke_msg_t *msg, FILE *out)
+{
+	time_t now;
+	u_int total, half_open;
+
+	now = time_monotonic(NULL);
+	fprintf(out, "Status summary of IKE charon daemon (%sSwan "VERSION
+			"):\n  uptime: %V\n", this->swan, &now, &this->uptime);
+	log_workers(out);
+
+	/* both are read from per-segment counters, no IKE_SA gets enumerated */
+	total = charon->ike_sa_manager->get_count(charon->ike_sa_manager);
+	half_open = charon->ike_sa_manager->get_half_open_count(
+												charon->ike_sa_manager, NULL);
+	fprintf(out, "Security Associations (%u up, %u connecting)\n",
+			total - half_open, half_open);
+}
+
 METHOD(stroke_list_t, destroy, void,
 	private_stroke_list_t *this)
 {
@@ -1531,6 +1727,7 @@ stroke_list_t *stroke_list_create(stroke_attribute_t *attribute)
 		.public = {
 			.list = _list,
 			.status = _status,
+			.summary = _summary,
 			.leases = _leases,
 			.destroy = _destroy,
 		},
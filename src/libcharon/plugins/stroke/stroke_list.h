@@ -52,6 +52,16 @@ struct stroke_list_t {
 	void (*status)(stroke_list_t *this, stroke_msg_t *msg, FILE *out,
 				   bool all, bool wait);
 
+	/**
+	 * Log a summary of SA counters to stroke console.
+	 *
+	 * In contrast to status(), this does not enumerate any IKE_SAs.
+	 *
+	 * @param msg		stroke message
+	 * @param out		stroke console stream
+	 */
+	void (*summary)(stroke_list_t *this, stroke_msg_t *msg, FILE *out);
+
 	/**
 	 * Log pool leases to stroke console.
 	 *
@@ -31,6 +31,7 @@
 #include <threading/condvar.h>
 #include <collections/linked_list.h>
 #include <processing/jobs/callback_job.h>
+#include <utils/slab.h>
 
 #include "stroke_config.h"
 #include "stroke_control.h"
@@ -217,9 +218,9 @@ static void pop_end(stroke_msg_t *msg, const char* label, stroke_end_t *end)
 }
 
 /**
- * Add a connection to the configuration list
+ * Pop the strings of an add_conn message and log its contents
  */
-static void stroke_add_conn(private_stroke_socket_t *this, stroke_msg_t *msg)
+static void pop_add_conn(stroke_msg_t *msg)
 {
 	pop_string(msg, &msg->add_conn.name);
 	DBG1(DBG_CFG, "received stroke: add connection '%s'", msg->add_conn.name);
@@ -247,6 +248,14 @@ static void stroke_add_conn(private_stroke_socket_t *this, stroke_msg_t *msg)
 	DBG2(DBG_CFG, "  mediated_by=%s", msg->add_conn.ikeme.mediated_by);
 	DBG2(DBG_CFG, "  me_peerid=%s", msg->add_conn.ikeme.peerid);
 	DBG2(DBG_CFG, "  keyexchange=ikev%u", msg->add_conn.version);
+}
+
+/**
+ * Add a connection to the configuration list
+ */
+static void stroke_add_conn(private_stroke_socket_t *this, stroke_msg_t *msg)
+{
+	pop_add_conn(msg);
 
 	this->config->add(this->config, msg);
 	this->attribute->add_dns(this->attribute, msg);
@@ -381,10 +390,21 @@ static void stroke_status(private_stroke_socket_t *this,
 						  stroke_msg_t *msg, FILE *out, bool all, bool wait)
 {
 	pop_string(msg, &(msg->status.name));
+	pop_string(msg, &(msg->status.id));
+	pop_string(msg, &(msg->status.address));
 
 	this->list->status(this->list, msg, out, all, wait);
 }
 
+/**
+ * show a counters-only status summary
+ */
+static void stroke_status_summary(private_stroke_socket_t *this,
+								  stroke_msg_t *msg, FILE *out)
+{
+	this->list->summary(this->list, msg, out);
+}
+
 /**
  * list various information
  */
@@ -480,10 +500,31 @@ static void stroke_leases(private_stroke_socket_t *this,
 static void stroke_memusage(private_stroke_socket_t *this,
 							stroke_msg_t *msg, FILE *out)
 {
+	enumerator_t *enumerator;
+	slab_stats_t stats;
+	slab_t *slab;
+	bool first = TRUE;
+
 	if (lib->leak_detective)
 	{
 		lib->leak_detective->usage(lib->leak_detective, out);
 	}
+	enumerator = slab_create_enumerator();
+	while (enumerator->enumerate(enumerator, &slab))
+	{
+		if (first)
+		{
+			fprintf(out, "Slab allocator:\n");
+			fprintf(out, "  %-24s %6s %10s %10s %12s %7s\n", "type", "size",
+					"in use", "total", "allocations", "threads");
+			first = FALSE;
+		}
+		slab_get_stats(slab, &stats);
+		fprintf(out, "  %-24s %6zu %10d %10u %12llu %7u\n", slab->name,
+				slab->size, stats.in_use, stats.total,
+				(unsigned long long)stats.allocs, stats.threads);
+	}
+	enumerator->destroy(enumerator);
 }
 
 /**
@@ -581,44 +622,11 @@ static inline job_requeue_t job_processed(private_stroke_socket_t *this)
 }
 
 /**
- * process a stroke request from the socket pointed by "fd"
+ * Process a single stroke message
  */
-static job_requeue_t process(stroke_job_context_t *ctx)
+static void process_msg(private_stroke_socket_t *this, stroke_msg_t *msg,
+						FILE *out)
 {
-	stroke_msg_t *msg;
-	u_int16_t msg_length;
-	ssize_t bytes_read;
-	FILE *out;
-	private_stroke_socket_t *this = ctx->this;
-	int strokefd = ctx->fd;
-
-	/* peek the length */
-	bytes_read = recv(strokefd, &msg_length, sizeof(msg_length), MSG_PEEK);
-	if (bytes_read != sizeof(msg_length))
-	{
-		DBG1(DBG_CFG, "reading length of stroke message failed: %s",
-			 strerror(errno));
-		return job_processed(this);
-	}
-
-	/* read message */
-	msg = alloca(msg_length);
-	bytes_read = recv(strokefd, msg, msg_length, 0);
-	if (bytes_read != msg_length)
-	{
-		DBG1(DBG_CFG, "reading stroke message failed: %s", strerror(errno));
-		return job_processed(this);
-	}
-
-	out = fdopen(strokefd, "w+");
-	if (out == NULL)
-	{
-		DBG1(DBG_CFG, "opening stroke output channel failed: %s", strerror(errno));
-		return job_processed(this);
-	}
-
-	DBG3(DBG_CFG, "stroke message %b", (void*)msg, msg_length);
-
 	switch (msg->type)
 	{
 		case STR_INITIATE:
@@ -648,6 +656,9 @@ static job_requeue_t process(stroke_job_context_t *ctx)
 		case STR_STATUS_ALL_NOBLK:
 			stroke_status(this, msg, out, TRUE, FALSE);
 			break;
+		case STR_STATUS_SUMMARY:
+			stroke_status_summary(this, msg, out);
+			break;
 		case STR_ADD_CONN:
 			stroke_add_conn(this, msg);
 			break;
@@ -694,6 +705,165 @@ static job_requeue_t process(stroke_job_context_t *ctx)
 			DBG1(DBG_CFG, "received unknown stroke");
 			break;
 	}
+}
+
+/**
+ * Read exactly len bytes from a stroke socket
+ */
+static bool read_all(int fd, void *buf, size_t len)
+{
+	ssize_t got;
+
+	while (len)
+	{
+		got = recv(fd, buf, len, 0);
+		if (got <= 0)
+		{
+			return FALSE;
+		}
+		buf += got;
+		len -= got;
+	}
+	return TRUE;
+}
+
+/**
+ * Read the next stroke message of a batch, NULL if there are no more
+ */
+static stroke_msg_t *read_msg(int fd)
+{
+	stroke_msg_t *msg;
+	u_int16_t msg_length;
+
+	if (!read_all(fd, &msg_length, sizeof(msg_length)))
+	{
+		return NULL;
+	}
+	if (msg_length < offsetof(stroke_msg_t, buffer) ||
+		msg_length > sizeof(stroke_msg_t))
+	{
+		DBG1(DBG_CFG, "invalid stroke message length %u in batch", msg_length);
+		return NULL;
+	}
+	msg = malloc(msg_length);
+	msg->length = msg_length;
+	if (!read_all(fd, (char*)msg + sizeof(msg_length),
+				  msg_length - sizeof(msg_length)))
+	{
+		DBG1(DBG_CFG, "reading stroke message in batch failed");
+		free(msg);
+		return NULL;
+	}
+	return msg;
+}
+
+/**
+ * Add the queued add_conn messages of a batch at once
+ */
+static void add_conns(private_stroke_socket_t *this, linked_list_t *conns,
+					  FILE *out)
+{
+	stroke_msg_t *msg;
+
+	if (conns->get_count(conns))
+	{
+		this->config->add_batch(this->config, conns, out);
+		while (conns->remove_first(conns, (void**)&msg) == SUCCESS)
+		{
+			this->attribute->add_dns(this->attribute, msg);
+			this->handler->add_attributes(this->handler, msg);
+			free(msg);
+		}
+	}
+}
+
+/**
+ * Process the stroke messages following a batch request until the client
+ * closes the connection. Subsequent add_conn messages are queued and
+ * added to the configuration backend at once.
+ */
+static void stroke_batch(private_stroke_socket_t *this, int fd, FILE *out)
+{
+	linked_list_t *conns;
+	stroke_msg_t *msg;
+	u_int count = 0;
+
+	DBG1(DBG_CFG, "received stroke: batch");
+
+	conns = linked_list_create();
+	while ((msg = read_msg(fd)))
+	{
+		count++;
+		if (msg->type == STR_ADD_CONN)
+		{
+			pop_add_conn(msg);
+			conns->insert_last(conns, msg);
+			continue;
+		}
+		add_conns(this, conns, out);
+		if (msg->type == STR_BATCH)
+		{
+			DBG1(DBG_CFG, "ignoring nested stroke batch");
+		}
+		else
+		{
+			process_msg(this, msg, out);
+		}
+		free(msg);
+	}
+	add_conns(this, conns, out);
+	conns->destroy(conns);
+
+	DBG1(DBG_CFG, "processed stroke batch of %u messages", count);
+}
+
+/**
+ * process a stroke request from the socket pointed by "fd"
+ */
+static job_requeue_t process(stroke_job_context_t *ctx)
+{
+	stroke_msg_t *msg;
+	u_int16_t msg_length;
+	ssize_t bytes_read;
+	FILE *out;
+	private_stroke_socket_t *this = ctx->this;
+	int strokefd = ctx->fd;
+
+	/* peek the length */
+	bytes_read = recv(strokefd, &msg_length, sizeof(msg_length), MSG_PEEK);
+	if (bytes_read != sizeof(msg_length))
+	{
+		DBG1(DBG_CFG, "reading length of stroke message failed: %s",
+			 strerror(errno));
+		return job_processed(this);
+	}
+
+	/* read message */
+	msg = alloca(msg_length);
+	bytes_read = recv(strokefd, msg, msg_length, 0);
+	if (bytes_read != msg_length)
+	{
+		DBG1(DBG_CFG, "reading stroke message failed: %s", strerror(errno));
+		return job_processed(this);
+	}
+
+	out = fdopen(strokefd, "w+");
+	if (out == NULL)
+	{
+		DBG1(DBG_CFG, "opening stroke output channel failed: %s", strerror(errno));
+		return job_processed(this);
+	}
+
+	DBG3(DBG_CFG, "stroke message %b", (void*)msg, msg_length);
+
+	if (msg->type == STR_BATCH)
+	{
+		stroke_batch(this, strokefd, out);
+	}
+	else
+	{
+		process_msg(this, msg, out);
+	}
 	fclose(out);
 	/* fclose() closes underlying FD */
 	ctx->fd = 0;
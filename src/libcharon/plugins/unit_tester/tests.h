@@ -20,6 +20,10 @@
 
 DEFINE_TEST("linked_list_t->remove()", test_list_remove, FALSE)
 DEFINE_TEST("hashtable_t->remove_at()", test_hashtable_remove_at, FALSE)
+DEFINE_TEST("array_t pointer operations", test_array_ptr, FALSE)
+DEFINE_TEST("array_t sorted values", test_array_sorted, FALSE)
+DEFINE_TEST("slab allocator", test_slab, FALSE)
+DEFINE_TEST("mem_cred shared key lookup", test_mem_cred_shared, FALSE)
 DEFINE_TEST("simple enumerator", test_enumerate, FALSE)
 DEFINE_TEST("nested enumerator", test_enumerate_nested, FALSE)
 DEFINE_TEST("filtered enumerator", test_enumerate_filtered, FALSE)
@@ -31,6 +35,7 @@ DEFINE_TEST("SQLite operations", test_sqlite, FALSE)
 DEFINE_TEST("mutex primitive", test_mutex, FALSE)
 DEFINE_TEST("RSA key generation", test_rsa_gen, FALSE)
 DEFINE_TEST("RSA subjectPublicKeyInfo loading", test_rsa_load_any, FALSE)
+DEFINE_TEST("Ed25519 signatures", test_ed25519, FALSE)
 DEFINE_TEST("X509 certificate", test_cert_x509, FALSE)
 DEFINE_TEST("Mediation database key fetch", test_med_db, FALSE)
 DEFINE_TEST("Base64 converter", test_chunk_base64, FALSE)
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2013 Hochschule fuer Technik Rapperswil
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.  See <http://www.fsf.org/copyleft/gpl.txt>.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+
+#include <library.h>
+#include <collections/array.h>
+
+/**
+ * Compare two integers stored in a value array
+ */
+static int cmp_int(const void *a, const void *b)
+{
+	return *(int*)a - *(int*)b;
+}
+
+/**
+ * Test a pointer based array, growing at both ends and beyond inline storage
+ */
+bool test_array_ptr()
+{
+	array_t *array;
+	enumerator_t *enumerator;
+	uintptr_t x;
+	void *ptr;
+	int i;
+
+	array = array_create(0, 0);
+	for (i = 1; i <= 50; i++)
+	{
+		if (i % 2)
+		{
+			array_insert(array, ARRAY_TAIL, (void*)(uintptr_t)i);
+		}
+		else
+		{
+			array_insert(array, ARRAY_HEAD, (void*)(uintptr_t)i);
+		}
+	}
+	if (array_count(array) != 50)
+	{
+		return FALSE;
+	}
+	/* head contains even numbers descending, tail odd numbers ascending */
+	if (!array_get(array, ARRAY_HEAD, &ptr) || ptr != (void*)50 ||
+		!array_get(array, ARRAY_TAIL, &ptr) || ptr != (void*)49 ||
+		!array_get(array, 25, &ptr) || ptr != (void*)1 ||
+		array_get(array, 50, &ptr))
+	{
+		return FALSE;
+	}
+
+	i = 0;
+	enumerator = array_create_enumerator(array);
+	while (enumerator->enumerate(enumerator, &ptr))
+	{
+		x = (uintptr_t)ptr;
+		if (x % 2 == 0)
+		{
+			array_remove_at(array, enumerator);
+		}
+		i++;
+	}
+	enumerator->destroy(enumerator);
+	if (i != 50 || array_count(array) != 25)
+	{
+		return FALSE;
+	}
+	array_foreach(array, i, &ptr)
+	{
+		if (ptr != (void*)(uintptr_t)(i * 2 + 1))
+		{
+			return FALSE;
+		}
+	}
+
+	while (array_remove(array, ARRAY_HEAD, &ptr))
+	{
+		if (array_count(array) == 12)
+		{
+			array_compress(array);
+		}
+	}
+	if (ptr != (void*)49 || array_count(array) != 0)
+	{
+		return FALSE;
+	}
+	array_destroy(array);
+
+	/* NULL arrays behave like empty arrays */
+	array = NULL;
+	if (array_count(array) != 0 || array_get(array, ARRAY_HEAD, NULL))
+	{
+		return FALSE;
+	}
+	array_insert_create(&array, ARRAY_TAIL, (void*)1);
+	if (array_count(array) != 1)
+	{
+		return FALSE;
+	}
+	array_destroy(array);
+	return TRUE;
+}
+
+/**
+ * Test a value based, sorted array
+ */
+bool test_array_sorted()
+{
+	array_t *array;
+	int i, x, values[] = { 7, 3, 9, 1, 5, 3, 8, 2, 6, 4, 0, 10, 11, 12 };
+
+	array = array_create(sizeof(int), 4);
+	for (i = 0; i < countof(values); i++)
+	{
+		array_insert_sorted(array, &values[i], cmp_int);
+	}
+	if (array_count(array) != countof(values))
+	{
+		return FALSE;
+	}
+	for (i = 1; i < countof(values); i++)
+	{
+		int a, b;
+
+		if (!array_get(array, i - 1, &a) || !array_get(array, i, &b) || a > b)
+		{
+			return FALSE;
+		}
+	}
+	x = 9;
+	if (array_bsearch(array, &x, cmp_int, &i) < 0 || i != 9)
+	{
+		return FALSE;
+	}
+	x = 13;
+	if (array_bsearch(array, &x, cmp_int, NULL) != -1)
+	{
+		return FALSE;
+	}
+	/* remove from the middle, keeping order */
+	if (!array_remove(array, 5, &x) || x != 4 ||
+		!array_get(array, 5, &x) || x != 5)
+	{
+		return FALSE;
+	}
+	array_destroy(array);
+	return TRUE;
+}
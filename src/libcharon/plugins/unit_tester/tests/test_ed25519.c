@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2013 Hochschule fuer Technik Rapperswil
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.  See <http://www.fsf.org/copyleft/gpl.txt>.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+
+#include <library.h>
+#include <daemon.h>
+
+/**
+ * Ed25519 test vector
+ */
+typedef struct {
+	chunk_t key;
+	chunk_t pub;
+	chunk_t msg;
+	chunk_t sig;
+} ed25519_test_t;
+
+/*******************************************************************************
+ * Ed25519 signature creation and verification, RFC 8032 section 7.1
+ ******************************************************************************/
+bool test_ed25519()
+{
+	ed25519_test_t tests[] = {
+		{
+			chunk_from_chars(
+				0x9d,0x61,0xb1,0x9d,0xef,0xfd,0x5a,0x60,0xba,0x84,0x4a,0xf4,0x92,0xec,0x2c,0xc4,
+				0x44,0x49,0xc5,0x69,0x7b,0x32,0x69,0x19,0x70,0x3b,0xac,0x03,0x1c,0xae,0x7f,0x60),
+			chunk_from_chars(
+				0xd7,0x5a,0x98,0x01,0x82,0xb1,0x0a,0xb7,0xd5,0x4b,0xfe,0xd3,0xc9,0x64,0x07,0x3a,
+				0x0e,0xe1,0x72,0xf3,0xda,0xa6,0x23,0x25,0xaf,0x02,0x1a,0x68,0xf7,0x07,0x51,0x1a),
+			chunk_empty,
+			chunk_from_chars(
+				0xe5,0x56,0x43,0x00,0xc3,0x60,0xac,0x72,0x90,0x86,0xe2,0xcc,0x80,0x6e,0x82,0x8a,
+				0x84,0x87,0x7f,0x1e,0xb8,0xe5,0xd9,0x74,0xd8,0x73,0xe0,0x65,0x22,0x49,0x01,0x55,
+				0x5f,0xb8,0x82,0x15,0x90,0xa3,0x3b,0xac,0xc6,0x1e,0x39,0x70,0x1c,0xf9,0xb4,0x6b,
+				0xd2,0x5b,0xf5,0xf0,0x59,0x5b,0xbe,0x24,0x65,0x51,0x41,0x43,0x8e,0x7a,0x10,0x0b),
+		},
+		{
+			chunk_from_chars(
+				0x4c,0xcd,0x08,0x9b,0x28,0xff,0x96,0xda,0x9d,0xb6,0xc3,0x46,0xec,0x11,0x4e,0x0f,
+				0x5b,0x8a,0x31,0x9f,0x35,0xab,0xa6,0x24,0xda,0x8c,0xf6,0xed,0x4f,0xb8,0xa6,0xfb),
+			chunk_from_chars(
+				0x3d,0x40,0x17,0xc3,0xe8,0x43,0x89,0x5a,0x92,0xb7,0x0a,0xa7,0x4d,0x1b,0x7e,0xbc,
+				0x9c,0x98,0x2c,0xcf,0x2e,0xc4,0x96,0x8c,0xc0,0xcd,0x55,0xf1,0x2a,0xf4,0x66,0x0c),
+			chunk_from_chars(0x72),
+			chunk_from_chars(
+				0x92,0xa0,0x09,0xa9,0xf0,0xd4,0xca,0xb8,0x72,0x0e,0x82,0x0b,0x5f,0x64,0x25,0x40,
+				0xa2,0xb2,0x7b,0x54,0x16,0x50,0x3f,0x8f,0xb3,0x76,0x22,0x23,0xeb,0xdb,0x69,0xda,
+				0x08,0x5a,0xc1,0xe4,0x3e,0x15,0x99,0x6e,0x45,0x8f,0x36,0x13,0xd0,0xf1,0x1d,0x8c,
+				0x38,0x7b,0x2e,0xae,0xb4,0x30,0x2a,0xee,0xb0,0x0d,0x29,0x16,0x12,0xbb,0x0c,0x00),
+		},
+	};
+	private_key_t *private;
+	public_key_t *public;
+	chunk_t sig, encoding;
+	int i;
+
+	for (i = 0; i < countof(tests); i++)
+	{
+		private = lib->creds->create(lib->creds, CRED_PRIVATE_KEY, KEY_ED25519,
+									 BUILD_EDDSA_PRIV, tests[i].key, BUILD_END);
+		if (!private)
+		{
+			DBG1(DBG_CFG, "loading Ed25519 private key failed");
+			return FALSE;
+		}
+		public = private->get_public_key(private);
+		if (!public)
+		{
+			DBG1(DBG_CFG, "generating public from private key failed");
+			return FALSE;
+		}
+		if (!public->get_encoding(public, PUBKEY_SPKI_ASN1_DER, &encoding) ||
+			!chunk_equals(chunk_skip(encoding, encoding.len - tests[i].pub.len),
+						  tests[i].pub))
+		{
+			DBG1(DBG_CFG, "derived Ed25519 public key invalid");
+			return FALSE;
+		}
+		public->destroy(public);
+		/* load the public key again from its subjectPublicKeyInfo */
+		public = lib->creds->create(lib->creds, CRED_PUBLIC_KEY, KEY_ANY,
+									BUILD_BLOB_ASN1_DER, encoding, BUILD_END);
+		chunk_free(&encoding);
+		if (!public || public->get_type(public) != KEY_ED25519)
+		{
+			DBG1(DBG_CFG, "loading Ed25519 subjectPublicKeyInfo failed");
+			return FALSE;
+		}
+		if (!private->sign(private, SIGN_ED25519, tests[i].msg, &sig))
+		{
+			DBG1(DBG_CFG, "creating Ed25519 signature failed");
+			return FALSE;
+		}
+		if (!chunk_equals(sig, tests[i].sig))
+		{
+			DBG1(DBG_CFG, "Ed25519 signature invalid, expected %B, got %B",
+				 &tests[i].sig, &sig);
+			return FALSE;
+		}
+		if (!public->verify(public, SIGN_ED25519, tests[i].msg, sig))
+		{
+			DBG1(DBG_CFG, "verifying Ed25519 signature failed");
+			return FALSE;
+		}
+		sig.ptr[sig.len-1]++;
+		if (public->verify(public, SIGN_ED25519, tests[i].msg, sig))
+		{
+			DBG1(DBG_CFG, "verifying faked Ed25519 signature succeeded!");
+			return FALSE;
+		}
+		free(sig.ptr);
+		public->destroy(public);
+		private->destroy(private);
+	}
+	return TRUE;
+}
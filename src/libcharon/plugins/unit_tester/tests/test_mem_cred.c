@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2013 Hochschule fuer Technik Rapperswil
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.  See <http://www.fsf.org/copyleft/gpl.txt>.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+
+#include <library.h>
+#include <credentials/sets/mem_cred.h>
+
+/**
+ * Get the secret of the best matching shared key, as the credential manager
+ */
+static char *get_secret(mem_cred_t *creds, char *me, char *other)
+{
+	identification_t *id_me = NULL, *id_other = NULL;
+	id_match_t match_me, match_other, best_me = 0, best_other = 0;
+	enumerator_t *enumerator;
+	shared_key_t *shared;
+	char *found = NULL;
+
+	if (me)
+	{
+		id_me = identification_create_from_string(me);
+	}
+	if (other)
+	{
+		id_other = identification_create_from_string(other);
+	}
+	enumerator = creds->set.create_shared_enumerator(&creds->set, SHARED_IKE,
+													 id_me, id_other);
+	while (enumerator->enumerate(enumerator, &shared, &match_me, &match_other))
+	{
+		if (match_other > best_other ||
+			(match_other == best_other && match_me > best_me))
+		{
+			found = shared->get_key(shared).ptr;
+			best_me = match_me;
+			best_other = match_other;
+		}
+	}
+	enumerator->destroy(enumerator);
+	DESTROY_IF(id_me);
+	DESTROY_IF(id_other);
+	return found;
+}
+
+/**
+ * Add a shared key with a single owner
+ */
+static void add_secret(mem_cred_t *creds, char *secret, char *owner)
+{
+	shared_key_t *shared;
+	chunk_t key;
+
+	key = chunk_clone(chunk_create(secret, strlen(secret) + 1));
+	shared = shared_key_create(SHARED_IKE, key);
+	if (owner)
+	{
+		creds->add_shared(creds, shared,
+						  identification_create_from_string(owner), NULL);
+	}
+	else
+	{
+		creds->add_shared(creds, shared, NULL);
+	}
+}
+
+/*******************************************************************************
+ * indexed shared key lookup
+ ******************************************************************************/
+bool test_mem_cred_shared()
+{
+	mem_cred_t *creds;
+	char secret[32], owner[32], *found;
+	int i;
+
+	creds = mem_cred_create();
+	add_secret(creds, "any", "%any");
+	for (i = 0; i < 100; i++)
+	{
+		snprintf(secret, sizeof(secret), "secret%d", i);
+		snprintf(owner, sizeof(owner), "host%d.strongswan.org", i);
+		add_secret(creds, secret, owner);
+	}
+	add_secret(creds, "wildcard", "*.example.com");
+	add_secret(creds, "dn", "C=CH, O=strongSwan, CN=moon");
+	add_secret(creds, "newer", "host42.strongswan.org");
+
+	found = get_secret(creds, NULL, "HOST7.strongswan.org");
+	if (!found || !streq(found, "secret7"))
+	{
+		return FALSE;
+	}
+	/* newer entries take precedence */
+	found = get_secret(creds, "host42.strongswan.org", NULL);
+	if (!found || !streq(found, "newer"))
+	{
+		return FALSE;
+	}
+	found = get_secret(creds, "unknown.org", "moon.example.com");
+	if (!found || !streq(found, "wildcard"))
+	{
+		return FALSE;
+	}
+	found = get_secret(creds, "C=CH, O=strongswan, CN=moon", NULL);
+	if (!found || !streq(found, "dn"))
+	{
+		return FALSE;
+	}
+	found = get_secret(creds, "unknown.org", NULL);
+	if (!found || !streq(found, "any"))
+	{
+		return FALSE;
+	}
+	creds->clear_secrets(creds);
+	if (get_secret(creds, NULL, "host7.strongswan.org"))
+	{
+		return FALSE;
+	}
+	creds->destroy(creds);
+	return TRUE;
+}
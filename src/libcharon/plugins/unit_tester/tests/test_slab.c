@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2013 Hochschule fuer Technik Rapperswil
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.  See <http://www.fsf.org/copyleft/gpl.txt>.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+
+#include <library.h>
+#include <utils/slab.h>
+
+#include <pthread.h>
+
+/**
+ * Object allocated in tests
+ */
+typedef struct {
+	pthread_t owner;
+	int value;
+	char pad[20];
+} object_t;
+
+SLAB_DEFINE(object_slab, object_t);
+
+#define THREADS 8
+#define OBJECTS 1000
+
+static pthread_barrier_t barrier;
+
+static bool failed = FALSE;
+
+/**
+ * Allocate objects, free half of them and return the other half
+ */
+static void* run(object_t **objects)
+{
+	int i;
+
+	pthread_barrier_wait(&barrier);
+
+	for (i = 0; i < OBJECTS; i++)
+	{
+		SLAB_INIT(&object_slab, objects[i],
+			.owner = pthread_self(),
+			.value = i,
+		);
+	}
+	for (i = 0; i < OBJECTS; i++)
+	{
+		if (!pthread_equal(objects[i]->owner, pthread_self()) ||
+			objects[i]->value != i)
+		{	/* object handed out twice */
+			failed = TRUE;
+		}
+		if (i % 2)
+		{
+			slab_free(&object_slab, objects[i]);
+			objects[i] = NULL;
+		}
+	}
+	return NULL;
+}
+
+/*******************************************************************************
+ * slab allocator test, objects freed by a different thread
+ ******************************************************************************/
+bool test_slab()
+{
+	object_t *objects[THREADS][OBJECTS];
+	pthread_t threads[THREADS];
+	slab_stats_t stats;
+	int i, j;
+
+	pthread_barrier_init(&barrier, NULL, THREADS);
+	for (i = 0; i < THREADS; i++)
+	{
+		pthread_create(&threads[i], NULL, (void*)run, objects[i]);
+	}
+	for (i = 0; i < THREADS; i++)
+	{
+		pthread_join(threads[i], NULL);
+	}
+	pthread_barrier_destroy(&barrier);
+
+	for (i = 0; i < THREADS; i++)
+	{
+		for (j = 0; j < OBJECTS; j++)
+		{
+			slab_free(&object_slab, objects[i][j]);
+		}
+	}
+	slab_get_stats(&object_slab, &stats);
+	if (stats.in_use != 0 || stats.total > THREADS * OBJECTS * 2)
+	{
+		return FALSE;
+	}
+	return !failed;
+}
@@ -58,9 +58,14 @@ METHOD(job_t, execute, job_requeue_t,
 	enumerator_t *enumerator;
 	child_sa_t *child_sa;
 	ike_sa_t *ike_sa;
+	bool queued;
 
-	ike_sa = charon->ike_sa_manager->checkout(charon->ike_sa_manager,
-											  this->ike_sa_id);
+	ike_sa = charon->ike_sa_manager->checkout_or_queue(charon->ike_sa_manager,
+							this->ike_sa_id, &this->public.job_interface, &queued);
+	if (queued)
+	{
+		return JOB_REQUEUE_DEFERRED;
+	}
 	if (ike_sa)
 	{
 		use_time = ike_sa->get_statistic(ike_sa, STAT_INBOUND);
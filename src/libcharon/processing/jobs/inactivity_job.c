@@ -116,13 +116,15 @@ METHOD(job_t, execute, job_requeue_t,
 		}
 		else
 		{
+			if (reschedule)
+			{
+				ike_sa->schedule_job(ike_sa, (job_t*)inactivity_job_create(
+										this->reqid, this->timeout,
+										this->close_ike), reschedule, TRUE);
+			}
 			charon->ike_sa_manager->checkin(charon->ike_sa_manager, ike_sa);
 		}
 	}
-	if (reschedule)
-	{
-		return JOB_RESCHEDULE(reschedule);
-	}
 	return JOB_REQUEUE_NONE;
 }
 
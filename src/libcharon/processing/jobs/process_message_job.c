@@ -38,7 +38,7 @@ struct private_process_message_job_t {
 METHOD(job_t, destroy, void,
 	private_process_message_job_t *this)
 {
-	this->message->destroy(this->message);
+	DESTROY_IF(this->message);
 	free(this);
 }
 
@@ -46,6 +46,7 @@ METHOD(job_t, execute, job_requeue_t,
 	private_process_message_job_t *this)
 {
 	ike_sa_t *ike_sa;
+	bool queued;
 
 #ifdef ME
 	/* if this is an unencrypted INFORMATIONAL exchange it is likely a
@@ -63,22 +64,32 @@ METHOD(job_t, execute, job_requeue_t,
 	}
 #endif /* ME */
 
-	ike_sa = charon->ike_sa_manager->checkout_by_message(charon->ike_sa_manager,
-														 this->message);
+	ike_sa = charon->ike_sa_manager->checkout_by_message_or_queue(
+					charon->ike_sa_manager, this->message,
+					&this->public.job_interface, &queued);
+	if (queued)
+	{
+		return JOB_REQUEUE_DEFERRED;
+	}
 	if (ike_sa)
 	{
 		DBG1(DBG_NET, "received packet: from %#H to %#H (%zu bytes)",
 			 this->message->get_source(this->message),
 			 this->message->get_destination(this->message),
 			 this->message->get_packet_data(this->message).len);
-		if (ike_sa->process_message(ike_sa, this->message) == DESTROY_ME)
-		{
-			charon->ike_sa_manager->checkin_and_destroy(charon->ike_sa_manager,
-														ike_sa);
-		}
-		else
+		switch (ike_sa->process_message(ike_sa, this->message))
 		{
-			charon->ike_sa_manager->checkin(charon->ike_sa_manager, ike_sa);
+			case DESTROY_ME:
+				charon->ike_sa_manager->checkin_and_destroy(
+											charon->ike_sa_manager, ike_sa);
+				break;
+			case DEFERRED:
+				/* the IKE_SA keeps the message until processing resumes */
+				this->message = NULL;
+				/* FALL */
+			default:
+				charon->ike_sa_manager->checkin(charon->ike_sa_manager, ike_sa);
+				break;
 		}
 	}
 	return JOB_REQUEUE_NONE;
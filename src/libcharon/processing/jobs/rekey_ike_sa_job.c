@@ -50,10 +50,15 @@ METHOD(job_t, execute, job_requeue_t,
 	private_rekey_ike_sa_job_t *this)
 {
 	ike_sa_t *ike_sa;
+	bool queued;
 	status_t status = SUCCESS;
 
-	ike_sa = charon->ike_sa_manager->checkout(charon->ike_sa_manager,
-											  this->ike_sa_id);
+	ike_sa = charon->ike_sa_manager->checkout_or_queue(charon->ike_sa_manager,
+							this->ike_sa_id, &this->public.job_interface, &queued);
+	if (queued)
+	{
+		return JOB_REQUEUE_DEFERRED;
+	}
 	if (ike_sa == NULL)
 	{
 		DBG2(DBG_JOB, "IKE_SA to rekey not found");
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2013 Hochschule fuer Technik Rapperswil
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.  See <http://www.fsf.org/copyleft/gpl.txt>.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+
+#include "resume_message_job.h"
+
+#include <daemon.h>
+
+typedef struct private_resume_message_job_t private_resume_message_job_t;
+
+/**
+ * Private data of an resume_message_job_t object.
+ */
+struct private_resume_message_job_t {
+	/**
+	 * Public resume_message_job_t interface.
+	 */
+	resume_message_job_t public;
+
+	/**
+	 * ID of the IKE_SA to resume
+	 */
+	ike_sa_id_t *ike_sa_id;
+};
+
+METHOD(job_t, destroy, void,
+	private_resume_message_job_t *this)
+{
+	this->ike_sa_id->destroy(this->ike_sa_id);
+	free(this);
+}
+
+METHOD(job_t, execute, job_requeue_t,
+	private_resume_message_job_t *this)
+{
+	ike_sa_t *ike_sa;
+	bool queued;
+
+	ike_sa = charon->ike_sa_manager->checkout_or_queue(charon->ike_sa_manager,
+							this->ike_sa_id, &this->public.job_interface, &queued);
+	if (queued)
+	{
+		return JOB_REQUEUE_DEFERRED;
+	}
+	if (ike_sa == NULL)
+	{
+		DBG2(DBG_JOB, "IKE_SA to resume not found");
+	}
+	else
+	{
+		if (ike_sa->resume_message(ike_sa) == DESTROY_ME)
+		{
+			charon->ike_sa_manager->checkin_and_destroy(
+										charon->ike_sa_manager, ike_sa);
+		}
+		else
+		{
+			charon->ike_sa_manager->checkin(charon->ike_sa_manager, ike_sa);
+		}
+	}
+	return JOB_REQUEUE_NONE;
+}
+
+METHOD(job_t, get_priority, job_priority_t,
+	private_resume_message_job_t *this)
+{
+	/* completes an IKE_AUTH exchange, which is expensive */
+	return JOB_PRIO_LOW;
+}
+
+/*
+ * Described in header
+ */
+resume_message_job_t *resume_message_job_create(ike_sa_id_t *ike_sa_id)
+{
+	private_resume_message_job_t *this;
+
+	INIT(this,
+		.public = {
+			.job_interface = {
+				.execute = _execute,
+				.get_priority = _get_priority,
+				.destroy = _destroy,
+			},
+		},
+		.ike_sa_id = ike_sa_id->clone(ike_sa_id),
+	);
+
+	return &(this->public);
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2013 Hochschule fuer Technik Rapperswil
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.  See <http://www.fsf.org/copyleft/gpl.txt>.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+
+/**
+ * @defgroup resume_message_job resume_message_job
+ * @{ @ingroup cjobs
+ */
+
+#ifndef RESUME_MESSAGE_JOB_H_
+#define RESUME_MESSAGE_JOB_H_
+
+typedef struct resume_message_job_t resume_message_job_t;
+
+#include <library.h>
+#include <sa/ike_sa_id.h>
+#include <processing/jobs/job.h>
+
+/**
+ * Class representing a RESUME_MESSAGE Job.
+ *
+ * This job resumes processing of a message an IKE_SA has deferred, for
+ * example while waiting for an asynchronous signature verification.
+ */
+struct resume_message_job_t {
+	/**
+	 * The job_t interface.
+	 */
+	job_t job_interface;
+};
+
+/**
+ * Creates a job of type RESUME_MESSAGE.
+ *
+ * @param ike_sa_id		ID of the IKE_SA to resume message processing
+ * @return				resume_message_job_t object
+ */
+resume_message_job_t *resume_message_job_create(ike_sa_id_t *ike_sa_id);
+
+#endif /** RESUME_MESSAGE_JOB_H_ @}*/
@@ -49,9 +49,14 @@ METHOD(job_t, execute, job_requeue_t,
 	private_send_keepalive_job_t *this)
 {
 	ike_sa_t *ike_sa;
+	bool queued;
 
-	ike_sa = charon->ike_sa_manager->checkout(charon->ike_sa_manager,
-											  this->ike_sa_id);
+	ike_sa = charon->ike_sa_manager->checkout_or_queue(charon->ike_sa_manager,
+							this->ike_sa_id, &this->public.job_interface, &queued);
+	if (queued)
+	{
+		return JOB_REQUEUE_DEFERRED;
+	}
 	if (ike_sa)
 	{
 		ike_sa->send_keepalive(ike_sa);
@@ -132,6 +132,8 @@ struct authenticator_t {
 	 *						- SUCCESS if authentication successful
 	 *						- FAILED if authentication failed
 	 *						- NEED_MORE if another exchange required
+	 *						- DEFERRED if verification completes asynchronously,
+	 *						  process() gets called again with the same message
 	 */
 	status_t (*process)(authenticator_t *this, message_t *message);
 
@@ -28,6 +28,7 @@
 #include <daemon.h>
 #include <collections/linked_list.h>
 #include <utils/lexparser.h>
+#include <sa/ike_sa_timer.h>
 #include <processing/jobs/retransmit_job.h>
 #include <processing/jobs/delete_ike_sa_job.h>
 #include <processing/jobs/send_dpd_job.h>
@@ -124,6 +125,11 @@ struct private_ike_sa_t {
 	 */
 	task_manager_t *task_manager;
 
+	/**
+	 * Coalesces the timed jobs of this IKE_SA
+	 */
+	ike_sa_timer_t *timer;
+
 	/**
 	 * Address of local host
 	 */
@@ -455,6 +461,26 @@ METHOD(ike_sa_t, set_message_id, void,
 	}
 }
 
+METHOD(ike_sa_t, schedule_job, void,
+	private_ike_sa_t *this, job_t *job, u_int32_t s, bool child)
+{
+	timeval_t tv;
+
+	time_monotonic(&tv);
+	tv.tv_sec += s;
+	this->timer->schedule_job(this->timer, job, tv, child);
+}
+
+METHOD(ike_sa_t, schedule_job_ms, void,
+	private_ike_sa_t *this, job_t *job, u_int32_t ms, bool child)
+{
+	timeval_t tv;
+
+	time_monotonic(&tv);
+	timeval_add_ms(&tv, ms);
+	this->timer->schedule_job(this->timer, job, tv, child);
+}
+
 METHOD(ike_sa_t, send_keepalive, void,
 	private_ike_sa_t *this)
 {
@@ -488,8 +514,7 @@ METHOD(ike_sa_t, send_keepalive, void,
 		diff = 0;
 	}
 	job = send_keepalive_job_create(this->ike_sa_id);
-	lib->scheduler->schedule_job(lib->scheduler, (job_t*)job,
-								 this->keepalive_interval - diff);
+	schedule_job(this, (job_t*)job, this->keepalive_interval - diff, FALSE);
 }
 
 METHOD(ike_sa_t, get_ike_cfg, ike_cfg_t*,
@@ -607,7 +632,7 @@ METHOD(ike_sa_t, send_dpd, status_t,
 	if (delay)
 	{
 		job = (job_t*)send_dpd_job_create(this->ike_sa_id);
-		lib->scheduler->schedule_job(lib->scheduler, job, delay - diff);
+		schedule_job(this, job, delay - diff, FALSE);
 	}
 	if (task_queued)
 	{
@@ -653,7 +678,7 @@ METHOD(ike_sa_t, set_state, void,
 				{
 					this->stats[STAT_REKEY] = t + this->stats[STAT_ESTABLISHED];
 					job = (job_t*)rekey_ike_sa_job_create(this->ike_sa_id, FALSE);
-					lib->scheduler->schedule_job(lib->scheduler, job, t);
+					schedule_job(this, job, t, FALSE);
 					DBG1(DBG_IKE, "scheduling rekeying in %ds", t);
 				}
 				t = this->peer_cfg->get_reauth_time(this->peer_cfg, TRUE);
@@ -662,7 +687,7 @@ METHOD(ike_sa_t, set_state, void,
 				{
 					this->stats[STAT_REAUTH] = t + this->stats[STAT_ESTABLISHED];
 					job = (job_t*)rekey_ike_sa_job_create(this->ike_sa_id, TRUE);
-					lib->scheduler->schedule_job(lib->scheduler, job, t);
+					schedule_job(this, job, t, FALSE);
 					DBG1(DBG_IKE, "scheduling reauthentication in %ds", t);
 				}
 				t = this->peer_cfg->get_over_time(this->peer_cfg);
@@ -684,7 +709,7 @@ METHOD(ike_sa_t, set_state, void,
 					this->stats[STAT_DELETE] += t;
 					t = this->stats[STAT_DELETE] - this->stats[STAT_ESTABLISHED];
 					job = (job_t*)delete_ike_sa_job_create(this->ike_sa_id, TRUE);
-					lib->scheduler->schedule_job(lib->scheduler, job, t);
+					schedule_job(this, job, t, FALSE);
 					DBG1(DBG_IKE, "maximum IKE_SA lifetime %ds", t);
 				}
 				trigger_dpd = this->peer_cfg->get_dpd(this->peer_cfg);
@@ -1225,8 +1250,7 @@ METHOD(ike_sa_t, initiate, status_t,
 		if (!this->retry_initiate_queued)
 		{
 			job_t *job = (job_t*)retry_initiate_job_create(this->ike_sa_id);
-			lib->scheduler->schedule_job(lib->scheduler, (job_t*)job,
-										 this->retry_initiate_interval);
+			schedule_job(this, job, this->retry_initiate_interval, FALSE);
 			this->retry_initiate_queued = TRUE;
 		}
 		return SUCCESS;
@@ -1275,6 +1299,21 @@ METHOD(ike_sa_t, process_message, status_t,
 	return status;
 }
 
+METHOD(ike_sa_t, resume_message, status_t,
+	private_ike_sa_t *this)
+{
+	status_t status;
+
+	status = this->task_manager->resume_message(this->task_manager);
+	if (this->flush_auth_cfg && this->state == IKE_ESTABLISHED)
+	{
+		/* authentication completed */
+		this->flush_auth_cfg = FALSE;
+		flush_auth_cfgs(this);
+	}
+	return status;
+}
+
 METHOD(ike_sa_t, get_id, ike_sa_id_t*,
 	private_ike_sa_t *this)
 {
@@ -1797,9 +1836,9 @@ METHOD(ike_sa_t, set_auth_lifetime, status_t,
 		{
 			DBG1(DBG_IKE, "received AUTH_LIFETIME of %ds, scheduling "
 				 "reauthentication in %ds", lifetime, lifetime - diff);
-			lib->scheduler->schedule_job(lib->scheduler,
+			schedule_job(this,
 						(job_t*)rekey_ike_sa_job_create(this->ike_sa_id, TRUE),
-						lifetime - diff);
+						lifetime - diff, FALSE);
 		}
 	}
 	else
@@ -2067,10 +2106,12 @@ METHOD(ike_sa_t, inherit, void,
 		this->stats[STAT_DELETE] = this->stats[STAT_REAUTH] + delete;
 		DBG1(DBG_IKE, "rescheduling reauthentication in %ds after rekeying, "
 			 "lifetime reduced to %ds", reauth, delete);
-		lib->scheduler->schedule_job(lib->scheduler,
-				(job_t*)rekey_ike_sa_job_create(this->ike_sa_id, TRUE), reauth);
-		lib->scheduler->schedule_job(lib->scheduler,
-				(job_t*)delete_ike_sa_job_create(this->ike_sa_id, TRUE), delete);
+		schedule_job(this,
+				(job_t*)rekey_ike_sa_job_create(this->ike_sa_id, TRUE),
+				reauth, FALSE);
+		schedule_job(this,
+				(job_t*)delete_ike_sa_job_create(this->ike_sa_id, TRUE),
+				delete, FALSE);
 	}
 }
 
@@ -2084,6 +2125,7 @@ METHOD(ike_sa_t, destroy, void,
 
 	set_state(this, IKE_DESTROYING);
 	DESTROY_IF(this->task_manager);
+	this->timer->destroy(this->timer);
 
 	/* remove attributes first, as we pass the IKE_SA to the handler */
 	while (this->attributes->remove_last(this->attributes,
@@ -2189,6 +2231,7 @@ ike_sa_t * ike_sa_create(ike_sa_id_t *ike_sa_id, bool initiator,
 			.get_statistic = _get_statistic,
 			.set_statistic = _set_statistic,
 			.process_message = _process_message,
+			.resume_message = _resume_message,
 			.initiate = _initiate,
 			.retry_initiate = _retry_initiate,
 			.get_ike_cfg = _get_ike_cfg,
@@ -2228,6 +2271,8 @@ ike_sa_t * ike_sa_create(ike_sa_id_t *ike_sa_id, bool initiator,
 			.destroy = _destroy,
 			.send_dpd = _send_dpd,
 			.send_keepalive = _send_keepalive,
+			.schedule_job = _schedule_job,
+			.schedule_job_ms = _schedule_job_ms,
 			.get_keymat = _get_keymat,
 			.add_child_sa = _add_child_sa,
 			.get_child_sa = _get_child_sa,
@@ -2286,6 +2331,7 @@ ike_sa_t * ike_sa_create(ike_sa_id_t *ike_sa_id, bool initiator,
 		.my_vips = linked_list_create(),
 		.other_vips = linked_list_create(),
 		.attributes = linked_list_create(),
+		.timer = ike_sa_timer_create(),
 		.keepalive_interval = lib->settings->get_time(lib->settings,
 							"%s.keep_alive", KEEPALIVE_INTERVAL, charon->name),
 		.retry_initiate_interval = lib->settings->get_time(lib->settings,
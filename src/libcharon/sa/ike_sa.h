@@ -770,6 +770,16 @@ struct ike_sa_t {
 	 */
 	status_t (*process_message) (ike_sa_t *this, message_t *message);
 
+	/**
+	 * Resume processing of a message deferred by process_message().
+	 *
+	 * @return
+	 *						- SUCCESS
+	 *						- FAILED
+	 *						- DESTROY_ME if this IKE_SA MUST be deleted
+	 */
+	status_t (*resume_message) (ike_sa_t *this);
+
 	/**
 	 * Generate a IKE message to send it to the peer.
 	 *
@@ -819,6 +829,29 @@ struct ike_sa_t {
 	 */
 	void (*send_keepalive) (ike_sa_t *this);
 
+	/**
+	 * Schedule a timed job for this IKE_SA, using a relative time in s.
+	 *
+	 * All timed jobs of an IKE_SA share a single scheduler entry for the
+	 * earliest deadline, see ike_sa_timer_t.  Pending jobs are canceled when
+	 * the IKE_SA gets destroyed, except those referring to a CHILD_SA.
+	 *
+	 * @param job			job to schedule
+	 * @param s				relative time to schedule job, in s
+	 * @param child			TRUE if the job refers to a CHILD_SA
+	 */
+	void (*schedule_job) (ike_sa_t *this, job_t *job, u_int32_t s, bool child);
+
+	/**
+	 * Schedule a timed job for this IKE_SA, using a relative time in ms.
+	 *
+	 * @param job			job to schedule
+	 * @param ms			relative time to schedule job, in ms
+	 * @param child			TRUE if the job refers to a CHILD_SA
+	 */
+	void (*schedule_job_ms) (ike_sa_t *this, job_t *job, u_int32_t ms,
+							 bool child);
+
 	/**
 	 * Get the keying material of this IKE_SA.
 	 *
@@ -27,6 +27,8 @@
 #include <threading/mutex.h>
 #include <threading/rwlock.h>
 #include <collections/linked_list.h>
+#include <collections/hashtable.h>
+#include <collections/array.h>
 #include <crypto/hashers/hasher.h>
 
 /* the default size of the hash table (MUST be a power of 2) */
@@ -38,6 +40,88 @@
 /* the default number of segments (MUST be a power of 2) */
 #define DEFAULT_SEGMENT_COUNT 1
 
+typedef struct lookup_key_t lookup_key_t;
+
+/**
+ * Secondary keys an IKE_SA can be looked up with.
+ */
+typedef enum {
+	/** unique ID of the IKE_SA */
+	LOOKUP_UNIQUE_ID,
+	/** name of the IKE_SA (its peer config) */
+	LOOKUP_IKE_NAME,
+	/** reqid of one of its CHILD_SAs */
+	LOOKUP_REQID,
+	/** name of one of its CHILD_SAs */
+	LOOKUP_CHILD_NAME,
+} lookup_type_t;
+
+/**
+ * Key of the secondary lookup table
+ */
+struct lookup_key_t {
+	/** type of the key */
+	lookup_type_t type;
+
+	/** unique ID or reqid */
+	u_int32_t id;
+
+	/** IKE_SA or CHILD_SA name */
+	char *name;
+};
+
+/**
+ * Destroy a lookup key
+ */
+static void lookup_key_destroy(lookup_key_t *this)
+{
+	free(this->name);
+	free(this);
+}
+
+/**
+ * Clone a lookup key
+ */
+static lookup_key_t *lookup_key_clone(lookup_key_t *this)
+{
+	lookup_key_t *clone;
+
+	INIT(clone,
+		.type = this->type,
+		.id = this->id,
+		.name = strdupnull(this->name),
+	);
+	return clone;
+}
+
+/**
+ * Hash function for lookup keys
+ */
+static u_int lookup_key_hash(lookup_key_t *this)
+{
+	if (this->name)
+	{
+		return chunk_hash_inc(chunk_from_str(this->name), this->type);
+	}
+	return chunk_hash_inc(chunk_from_thing(this->id), this->type);
+}
+
+/**
+ * Compare two lookup keys
+ */
+static bool lookup_key_equals(lookup_key_t *a, lookup_key_t *b)
+{
+	if (a->type != b->type || a->id != b->id)
+	{
+		return FALSE;
+	}
+	if (a->name && b->name)
+	{
+		return streq(a->name, b->name);
+	}
+	return a->name == b->name;
+}
+
 typedef struct entry_t entry_t;
 
 /**
@@ -60,6 +144,17 @@ struct entry_t {
 	 */
 	bool checked_out;
 
+	/**
+	 * Jobs queued until the checked out IKE_SA gets checked in, as job_t
+	 */
+	array_t *mailbox;
+
+	/**
+	 * Queued job the IKE_SA has been handed over to at check-in, the IKE_SA
+	 * stays checked out until that job checks it out
+	 */
+	job_t *handover;
+
 	/**
 	 * Does this SA drives out new threads?
 	 */
@@ -111,6 +206,11 @@ struct entry_t {
 	 * message ID or hash of currently processing message, -1 if none
 	 */
 	u_int32_t processing;
+
+	/**
+	 * lookup keys this entry is registered with, as lookup_sa_t
+	 */
+	array_t *lookups;
 };
 
 /**
@@ -125,6 +225,9 @@ static status_t entry_destroy(entry_t *this)
 	DESTROY_IF(this->other);
 	DESTROY_IF(this->my_id);
 	DESTROY_IF(this->other_id);
+	array_destroy_offset(this->mailbox, offsetof(job_t, destroy));
+	/* unregistered with remove_lookups() */
+	array_destroy(this->lookups);
 	this->condvar->destroy(this->condvar);
 	free(this);
 	return SUCCESS;
@@ -250,6 +353,41 @@ static inline bool connected_peers_match(connected_peers_t *connected_peers,
 		   (!family || family == connected_peers->family);
 }
 
+typedef struct lookup_t lookup_t;
+typedef struct lookup_sa_t lookup_sa_t;
+
+/**
+ * IKE_SAs registered with a specific lookup key
+ */
+struct lookup_t {
+	/** key of this lookup entry */
+	lookup_key_t *key;
+
+	/** first and last IKE_SA registered with the key */
+	lookup_sa_t *first, *last;
+};
+
+/**
+ * Registration of an IKE_SA with a lookup key, referenced by the entry so it
+ * can be unregistered without searching for it
+ */
+struct lookup_sa_t {
+	/** lookup entry the IKE_SA is registered with */
+	lookup_t *lookup;
+
+	/** ID of the registered IKE_SA */
+	ike_sa_id_t *ike_sa_id;
+
+	/** previous and next IKE_SA registered with the same key */
+	lookup_sa_t *prev, *next;
+};
+
+static void lookup_destroy(lookup_t *this)
+{
+	lookup_key_destroy(this->key);
+	free(this);
+}
+
 typedef struct init_hash_t init_hash_t;
 
 struct init_hash_t {
@@ -352,6 +490,11 @@ struct private_ike_sa_manager_t {
 	 */
 	shareable_segment_t *half_open_segments;
 
+	/**
+	 * Total number of half-open IKE_SAs, readable without locking
+	 */
+	refcount_t half_open_count;
+
 	/**
 	 * Hash table with connected_peers_t objects.
 	 */
@@ -362,6 +505,16 @@ struct private_ike_sa_manager_t {
 	 */
 	shareable_segment_t *connected_peers_segments;
 
+	/**
+	 * Hash table with lookup_t objects, by lookup_key_t
+	 */
+	hashtable_t *lookups;
+
+	/**
+	 * Lock for the lookups table
+	 */
+	rwlock_t *lookups_lock;
+
 	/**
 	 * Hash table with init_hash_t objects.
 	 */
@@ -391,6 +544,11 @@ struct private_ike_sa_manager_t {
 	 * Configured IKE_SA limit, if any
 	 */
 	u_int ikesa_limit;
+
+	/**
+	 * Queue jobs to the mailbox of checked out IKE_SAs instead of waiting
+	 */
+	bool mailbox;
 };
 
 /**
@@ -721,6 +879,79 @@ static bool wait_for_entry(private_ike_sa_manager_t *this, entry_t *entry,
 	return TRUE;
 }
 
+/**
+ * Queue a job to the mailbox of an IKE_SA checked out by another thread,
+ * instead of waiting for it. Return TRUE if the job has been queued.
+ */
+static bool queue_for_entry(private_ike_sa_manager_t *this, entry_t *entry,
+							job_t *job)
+{
+	if (!this->mailbox || !job || !entry->checked_out ||
+		entry->handover == job ||
+		entry->driveout_new_threads || entry->driveout_waiting_threads)
+	{
+		return FALSE;
+	}
+	/* the job might get queued and destroyed as soon as the segment is
+	 * unlocked, so the processor must not refer to it anymore */
+	lib->processor->release_job(lib->processor, job);
+	array_insert_create(&entry->mailbox, ARRAY_TAIL, job);
+	DBG2(DBG_MGR, "IKE_SA %s[%u] in use, queued job to its mailbox",
+		 entry->ike_sa->get_name(entry->ike_sa),
+		 entry->ike_sa->get_unique_id(entry->ike_sa));
+	return TRUE;
+}
+
+/**
+ * Check if the IKE_SA has been handed over to the given job at check-in,
+ * the job gets it without waiting, as it is still checked out.
+ */
+static bool take_handover(entry_t *entry, job_t *job)
+{
+	if (job && entry->handover == job)
+	{
+		entry->handover = NULL;
+		return TRUE;
+	}
+	return FALSE;
+}
+
+/**
+ * Take the jobs from the mailbox of an IKE_SA, the next one only or all of
+ * them. Returns NULL if there are none. Has to be called with the segment
+ * locked, queue the jobs with requeue_jobs() after unlocking.
+ */
+static array_t *take_jobs(entry_t *entry, bool all)
+{
+	array_t *jobs = NULL;
+	job_t *job;
+
+	if (all)
+	{
+		jobs = entry->mailbox;
+		entry->mailbox = NULL;
+	}
+	else if (array_remove(entry->mailbox, ARRAY_HEAD, &job))
+	{
+		array_insert_create(&jobs, ARRAY_TAIL, job);
+	}
+	return jobs;
+}
+
+/**
+ * Hand jobs taken from a mailbox back to the processor
+ */
+static void requeue_jobs(array_t *jobs)
+{
+	job_t *job;
+
+	while (array_remove(jobs, ARRAY_HEAD, &job))
+	{
+		lib->processor->queue_job(lib->processor, job);
+	}
+	array_destroy(jobs);
+}
+
 /**
  * Put a half-open SA into the hash table.
  */
@@ -763,6 +994,7 @@ static void put_half_open(private_ike_sa_manager_t *this, entry_t *entry)
 		this->half_open_table[row] = item;
 	}
 	this->half_open_segments[segment].count++;
+	ref_get(&this->half_open_count);
 	lock->unlock(lock);
 }
 
@@ -802,6 +1034,7 @@ static void remove_half_open(private_ike_sa_manager_t *this, entry_t *entry)
 				free(item);
 			}
 			this->half_open_segments[segment].count--;
+			ignore_result(ref_put(&this->half_open_count));
 			break;
 		}
 		prev = item;
@@ -819,13 +1052,11 @@ static void put_connected_peers(private_ike_sa_manager_t *this, entry_t *entry)
 	u_int row, segment;
 	rwlock_t *lock;
 	connected_peers_t *connected_peers;
-	chunk_t my_id, other_id;
 	int family;
 
-	my_id = entry->my_id->get_encoding(entry->my_id);
-	other_id = entry->other_id->get_encoding(entry->other_id);
 	family = entry->other->get_family(entry->other);
-	row = chunk_hash_inc(other_id, chunk_hash(my_id)) & this->table_mask;
+	row = entry->other_id->hash(entry->other_id,
+					entry->my_id->hash(entry->my_id, 0)) & this->table_mask;
 	segment = row & this->segment_mask;
 	lock = this->connected_peers_segments[segment].lock;
 	lock->write_lock(lock);
@@ -877,14 +1108,12 @@ static void remove_connected_peers(private_ike_sa_manager_t *this, entry_t *entr
 	table_item_t *item, *prev = NULL;
 	u_int row, segment;
 	rwlock_t *lock;
-	chunk_t my_id, other_id;
 	int family;
 
-	my_id = entry->my_id->get_encoding(entry->my_id);
-	other_id = entry->other_id->get_encoding(entry->other_id);
 	family = entry->other->get_family(entry->other);
 
-	row = chunk_hash_inc(other_id, chunk_hash(my_id)) & this->table_mask;
+	row = entry->other_id->hash(entry->other_id,
+					entry->my_id->hash(entry->my_id, 0)) & this->table_mask;
 	segment = row & this->segment_mask;
 
 	lock = this->connected_peers_segments[segment].lock;
@@ -933,6 +1162,197 @@ static void remove_connected_peers(private_ike_sa_manager_t *this, entry_t *entr
 	lock->unlock(lock);
 }
 
+/**
+ * Check if the given lookup key still matches an IKE_SA
+ */
+static bool lookup_key_matches(lookup_key_t *key, ike_sa_t *ike_sa)
+{
+	enumerator_t *enumerator;
+	child_sa_t *child_sa;
+	bool match = FALSE;
+
+	switch (key->type)
+	{
+		case LOOKUP_UNIQUE_ID:
+			return ike_sa->get_unique_id(ike_sa) == key->id;
+		case LOOKUP_IKE_NAME:
+			return ike_sa->get_peer_cfg(ike_sa) &&
+				   streq(ike_sa->get_name(ike_sa), key->name);
+		case LOOKUP_REQID:
+		case LOOKUP_CHILD_NAME:
+			break;
+	}
+	enumerator = ike_sa->create_child_sa_enumerator(ike_sa);
+	while (enumerator->enumerate(enumerator, &child_sa))
+	{
+		if (key->type == LOOKUP_REQID)
+		{
+			match = child_sa->get_reqid(child_sa) == key->id;
+		}
+		else
+		{
+			match = streq(child_sa->get_name(child_sa), key->name);
+		}
+		if (match)
+		{
+			break;
+		}
+	}
+	enumerator->destroy(enumerator);
+	return match;
+}
+
+/**
+ * Register an entry with a lookup key, unless it already is
+ */
+static void put_lookup(private_ike_sa_manager_t *this, entry_t *entry,
+					   lookup_key_t *key)
+{
+	enumerator_t *enumerator;
+	lookup_sa_t *current;
+	lookup_t *lookup;
+	bool found = FALSE;
+
+	enumerator = array_create_enumerator(entry->lookups);
+	while (enumerator->enumerate(enumerator, &current))
+	{	/* the key of a lookup entry we are registered with does not change */
+		if (lookup_key_equals(current->lookup->key, key))
+		{
+			found = TRUE;
+			break;
+		}
+	}
+	enumerator->destroy(enumerator);
+	if (found)
+	{
+		return;
+	}
+
+	INIT(current,
+		.ike_sa_id = entry->ike_sa_id->clone(entry->ike_sa_id),
+	);
+	this->lookups_lock->write_lock(this->lookups_lock);
+	lookup = this->lookups->get(this->lookups, key);
+	if (!lookup)
+	{
+		INIT(lookup,
+			.key = lookup_key_clone(key),
+		);
+		this->lookups->put(this->lookups, lookup->key, lookup);
+	}
+	current->lookup = lookup;
+	current->prev = lookup->last;
+	if (lookup->last)
+	{
+		lookup->last->next = current;
+	}
+	else
+	{
+		lookup->first = current;
+	}
+	lookup->last = current;
+	this->lookups_lock->unlock(this->lookups_lock);
+
+	array_insert_create(&entry->lookups, ARRAY_TAIL, current);
+}
+
+/**
+ * Remove and destroy a registration of an entry with a lookup key
+ */
+static void remove_lookup(private_ike_sa_manager_t *this, lookup_sa_t *current)
+{
+	lookup_t *lookup = current->lookup;
+
+	this->lookups_lock->write_lock(this->lookups_lock);
+	if (current->prev)
+	{
+		current->prev->next = current->next;
+	}
+	else
+	{
+		lookup->first = current->next;
+	}
+	if (current->next)
+	{
+		current->next->prev = current->prev;
+	}
+	else
+	{
+		lookup->last = current->prev;
+	}
+	if (!lookup->first)
+	{
+		this->lookups->remove(this->lookups, lookup->key);
+		lookup_destroy(lookup);
+	}
+	this->lookups_lock->unlock(this->lookups_lock);
+	current->ike_sa_id->destroy(current->ike_sa_id);
+	free(current);
+}
+
+/**
+ * Unregister an entry from all its lookup keys
+ */
+static void remove_lookups(private_ike_sa_manager_t *this, entry_t *entry)
+{
+	lookup_sa_t *current;
+
+	while (array_remove(entry->lookups, ARRAY_HEAD, &current))
+	{
+		remove_lookup(this, current);
+	}
+}
+
+/**
+ * Update the lookup keys of an entry to match the current state of its IKE_SA.
+ * Note: The caller MUST have a lock on the segment of this entry.
+ */
+static void update_lookups(private_ike_sa_manager_t *this, entry_t *entry)
+{
+	enumerator_t *enumerator;
+	child_sa_t *child_sa;
+	lookup_key_t current;
+	lookup_sa_t *registered;
+	ike_sa_t *ike_sa = entry->ike_sa;
+
+	enumerator = array_create_enumerator(entry->lookups);
+	while (enumerator->enumerate(enumerator, &registered))
+	{
+		if (!lookup_key_matches(registered->lookup->key, ike_sa))
+		{
+			array_remove_at(entry->lookups, enumerator);
+			remove_lookup(this, registered);
+		}
+	}
+	enumerator->destroy(enumerator);
+
+	current.type = LOOKUP_UNIQUE_ID;
+	current.id = ike_sa->get_unique_id(ike_sa);
+	current.name = NULL;
+	put_lookup(this, entry, &current);
+	if (ike_sa->get_peer_cfg(ike_sa))
+	{	/* IKE_SAs without config share a placeholder name, don't index it */
+		current.type = LOOKUP_IKE_NAME;
+		current.id = 0;
+		current.name = ike_sa->get_name(ike_sa);
+		put_lookup(this, entry, &current);
+	}
+
+	enumerator = ike_sa->create_child_sa_enumerator(ike_sa);
+	while (enumerator->enumerate(enumerator, &child_sa))
+	{
+		current.type = LOOKUP_REQID;
+		current.id = child_sa->get_reqid(child_sa);
+		current.name = NULL;
+		put_lookup(this, entry, &current);
+		current.type = LOOKUP_CHILD_NAME;
+		current.id = 0;
+		current.name = child_sa->get_name(child_sa);
+		put_lookup(this, entry, &current);
+	}
+	enumerator->destroy(enumerator);
+}
+
 /**
  * Get a random SPI for new IKE_SAs
  */
@@ -1100,8 +1520,12 @@ static void remove_init_hash(private_ike_sa_manager_t *this, chunk_t init_hash)
 	mutex->unlock(mutex);
 }
 
-METHOD(ike_sa_manager_t, checkout, ike_sa_t*,
-	private_ike_sa_manager_t *this, ike_sa_id_t *ike_sa_id)
+/**
+ * Checkout an IKE_SA by ID, queue the job to the mailbox if given and in use
+ */
+static ike_sa_t *checkout_internal(private_ike_sa_manager_t *this,
+								   ike_sa_id_t *ike_sa_id, job_t *job,
+								   bool *queued)
 {
 	ike_sa_t *ike_sa = NULL;
 	entry_t *entry;
@@ -1111,7 +1535,12 @@ METHOD(ike_sa_manager_t, checkout, ike_sa_t*,
 
 	if (get_entry_by_id(this, ike_sa_id, &entry, &segment) == SUCCESS)
 	{
-		if (wait_for_entry(this, entry, segment))
+		if (queue_for_entry(this, entry, job))
+		{
+			*queued = TRUE;
+		}
+		else if (take_handover(entry, job) ||
+				 wait_for_entry(this, entry, segment))
 		{
 			entry->checked_out = TRUE;
 			ike_sa = entry->ike_sa;
@@ -1124,6 +1553,20 @@ METHOD(ike_sa_manager_t, checkout, ike_sa_t*,
 	return ike_sa;
 }
 
+METHOD(ike_sa_manager_t, checkout, ike_sa_t*,
+	private_ike_sa_manager_t *this, ike_sa_id_t *ike_sa_id)
+{
+	return checkout_internal(this, ike_sa_id, NULL, NULL);
+}
+
+METHOD(ike_sa_manager_t, checkout_or_queue, ike_sa_t*,
+	private_ike_sa_manager_t *this, ike_sa_id_t *ike_sa_id, job_t *job,
+	bool *queued)
+{
+	*queued = FALSE;
+	return checkout_internal(this, ike_sa_id, job, queued);
+}
+
 METHOD(ike_sa_manager_t, checkout_new, ike_sa_t*,
 	private_ike_sa_manager_t* this, ike_version_t version, bool initiator)
 {
@@ -1174,8 +1617,12 @@ static u_int32_t get_message_id_or_hash(message_t *message)
 	return message->get_message_id(message);
 }
 
-METHOD(ike_sa_manager_t, checkout_by_message, ike_sa_t*,
-	private_ike_sa_manager_t* this, message_t *message)
+/**
+ * Checkout an IKE_SA by message, queue the job to the mailbox if given and
+ * in use
+ */
+static ike_sa_t *checkout_by_message_internal(private_ike_sa_manager_t *this,
+									message_t *message, job_t *job, bool *queued)
 {
 	u_int segment;
 	entry_t *entry;
@@ -1247,6 +1694,7 @@ METHOD(ike_sa_manager_t, checkout_by_message, ike_sa_t*,
 
 						segment = put_entry(this, entry);
 						entry->checked_out = TRUE;
+						update_lookups(this, entry);
 						unlock_single_segment(this, segment);
 
 						entry->processing = get_message_id_or_hash(message);
@@ -1299,7 +1747,12 @@ METHOD(ike_sa_manager_t, checkout_by_message, ike_sa_t*,
 			DBG1(DBG_MGR, "ignoring request with ID %u, already processing",
 				 entry->processing);
 		}
-		else if (wait_for_entry(this, entry, segment))
+		else if (queue_for_entry(this, entry, job))
+		{
+			*queued = TRUE;
+		}
+		else if (take_handover(entry, job) ||
+				 wait_for_entry(this, entry, segment))
 		{
 			ike_sa_id_t *ike_id;
 
@@ -1328,6 +1781,20 @@ METHOD(ike_sa_manager_t, checkout_by_message, ike_sa_t*,
 	return ike_sa;
 }
 
+METHOD(ike_sa_manager_t, checkout_by_message, ike_sa_t*,
+	private_ike_sa_manager_t* this, message_t *message)
+{
+	return checkout_by_message_internal(this, message, NULL, NULL);
+}
+
+METHOD(ike_sa_manager_t, checkout_by_message_or_queue, ike_sa_t*,
+	private_ike_sa_manager_t* this, message_t *message, job_t *job,
+	bool *queued)
+{
+	*queued = FALSE;
+	return checkout_by_message_internal(this, message, job, queued);
+}
+
 METHOD(ike_sa_manager_t, checkout_by_config, ike_sa_t*,
 	private_ike_sa_manager_t *this, peer_cfg_t *peer_cfg)
 {
@@ -1384,106 +1851,109 @@ METHOD(ike_sa_manager_t, checkout_by_config, ike_sa_t*,
 	return ike_sa;
 }
 
-METHOD(ike_sa_manager_t, checkout_by_id, ike_sa_t*,
-	private_ike_sa_manager_t *this, u_int32_t id, bool child)
+/**
+ * Get a copy of the ID of the first IKE_SA registered with the given lookup
+ * key, skipping the IKE_SAs in tried
+ */
+static ike_sa_id_t *get_lookup_id(private_ike_sa_manager_t *this,
+								  lookup_key_t *key, array_t *tried)
 {
-	enumerator_t *enumerator, *children;
-	entry_t *entry;
-	ike_sa_t *ike_sa = NULL;
-	child_sa_t *child_sa;
-	u_int segment;
-
-	DBG2(DBG_MGR, "checkout IKE_SA by ID");
+	ike_sa_id_t *ike_sa_id = NULL, *current;
+	lookup_sa_t *registered = NULL;
+	lookup_t *lookup;
+	int i;
 
-	enumerator = create_table_enumerator(this);
-	while (enumerator->enumerate(enumerator, &entry, &segment))
+	this->lookups_lock->read_lock(this->lookups_lock);
+	lookup = this->lookups->get(this->lookups, key);
+	if (lookup)
 	{
-		if (wait_for_entry(this, entry, segment))
+		registered = lookup->first;
+	}
+	for (; registered && !ike_sa_id; registered = registered->next)
+	{
+		ike_sa_id = registered->ike_sa_id;
+		array_foreach(tried, i, &current)
 		{
-			/* look for a child with such a reqid ... */
-			if (child)
+			if (current->equals(current, ike_sa_id))
 			{
-				children = entry->ike_sa->create_child_sa_enumerator(entry->ike_sa);
-				while (children->enumerate(children, (void**)&child_sa))
-				{
-					if (child_sa->get_reqid(child_sa) == id)
-					{
-						ike_sa = entry->ike_sa;
-						break;
-					}
-				}
-				children->destroy(children);
-			}
-			else /* ... or for a IKE_SA with such a unique id */
-			{
-				if (entry->ike_sa->get_unique_id(entry->ike_sa) == id)
-				{
-					ike_sa = entry->ike_sa;
-				}
-			}
-			/* got one, return */
-			if (ike_sa)
-			{
-				entry->checked_out = TRUE;
-				DBG2(DBG_MGR, "IKE_SA %s[%u] successfully checked out",
-						ike_sa->get_name(ike_sa), ike_sa->get_unique_id(ike_sa));
+				ike_sa_id = NULL;
 				break;
 			}
 		}
 	}
-	enumerator->destroy(enumerator);
-
-	charon->bus->set_sa(charon->bus, ike_sa);
-	return ike_sa;
+	if (ike_sa_id)
+	{
+		ike_sa_id = ike_sa_id->clone(ike_sa_id);
+	}
+	this->lookups_lock->unlock(this->lookups_lock);
+	return ike_sa_id;
 }
 
-METHOD(ike_sa_manager_t, checkout_by_name, ike_sa_t*,
-	private_ike_sa_manager_t *this, char *name, bool child)
+/**
+ * Checkout an IKE_SA registered with the given lookup key
+ */
+static ike_sa_t *checkout_by_lookup(private_ike_sa_manager_t *this,
+									lookup_key_t *key)
 {
-	enumerator_t *enumerator, *children;
-	entry_t *entry;
+	array_t *tried = NULL;
+	ike_sa_id_t *ike_sa_id;
 	ike_sa_t *ike_sa = NULL;
-	child_sa_t *child_sa;
+	entry_t *entry;
 	u_int segment;
 
-	enumerator = create_table_enumerator(this);
-	while (enumerator->enumerate(enumerator, &entry, &segment))
+	/* usually the first registered IKE_SA matches, so we don't copy the IDs
+	 * of all of them, but get them one by one */
+	while (!ike_sa && (ike_sa_id = get_lookup_id(this, key, tried)))
 	{
-		if (wait_for_entry(this, entry, segment))
+		if (get_entry_by_id(this, ike_sa_id, &entry, &segment) == SUCCESS)
 		{
-			/* look for a child with such a policy name ... */
-			if (child)
-			{
-				children = entry->ike_sa->create_child_sa_enumerator(entry->ike_sa);
-				while (children->enumerate(children, (void**)&child_sa))
-				{
-					if (streq(child_sa->get_name(child_sa), name))
-					{
-						ike_sa = entry->ike_sa;
-						break;
-					}
-				}
-				children->destroy(children);
-			}
-			else /* ... or for a IKE_SA with such a connection name */
-			{
-				if (streq(entry->ike_sa->get_name(entry->ike_sa), name))
-				{
-					ike_sa = entry->ike_sa;
-				}
-			}
-			/* got one, return */
-			if (ike_sa)
+			/* the IKE_SA might have changed while we were waiting */
+			if (wait_for_entry(this, entry, segment) &&
+				lookup_key_matches(key, entry->ike_sa))
 			{
 				entry->checked_out = TRUE;
+				ike_sa = entry->ike_sa;
 				DBG2(DBG_MGR, "IKE_SA %s[%u] successfully checked out",
 						ike_sa->get_name(ike_sa), ike_sa->get_unique_id(ike_sa));
-				break;
 			}
+			unlock_single_segment(this, segment);
 		}
+		array_insert_create(&tried, ARRAY_TAIL, ike_sa_id);
 	}
-	enumerator->destroy(enumerator);
+	array_destroy_offset(tried, offsetof(ike_sa_id_t, destroy));
+	return ike_sa;
+}
 
+METHOD(ike_sa_manager_t, checkout_by_id, ike_sa_t*,
+	private_ike_sa_manager_t *this, u_int32_t id, bool child)
+{
+	lookup_key_t key = {
+		/* look for a child with such a reqid or for an IKE_SA with such a
+		 * unique id */
+		.type = child ? LOOKUP_REQID : LOOKUP_UNIQUE_ID,
+		.id = id,
+	};
+	ike_sa_t *ike_sa;
+
+	DBG2(DBG_MGR, "checkout IKE_SA by ID");
+
+	ike_sa = checkout_by_lookup(this, &key);
+	charon->bus->set_sa(charon->bus, ike_sa);
+	return ike_sa;
+}
+
+METHOD(ike_sa_manager_t, checkout_by_name, ike_sa_t*,
+	private_ike_sa_manager_t *this, char *name, bool child)
+{
+	lookup_key_t key = {
+		/* look for a child with such a policy name or for an IKE_SA with such
+		 * a connection name */
+		.type = child ? LOOKUP_CHILD_NAME : LOOKUP_IKE_NAME,
+		.name = name,
+	};
+	ike_sa_t *ike_sa;
+
+	ike_sa = checkout_by_lookup(this, &key);
 	charon->bus->set_sa(charon->bus, ike_sa);
 	return ike_sa;
 }
@@ -1549,6 +2019,7 @@ METHOD(ike_sa_manager_t, checkin, void,
 	ike_sa_id_t *ike_sa_id;
 	host_t *other;
 	identification_t *my_id, *other_id;
+	array_t *jobs = NULL;
 	u_int segment;
 
 	ike_sa_id = ike_sa->get_id(ike_sa);
@@ -1562,6 +2033,10 @@ METHOD(ike_sa_manager_t, checkin, void,
 	/* look for the entry */
 	if (get_entry_by_sa(this, ike_sa_id, ike_sa, &entry, &segment) == SUCCESS)
 	{
+		if (!entry->ike_sa_id->equals(entry->ike_sa_id, ike_sa_id))
+		{	/* lookups are registered with the old ike_sa_id */
+			remove_lookups(this, entry);
+		}
 		/* ike_sa_id must be updated */
 		entry->ike_sa_id->replace_values(entry->ike_sa_id, ike_sa->get_id(ike_sa));
 		/* signal waiting threads */
@@ -1592,7 +2067,21 @@ METHOD(ike_sa_manager_t, checkin, void,
 			put_half_open(this, entry);
 		}
 		DBG2(DBG_MGR, "check-in of IKE_SA successful.");
-		entry->condvar->signal(entry->condvar);
+		if (!entry->driveout_new_threads)
+		{	/* hand over the IKE_SA to the next queued job, if any. It stays
+			 * checked out until that job runs, so it gets processed before
+			 * jobs of other threads or queued later */
+			jobs = take_jobs(entry, FALSE);
+		}
+		if (jobs)
+		{
+			array_get(jobs, ARRAY_HEAD, &entry->handover);
+			entry->checked_out = TRUE;
+		}
+		else
+		{
+			entry->condvar->signal(entry->condvar);
+		}
 	}
 	else
 	{
@@ -1626,10 +2115,12 @@ METHOD(ike_sa_manager_t, checkin, void,
 		}
 		put_connected_peers(this, entry);
 	}
+	update_lookups(this, entry);
 
 	unlock_single_segment(this, segment);
 
 	charon->bus->set_sa(charon->bus, NULL);
+	requeue_jobs(jobs);
 }
 
 METHOD(ike_sa_manager_t, checkin_and_destroy, void,
@@ -1642,6 +2133,7 @@ METHOD(ike_sa_manager_t, checkin_and_destroy, void,
 	 */
 	entry_t *entry;
 	ike_sa_id_t *ike_sa_id;
+	array_t *jobs;
 	u_int segment;
 
 	ike_sa_id = ike_sa->get_id(ike_sa);
@@ -1657,7 +2149,9 @@ METHOD(ike_sa_manager_t, checkin_and_destroy, void,
 			DBG2(DBG_MGR, "ignored check-in and destroy of IKE_SA during shutdown");
 			entry->checked_out = FALSE;
 			entry->condvar->broadcast(entry->condvar);
+			jobs = take_jobs(entry, TRUE);
 			unlock_single_segment(this, segment);
+			requeue_jobs(jobs);
 			return;
 		}
 
@@ -1674,7 +2168,10 @@ METHOD(ike_sa_manager_t, checkin_and_destroy, void,
 			entry->condvar->wait(entry->condvar, this->segments[segment].mutex);
 		}
 		remove_entry(this, entry);
+		/* queued jobs won't find the IKE_SA anymore */
+		jobs = take_jobs(entry, TRUE);
 		unlock_single_segment(this, segment);
+		requeue_jobs(jobs);
 
 		if (entry->half_open)
 		{
@@ -1684,6 +2181,7 @@ METHOD(ike_sa_manager_t, checkin_and_destroy, void,
 		{
 			remove_connected_peers(this, entry);
 		}
+		remove_lookups(this, entry);
 		if (entry->init_hash.ptr)
 		{
 			remove_init_hash(this, entry->init_hash);
@@ -1718,8 +2216,7 @@ METHOD(ike_sa_manager_t, create_id_enumerator, enumerator_t*,
 	rwlock_t *lock;
 	linked_list_t *ids = NULL;
 
-	row = chunk_hash_inc(other->get_encoding(other),
-						 chunk_hash(me->get_encoding(me))) & this->table_mask;
+	row = other->hash(other, me->hash(me, 0)) & this->table_mask;
 	segment = row & this->segment_mask;
 
 	lock = this->connected_peers_segments[segment].lock;
@@ -1862,8 +2359,7 @@ METHOD(ike_sa_manager_t, has_contact, bool,
 	rwlock_t *lock;
 	bool found = FALSE;
 
-	row = chunk_hash_inc(other->get_encoding(other),
-						 chunk_hash(me->get_encoding(me))) & this->table_mask;
+	row = other->hash(other, me->hash(me, 0)) & this->table_mask;
 	segment = row & this->segment_mask;
 	lock = this->connected_peers_segments[segment].lock;
 	lock->read_lock(lock);
@@ -1930,13 +2426,7 @@ METHOD(ike_sa_manager_t, get_half_open_count, u_int,
 	}
 	else
 	{
-		for (segment = 0; segment < this->segment_count; segment++)
-		{
-			lock = this->half_open_segments[segment].lock;
-			lock->read_lock(lock);
-			count += this->half_open_segments[segment].count;
-			lock->unlock(lock);
-		}
+		count = this->half_open_count;
 	}
 	return count;
 }
@@ -1959,6 +2449,11 @@ METHOD(ike_sa_manager_t, flush, void,
 		/* do not accept new threads, drive out waiting threads */
 		entry->driveout_new_threads = TRUE;
 		entry->driveout_waiting_threads = TRUE;
+		if (entry->handover)
+		{	/* the job won't get the IKE_SA anymore */
+			entry->handover = NULL;
+			entry->checked_out = FALSE;
+		}
 	}
 	enumerator->destroy(enumerator);
 	DBG2(DBG_MGR, "wait for all threads to leave IKE_SA's");
@@ -2012,6 +2507,7 @@ METHOD(ike_sa_manager_t, flush, void,
 		{
 			remove_connected_peers(this, entry);
 		}
+		remove_lookups(this, entry);
 		if (entry->init_hash.ptr)
 		{
 			remove_init_hash(this, entry->init_hash);
@@ -2039,6 +2535,8 @@ METHOD(ike_sa_manager_t, destroy, void,
 	free(this->half_open_table);
 	free(this->connected_peers_table);
 	free(this->init_hashes_table);
+	this->lookups->destroy(this->lookups);
+	this->lookups_lock->destroy(this->lookups_lock);
 	for (i = 0; i < this->segment_count; i++)
 	{
 		this->segments[i].mutex->destroy(this->segments[i].mutex);
@@ -2083,8 +2581,10 @@ ike_sa_manager_t *ike_sa_manager_create()
 	INIT(this,
 		.public = {
 			.checkout = _checkout,
+			.checkout_or_queue = _checkout_or_queue,
 			.checkout_new = _checkout_new,
 			.checkout_by_message = _checkout_by_message,
+			.checkout_by_message_or_queue = _checkout_by_message_or_queue,
 			.checkout_by_config = _checkout_by_config,
 			.checkout_by_id = _checkout_by_id,
 			.checkout_by_name = _checkout_by_name,
@@ -2158,6 +2658,11 @@ ike_sa_manager_t *ike_sa_manager_create()
 		this->connected_peers_segments[i].count = 0;
 	}
 
+	/* secondary lookups by name, unique ID and reqid */
+	this->lookups = hashtable_create((hashtable_hash_t)lookup_key_hash,
+									 (hashtable_equals_t)lookup_key_equals, 8);
+	this->lookups_lock = rwlock_create(RWLOCK_TYPE_DEFAULT);
+
 	/* and again for the table of hashes of seen initial IKE messages */
 	this->init_hashes_table = calloc(this->table_size, sizeof(table_item_t*));
 	this->init_hashes_segments = calloc(this->segment_count, sizeof(segment_t));
@@ -2169,5 +2674,7 @@ ike_sa_manager_t *ike_sa_manager_create()
 
 	this->reuse_ikesa = lib->settings->get_bool(lib->settings,
 										"%s.reuse_ikesa", TRUE, charon->name);
+	this->mailbox = lib->settings->get_bool(lib->settings,
+										"%s.ikesa_mailbox", FALSE, charon->name);
 	return &this->public;
 }
@@ -29,6 +29,7 @@ typedef struct ike_sa_manager_t ike_sa_manager_t;
 #include <sa/ike_sa.h>
 #include <encoding/message.h>
 #include <config/peer_cfg.h>
+#include <processing/jobs/job.h>
 
 /**
  * Manages and synchronizes access to all IKE_SAs.
@@ -49,6 +50,26 @@ struct ike_sa_manager_t {
 	 */
 	ike_sa_t* (*checkout) (ike_sa_manager_t* this, ike_sa_id_t *sa_id);
 
+	/**
+	 * Checkout an existing IKE_SA, or queue a job to its mailbox if in use.
+	 *
+	 * If IKE_SA mailboxes are enabled and the IKE_SA is currently checked
+	 * out by another thread, the calling job is queued to the mailbox of the
+	 * IKE_SA instead of blocking the thread. Once the IKE_SA gets checked in,
+	 * the job is queued to the processor again, where it is expected to
+	 * retry the checkout. A queued job has to return JOB_REQUEUE_DEFERRED
+	 * without accessing itself afterwards.
+	 *
+	 * @param ike_sa_id			the SA identifier, will be updated
+	 * @param job				job calling this method
+	 * @param queued			set to TRUE if the job has been queued
+	 * @returns
+	 * 							- checked out IKE_SA if found
+	 * 							- NULL, if not found or job queued
+	 */
+	ike_sa_t* (*checkout_or_queue)(ike_sa_manager_t* this, ike_sa_id_t *sa_id,
+								   job_t *job, bool *queued);
+
 	/**
 	 * Create and check out a new IKE_SA.
 	 *
@@ -82,6 +103,22 @@ struct ike_sa_manager_t {
 	 */
 	ike_sa_t* (*checkout_by_message) (ike_sa_manager_t* this, message_t *message);
 
+	/**
+	 * Checkout an IKE_SA by a message, or queue a job to its mailbox if in use.
+	 *
+	 * Same as checkout_by_message(), but queues the calling job instead of
+	 * waiting for the IKE_SA, as described in checkout_or_queue().
+	 *
+	 * @param message			message to find IKE_SA for
+	 * @param job				job calling this method
+	 * @param queued			set to TRUE if the job has been queued
+	 * @returns
+	 * 							- checked out/created IKE_SA
+	 * 							- NULL to not process message further
+	 */
+	ike_sa_t* (*checkout_by_message_or_queue)(ike_sa_manager_t* this,
+									message_t *message, job_t *job, bool *queued);
+
 	/**
 	 * Checkout an IKE_SA for initiation by a peer_config.
 	 *
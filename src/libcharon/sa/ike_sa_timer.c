@@ -0,0 +1,274 @@
+/*
+ * Copyright (C) 2013 Hochschule fuer Technik Rapperswil
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.  See <http://www.fsf.org/copyleft/gpl.txt>.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+
+#include "ike_sa_timer.h"
+
+#include <threading/mutex.h>
+#include <collections/array.h>
+#include <processing/jobs/callback_job.h>
+
+typedef struct private_ike_sa_timer_t private_ike_sa_timer_t;
+
+/**
+ * Private data of an ike_sa_timer_t object.
+ */
+struct private_ike_sa_timer_t {
+
+	/**
+	 * Public ike_sa_timer_t interface.
+	 */
+	ike_sa_timer_t public;
+
+	/**
+	 * Pending jobs, as event_t, sorted by deadline
+	 */
+	array_t *events;
+
+	/**
+	 * Deadlines of scheduled timer jobs, as timeval_t, earliest last
+	 */
+	array_t *ticks;
+
+	/**
+	 * Has the timer been destroyed?
+	 */
+	bool destroyed;
+
+	/**
+	 * References held by the owner and scheduled timer jobs
+	 */
+	refcount_t ref;
+
+	/**
+	 * Lock for the above
+	 */
+	mutex_t *mutex;
+};
+
+/**
+ * A pending job
+ */
+typedef struct {
+
+	/** absolute deadline */
+	timeval_t time;
+
+	/** job to queue */
+	job_t *job;
+
+	/** does the job refer to a CHILD_SA? */
+	bool child;
+} event_t;
+
+/**
+ * Data of a scheduled timer job
+ */
+typedef struct {
+
+	/** timer that scheduled the job */
+	private_ike_sa_timer_t *timer;
+
+	/** deadline the timer job is scheduled for */
+	timeval_t time;
+} tick_t;
+
+/**
+ * Release a reference to the timer, destroy it if it was the last one
+ */
+static void timer_unref(private_ike_sa_timer_t *this)
+{
+	if (ref_put(&this->ref))
+	{
+		array_destroy(this->events);
+		array_destroy(this->ticks);
+		this->mutex->destroy(this->mutex);
+		free(this);
+	}
+}
+
+/**
+ * Cleanup function of timer jobs
+ */
+static void tick_destroy(tick_t *tick)
+{
+	timer_unref(tick->timer);
+	free(tick);
+}
+
+static job_requeue_t fire(tick_t *tick);
+
+/**
+ * Schedule a timer job for the earliest deadline, unless a scheduled one fires
+ * early enough. As timer jobs can't be unscheduled, a later one stays pending
+ * and handles the deadlines due when it fires, so each scheduled timer job
+ * serves a deadline, and one is added only for a new earliest deadline.
+ * Note: The caller has to hold the lock.
+ */
+static void schedule_tick(private_ike_sa_timer_t *this)
+{
+	event_t *event;
+	timeval_t next;
+	tick_t *tick;
+
+	if (!array_get(this->events, ARRAY_HEAD, &event))
+	{
+		return;
+	}
+	if (array_get(this->ticks, ARRAY_TAIL, &next) &&
+		!timercmp(&event->time, &next, <))
+	{	/* a pending timer job fires early enough */
+		return;
+	}
+	array_insert(this->ticks, ARRAY_TAIL, &event->time);
+
+	INIT(tick,
+		.timer = this,
+		.time = event->time,
+	);
+	ref_get(&this->ref);
+	lib->scheduler->schedule_job_tv(lib->scheduler,
+				(job_t*)callback_job_create_with_prio((callback_job_cb_t)fire,
+						tick, (callback_job_cleanup_t)tick_destroy, NULL,
+						JOB_PRIO_HIGH), event->time);
+}
+
+/**
+ * Queue all due jobs and schedule the timer for the next deadline, if necessary
+ */
+static job_requeue_t fire(tick_t *tick)
+{
+	private_ike_sa_timer_t *this = tick->timer;
+	array_t *due = NULL;
+	event_t *event;
+	job_t *job;
+	timeval_t now, time;
+	int i;
+
+	this->mutex->lock(this->mutex);
+	for (i = array_count(this->ticks) - 1; i >= 0; i--)
+	{
+		array_get(this->ticks, i, &time);
+		if (timercmp(&time, &tick->time, ==))
+		{
+			array_remove(this->ticks, i, NULL);
+			break;
+		}
+	}
+	if (this->destroyed)
+	{
+		this->mutex->unlock(this->mutex);
+		return JOB_REQUEUE_NONE;
+	}
+	time_monotonic(&now);
+	while (array_get(this->events, ARRAY_HEAD, &event) &&
+		   !timercmp(&now, &event->time, <))
+	{
+		array_remove(this->events, ARRAY_HEAD, NULL);
+		array_insert_create(&due, ARRAY_TAIL, event->job);
+		free(event);
+	}
+	schedule_tick(this);
+	this->mutex->unlock(this->mutex);
+
+	while (array_remove(due, ARRAY_HEAD, &job))
+	{
+		lib->processor->queue_job(lib->processor, job);
+	}
+	array_destroy(due);
+	return JOB_REQUEUE_NONE;
+}
+
+METHOD(ike_sa_timer_t, schedule_job, void,
+	private_ike_sa_timer_t *this, job_t *job, timeval_t tv, bool child)
+{
+	event_t *event, *current;
+	int i;
+
+	INIT(event,
+		.time = tv,
+		.job = job,
+		.child = child,
+	);
+
+	this->mutex->lock(this->mutex);
+	/* insert after all jobs with an earlier or equal deadline, searching from
+	 * the end as most jobs get scheduled later than the pending ones */
+	for (i = array_count(this->events); i > 0; i--)
+	{
+		array_get(this->events, i - 1, &current);
+		if (!timercmp(&event->time, &current->time, <))
+		{
+			break;
+		}
+	}
+	array_insert_create(&this->events, i, event);
+	schedule_tick(this);
+	this->mutex->unlock(this->mutex);
+}
+
+METHOD(ike_sa_timer_t, get_count, u_int,
+	private_ike_sa_timer_t *this)
+{
+	u_int count;
+
+	this->mutex->lock(this->mutex);
+	count = array_count(this->events);
+	this->mutex->unlock(this->mutex);
+	return count;
+}
+
+METHOD(ike_sa_timer_t, destroy, void,
+	private_ike_sa_timer_t *this)
+{
+	event_t *event;
+
+	this->mutex->lock(this->mutex);
+	this->destroyed = TRUE;
+	while (array_remove(this->events, ARRAY_HEAD, &event))
+	{
+		if (event->child)
+		{
+			lib->scheduler->schedule_job_tv(lib->scheduler, event->job,
+											event->time);
+		}
+		else
+		{
+			event->job->destroy(event->job);
+		}
+		free(event);
+	}
+	this->mutex->unlock(this->mutex);
+	timer_unref(this);
+}
+
+/*
+ * Described in header.
+ */
+ike_sa_timer_t *ike_sa_timer_create()
+{
+	private_ike_sa_timer_t *this;
+
+	INIT(this,
+		.public = {
+			.schedule_job = _schedule_job,
+			.get_count = _get_count,
+			.destroy = _destroy,
+		},
+		.ticks = array_create(sizeof(timeval_t), 0),
+		.ref = 1,
+		.mutex = mutex_create(MUTEX_TYPE_DEFAULT),
+	);
+
+	return &this->public;
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2013 Hochschule fuer Technik Rapperswil
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.  See <http://www.fsf.org/copyleft/gpl.txt>.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+
+/**
+ * @defgroup ike_sa_timer ike_sa_timer
+ * @{ @ingroup sa
+ */
+
+#ifndef IKE_SA_TIMER_H_
+#define IKE_SA_TIMER_H_
+
+typedef struct ike_sa_timer_t ike_sa_timer_t;
+
+#include <library.h>
+#include <processing/jobs/job.h>
+
+/**
+ * Coalesces the timed jobs of an IKE_SA to a single scheduler entry.
+ *
+ * Jobs are kept in a list sorted by their deadline, only a job for the
+ * earliest deadline is passed to the global scheduler.  When it fires, all
+ * due jobs are queued to the processor and the timer is scheduled again for
+ * the next deadline, if any.
+ */
+struct ike_sa_timer_t {
+
+	/**
+	 * Schedule a job, using an absolute time based on time_monotonic().
+	 *
+	 * Jobs referring to the IKE_SA are canceled if the timer gets destroyed.
+	 * Jobs referring to a CHILD_SA, which might get adopted by another
+	 * IKE_SA, are handed over to the global scheduler instead.
+	 *
+	 * @param job			job to schedule
+	 * @param tv			absolute time to schedule job
+	 * @param child			TRUE if the job refers to a CHILD_SA
+	 */
+	void (*schedule_job)(ike_sa_timer_t *this, job_t *job, timeval_t tv,
+						 bool child);
+
+	/**
+	 * Get the number of pending jobs.
+	 *
+	 * @return				number of jobs not yet queued
+	 */
+	u_int (*get_count)(ike_sa_timer_t *this);
+
+	/**
+	 * Cancel pending jobs and destroy the timer.
+	 */
+	void (*destroy)(ike_sa_timer_t *this);
+};
+
+/**
+ * Create an ike_sa_timer_t instance.
+ *
+ * @return					timer instance
+ */
+ike_sa_timer_t *ike_sa_timer_create();
+
+#endif /** IKE_SA_TIMER_H_ @}*/
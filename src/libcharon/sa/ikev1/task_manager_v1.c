@@ -496,8 +496,9 @@ static status_t retransmit_packet(private_task_manager_t *this, bool request,
 	{
 		return DESTROY_ME;
 	}
-	lib->scheduler->schedule_job_ms(lib->scheduler, (job_t*)
-			retransmit_job_create(seqnr, this->ike_sa->get_id(this->ike_sa)), t);
+	this->ike_sa->schedule_job_ms(this->ike_sa, (job_t*)
+			retransmit_job_create(seqnr, this->ike_sa->get_id(this->ike_sa)),
+			t, FALSE);
 	return NEED_MORE;
 }
 
@@ -1558,10 +1559,10 @@ METHOD(task_manager_t, process_message, status_t,
 			/* add a timeout if peer does not establish it completely */
 			ike_sa_id = this->ike_sa->get_id(this->ike_sa);
 			job = (job_t*)delete_ike_sa_job_create(ike_sa_id, FALSE);
-			lib->scheduler->schedule_job(lib->scheduler, job,
+			this->ike_sa->schedule_job(this->ike_sa, job,
 					lib->settings->get_int(lib->settings,
 							"%s.half_open_timeout", HALF_OPEN_IKE_SA_TIMEOUT,
-							charon->name));
+							charon->name), FALSE);
 		}
 		this->ike_sa->update_hosts(this->ike_sa, me, other, TRUE);
 		charon->bus->message(charon->bus, msg, TRUE, TRUE);
@@ -1880,8 +1881,9 @@ METHOD(task_manager_t, queue_dpd, void,
 	}
 
 	/* schedule DPD timeout job */
-	lib->scheduler->schedule_job_ms(lib->scheduler,
-		(job_t*)dpd_timeout_job_create(this->ike_sa->get_id(this->ike_sa)), t);
+	this->ike_sa->schedule_job_ms(this->ike_sa,
+		(job_t*)dpd_timeout_job_create(this->ike_sa->get_id(this->ike_sa)),
+		t, FALSE);
 }
 
 METHOD(task_manager_t, adopt_tasks, void,
@@ -1999,6 +2001,7 @@ task_manager_v1_t *task_manager_v1_create(ike_sa_t *ike_sa)
 		.public = {
 			.task_manager = {
 				.process_message = _process_message,
+				.resume_message = (void*)return_success,
 				.queue_task = _queue_task,
 				.queue_ike = _queue_ike,
 				.queue_ike_rekey = _queue_ike_rekey,
@@ -643,8 +643,8 @@ METHOD(task_t, process_i, status_t,
 					 * we queue a timeout */
 					job_t *job = (job_t*)delete_ike_sa_job_create(
 									this->ike_sa->get_id(this->ike_sa), FALSE);
-					lib->scheduler->schedule_job(lib->scheduler, job,
-												 HALF_OPEN_IKE_SA_TIMEOUT);
+					this->ike_sa->schedule_job(this->ike_sa, job,
+											HALF_OPEN_IKE_SA_TIMEOUT, FALSE);
 					break;
 				}
 				case AUTH_XAUTH_RESP_PSK:
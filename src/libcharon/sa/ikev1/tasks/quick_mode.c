@@ -190,9 +190,9 @@ static void schedule_inactivity_timeout(private_quick_mode_t *this)
 	{
 		close_ike = lib->settings->get_bool(lib->settings,
 								"%s.inactivity_close_ike", FALSE, charon->name);
-		lib->scheduler->schedule_job(lib->scheduler, (job_t*)
+		this->ike_sa->schedule_job(this->ike_sa, (job_t*)
 				inactivity_job_create(this->child_sa->get_reqid(this->child_sa),
-									  timeout, close_ike), timeout);
+									  timeout, close_ike), timeout, TRUE);
 	}
 }
 
@@ -20,6 +20,7 @@
 #include <daemon.h>
 #include <encoding/payloads/auth_payload.h>
 #include <sa/ikev2/keymat_v2.h>
+#include <processing/jobs/resume_message_job.h>
 
 typedef struct private_pubkey_authenticator_t private_pubkey_authenticator_t;
 
@@ -52,6 +53,11 @@ struct private_pubkey_authenticator_t {
 	 * Reserved bytes of ID payload
 	 */
 	char reserved[3];
+
+	/**
+	 * Pending asynchronous signature verification, if any
+	 */
+	verify_request_t *request;
 };
 
 METHOD(authenticator_t, build, status_t,
@@ -132,6 +138,70 @@ METHOD(authenticator_t, build, status_t,
 	return status;
 }
 
+/**
+ * Complete an asynchronous signature verification
+ */
+static status_t process_result(private_pubkey_authenticator_t *this,
+							   auth_method_t auth_method, key_type_t key_type)
+{
+	public_key_t *public;
+	identification_t *id;
+	auth_cfg_t *auth, *current_auth;
+	status_t status = FAILED;
+
+	id = this->ike_sa->get_other_id(this->ike_sa);
+	if (this->request->get_result(this->request, &public, &current_auth))
+	{
+		DBG1(DBG_IKE, "authentication of '%Y' with %N successful",
+					   id, auth_method_names, auth_method);
+		auth = this->ike_sa->get_auth_cfg(this->ike_sa, FALSE);
+		auth->merge(auth, current_auth, FALSE);
+		auth->add(auth, AUTH_RULE_AUTH_CLASS, AUTH_CLASS_PUBKEY);
+		status = SUCCESS;
+	}
+	else if (!this->request->get_key_count(this->request))
+	{
+		DBG1(DBG_IKE, "no trusted %N public key found for '%Y'",
+			 key_type_names, key_type, id);
+		status = NOT_FOUND;
+	}
+	else
+	{
+		DBG1(DBG_IKE, "signature validation of '%Y' failed with all %d "
+			 "trusted keys", id, this->request->get_key_count(this->request));
+	}
+	this->request->destroy(this->request);
+	this->request = NULL;
+	return status;
+}
+
+/**
+ * Queue the lookup of trusted keys and the signature verification to the
+ * verify_manager_t, resuming message processing once completed
+ */
+static status_t process_async(private_pubkey_authenticator_t *this,
+							  auth_method_t auth_method, key_type_t key_type,
+							  signature_scheme_t scheme, chunk_t octets,
+							  chunk_t auth_data)
+{
+	identification_t *id;
+	auth_cfg_t *auth;
+	job_t *job;
+
+	id = this->ike_sa->get_other_id(this->ike_sa);
+	auth = this->ike_sa->get_auth_cfg(this->ike_sa, FALSE);
+	this->request = verify_request_create(key_type, id, auth, scheme,
+										  octets, auth_data);
+	job = (job_t*)resume_message_job_create(this->ike_sa->get_id(this->ike_sa));
+	if (!charon->verifier->queue(charon->verifier, this->request, job))
+	{	/* verifier shutting down, verify synchronously */
+		this->request->verify(this->request);
+		return process_result(this, auth_method, key_type);
+	}
+	DBG2(DBG_IKE, "verifying signature of '%Y' asynchronously", id);
+	return DEFERRED;
+}
+
 METHOD(authenticator_t, process, status_t,
 	private_pubkey_authenticator_t *this, message_t *message)
 {
@@ -173,6 +243,10 @@ METHOD(authenticator_t, process, status_t,
 		default:
 			return INVALID_ARG;
 	}
+	if (this->request)
+	{	/* resumed after asynchronous verification */
+		return process_result(this, auth_method, key_type);
+	}
 	auth_data = auth_payload->get_data(auth_payload);
 	id = this->ike_sa->get_other_id(this->ike_sa);
 	keymat = (keymat_v2_t*)this->ike_sa->get_keymat(this->ike_sa);
@@ -181,6 +255,14 @@ METHOD(authenticator_t, process, status_t,
 	{
 		return FAILED;
 	}
+	if (message->get_request(message) &&
+		charon->verifier->get_threads(charon->verifier))
+	{	/* only the responder can defer processing of a message */
+		status = process_async(this, auth_method, key_type, scheme,
+							   octets, auth_data);
+		chunk_free(&octets);
+		return status;
+	}
 	auth = this->ike_sa->get_auth_cfg(this->ike_sa, FALSE);
 	enumerator = lib->credmgr->create_public_enumerator(lib->credmgr,
 														key_type, id, auth);
@@ -214,6 +296,7 @@ METHOD(authenticator_t, process, status_t,
 METHOD(authenticator_t, destroy, void,
 	private_pubkey_authenticator_t *this)
 {
+	DESTROY_IF(this->request);
 	free(this);
 }
 
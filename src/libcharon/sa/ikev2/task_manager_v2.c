@@ -93,6 +93,16 @@ struct private_task_manager_t {
 		 */
 		packet_t *packet;
 
+		/**
+		 * request deferred by a passive task, if any
+		 */
+		message_t *deferred;
+
+		/**
+		 * passive task that deferred processing of the request
+		 */
+		task_t *deferred_task;
+
 	} responding;
 
 	/**
@@ -188,6 +198,9 @@ METHOD(task_manager_t, flush_queue, void,
  */
 static void flush(private_task_manager_t *this)
 {
+	DESTROY_IF(this->responding.deferred);
+	this->responding.deferred = NULL;
+	this->responding.deferred_task = NULL;
 	flush_queue(this, TASK_QUEUE_QUEUED);
 	flush_queue(this, TASK_QUEUE_PASSIVE);
 	flush_queue(this, TASK_QUEUE_ACTIVE);
@@ -296,7 +309,7 @@ METHOD(task_manager_t, retransmit, status_t,
 		this->initiating.retransmitted++;
 		job = (job_t*)retransmit_job_create(this->initiating.mid,
 											this->ike_sa->get_id(this->ike_sa));
-		lib->scheduler->schedule_job_ms(lib->scheduler, job, timeout);
+		this->ike_sa->schedule_job_ms(this->ike_sa, job, timeout, FALSE);
 	}
 	return SUCCESS;
 }
@@ -724,6 +737,60 @@ static status_t build_response(private_task_manager_t *this, message_t *request)
 	return SUCCESS;
 }
 
+/**
+ * Let the passive tasks process a request, starting at the given task
+ */
+static status_t process_passive(private_task_manager_t *this,
+								message_t *message, task_t *resume)
+{
+	enumerator_t *enumerator;
+	task_t *task;
+
+	/* let the tasks process the message */
+	enumerator = this->passive_tasks->create_enumerator(this->passive_tasks);
+	while (enumerator->enumerate(enumerator, (void*)&task))
+	{
+		if (resume)
+		{	/* skip tasks that already processed the deferred request */
+			if (task != resume)
+			{
+				continue;
+			}
+			resume = NULL;
+		}
+		switch (task->process(task, message))
+		{
+			case SUCCESS:
+				/* task completed, remove it */
+				this->passive_tasks->remove_at(this->passive_tasks, enumerator);
+				task->destroy(task);
+				break;
+			case NEED_MORE:
+				/* processed, but task needs at least another call to build() */
+				break;
+			case DEFERRED:
+				/* task continues asynchronously, resumed by resume_message() */
+				enumerator->destroy(enumerator);
+				this->responding.deferred = message;
+				this->responding.deferred_task = task;
+				return DEFERRED;
+			case FAILED:
+			default:
+				charon->bus->ike_updown(charon->bus, this->ike_sa, FALSE);
+				/* FALL */
+			case DESTROY_ME:
+				/* critical failure, destroy IKE_SA */
+				this->passive_tasks->remove_at(this->passive_tasks, enumerator);
+				enumerator->destroy(enumerator);
+				task->destroy(task);
+				return DESTROY_ME;
+		}
+	}
+	enumerator->destroy(enumerator);
+
+	return build_response(this, message);
+}
+
 /**
  * handle an incoming request message
  */
@@ -898,35 +965,35 @@ static status_t process_request(private_task_manager_t *this,
 		}
 	}
 
-	/* let the tasks process the message */
-	enumerator = this->passive_tasks->create_enumerator(this->passive_tasks);
-	while (enumerator->enumerate(enumerator, (void*)&task))
+	return process_passive(this, message, NULL);
+}
+
+METHOD(task_manager_t, resume_message, status_t,
+	private_task_manager_t *this)
+{
+	message_t *message;
+	status_t status;
+
+	message = this->responding.deferred;
+	if (!message)
 	{
-		switch (task->process(task, message))
-		{
-			case SUCCESS:
-				/* task completed, remove it */
-				this->passive_tasks->remove_at(this->passive_tasks, enumerator);
-				task->destroy(task);
-				break;
-			case NEED_MORE:
-				/* processed, but task needs at least another call to build() */
-				break;
-			case FAILED:
-			default:
-				charon->bus->ike_updown(charon->bus, this->ike_sa, FALSE);
-				/* FALL */
-			case DESTROY_ME:
-				/* critical failure, destroy IKE_SA */
-				this->passive_tasks->remove_at(this->passive_tasks, enumerator);
-				enumerator->destroy(enumerator);
-				task->destroy(task);
-				return DESTROY_ME;
-		}
+		return SUCCESS;
 	}
-	enumerator->destroy(enumerator);
-
-	return build_response(this, message);
+	this->responding.deferred = NULL;
+	status = process_passive(this, message, this->responding.deferred_task);
+	if (status == DEFERRED)
+	{
+		return DEFERRED;
+	}
+	this->responding.deferred_task = NULL;
+	message->destroy(message);
+	if (status != SUCCESS)
+	{
+		flush(this);
+		return DESTROY_ME;
+	}
+	this->responding.mid++;
+	return SUCCESS;
 }
 
 METHOD(task_manager_t, incr_mid, void,
@@ -1111,10 +1178,10 @@ METHOD(task_manager_t, process_message, status_t,
 		/* add a timeout if peer does not establish it completely */
 		ike_sa_id = this->ike_sa->get_id(this->ike_sa);
 		job = (job_t*)delete_ike_sa_job_create(ike_sa_id, FALSE);
-		lib->scheduler->schedule_job(lib->scheduler, job,
+		this->ike_sa->schedule_job(this->ike_sa, job,
 				lib->settings->get_int(lib->settings,
 						"%s.half_open_timeout", HALF_OPEN_IKE_SA_TIMEOUT,
-						charon->name));
+						charon->name), FALSE);
 	}
 	this->ike_sa->set_statistic(this->ike_sa, STAT_INBOUND,
 								time_monotonic(NULL));
@@ -1150,7 +1217,18 @@ METHOD(task_manager_t, process_message, status_t,
 			{	/* ignore messages altered to EXCHANGE_TYPE_UNDEFINED */
 				return SUCCESS;
 			}
-			if (process_request(this, msg) != SUCCESS)
+			if (this->responding.deferred)
+			{
+				DBG1(DBG_IKE, "received retransmit of request with ID %d, "
+					 "but processing is deferred", mid);
+				return SUCCESS;
+			}
+			status = process_request(this, msg);
+			if (status == DEFERRED)
+			{
+				return DEFERRED;
+			}
+			if (status != SUCCESS)
 			{
 				flush(this);
 				return DESTROY_ME;
@@ -1500,6 +1578,7 @@ task_manager_v2_t *task_manager_v2_create(ike_sa_t *ike_sa)
 		.public = {
 			.task_manager = {
 				.process_message = _process_message,
+				.resume_message = _resume_message,
 				.queue_task = _queue_task,
 				.queue_ike = _queue_ike,
 				.queue_ike_rekey = _queue_ike_rekey,
@@ -279,9 +279,9 @@ static void schedule_inactivity_timeout(private_child_create_t *this)
 	{
 		close_ike = lib->settings->get_bool(lib->settings,
 								"%s.inactivity_close_ike", FALSE, charon->name);
-		lib->scheduler->schedule_job(lib->scheduler, (job_t*)
+		this->ike_sa->schedule_job(this->ike_sa, (job_t*)
 				inactivity_job_create(this->child_sa->get_reqid(this->child_sa),
-									  timeout, close_ike), timeout);
+									  timeout, close_ike), timeout, TRUE);
 	}
 }
 
@@ -991,9 +991,9 @@ static void handle_child_sa_failure(private_child_create_t *this,
 		/* we delay the delete for 100ms, as the IKE_AUTH response must arrive
 		 * first */
 		DBG1(DBG_IKE, "closing IKE_SA due CHILD_SA setup failure");
-		lib->scheduler->schedule_job_ms(lib->scheduler, (job_t*)
+		this->ike_sa->schedule_job_ms(this->ike_sa, (job_t*)
 			delete_ike_sa_job_create(this->ike_sa->get_id(this->ike_sa), TRUE),
-			100);
+			100, FALSE);
 	}
 	else
 	{
@@ -101,7 +101,7 @@ static void schedule_delayed_rekey(private_child_rekey_t *this)
 						this->child_sa->get_spi(this->child_sa, TRUE));
 	DBG1(DBG_IKE, "CHILD_SA rekeying failed, trying again in %d seconds", retry);
 	this->child_sa->set_state(this->child_sa, CHILD_INSTALLED);
-	lib->scheduler->schedule_job(lib->scheduler, job, retry);
+	this->ike_sa->schedule_job(this->ike_sa, job, retry, TRUE);
 }
 
 /**
@@ -636,6 +636,10 @@ METHOD(task_t, process_r, status_t,
 				break;
 			}
 			return NEED_MORE;
+		case DEFERRED:
+			/* verification completes asynchronously, process() gets called
+			 * again with the same message */
+			return DEFERRED;
 		default:
 			this->authentication_failed = TRUE;
 			return NEED_MORE;
@@ -249,7 +249,7 @@ METHOD(task_t, process_i, status_t,
 				DBG1(DBG_IKE, "IKE_SA rekeying failed, "
 										"trying again in %d seconds", retry);
 				this->ike_sa->set_state(this->ike_sa, IKE_ESTABLISHED);
-				lib->scheduler->schedule_job(lib->scheduler, job, retry);
+				this->ike_sa->schedule_job(this->ike_sa, job, retry, FALSE);
 			}
 			return SUCCESS;
 		case NEED_MORE:
@@ -283,7 +283,7 @@ METHOD(task_t, process_i, status_t,
 				/* peer should delete this SA. Add a timeout just in case. */
 				job_t *job = (job_t*)delete_ike_sa_job_create(
 						other->new_sa->get_id(other->new_sa), TRUE);
-				lib->scheduler->schedule_job(lib->scheduler, job, 10);
+				other->new_sa->schedule_job(other->new_sa, job, 10, FALSE);
 				DBG1(DBG_IKE, "IKE_SA rekey collision won, waiting for delete");
 				charon->ike_sa_manager->checkin(charon->ike_sa_manager, other->new_sa);
 				other->new_sa = NULL;
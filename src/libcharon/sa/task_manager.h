@@ -112,6 +112,20 @@ struct task_manager_t {
 	 */
 	status_t (*process_message) (task_manager_t *this, message_t *message);
 
+	/**
+	 * Resume processing of a request deferred by process_message().
+	 *
+	 * A task returning DEFERRED while processing a request makes
+	 * process_message() return DEFERRED and keep the message. Once the task
+	 * is ready to continue, processing gets resumed with this method.
+	 *
+	 * @return
+	 *						- DESTROY_ME if IKE_SA must be closed
+	 *						- DEFERRED if processing is deferred again
+	 *						- SUCCESS otherwise
+	 */
+	status_t (*resume_message) (task_manager_t *this);
+
 	/**
 	 * Initiate an exchange with the currently queued tasks.
 	 */
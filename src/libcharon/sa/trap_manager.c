@@ -19,6 +19,8 @@
 #include <hydra.h>
 #include <daemon.h>
 #include <threading/rwlock.h>
+#include <threading/mutex.h>
+#include <collections/hashtable.h>
 #include <collections/linked_list.h>
 
 
@@ -52,15 +54,30 @@ struct private_trap_manager_t {
 	trap_manager_t public;
 
 	/**
-	 * Installed traps, as entry_t
+	 * Installed traps, reqid => entry_t
 	 */
-	linked_list_t *traps;
+	hashtable_t *traps;
 
 	/**
-	 * read write lock for traps list
+	 * Installed traps, CHILD_SA name => entry_t
+	 */
+	hashtable_t *names;
+
+	/**
+	 * read write lock for traps tables
 	 */
 	rwlock_t *lock;
 
+	/**
+	 * Acquires in progress, reqid => acquire_t
+	 */
+	hashtable_t *acquires;
+
+	/**
+	 * Mutex for acquires table
+	 */
+	mutex_t *mutex;
+
 	/**
 	 * listener to track acquiring IKE_SAs
 	 */
@@ -75,12 +92,52 @@ typedef struct {
 	peer_cfg_t *peer_cfg;
 	/** ref to instanciated CHILD_SA */
 	child_sa_t *child_sa;
-	/** TRUE if an acquire is pending */
-	bool pending;
-	/** pending IKE_SA connecting upon acquire */
-	ike_sa_t *ike_sa;
 } entry_t;
 
+/**
+ * An acquire in progress
+ */
+typedef struct {
+	/** reqid of the acquiring trap */
+	u_int32_t reqid;
+	/** IKE_SA connecting upon acquire, NULL until initiated */
+	ike_sa_t *ike_sa;
+	/** number of acquires coalesced into this one */
+	u_int coalesced;
+} acquire_t;
+
+/**
+ * Hashtable hash function for reqids
+ */
+static u_int hash_reqid(uintptr_t reqid)
+{
+	return reqid;
+}
+
+/**
+ * Hashtable equals function for reqids
+ */
+static bool equals_reqid(uintptr_t a, uintptr_t b)
+{
+	return a == b;
+}
+
+/**
+ * Hashtable hash function for CHILD_SA names
+ */
+static u_int hash_name(char *name)
+{
+	return chunk_hash(chunk_from_str(name));
+}
+
+/**
+ * Hashtable equals function for CHILD_SA names
+ */
+static bool equals_name(char *a, char *b)
+{
+	return streq(a, b);
+}
+
 /**
  * actually uninstall and destroy an installed entry
  */
@@ -91,15 +148,25 @@ static void destroy_entry(entry_t *entry)
 	free(entry);
 }
 
+/**
+ * Remove an entry from both tables, requires the write lock
+ */
+static void remove_entry(private_trap_manager_t *this, entry_t *entry)
+{
+	this->traps->remove(this->traps,
+		(void*)(uintptr_t)entry->child_sa->get_reqid(entry->child_sa));
+	this->names->remove(this->names,
+						entry->child_sa->get_name(entry->child_sa));
+}
+
 METHOD(trap_manager_t, install, u_int32_t,
 	private_trap_manager_t *this, peer_cfg_t *peer, child_cfg_t *child)
 {
-	entry_t *entry, *found = NULL;
+	entry_t *entry, *found;
 	ike_cfg_t *ike_cfg;
 	child_sa_t *child_sa;
 	host_t *me, *other;
 	linked_list_t *my_ts, *other_ts, *list;
-	enumerator_t *enumerator;
 	status_t status;
 	u_int32_t reqid = 0;
 
@@ -129,22 +196,12 @@ METHOD(trap_manager_t, install, u_int32_t,
 	}
 
 	this->lock->write_lock(this->lock);
-	enumerator = this->traps->create_enumerator(this->traps);
-	while (enumerator->enumerate(enumerator, &entry))
-	{
-		if (streq(entry->child_sa->get_name(entry->child_sa),
-				  child->get_name(child)))
-		{
-			this->traps->remove_at(this->traps, enumerator);
-			found = entry;
-			break;
-		}
-	}
-	enumerator->destroy(enumerator);
+	found = this->names->get(this->names, child->get_name(child));
 	if (found)
 	{	/* config might have changed so update everything */
 		DBG1(DBG_CFG, "updating already routed CHILD_SA '%s'",
 			 child->get_name(child));
+		remove_entry(this, found);
 		reqid = found->child_sa->get_reqid(found->child_sa);
 	}
 
@@ -179,8 +236,9 @@ METHOD(trap_manager_t, install, u_int32_t,
 			.child_sa = child_sa,
 			.peer_cfg = peer->get_ref(peer),
 		);
-		this->traps->insert_last(this->traps, entry);
 		reqid = child_sa->get_reqid(child_sa);
+		this->traps->put(this->traps, (void*)(uintptr_t)reqid, entry);
+		this->names->put(this->names, child_sa->get_name(child_sa), entry);
 	}
 	this->lock->unlock(this->lock);
 
@@ -198,21 +256,14 @@ METHOD(trap_manager_t, install, u_int32_t,
 METHOD(trap_manager_t, uninstall, bool,
 	private_trap_manager_t *this, u_int32_t reqid)
 {
-	enumerator_t *enumerator;
-	entry_t *entry, *found = NULL;
+	entry_t *found;
 
 	this->lock->write_lock(this->lock);
-	enumerator = this->traps->create_enumerator(this->traps);
-	while (enumerator->enumerate(enumerator, &entry))
+	found = this->traps->get(this->traps, (void*)(uintptr_t)reqid);
+	if (found)
 	{
-		if (entry->child_sa->get_reqid(entry->child_sa) == reqid)
-		{
-			this->traps->remove_at(this->traps, enumerator);
-			found = entry;
-			break;
-		}
+		remove_entry(this, found);
 	}
-	enumerator->destroy(enumerator);
 	this->lock->unlock(this->lock);
 
 	if (!found)
@@ -228,8 +279,8 @@ METHOD(trap_manager_t, uninstall, bool,
 /**
  * convert enumerated entries to peer_cfg, child_sa
  */
-static bool trap_filter(rwlock_t *lock, entry_t **entry, peer_cfg_t **peer_cfg,
-						void *none, child_sa_t **child_sa)
+static bool trap_filter(rwlock_t *lock, void **key, peer_cfg_t **peer_cfg,
+						entry_t **entry, child_sa_t **child_sa)
 {
 	if (peer_cfg)
 	{
@@ -251,44 +302,56 @@ METHOD(trap_manager_t, create_enumerator, enumerator_t*,
 									(void*)this->lock->unlock);
 }
 
+/**
+ * Forget about an acquire for which initiation failed
+ */
+static void abort_acquire(private_trap_manager_t *this, u_int32_t reqid)
+{
+	acquire_t *acquire;
+
+	this->mutex->lock(this->mutex);
+	acquire = this->acquires->remove(this->acquires, (void*)(uintptr_t)reqid);
+	this->mutex->unlock(this->mutex);
+	free(acquire);
+}
+
 METHOD(trap_manager_t, acquire, void,
 	private_trap_manager_t *this, u_int32_t reqid,
 	traffic_selector_t *src, traffic_selector_t *dst)
 {
-	enumerator_t *enumerator;
-	entry_t *entry, *found = NULL;
+	entry_t *found;
+	acquire_t *acquire;
 	peer_cfg_t *peer;
 	child_cfg_t *child;
 	ike_sa_t *ike_sa;
 
 	this->lock->read_lock(this->lock);
-	enumerator = this->traps->create_enumerator(this->traps);
-	while (enumerator->enumerate(enumerator, &entry))
-	{
-		if (entry->child_sa->get_reqid(entry->child_sa) == reqid)
-		{
-			found = entry;
-			break;
-		}
-	}
-	enumerator->destroy(enumerator);
-
+	found = this->traps->get(this->traps, (void*)(uintptr_t)reqid);
 	if (!found)
 	{
 		DBG1(DBG_CFG, "trap not found, unable to acquire reqid %d",reqid);
 		this->lock->unlock(this->lock);
 		return;
 	}
-	if (!cas_bool(&found->pending, FALSE, TRUE))
+	this->mutex->lock(this->mutex);
+	acquire = this->acquires->get(this->acquires, (void*)(uintptr_t)reqid);
+	if (acquire)
 	{
-		DBG1(DBG_CFG, "ignoring acquire, connection attempt pending");
+		acquire->coalesced++;
+		this->mutex->unlock(this->mutex);
 		this->lock->unlock(this->lock);
+		DBG2(DBG_CFG, "ignoring acquire, connection attempt pending");
 		return;
 	}
+	INIT(acquire,
+		.reqid = reqid,
+	);
+	this->acquires->put(this->acquires, (void*)(uintptr_t)reqid, acquire);
+	this->mutex->unlock(this->mutex);
+
 	peer = found->peer_cfg->get_ref(found->peer_cfg);
 	child = found->child_sa->get_config(found->child_sa);
 	child = child->get_ref(child);
-	reqid = found->child_sa->get_reqid(found->child_sa);
 	/* don't hold the lock while checking out the IKE_SA */
 	this->lock->unlock(this->lock);
 
@@ -307,22 +370,24 @@ METHOD(trap_manager_t, acquire, void,
 		}
 		if (ike_sa->initiate(ike_sa, child, reqid, src, dst) != DESTROY_ME)
 		{
-			/* make sure the entry is still there */
-			this->lock->read_lock(this->lock);
-			if (this->traps->find_first(this->traps, NULL,
-										(void**)&found) == SUCCESS)
-			{
-				found->ike_sa = ike_sa;
-			}
-			this->lock->unlock(this->lock);
+			/* we still hold the IKE_SA, so the acquire can't be completed */
+			this->mutex->lock(this->mutex);
+			acquire->ike_sa = ike_sa;
+			this->mutex->unlock(this->mutex);
 			charon->ike_sa_manager->checkin(charon->ike_sa_manager, ike_sa);
 		}
 		else
 		{
 			charon->ike_sa_manager->checkin_and_destroy(
 												charon->ike_sa_manager, ike_sa);
+			abort_acquire(this, reqid);
 		}
 	}
+	else
+	{
+		child->destroy(child);
+		abort_acquire(this, reqid);
+	}
 	peer->destroy(peer);
 }
 
@@ -333,26 +398,34 @@ static void complete(private_trap_manager_t *this, ike_sa_t *ike_sa,
 					 child_sa_t *child_sa)
 {
 	enumerator_t *enumerator;
-	entry_t *entry;
+	acquire_t *acquire;
 
-	this->lock->read_lock(this->lock);
-	enumerator = this->traps->create_enumerator(this->traps);
-	while (enumerator->enumerate(enumerator, &entry))
+	this->mutex->lock(this->mutex);
+	if (child_sa)
 	{
-		if (entry->ike_sa != ike_sa)
+		acquire = this->acquires->get(this->acquires,
+						(void*)(uintptr_t)child_sa->get_reqid(child_sa));
+		if (acquire && acquire->ike_sa == ike_sa)
 		{
-			continue;
+			this->acquires->remove(this->acquires,
+								   (void*)(uintptr_t)acquire->reqid);
+			free(acquire);
 		}
-		if (child_sa && child_sa->get_reqid(child_sa) !=
-									entry->child_sa->get_reqid(entry->child_sa))
+	}
+	else if (this->acquires->get_count(this->acquires))
+	{
+		enumerator = this->acquires->create_enumerator(this->acquires);
+		while (enumerator->enumerate(enumerator, NULL, &acquire))
 		{
-			continue;
+			if (acquire->ike_sa == ike_sa)
+			{
+				this->acquires->remove_at(this->acquires, enumerator);
+				free(acquire);
+			}
 		}
-		entry->ike_sa = NULL;
-		entry->pending = FALSE;
+		enumerator->destroy(enumerator);
 	}
-	enumerator->destroy(enumerator);
-	this->lock->unlock(this->lock);
+	this->mutex->unlock(this->mutex);
 }
 
 METHOD(listener_t, ike_state_change, bool,
@@ -383,24 +456,57 @@ METHOD(listener_t, child_state_change, bool,
 	}
 }
 
+/**
+ * Destroy all entries in the given table and the table itself
+ */
+static void destroy_traps(hashtable_t *traps)
+{
+	enumerator_t *enumerator;
+	entry_t *entry;
+
+	enumerator = traps->create_enumerator(traps);
+	while (enumerator->enumerate(enumerator, NULL, &entry))
+	{
+		destroy_entry(entry);
+	}
+	enumerator->destroy(enumerator);
+	traps->destroy(traps);
+}
+
 METHOD(trap_manager_t, flush, void,
 	private_trap_manager_t *this)
 {
-	linked_list_t *traps;
+	hashtable_t *traps;
 	/* since destroying the CHILD_SA results in events which require a read
-	 * lock we cannot destroy the list while holding the write lock */
+	 * lock we cannot destroy the table while holding the write lock */
 	this->lock->write_lock(this->lock);
 	traps = this->traps;
-	this->traps = linked_list_create();
+	this->traps = hashtable_create((hashtable_hash_t)hash_reqid,
+								   (hashtable_equals_t)equals_reqid, 32);
+	this->names->destroy(this->names);
+	this->names = hashtable_create((hashtable_hash_t)hash_name,
+								   (hashtable_equals_t)equals_name, 32);
 	this->lock->unlock(this->lock);
-	traps->destroy_function(traps, (void*)destroy_entry);
+	destroy_traps(traps);
 }
 
 METHOD(trap_manager_t, destroy, void,
 	private_trap_manager_t *this)
 {
+	enumerator_t *enumerator;
+	acquire_t *acquire;
+
 	charon->bus->remove_listener(charon->bus, &this->listener.listener);
-	this->traps->destroy_function(this->traps, (void*)destroy_entry);
+	destroy_traps(this->traps);
+	this->names->destroy(this->names);
+	enumerator = this->acquires->create_enumerator(this->acquires);
+	while (enumerator->enumerate(enumerator, NULL, &acquire))
+	{
+		free(acquire);
+	}
+	enumerator->destroy(enumerator);
+	this->acquires->destroy(this->acquires);
+	this->mutex->destroy(this->mutex);
 	this->lock->destroy(this->lock);
 	free(this);
 }
@@ -428,8 +534,14 @@ trap_manager_t *trap_manager_create(void)
 				.child_state_change = _child_state_change,
 			},
 		},
-		.traps = linked_list_create(),
+		.traps = hashtable_create((hashtable_hash_t)hash_reqid,
+								  (hashtable_equals_t)equals_reqid, 32),
+		.names = hashtable_create((hashtable_hash_t)hash_name,
+								  (hashtable_equals_t)equals_name, 32),
 		.lock = rwlock_create(RWLOCK_TYPE_DEFAULT),
+		.acquires = hashtable_create((hashtable_hash_t)hash_reqid,
+									 (hashtable_equals_t)equals_reqid, 8),
+		.mutex = mutex_create(MUTEX_TYPE_DEFAULT),
 	);
 	charon->bus->add_listener(charon->bus, &this->listener.listener);
 
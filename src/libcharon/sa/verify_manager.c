@@ -0,0 +1,449 @@
+/*
+ * Copyright (C) 2013 Hochschule fuer Technik Rapperswil
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.  See <http://www.fsf.org/copyleft/gpl.txt>.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+
+#include "verify_manager.h"
+
+#include <daemon.h>
+#include <collections/array.h>
+#include <threading/thread.h>
+#include <threading/mutex.h>
+#include <threading/condvar.h>
+
+/**
+ * Default number of requests a crypto thread takes from the queue at once
+ */
+#define DEFAULT_BATCH_SIZE 8
+
+typedef struct private_verify_request_t private_verify_request_t;
+
+/**
+ * Private data of a verify_request_t object.
+ */
+struct private_verify_request_t {
+
+	/**
+	 * Public verify_request_t interface.
+	 */
+	verify_request_t public;
+
+	/**
+	 * Type of the public keys to look up
+	 */
+	key_type_t type;
+
+	/**
+	 * Identity of the peer
+	 */
+	identification_t *id;
+
+	/**
+	 * Constraints for the trusted public keys
+	 */
+	auth_cfg_t *constraints;
+
+	/**
+	 * Signature scheme to verify
+	 */
+	signature_scheme_t scheme;
+
+	/**
+	 * Signed data
+	 */
+	chunk_t data;
+
+	/**
+	 * Signature to verify
+	 */
+	chunk_t signature;
+
+	/**
+	 * Public key that verified the signature, if any
+	 */
+	public_key_t *key;
+
+	/**
+	 * Auth config of the verifying public key
+	 */
+	auth_cfg_t *auth;
+
+	/**
+	 * Number of public keys tried
+	 */
+	int tried;
+
+	/**
+	 * Has verify() been called?
+	 */
+	bool complete;
+
+	/**
+	 * Reference count
+	 */
+	refcount_t ref;
+};
+
+METHOD(verify_request_t, get_key_count, int,
+	private_verify_request_t *this)
+{
+	return this->tried;
+}
+
+METHOD(verify_request_t, verify, void,
+	private_verify_request_t *this)
+{
+	enumerator_t *enumerator;
+	public_key_t *public;
+	auth_cfg_t *current_auth;
+
+	enumerator = lib->credmgr->create_public_enumerator(lib->credmgr,
+									this->type, this->id, this->constraints);
+	while (enumerator->enumerate(enumerator, &public, &current_auth))
+	{
+		this->tried++;
+		if (public->verify(public, this->scheme, this->data, this->signature))
+		{
+			this->key = public->get_ref(public);
+			this->auth = current_auth->clone(current_auth);
+			break;
+		}
+		DBG1(DBG_IKE, "signature validation failed, looking for another key");
+	}
+	enumerator->destroy(enumerator);
+	this->complete = TRUE;
+}
+
+METHOD(verify_request_t, is_complete, bool,
+	private_verify_request_t *this)
+{
+	return this->complete;
+}
+
+METHOD(verify_request_t, get_result, bool,
+	private_verify_request_t *this, public_key_t **key, auth_cfg_t **auth)
+{
+	if (!this->complete || !this->key)
+	{
+		return FALSE;
+	}
+	*key = this->key;
+	*auth = this->auth;
+	return TRUE;
+}
+
+METHOD(verify_request_t, get_ref, verify_request_t*,
+	private_verify_request_t *this)
+{
+	ref_get(&this->ref);
+	return &this->public;
+}
+
+METHOD(verify_request_t, request_destroy, void,
+	private_verify_request_t *this)
+{
+	if (ref_put(&this->ref))
+	{
+		DESTROY_IF(this->key);
+		DESTROY_IF(this->auth);
+		this->id->destroy(this->id);
+		this->constraints->destroy(this->constraints);
+		free(this->data.ptr);
+		free(this->signature.ptr);
+		free(this);
+	}
+}
+
+/**
+ * See header
+ */
+verify_request_t *verify_request_create(key_type_t type, identification_t *id,
+										auth_cfg_t *auth,
+										signature_scheme_t scheme,
+										chunk_t data, chunk_t signature)
+{
+	private_verify_request_t *this;
+
+	INIT(this,
+		.public = {
+			.get_key_count = _get_key_count,
+			.verify = _verify,
+			.is_complete = _is_complete,
+			.get_result = _get_result,
+			.get_ref = _get_ref,
+			.destroy = _request_destroy,
+		},
+		.type = type,
+		.id = id->clone(id),
+		.constraints = auth->clone(auth),
+		.scheme = scheme,
+		.data = chunk_clone(data),
+		.signature = chunk_clone(signature),
+		.ref = 1,
+	);
+
+	return &this->public;
+}
+
+typedef struct private_verify_manager_t private_verify_manager_t;
+
+/**
+ * Private data of a verify_manager_t object.
+ */
+struct private_verify_manager_t {
+
+	/**
+	 * Public verify_manager_t interface.
+	 */
+	verify_manager_t public;
+
+	/**
+	 * Crypto threads, as thread_t
+	 */
+	array_t *threads;
+
+	/**
+	 * Queued requests, as entry_t*
+	 */
+	array_t *queue;
+
+	/**
+	 * Maximum number of requests a thread takes from the queue at once
+	 */
+	u_int batch;
+
+	/**
+	 * Number of completed requests
+	 */
+	u_int done;
+
+	/**
+	 * Sum of the latency of all completed requests, in us
+	 */
+	u_int64_t latency;
+
+	/**
+	 * Maximum latency of a completed request, in us
+	 */
+	u_int max;
+
+	/**
+	 * Terminate crypto threads?
+	 */
+	bool terminate;
+
+	/**
+	 * Mutex to lock queue and statistics
+	 */
+	mutex_t *mutex;
+
+	/**
+	 * Condvar to signal queued requests
+	 */
+	condvar_t *condvar;
+};
+
+/**
+ * A queued request
+ */
+typedef struct {
+	/** request to verify */
+	verify_request_t *request;
+	/** job to queue when done */
+	job_t *done;
+	/** time the request was queued */
+	timeval_t queued;
+} entry_t;
+
+/**
+ * Destroy a queued entry, without completing it
+ */
+static void entry_destroy(entry_t *entry)
+{
+	entry->request->destroy(entry->request);
+	entry->done->destroy(entry->done);
+	free(entry);
+}
+
+/**
+ * Get the time passed since tv in us
+ */
+static u_int get_latency(timeval_t *tv)
+{
+	timeval_t now, diff;
+
+	time_monotonic(&now);
+	timersub(&now, tv, &diff);
+	return diff.tv_sec * 1000000 + diff.tv_usec;
+}
+
+/**
+ * Main loop of a crypto thread
+ */
+static void *verify_requests(private_verify_manager_t *this)
+{
+	entry_t **batch, *entry;
+	u_int count, limit, i, latency, peak;
+	u_int64_t sum;
+
+	thread_cancelability(FALSE);
+	batch = malloc(sizeof(entry_t*) * this->batch);
+
+	while (TRUE)
+	{
+		this->mutex->lock(this->mutex);
+		while (!this->terminate && !array_count(this->queue))
+		{
+			this->condvar->wait(this->condvar, this->mutex);
+		}
+		if (this->terminate)
+		{
+			this->mutex->unlock(this->mutex);
+			break;
+		}
+		/* take a fair share of the queued requests, up to the batch size */
+		limit = array_count(this->queue) / array_count(this->threads);
+		limit = min(this->batch, max(1, limit));
+		count = 0;
+		while (count < limit &&
+			   array_remove(this->queue, ARRAY_HEAD, &batch[count]))
+		{
+			count++;
+		}
+		this->mutex->unlock(this->mutex);
+
+		for (i = sum = peak = 0; i < count; i++)
+		{
+			entry = batch[i];
+			entry->request->verify(entry->request);
+			latency = get_latency(&entry->queued);
+			sum += latency;
+			peak = max(peak, latency);
+			lib->processor->queue_job(lib->processor, entry->done);
+			entry->request->destroy(entry->request);
+			free(entry);
+		}
+
+		this->mutex->lock(this->mutex);
+		this->done += count;
+		this->latency += sum;
+		this->max = max(this->max, peak);
+		this->mutex->unlock(this->mutex);
+	}
+	free(batch);
+	return NULL;
+}
+
+METHOD(verify_manager_t, queue, bool,
+	private_verify_manager_t *this, verify_request_t *request, job_t *done)
+{
+	entry_t *entry;
+
+	if (!array_count(this->threads))
+	{
+		return FALSE;
+	}
+	INIT(entry,
+		.request = request->get_ref(request),
+		.done = done,
+	);
+	time_monotonic(&entry->queued);
+
+	this->mutex->lock(this->mutex);
+	array_insert(this->queue, ARRAY_TAIL, entry);
+	this->condvar->signal(this->condvar);
+	this->mutex->unlock(this->mutex);
+	return TRUE;
+}
+
+METHOD(verify_manager_t, get_threads, u_int,
+	private_verify_manager_t *this)
+{
+	return array_count(this->threads);
+}
+
+METHOD(verify_manager_t, get_stats, void,
+	private_verify_manager_t *this, u_int *pending, u_int *done,
+	u_int *latency, u_int *max)
+{
+	this->mutex->lock(this->mutex);
+	*pending = array_count(this->queue);
+	*done = this->done;
+	*latency = this->done ? this->latency / this->done : 0;
+	*max = this->max;
+	this->mutex->unlock(this->mutex);
+}
+
+METHOD(verify_manager_t, destroy, void,
+	private_verify_manager_t *this)
+{
+	thread_t *thread;
+
+	this->mutex->lock(this->mutex);
+	this->terminate = TRUE;
+	this->condvar->broadcast(this->condvar);
+	this->mutex->unlock(this->mutex);
+
+	while (array_remove(this->threads, ARRAY_TAIL, &thread))
+	{
+		thread->join(thread);
+	}
+	array_destroy(this->threads);
+	array_destroy_function(this->queue, (void*)entry_destroy, NULL);
+	this->condvar->destroy(this->condvar);
+	this->mutex->destroy(this->mutex);
+	free(this);
+}
+
+/**
+ * See header
+ */
+verify_manager_t *verify_manager_create()
+{
+	private_verify_manager_t *this;
+	thread_t *thread;
+	int i, threads;
+
+	INIT(this,
+		.public = {
+			.queue = _queue,
+			.get_threads = _get_threads,
+			.get_stats = _get_stats,
+			.destroy = _destroy,
+		},
+		.threads = array_create(0, 0),
+		.queue = array_create(0, 0),
+		.batch = max(1, lib->settings->get_int(lib->settings,
+						"%s.verify.batch", DEFAULT_BATCH_SIZE, charon->name)),
+		.mutex = mutex_create(MUTEX_TYPE_DEFAULT),
+		.condvar = condvar_create(CONDVAR_TYPE_DEFAULT),
+	);
+
+	threads = lib->settings->get_int(lib->settings, "%s.verify.threads", 0,
+									 charon->name);
+	for (i = 0; i < threads; i++)
+	{
+		thread = thread_create((thread_main_t)verify_requests, this);
+		if (!thread)
+		{
+			DBG1(DBG_IKE, "creating signature verification thread failed");
+			break;
+		}
+		array_insert(this->threads, ARRAY_TAIL, thread);
+	}
+	if (array_count(this->threads))
+	{
+		DBG1(DBG_IKE, "verifying signatures asynchronously using %d threads",
+			 array_count(this->threads));
+	}
+	return &this->public;
+}
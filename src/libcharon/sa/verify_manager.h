@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2013 Hochschule fuer Technik Rapperswil
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.  See <http://www.fsf.org/copyleft/gpl.txt>.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+
+/**
+ * @defgroup verify_manager verify_manager
+ * @{ @ingroup sa
+ */
+
+#ifndef VERIFY_MANAGER_H_
+#define VERIFY_MANAGER_H_
+
+typedef struct verify_manager_t verify_manager_t;
+typedef struct verify_request_t verify_request_t;
+
+#include <library.h>
+#include <processing/jobs/job.h>
+#include <credentials/auth_cfg.h>
+#include <credentials/keys/public_key.h>
+
+/**
+ * A signature verification request against the trusted public keys of a peer.
+ *
+ * Requests are reference counted, as they are shared between the requesting
+ * authenticator and the thread completing it.
+ */
+struct verify_request_t {
+
+	/**
+	 * Get the number of trusted public keys tried.
+	 *
+	 * @return				number of keys tried by verify()
+	 */
+	int (*get_key_count)(verify_request_t *this);
+
+	/**
+	 * Look up trusted public keys of the peer and verify the signature
+	 * against them, until one matches.
+	 *
+	 * Keys are enumerated from the credential manager one at a time, so the
+	 * trust chain of a candidate gets validated only if all previous ones
+	 * failed to verify the signature.
+	 *
+	 * This is invoked by the verify_manager_t, but may be called directly to
+	 * complete a request synchronously.
+	 */
+	void (*verify)(verify_request_t *this);
+
+	/**
+	 * Check if the request has been completed.
+	 *
+	 * @return				TRUE if verify() has been called
+	 */
+	bool (*is_complete)(verify_request_t *this);
+
+	/**
+	 * Get the public key that successfully verified the signature.
+	 *
+	 * @param key			verifying public key, internal reference
+	 * @param auth			auth config of the key, internal reference
+	 * @return				TRUE if signature verified successfully
+	 */
+	bool (*get_result)(verify_request_t *this, public_key_t **key,
+					   auth_cfg_t **auth);
+
+	/**
+	 * Get a reference to this request.
+	 *
+	 * @return				this, with an increased refcount
+	 */
+	verify_request_t* (*get_ref)(verify_request_t *this);
+
+	/**
+	 * Release a reference, destroy the request if it was the last.
+	 */
+	void (*destroy)(verify_request_t *this);
+};
+
+/**
+ * Create a signature verification request.
+ *
+ * @param type				type of the public keys to look up
+ * @param id				identity of the peer, gets cloned
+ * @param auth				auth constraints for the keys, gets cloned
+ * @param scheme			signature scheme to verify
+ * @param data				signed data, gets cloned
+ * @param signature			signature to verify, gets cloned
+ * @return					request
+ */
+verify_request_t *verify_request_create(key_type_t type, identification_t *id,
+										auth_cfg_t *auth,
+										signature_scheme_t scheme,
+										chunk_t data, chunk_t signature);
+
+/**
+ * Asynchronous signature verification stage.
+ *
+ * Dedicated crypto threads take pending verification requests from a queue
+ * in batches and complete them. Once completed, a job is queued to the
+ * processor to resume the waiting operation. This frees worker threads from
+ * waiting on expensive public key operations, and keeps the number of
+ * concurrent verifications bounded during load peaks.
+ *
+ * The number of crypto threads is configured with the
+ * charon.verify.threads option, asynchronous verification is disabled if
+ * it is zero.
+ */
+struct verify_manager_t {
+
+	/**
+	 * Queue a request for asynchronous verification.
+	 *
+	 * @param request		request to verify, gets referenced
+	 * @param done			job to queue once request is complete, gets owned
+	 * @return				TRUE if queued, FALSE if disabled
+	 */
+	bool (*queue)(verify_manager_t *this, verify_request_t *request,
+				  job_t *done);
+
+	/**
+	 * Get the number of crypto threads.
+	 *
+	 * @return				number of threads, 0 if disabled
+	 */
+	u_int (*get_threads)(verify_manager_t *this);
+
+	/**
+	 * Get statistics about processed requests.
+	 *
+	 * @param pending		number of currently queued requests
+	 * @param done			number of requests completed so far
+	 * @param latency		average time from queueing to completion, in us
+	 * @param max			maximum time from queueing to completion, in us
+	 */
+	void (*get_stats)(verify_manager_t *this, u_int *pending, u_int *done,
+					  u_int *latency, u_int *max);
+
+	/**
+	 * Destroy a verify_manager_t, stops all crypto threads.
+	 */
+	void (*destroy)(verify_manager_t *this);
+};
+
+/**
+ * Create a verify_manager instance.
+ */
+verify_manager_t *verify_manager_create();
+
+#endif /** VERIFY_MANAGER_H_ @}*/
@@ -82,7 +82,7 @@ typedef struct {
  */
 static u_int id_hash(identification_t *id)
 {
-	return chunk_hash(id->get_encoding(id));
+	return id->hash(id, 0);
 }
 
 /**
@@ -270,6 +270,7 @@ static char* lookup_algorithm(transform_type_t type, int ikev2)
 	return NULL;
 }
 
+typedef struct usage_stats_t usage_stats_t;
 typedef struct private_kernel_netlink_ipsec_t private_kernel_netlink_ipsec_t;
 
 /**
@@ -325,6 +326,26 @@ struct private_kernel_netlink_ipsec_t {
 	 * Size of the replay window bitmap, in number of __u32 blocks
 	 */
 	u_int32_t replay_bmp;
+
+	/**
+	 * Maximum age of usage statistics snapshots, in seconds, 0 to disable
+	 */
+	u_int32_t stats_interval;
+
+	/**
+	 * Current snapshot of SA and policy usage statistics, if any
+	 */
+	usage_stats_t *stats;
+
+	/**
+	 * Whether a thread is currently taking a new snapshot
+	 */
+	bool stats_refreshing;
+
+	/**
+	 * Mutex to lock access to the usage statistics snapshot
+	 */
+	mutex_t *stats_lock;
 };
 
 typedef struct route_entry_t route_entry_t;
@@ -599,6 +620,131 @@ static bool policy_equals(policy_entry_t *key, policy_entry_t *other_key)
 		   key->direction == other_key->direction;
 }
 
+typedef struct sa_stats_t sa_stats_t;
+
+/**
+ * Usage statistics of an installed SA
+ */
+struct sa_stats_t {
+
+	/** Destination address, SPI and protocol of the SA */
+	struct xfrm_id id;
+
+	/** Address family of the SA */
+	u_int16_t family;
+
+	/** Optional mark */
+	struct xfrm_mark mark;
+
+	/** Number of bytes processed */
+	u_int64_t bytes;
+
+	/** Number of packets processed */
+	u_int64_t packets;
+};
+
+/**
+ * Hash function for sa_stats_t objects
+ */
+static u_int sa_stats_hash(sa_stats_t *key)
+{
+	return chunk_hash_inc(chunk_from_thing(key->id.spi),
+						  chunk_hash(chunk_from_thing(key->mark)));
+}
+
+/**
+ * Equality function for sa_stats_t objects
+ */
+static bool sa_stats_equals(sa_stats_t *key, sa_stats_t *other_key)
+{
+	return key->id.spi == other_key->id.spi &&
+		   key->id.proto == other_key->id.proto &&
+		   key->family == other_key->family &&
+		   memeq(&key->id.daddr, &other_key->id.daddr,
+				 key->family == AF_INET ? 4 : 16) &&
+		   key->mark.v == other_key->mark.v &&
+		   key->mark.m == other_key->mark.m;
+}
+
+typedef struct policy_stats_t policy_stats_t;
+
+/**
+ * Usage statistics of an installed policy, the key matches policy_entry_t
+ */
+struct policy_stats_t {
+
+	/** Direction of this policy: in, out, forward */
+	u_int8_t direction;
+
+	/** Selector of the policy */
+	struct xfrm_selector sel;
+
+	/** Optional mark */
+	u_int32_t mark;
+
+	/** Last use of the policy, as system time, 0 if not used yet */
+	u_int32_t use_time;
+};
+
+/**
+ * Hash function for policy_stats_t objects
+ */
+static u_int policy_stats_hash(policy_stats_t *key)
+{
+	chunk_t chunk = chunk_from_thing(key->sel);
+	return chunk_hash_inc(chunk, chunk_hash(chunk_from_thing(key->mark)));
+}
+
+/**
+ * Equality function for policy_stats_t objects
+ */
+static bool policy_stats_equals(policy_stats_t *key, policy_stats_t *other_key)
+{
+	return memeq(&key->sel, &other_key->sel, sizeof(struct xfrm_selector)) &&
+		   key->mark == other_key->mark &&
+		   key->direction == other_key->direction;
+}
+
+/**
+ * Snapshot of the usage statistics of all installed SAs and policies
+ */
+struct usage_stats_t {
+
+	/** Monotonic time the snapshot was taken */
+	time_t created;
+
+	/** Statistics of SAs, sa_stats_t */
+	hashtable_t *sas;
+
+	/** Statistics of policies, policy_stats_t */
+	hashtable_t *policies;
+};
+
+/**
+ * Destroy a usage_stats_t object
+ */
+static void usage_stats_destroy(usage_stats_t *this)
+{
+	enumerator_t *enumerator;
+	void *key, *value;
+
+	enumerator = this->sas->create_enumerator(this->sas);
+	while (enumerator->enumerate(enumerator, &key, &value))
+	{
+		free(value);
+	}
+	enumerator->destroy(enumerator);
+	enumerator = this->policies->create_enumerator(this->policies);
+	while (enumerator->enumerate(enumerator, &key, &value))
+	{
+		free(value);
+	}
+	enumerator->destroy(enumerator);
+	this->sas->destroy(this->sas);
+	this->policies->destroy(this->policies);
+	free(this);
+}
+
 /**
  * Calculate the priority of a policy
  */
@@ -1592,6 +1738,187 @@ static void get_replay_state(private_kernel_netlink_ipsec_t *this,
 	free(out);
 }
 
+/**
+ * Get the XFRMA_MARK attribute of a dumped SA or policy
+ */
+static struct xfrm_mark get_dumped_mark(struct rtattr *rta, size_t rtasize)
+{
+	struct xfrm_mark mark = {};
+
+	while (RTA_OK(rta, rtasize))
+	{
+		if (rta->rta_type == XFRMA_MARK &&
+			RTA_PAYLOAD(rta) == sizeof(struct xfrm_mark))
+		{
+			mark = *(struct xfrm_mark*)RTA_DATA(rta);
+			break;
+		}
+		rta = RTA_NEXT(rta, rtasize);
+	}
+	return mark;
+}
+
+/**
+ * Dump the counters of all installed SAs with a single request
+ */
+static bool dump_sa_stats(private_kernel_netlink_ipsec_t *this,
+						  hashtable_t *sas)
+{
+	netlink_buf_t request;
+	struct nlmsghdr *out, *hdr;
+	struct xfrm_usersa_info *info;
+	sa_stats_t *sa;
+	size_t len;
+
+	memset(&request, 0, sizeof(request));
+
+	hdr = (struct nlmsghdr*)request;
+	hdr->nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+	hdr->nlmsg_type = XFRM_MSG_GETSA;
+	hdr->nlmsg_len = NLMSG_LENGTH(sizeof(struct xfrm_usersa_id));
+
+	if (this->socket_xfrm->send(this->socket_xfrm, hdr, &out, &len) != SUCCESS)
+	{
+		DBG1(DBG_KNL, "unable to dump SAD entries");
+		return FALSE;
+	}
+	for (hdr = out; NLMSG_OK(hdr, len); hdr = NLMSG_NEXT(hdr, len))
+	{
+		if (hdr->nlmsg_type != XFRM_MSG_NEWSA)
+		{
+			continue;
+		}
+		info = (struct xfrm_usersa_info*)NLMSG_DATA(hdr);
+		INIT(sa,
+			.id = info->id,
+			.family = info->family,
+			.mark = get_dumped_mark(XFRM_RTA(hdr, struct xfrm_usersa_info),
+							XFRM_PAYLOAD(hdr, struct xfrm_usersa_info)),
+			.bytes = info->curlft.bytes,
+			.packets = info->curlft.packets,
+		);
+		free(sas->put(sas, sa, sa));
+	}
+	/* the dump contains the keys of all SAs */
+	memwipe(out, len);
+	free(out);
+	return TRUE;
+}
+
+/**
+ * Dump the use times of all installed policies with a single request
+ */
+static bool dump_policy_stats(private_kernel_netlink_ipsec_t *this,
+							  hashtable_t *policies)
+{
+	netlink_buf_t request;
+	struct nlmsghdr *out, *hdr;
+	struct xfrm_userpolicy_info *info;
+	struct xfrm_mark mark;
+	policy_stats_t *policy;
+	size_t len;
+
+	memset(&request, 0, sizeof(request));
+
+	hdr = (struct nlmsghdr*)request;
+	hdr->nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+	hdr->nlmsg_type = XFRM_MSG_GETPOLICY;
+	hdr->nlmsg_len = NLMSG_LENGTH(sizeof(struct xfrm_userpolicy_id));
+
+	if (this->socket_xfrm->send(this->socket_xfrm, hdr, &out, &len) != SUCCESS)
+	{
+		DBG1(DBG_KNL, "unable to dump policies");
+		return FALSE;
+	}
+	for (hdr = out; NLMSG_OK(hdr, len); hdr = NLMSG_NEXT(hdr, len))
+	{
+		if (hdr->nlmsg_type != XFRM_MSG_NEWPOLICY)
+		{
+			continue;
+		}
+		info = (struct xfrm_userpolicy_info*)NLMSG_DATA(hdr);
+		mark = get_dumped_mark(XFRM_RTA(hdr, struct xfrm_userpolicy_info),
+							   XFRM_PAYLOAD(hdr, struct xfrm_userpolicy_info));
+		INIT(policy,
+			.direction = info->dir,
+			.sel = info->sel,
+			.mark = mark.v & mark.m,
+			.use_time = info->curlft.use_time,
+		);
+		free(policies->put(policies, policy, policy));
+	}
+	free(out);
+	return TRUE;
+}
+
+/**
+ * Take a new snapshot of the usage statistics of all SAs and policies
+ */
+static usage_stats_t *usage_stats_create(private_kernel_netlink_ipsec_t *this)
+{
+	usage_stats_t *stats;
+
+	INIT(stats,
+		.created = time_monotonic(NULL),
+		.sas = hashtable_create((hashtable_hash_t)sa_stats_hash,
+								(hashtable_equals_t)sa_stats_equals, 128),
+		.policies = hashtable_create((hashtable_hash_t)policy_stats_hash,
+								(hashtable_equals_t)policy_stats_equals, 128),
+	);
+	if (!dump_sa_stats(this, stats->sas) ||
+		!dump_policy_stats(this, stats->policies))
+	{
+		usage_stats_destroy(stats);
+		return NULL;
+	}
+	DBG2(DBG_KNL, "dumped usage statistics of %u SAs and %u policies",
+		 stats->sas->get_count(stats->sas),
+		 stats->policies->get_count(stats->policies));
+	return stats;
+}
+
+/**
+ * Get the current usage statistics snapshot, take a new one if it is
+ * outdated. Returns NULL if none is available, otherwise stats_lock is held
+ * and has to be released after using the snapshot.
+ *
+ * While one thread takes a new snapshot, other threads keep using the
+ * previous one (or query the kernel directly if there is none).
+ */
+static usage_stats_t *get_usage_stats(private_kernel_netlink_ipsec_t *this)
+{
+	usage_stats_t *stats;
+
+	if (!this->stats_interval)
+	{
+		return NULL;
+	}
+	this->stats_lock->lock(this->stats_lock);
+	if (!this->stats_refreshing && (!this->stats ||
+		this->stats->created + this->stats_interval <= time_monotonic(NULL)))
+	{
+		this->stats_refreshing = TRUE;
+		this->stats_lock->unlock(this->stats_lock);
+		stats = usage_stats_create(this);
+		this->stats_lock->lock(this->stats_lock);
+		this->stats_refreshing = FALSE;
+		if (stats)
+		{
+			if (this->stats)
+			{
+				usage_stats_destroy(this->stats);
+			}
+			this->stats = stats;
+		}
+	}
+	if (!this->stats)
+	{
+		this->stats_lock->unlock(this->stats_lock);
+		return NULL;
+	}
+	return this->stats;
+}
+
 METHOD(kernel_ipsec_t, query_sa, status_t,
 	private_kernel_netlink_ipsec_t *this, host_t *src, host_t *dst,
 	u_int32_t spi, u_int8_t protocol, mark_t mark,
@@ -1602,8 +1929,47 @@ METHOD(kernel_ipsec_t, query_sa, status_t,
 	struct xfrm_usersa_id *sa_id;
 	struct xfrm_usersa_info *sa = NULL;
 	status_t status = FAILED;
+	usage_stats_t *stats;
+	sa_stats_t *found, key = {
+		.id = {
+			.spi = spi,
+			.proto = protocol,
+		},
+		.family = dst->get_family(dst),
+		.mark = {
+			.v = mark.value,
+			.m = mark.mask,
+		},
+	};
 	size_t len;
 
+	stats = get_usage_stats(this);
+	if (stats)
+	{
+		host2xfrm(dst, &key.id.daddr);
+		found = stats->sas->get(stats->sas, &key);
+		if (found)
+		{
+			if (bytes)
+			{
+				*bytes = found->bytes;
+			}
+			if (packets)
+			{
+				*packets = found->packets;
+			}
+			if (time)
+			{	/* not provided by SAs, see below */
+				*time = 0;
+			}
+		}
+		this->stats_lock->unlock(this->stats_lock);
+		if (found)
+		{
+			return SUCCESS;
+		}
+	}
+
 	memset(&request, 0, sizeof(request));
 
 	DBG2(DBG_KNL, "querying SAD entry with SPI %.8x  (mark %u/0x%08x)",
@@ -2281,8 +2647,38 @@ METHOD(kernel_ipsec_t, query_policy, status_t,
 	struct nlmsghdr *out = NULL, *hdr;
 	struct xfrm_userpolicy_id *policy_id;
 	struct xfrm_userpolicy_info *policy = NULL;
+	usage_stats_t *stats;
+	policy_stats_t *found, key;
+	u_int32_t last_use = 0;
 	size_t len;
 
+	stats = get_usage_stats(this);
+	if (stats)
+	{
+		memset(&key, 0, sizeof(key));
+		key.sel = ts2selector(src_ts, dst_ts);
+		key.direction = direction;
+		key.mark = mark.value & mark.mask;
+		found = stats->policies->get(stats->policies, &key);
+		if (found)
+		{
+			last_use = found->use_time;
+		}
+		this->stats_lock->unlock(this->stats_lock);
+		if (found)
+		{
+			if (last_use)
+			{	/* convert system to monotonic time, as below */
+				*use_time = time_monotonic(NULL) - (time(NULL) - last_use);
+			}
+			else
+			{
+				*use_time = 0;
+			}
+			return SUCCESS;
+		}
+	}
+
 	memset(&request, 0, sizeof(request));
 
 	DBG2(DBG_KNL, "querying policy %R === %R %N  (mark %u/0x%08x)",
@@ -2597,6 +2993,11 @@ METHOD(kernel_ipsec_t, destroy, void,
 	this->policies->destroy(this->policies);
 	this->sas->destroy(this->sas);
 	this->mutex->destroy(this->mutex);
+	if (this->stats)
+	{
+		usage_stats_destroy(this->stats);
+	}
+	this->stats_lock->destroy(this->stats_lock);
 	free(this);
 }
 
@@ -2634,11 +3035,15 @@ kernel_netlink_ipsec_t *kernel_netlink_ipsec_create()
 		.sas = hashtable_create((hashtable_hash_t)ipsec_sa_hash,
 								(hashtable_equals_t)ipsec_sa_equals, 32),
 		.mutex = mutex_create(MUTEX_TYPE_DEFAULT),
+		.stats_lock = mutex_create(MUTEX_TYPE_DEFAULT),
 		.policy_history = TRUE,
 		.install_routes = lib->settings->get_bool(lib->settings,
 					"%s.install_routes", TRUE, hydra->daemon),
 		.replay_window = lib->settings->get_int(lib->settings,
 					"%s.replay_window", DEFAULT_REPLAY_WINDOW, hydra->daemon),
+		.stats_interval = lib->settings->get_int(lib->settings,
+					"%s.plugins.kernel-netlink.stats_interval", 0,
+					hydra->daemon),
 	);
 
 	this->replay_bmp = (this->replay_window + sizeof(u_int32_t) * 8 - 1) /
@@ -16,10 +16,48 @@
 #include "imv_os_database.h"
 
 #include <utils/debug.h>
+#include <threading/mutex.h>
+#include <collections/hashtable.h>
+#include <collections/array.h>
 
 #include <string.h>
 
 typedef struct private_imv_os_database_t private_imv_os_database_t;
+typedef struct index_t index_t;
+
+/**
+ * Acceptable release of a package
+ */
+typedef struct {
+	/** release string, "*" matches any release */
+	char *release;
+	/** security state of this release */
+	os_package_state_t security;
+} version_t;
+
+/**
+ * Package of a product, along with its acceptable releases
+ */
+typedef struct {
+	/** package name */
+	char *name;
+	/** acceptable releases, version_t */
+	array_t *versions;
+} package_t;
+
+/**
+ * Snapshot of the products, packages and versions tables
+ */
+struct index_t {
+	/** known products, name => product packages (hashtable of package_t) */
+	hashtable_t *products;
+	/** names of packages known for any product */
+	hashtable_t *packages;
+	/** time the snapshot was taken */
+	time_t created;
+	/** references to this snapshot */
+	refcount_t refs;
+};
 
 /**
  * Private data of a imv_os_database_t object.
@@ -37,20 +75,320 @@ struct private_imv_os_database_t {
 	 */
 	database_t *db;
 
+	/**
+	 * in-memory package index, NULL if not (yet) built
+	 */
+	index_t *index;
+
+	/**
+	 * interval in seconds to rebuild the index, 0 to disable it
+	 */
+	u_int refresh;
+
+	/**
+	 * TRUE while a thread rebuilds the index
+	 */
+	bool refreshing;
+
+	/**
+	 * mutex protecting index and refreshing flag
+	 */
+	mutex_t *mutex;
 };
 
+/**
+ * Hash a string
+ */
+static u_int hash(char *key)
+{
+	return chunk_hash(chunk_create(key, strlen(key)));
+}
+
+/**
+ * Compare two strings
+ */
+static bool equals(char *a, char *b)
+{
+	return streq(a, b);
+}
+
+/**
+ * Destroy a package and its versions
+ */
+static void package_destroy(package_t *package)
+{
+	version_t version;
+
+	while (array_remove(package->versions, ARRAY_TAIL, &version))
+	{
+		free(version.release);
+	}
+	array_destroy(package->versions);
+	free(package->name);
+	free(package);
+}
+
+/**
+ * Destroy an index snapshot
+ */
+static void index_destroy(index_t *index)
+{
+	enumerator_t *enumerator, *packages;
+	hashtable_t *product;
+	package_t *package;
+	char *name;
+
+	enumerator = index->products->create_enumerator(index->products);
+	while (enumerator->enumerate(enumerator, &name, &product))
+	{
+		packages = product->create_enumerator(product);
+		while (packages->enumerate(packages, NULL, &package))
+		{
+			package_destroy(package);
+		}
+		packages->destroy(packages);
+		product->destroy(product);
+		free(name);
+	}
+	enumerator->destroy(enumerator);
+	index->products->destroy(index->products);
+
+	enumerator = index->packages->create_enumerator(index->packages);
+	while (enumerator->enumerate(enumerator, &name, NULL))
+	{
+		free(name);
+	}
+	enumerator->destroy(enumerator);
+	index->packages->destroy(index->packages);
+	free(index);
+}
+
+/**
+ * Release a reference to an index snapshot
+ */
+static void index_release(index_t *index)
+{
+	if (ref_put(&index->refs))
+	{
+		index_destroy(index);
+	}
+}
+
+/**
+ * Build an index snapshot from the database with a few bulk queries
+ */
+static index_t* index_create(private_imv_os_database_t *this)
+{
+	index_t *index;
+	hashtable_t *product;
+	package_t *package;
+	version_t version;
+	enumerator_t *e;
+	char *product_name, *package_name, *release;
+	int security;
+
+	INIT(index,
+		.products = hashtable_create((hashtable_hash_t)hash,
+									 (hashtable_equals_t)equals, 32),
+		.packages = hashtable_create((hashtable_hash_t)hash,
+									 (hashtable_equals_t)equals, 1024),
+		.created = time_monotonic(NULL),
+		.refs = 1,
+	);
+
+	e = this->db->query(this->db, "SELECT name FROM packages", DB_TEXT);
+	if (!e)
+	{
+		index_destroy(index);
+		return NULL;
+	}
+	while (e->enumerate(e, &package_name))
+	{
+		if (!index->packages->get(index->packages, package_name))
+		{
+			package_name = strdup(package_name);
+			index->packages->put(index->packages, package_name, package_name);
+		}
+	}
+	e->destroy(e);
+
+	e = this->db->query(this->db, "SELECT name FROM products", DB_TEXT);
+	if (!e)
+	{
+		index_destroy(index);
+		return NULL;
+	}
+	while (e->enumerate(e, &product_name))
+	{
+		if (!index->products->get(index->products, product_name))
+		{
+			product = hashtable_create((hashtable_hash_t)hash,
+									   (hashtable_equals_t)equals, 256);
+			index->products->put(index->products, strdup(product_name),
+								 product);
+		}
+	}
+	e->destroy(e);
+
+	e = this->db->query(this->db,
+				"SELECT p.name, g.name, v.release, v.security "
+				"FROM versions AS v JOIN products AS p ON v.product = p.id "
+				"JOIN packages AS g ON v.package = g.id",
+				DB_TEXT, DB_TEXT, DB_TEXT, DB_INT);
+	if (!e)
+	{
+		index_destroy(index);
+		return NULL;
+	}
+	while (e->enumerate(e, &product_name, &package_name, &release, &security))
+	{
+		product = index->products->get(index->products, product_name);
+		if (!product || !package_name || !release)
+		{
+			continue;
+		}
+		package = product->get(product, package_name);
+		if (!package)
+		{
+			INIT(package,
+				.name = strdup(package_name),
+				.versions = array_create(sizeof(version_t), 0),
+			);
+			product->put(product, package->name, package);
+		}
+		version = (version_t){
+			.release = strdup(release),
+			.security = security,
+		};
+		array_insert(package->versions, ARRAY_TAIL, &version);
+	}
+	e->destroy(e);
+
+	DBG1(DBG_IMV, "indexed %d packages of %d products",
+		 index->packages->get_count(index->packages),
+		 index->products->get_count(index->products));
+	return index;
+}
+
+/**
+ * Get a reference to a current index snapshot, rebuilding it if necessary.
+ * While a thread rebuilds the index, others continue to use the old one.
+ */
+static index_t* get_index(private_imv_os_database_t *this)
+{
+	index_t *index, *old = NULL;
+	bool refresh;
+
+	if (!this->refresh)
+	{
+		return NULL;
+	}
+	this->mutex->lock(this->mutex);
+	refresh = !this->refreshing && (!this->index ||
+				this->index->created + this->refresh <= time_monotonic(NULL));
+	if (refresh)
+	{
+		this->refreshing = TRUE;
+		this->mutex->unlock(this->mutex);
+
+		index = index_create(this);
+
+		this->mutex->lock(this->mutex);
+		this->refreshing = FALSE;
+		if (index)
+		{
+			old = this->index;
+			this->index = index;
+		}
+	}
+	index = this->index;
+	if (index)
+	{
+		ref_get(&index->refs);
+	}
+	this->mutex->unlock(this->mutex);
+
+	if (old)
+	{
+		index_release(old);
+	}
+	return index;
+}
+
+/**
+ * Look up the acceptable versions of a package in the index
+ */
+static void check_release_index(hashtable_t *product, char *package,
+								char *release, bool *found, bool *match,
+								os_package_state_t *package_state)
+{
+	package_t *entry;
+	version_t version;
+	int i;
+
+	entry = product->get(product, package);
+	if (!entry)
+	{
+		return;
+	}
+	for (i = 0; array_get(entry->versions, i, &version); i++)
+	{
+		*found = TRUE;
+		*package_state = version.security;
+		if (streq(release, version.release) || streq("*", version.release))
+		{
+			*match = TRUE;
+			break;
+		}
+	}
+}
+
+/**
+ * Look up the acceptable versions of a package in the database
+ */
+static bool check_release_db(private_imv_os_database_t *this, int pid,
+							 int gid, char *release, bool *found, bool *match,
+							 os_package_state_t *package_state)
+{
+	enumerator_t *e;
+	char *cur_release;
+
+	/* Enumerate over all acceptable versions */
+	e = this->db->query(this->db,
+			"SELECT release, security FROM versions "
+			"WHERE product = ? AND package = ?",
+			DB_INT, pid, DB_INT, gid, DB_TEXT, DB_INT);
+	if (!e)
+	{
+		return FALSE;
+	}
+	while (e->enumerate(e, &cur_release, package_state))
+	{
+		*found = TRUE;
+		if (streq(release, cur_release) || streq("*", cur_release))
+		{
+			*match = TRUE;
+			break;
+		}
+	}
+	e->destroy(e);
+	return TRUE;
+}
+
 METHOD(imv_os_database_t, check_packages, status_t,
 	private_imv_os_database_t *this, imv_os_state_t *state,
 	enumerator_t *package_enumerator)
 {
-	char *product, *package, *release, *cur_release;
+	char *product, *package, *release;
 	u_char *pos;
 	chunk_t os_name, os_version, name, version;
 	os_type_t os_type;
 	size_t os_version_len;
 	os_package_state_t package_state;
-	int pid, gid;
+	int pid = 0, gid;
 	int count = 0, count_ok = 0, count_no_match = 0, count_blacklist = 0;
+	hashtable_t *packages = NULL;
+	index_t *index;
 	enumerator_t *e;
 	status_t status = SUCCESS;
 	bool found, match;
@@ -73,22 +411,36 @@ METHOD(imv_os_database_t, check_packages, status_t,
 	}
 	DBG1(DBG_IMV, "processing installed '%s' packages", product);
 
-	/* Get primary key of product */
-	e = this->db->query(this->db,
-				"SELECT id FROM products WHERE name = ?",
-				DB_TEXT, product, DB_INT);
-	if (!e)
+	index = get_index(this);
+	if (index)
 	{
-		free(product);
-		return FAILED;
+		packages = index->products->get(index->products, product);
+		if (!packages)
+		{
+			index_release(index);
+			free(product);
+			return NOT_FOUND;
+		}
 	}
-	if (!e->enumerate(e, &pid))
+	else
 	{
+		/* Get primary key of product */
+		e = this->db->query(this->db,
+					"SELECT id FROM products WHERE name = ?",
+					DB_TEXT, product, DB_INT);
+		if (!e)
+		{
+			free(product);
+			return FAILED;
+		}
+		if (!e->enumerate(e, &pid))
+		{
+			e->destroy(e);
+			free(product);
+			return NOT_FOUND;
+		}
 		e->destroy(e);
-		free(product);
-		return NOT_FOUND;
 	}
-	e->destroy(e);
 
 	while (package_enumerator->enumerate(package_enumerator, &name, &version))
 	{
@@ -97,16 +449,25 @@ METHOD(imv_os_database_t, check_packages, status_t,
 		count++;
 
 		/* Get primary key of package */
-		e = this->db->query(this->db,
-					"SELECT id FROM packages WHERE name = ?",
-					DB_TEXT, package, DB_INT);
-		if (!e)
+		if (index)
 		{
-			free(product);
-			free(package);
-			return FAILED;
+			found = index->packages->get(index->packages, package) != NULL;
 		}
-		if (!e->enumerate(e, &gid))
+		else
+		{
+			e = this->db->query(this->db,
+						"SELECT id FROM packages WHERE name = ?",
+						DB_TEXT, package, DB_INT);
+			if (!e)
+			{
+				status = FAILED;
+				free(package);
+				break;
+			}
+			found = e->enumerate(e, &gid);
+			e->destroy(e);
+		}
+		if (!found)
 		{
 			/* package not present in database for any product - skip */
 			if (os_type == OS_TYPE_ANDROID)
@@ -115,39 +476,27 @@ METHOD(imv_os_database_t, check_packages, status_t,
 					 package, version.len, version.ptr);
 			}
 			free(package);
-			e->destroy(e);
 			continue;
 		}
-		e->destroy(e);
 
 		/* Convert package version chunk to a string */
 		release = strndup(version.ptr, version.len);
 
-		/* Enumerate over all acceptable versions */
-		e = this->db->query(this->db,
-				"SELECT release, security FROM versions "
-				"WHERE product = ? AND package = ?",
-				DB_INT, pid, DB_INT, gid, DB_TEXT, DB_INT);
-		if (!e)
-		{
-			free(product);
-			free(package);
-			free(release);
-			return FAILED;
-		}
 		found = FALSE;
 		match = FALSE;
-
-		while (e->enumerate(e, &cur_release, &package_state))
+		if (index)
 		{
-			found = TRUE;
-			if (streq(release, cur_release) || streq("*", cur_release))
-			{
-				match = TRUE;
-				break;
-			}
+			check_release_index(packages, package, release, &found, &match,
+								&package_state);
+		}
+		else if (!check_release_db(this, pid, gid, release, &found, &match,
+								   &package_state))
+		{
+			status = FAILED;
+			free(package);
+			free(release);
+			break;
 		}
-		e->destroy(e);
 
 		if (found)
 		{
@@ -181,9 +530,16 @@ METHOD(imv_os_database_t, check_packages, status_t,
 		free(package);
 		free(release);
 	}
+	if (index)
+	{
+		index_release(index);
+	}
 	free(product);
-	state->set_count(state, count, count_no_match, count_blacklist, count_ok);
-
+	if (status == SUCCESS)
+	{
+		state->set_count(state, count, count_no_match, count_blacklist,
+						 count_ok);
+	}
 	return status;
 }
 
@@ -300,6 +656,11 @@ METHOD(imv_os_database_t, set_device_info, void,
 METHOD(imv_os_database_t, destroy, void,
 	private_imv_os_database_t *this)
 {
+	if (this->index)
+	{
+		index_release(this->index);
+	}
+	this->mutex->destroy(this->mutex);
 	this->db->destroy(this->db);
 	free(this);
 }
@@ -319,12 +680,16 @@ imv_os_database_t *imv_os_database_create(char *uri)
 			.destroy = _destroy,
 		},
 		.db = lib->db->create(lib->db, uri),
+		.refresh = lib->settings->get_int(lib->settings,
+					"libimcv.plugins.imv-os.index_refresh", 0),
+		.mutex = mutex_create(MUTEX_TYPE_DEFAULT),
 	);
 
 	if (!this->db)
 	{
 		DBG1(DBG_IMV,
 			 "failed to connect to OS database '%s'", uri);
+		this->mutex->destroy(this->mutex);
 		free(this);
 		return NULL;
 	}
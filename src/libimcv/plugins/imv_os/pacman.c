@@ -26,6 +26,7 @@
 
 #include <library.h>
 #include <utils/debug.h>
+#include <collections/hashtable.h>
 
 /**
  * global debug output variables
@@ -124,7 +125,81 @@ static time_t extract_time(char *line)
 }
 
 /**
- * Process a package file and store updates in the database
+ * Hash a package name
+ */
+static u_int hash(char *key)
+{
+	return chunk_hash(chunk_create(key, strlen(key)));
+}
+
+/**
+ * Compare package names
+ */
+static bool equals(char *a, char *b)
+{
+	return streq(a, b);
+}
+
+/**
+ * Load the primary keys of all known packages, indexed by name
+ */
+static hashtable_t* load_packages(database_t *db)
+{
+	hashtable_t *packages;
+	enumerator_t *e;
+	char *name;
+	int gid;
+
+	packages = hashtable_create((hashtable_hash_t)hash,
+								(hashtable_equals_t)equals, 1024);
+	e = db->query(db, "SELECT id, name FROM packages", DB_INT, DB_TEXT);
+	if (e)
+	{
+		while (e->enumerate(e, &gid, &name))
+		{
+			if (!packages->get(packages, name))
+			{
+				packages->put(packages, strdup(name), (void*)(uintptr_t)gid);
+			}
+		}
+		e->destroy(e);
+	}
+	return packages;
+}
+
+/**
+ * Destroy the package index
+ */
+static void destroy_packages(hashtable_t *packages)
+{
+	enumerator_t *enumerator;
+	char *name;
+
+	enumerator = packages->create_enumerator(packages);
+	while (enumerator->enumerate(enumerator, &name, NULL))
+	{
+		free(name);
+	}
+	enumerator->destroy(enumerator);
+	packages->destroy(packages);
+}
+
+/**
+ * Abort processing, discarding all changes made to the database
+ */
+static void abort_processing(database_t *db, hashtable_t *packages,
+							 FILE *file)
+{
+	db->rollback(db);
+	db->destroy(db);
+	destroy_packages(packages);
+	fclose(file);
+	exit(EXIT_FAILURE);
+}
+
+/**
+ * Process a package file and store updates in the database, within a single
+ * transaction
  */
 static void process_packages(char *filename, char *product, bool update)
 {
@@ -133,6 +208,7 @@ static void process_packages(char *filename, char *product, bool update)
 	int new_versions = 0, updated_versions = 0, deleted_versions = 0;
 	time_t gen_time;
 	u_int32_t pid = 0;
+	hashtable_t *packages;
 	enumerator_t *e;
 	database_t *db;
 	FILE *file;
@@ -161,6 +237,14 @@ static void process_packages(char *filename, char *product, bool update)
 		fclose(file);
 		exit(EXIT_FAILURE);
 	}
+	if (!db->transaction(db))
+	{
+		fprintf(stderr, "could not start database transaction\n");
+		db->destroy(db);
+		fclose(file);
+		exit(EXIT_FAILURE);
+	}
+	packages = load_packages(db);
 
 	/* check if product is already in database */
 	e = db->query(db, "SELECT id FROM products WHERE name = ?",
@@ -180,9 +264,7 @@ static void process_packages(char *filename, char *product, bool update)
 		{
 			fprintf(stderr, "could not store product '%s' to database\n",
 							 product);
-			fclose(file);
-			db->destroy(db);
-			exit(EXIT_FAILURE);
+			abort_processing(db, packages, file);
 		}
 	}
 
@@ -207,9 +289,7 @@ static void process_packages(char *filename, char *product, bool update)
 			if (gen_time == UNDEFINED_TIME)
 			{
 				fprintf(stderr, "could not extract generation time\n");
-				fclose(file);
-				db->destroy(db);
-				exit(EXIT_FAILURE);
+				abort_processing(db, packages, file);
 			}
 			printf("Generated: %T\n", &gen_time, TRUE);
 		}
@@ -265,16 +345,7 @@ static void process_packages(char *filename, char *product, bool update)
 		}
 
 		/* check if package is already in database */
-		e = db->query(db, "SELECT id FROM packages WHERE name = ?",
-						  DB_TEXT, package, DB_INT);
-		if (e)
-		{
-			if (!e->enumerate(e, &gid))
-			{
-				gid = 0;
-			}
-			e->destroy(e);
-		}
+		gid = (uintptr_t)packages->get(packages, package);
 		if (!gid && security)
 		{
 			if (db->execute(db, &gid, "INSERT INTO packages (name) VALUES (?)",
@@ -282,12 +353,16 @@ static void process_packages(char *filename, char *product, bool update)
 			{
 				fprintf(stderr, "could not store package '%s' to database\n",
 								 package);
-				fclose(file);
-				db->destroy(db);
-				exit(EXIT_FAILURE);
+				abort_processing(db, packages, file);
 			}
+			packages->put(packages, strdup(package), (void*)(uintptr_t)gid);
 			new_packages++;
 		}
+		if (!gid)
+		{
+			/* unknown non-security package, no versions to update */
+			continue;
+		}
 
 		/* check for package versions already in database */
 		e = db->query(db,
@@ -364,9 +439,7 @@ static void process_packages(char *filename, char *product, bool update)
 								 version);
 				free(version_update);
 				free(version_delete);
-				fclose(file);
-				db->destroy(db);
-				exit(EXIT_FAILURE);
+				abort_processing(db, packages, file);
 			}
 			new_versions++;
 		}
@@ -384,9 +457,7 @@ static void process_packages(char *filename, char *product, bool update)
 								 version);
 				free(version_update);
 				free(version_delete);
-				fclose(file);
-				db->destroy(db);
-				exit(EXIT_FAILURE);
+				abort_processing(db, packages, file);
 			}
 			updated_versions++;
 		}
@@ -404,9 +475,7 @@ static void process_packages(char *filename, char *product, bool update)
 								 version_delete);
 				free(version_update);
 				free(version_delete);
-				fclose(file);
-				db->destroy(db);
-				exit(EXIT_FAILURE);
+				abort_processing(db, packages, file);
 			}
 			deleted_versions++;
 		}
@@ -414,6 +483,13 @@ static void process_packages(char *filename, char *product, bool update)
 		free(version_delete);
 	}
 	fclose(file);
+	destroy_packages(packages);
+	if (!db->commit(db))
+	{
+		fprintf(stderr, "could not commit changes to database\n");
+		db->destroy(db);
+		exit(EXIT_FAILURE);
+	}
 	db->destroy(db);
 
 	printf("processed %d packages, %d security, %d new packages, "
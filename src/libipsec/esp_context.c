@@ -24,10 +24,20 @@
 #include <utils/debug.h>
 
 /**
- * Should be a multiple of 8
+ * Default size of the anti-replay window (in packets)
  */
 #define ESP_DEFAULT_WINDOW_SIZE 128
 
+/**
+ * Maximum size of the anti-replay window (in packets)
+ */
+#define ESP_MAX_WINDOW_SIZE (1 << 20)
+
+/**
+ * Bits per anti-replay window block
+ */
+#define WINDOW_BLOCK_BITS (sizeof(u_int64_t) * CHAR_BIT)
+
 typedef struct private_esp_context_t private_esp_context_t;
 
 /**
@@ -52,19 +62,20 @@ struct private_esp_context_t {
 	u_int32_t last_seqno;
 
 	/**
-	 * The bit in the window of the highest authenticated sequence number
+	 * The size of the anti-replay window (in packets)
 	 */
-	u_int seqno_index;
+	u_int window_size;
 
 	/**
-	 * The size of the anti-replay window (in bits)
+	 * The anti-replay window, a ring buffer of blocks (RFC 6479), the bit for
+	 * a sequence number is found in block (seqno / WINDOW_BLOCK_BITS) & mask
 	 */
-	u_int window_size;
+	u_int64_t *window;
 
 	/**
-	 * The anti-replay window buffer
+	 * Mask to get the block index, the number of blocks is a power of two
 	 */
-	chunk_t window;
+	u_int window_mask;
 
 	/**
 	 * TRUE in case of an inbound ESP context
@@ -73,31 +84,20 @@ struct private_esp_context_t {
 };
 
 /**
- * Set or unset a bit in the window.
+ * Get the block of the window containing the given seqno
  */
-static inline void set_window_bit(private_esp_context_t *this,
-								  u_int index, bool set)
+static inline u_int64_t *get_window_block(private_esp_context_t *this,
+										  u_int32_t seqno)
 {
-	u_int i = index / CHAR_BIT;
-
-	if (set)
-	{
-		this->window.ptr[i] |= 1 << (index % CHAR_BIT);
-	}
-	else
-	{
-		this->window.ptr[i] &= ~(1 << (index % CHAR_BIT));
-	}
+	return &this->window[(seqno / WINDOW_BLOCK_BITS) & this->window_mask];
 }
 
 /**
- * Get a bit from the window.
+ * Get the bit of the given seqno in its block
  */
-static inline bool get_window_bit(private_esp_context_t *this, u_int index)
+static inline u_int64_t get_window_bit(u_int32_t seqno)
 {
-	u_int i = index / CHAR_BIT;
-
-	return this->window.ptr[i] & (1 << index % CHAR_BIT);
+	return (u_int64_t)1 << (seqno % WINDOW_BLOCK_BITS);
 }
 
 /**
@@ -105,11 +105,7 @@ static inline bool get_window_bit(private_esp_context_t *this, u_int index)
  */
 static bool check_window(private_esp_context_t *this, u_int32_t seqno)
 {
-	u_int offset;
-
-	offset = this->last_seqno - seqno;
-	offset = (this->seqno_index - offset) % this->window_size;
-	return !get_window_bit(this, offset);
+	return !(*get_window_block(this, seqno) & get_window_bit(seqno));
 }
 
 METHOD(esp_context_t, verify_seqno, bool,
@@ -155,22 +151,18 @@ METHOD(esp_context_t, set_authenticated_seqno, void,
 	}
 
 	if (seqno > this->last_seqno)
-	{	/* shift the window to the new highest authenticated seqno */
-		shift = seqno - this->last_seqno;
-		shift = shift < this->window_size ? shift : this->window_size;
-		for (i = 0; i < shift; ++i)
+	{	/* advance the window to the new highest authenticated seqno, clearing
+		 * the blocks entering it, but at most all of them */
+		shift = seqno / WINDOW_BLOCK_BITS - this->last_seqno / WINDOW_BLOCK_BITS;
+		shift = min(shift, this->window_mask + 1);
+		for (i = 1; i <= shift; i++)
 		{
-			this->seqno_index = (this->seqno_index + 1) % this->window_size;
-			set_window_bit(this, this->seqno_index, FALSE);
+			*get_window_block(this, this->last_seqno +
+							  i * WINDOW_BLOCK_BITS) = 0;
 		}
-		set_window_bit(this, this->seqno_index, TRUE);
 		this->last_seqno = seqno;
 	}
-	else
-	{	/* seqno is inside the window, set the corresponding window bit */
-		i = this->last_seqno - seqno;
-		set_window_bit(this, (this->seqno_index - i) % this->window_size, TRUE);
-	}
+	*get_window_block(this, seqno) |= get_window_bit(seqno);
 }
 
 METHOD(esp_context_t, get_seqno, u_int32_t,
@@ -199,7 +191,7 @@ METHOD(esp_context_t, get_aead, aead_t*,
 METHOD(esp_context_t, destroy, void,
 	private_esp_context_t *this)
 {
-	chunk_free(&this->window);
+	free(this->window);
 	DESTROY_IF(this->aead);
 	free(this);
 }
@@ -305,6 +297,17 @@ esp_context_t *esp_context_create(int enc_alg, chunk_t enc_key,
 								  int int_alg, chunk_t int_key, bool inbound)
 {
 	private_esp_context_t *this;
+	u_int blocks = 1;
+	int window;
+
+	window = lib->settings->get_int(lib->settings, "libipsec.replay_window",
+									ESP_DEFAULT_WINDOW_SIZE);
+	if (window < 0 || window > ESP_MAX_WINDOW_SIZE)
+	{
+		DBG1(DBG_ESP, "replay window size %d out of range, using %d", window,
+			 window < 0 ? 0 : ESP_MAX_WINDOW_SIZE);
+		window = window < 0 ? 0 : ESP_MAX_WINDOW_SIZE;
+	}
 
 	INIT(this,
 		.public = {
@@ -316,7 +319,7 @@ esp_context_t *esp_context_create(int enc_alg, chunk_t enc_key,
 			.destroy = _destroy,
 		},
 		.inbound = inbound,
-		.window_size = ESP_DEFAULT_WINDOW_SIZE,
+		.window_size = window,
 	);
 
 	if (encryption_algorithm_is_aead(enc_alg))
@@ -337,9 +340,14 @@ esp_context_t *esp_context_create(int enc_alg, chunk_t enc_key,
 	}
 
 	if (inbound)
-	{
-		this->window = chunk_alloc(this->window_size / CHAR_BIT + 1);
-		memset(this->window.ptr, 0, this->window.len);
+	{	/* one additional block, as the window usually starts within a block */
+		while (blocks < (this->window_size + WINDOW_BLOCK_BITS - 1) /
+													WINDOW_BLOCK_BITS + 1)
+		{
+			blocks <<= 1;
+		}
+		this->window = calloc(blocks, sizeof(u_int64_t));
+		this->window_mask = blocks - 1;
 	}
 	return &this->public;
 }
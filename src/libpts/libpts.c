@@ -14,6 +14,7 @@
 
 #include "libpts.h"
 #include "tcg/tcg_attr.h"
+#include "pts/pts_file_meas.h"
 #include "pts/components/pts_component.h"
 #include "pts/components/pts_component_manager.h"
 #include "pts/components/tcg/tcg_comp_func_name.h"
@@ -67,6 +68,8 @@ bool libpts_init(void)
 									  PTS_ITA_COMP_FUNC_NAME_IMA,
 									  pts_ita_comp_ima_create);
 
+		pts_file_meas_cache_init();
+
 		DBG1(DBG_LIB, "libpts initialized");
 	}
 	ref_get(&libpts_ref);
@@ -84,6 +87,7 @@ void libpts_deinit(void)
 		pts_components->remove_vendor(pts_components, PEN_TCG);
 		pts_components->remove_vendor(pts_components, PEN_ITA);
 		pts_components->destroy(pts_components);
+		pts_file_meas_cache_deinit();
 
 		if (!imcv_pa_tnc_attributes)
 		{
@@ -16,12 +16,29 @@
 #include "pts_file_meas.h"
 
 #include <collections/linked_list.h>
+#include <collections/hashtable.h>
+#include <threading/mutex.h>
+#include <threading/condvar.h>
+#include <processing/jobs/callback_job.h>
 #include <utils/debug.h>
 
 #include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
 #include <libgen.h>
 #include <errno.h>
 
+/**
+ * Size of the read buffer used to hash files
+ */
+#define READ_BUFFER_SIZE 262144
+
+/**
+ * Default maximum number of cached measurements
+ */
+#define DEFAULT_CACHE_SIZE 16384
+
 typedef struct private_pts_file_meas_t private_pts_file_meas_t;
 
 /**
@@ -234,26 +251,227 @@ pts_file_meas_t *pts_file_meas_create(u_int16_t request_id)
 	return &this->public;
 }
 
+typedef struct cache_key_t cache_key_t;
+
 /**
- * Hash a file with a given absolute pathname
+ * Identifies an unchanged file and the algorithm it was measured with
+ */
+struct cache_key_t {
+	dev_t dev;
+	ino_t ino;
+	off_t size;
+	time_t mtime;
+	time_t ctime;
+	hash_algorithm_t alg;
+};
+
+/**
+ * Cached file measurement
+ */
+typedef struct {
+	/** key of this entry */
+	cache_key_t key;
+	/** measurement of the file */
+	u_char hash[HASH_SIZE_SHA384];
+} cache_entry_t;
+
+/**
+ * Cached measurements, cache_key_t => cache_entry_t, NULL if disabled
+ */
+static hashtable_t *cache;
+
+/**
+ * Mutex to lock cache
+ */
+static mutex_t *cache_mutex;
+
+/**
+ * Cached entries in insertion order, the oldest gets evicted if full
+ */
+static cache_entry_t **cache_ring;
+
+/**
+ * Maximum number of cached entries
+ */
+static u_int cache_size;
+
+/**
+ * Position of the oldest entry in cache_ring
+ */
+static u_int cache_pos;
+
+/**
+ * Hashtable hash function for cache keys
  */
-static bool hash_file(hasher_t *hasher, char *pathname, u_char *hash)
+static u_int cache_hash(cache_key_t *key)
 {
-	u_char buffer[4096];
-	size_t bytes_read;
-	bool success = TRUE;
-	FILE *file;
+	return chunk_hash(chunk_create((u_char*)key, sizeof(*key)));
+}
+
+/**
+ * Hashtable equals function for cache keys
+ */
+static bool cache_equals(cache_key_t *a, cache_key_t *b)
+{
+	return memeq(a, b, sizeof(*a));
+}
+
+/**
+ * Build the cache key for an opened file, returns FALSE if the file should
+ * not be cached
+ */
+static bool build_key(cache_key_t *key, struct stat *st, hash_algorithm_t alg)
+{
+	time_t now = time(NULL);
+
+	/* timestamps have a resolution of one second, a file changed within the
+	 * current second might get changed again without notice */
+	if (st->st_mtime >= now - 1 || st->st_ctime >= now - 1)
+	{
+		return FALSE;
+	}
+	/* zero padding so the key can be hashed and compared as a whole */
+	memset(key, 0, sizeof(*key));
+	key->dev = st->st_dev;
+	key->ino = st->st_ino;
+	key->size = st->st_size;
+	key->mtime = st->st_mtime;
+	key->ctime = st->st_ctime;
+	key->alg = alg;
+	return TRUE;
+}
+
+/**
+ * Look up a cached measurement, returns TRUE if found
+ */
+static bool cache_get(cache_key_t *key, u_char *hash, size_t len)
+{
+	cache_entry_t *entry;
+
+	if (!cache)
+	{
+		return FALSE;
+	}
+	cache_mutex->lock(cache_mutex);
+	entry = cache->get(cache, key);
+	if (entry)
+	{
+		memcpy(hash, entry->hash, len);
+	}
+	cache_mutex->unlock(cache_mutex);
+	return entry != NULL;
+}
+
+/**
+ * Store a measurement in the cache
+ */
+static void cache_put(cache_key_t *key, u_char *hash, size_t len)
+{
+	cache_entry_t *entry;
+
+	if (!cache)
+	{
+		return;
+	}
+	cache_mutex->lock(cache_mutex);
+	if (cache->get(cache, key))
+	{	/* measured concurrently, same file content */
+		cache_mutex->unlock(cache_mutex);
+		return;
+	}
+	entry = cache_ring[cache_pos];
+	if (entry)
+	{	/* evict the oldest entry, reuse it */
+		cache->remove(cache, &entry->key);
+	}
+	else
+	{
+		entry = malloc_thing(cache_entry_t);
+	}
+	entry->key = *key;
+	memcpy(entry->hash, hash, len);
+	cache->put(cache, &entry->key, entry);
+	cache_ring[cache_pos] = entry;
+	cache_pos = (cache_pos + 1) % cache_size;
+	cache_mutex->unlock(cache_mutex);
+}
+
+/**
+ * See header
+ */
+void pts_file_meas_cache_init(void)
+{
+	if (!cache && lib->settings->get_bool(lib->settings,
+						"libimcv.plugins.imc-attestation.meas_cache", FALSE))
+	{
+		cache_size = lib->settings->get_int(lib->settings,
+						"libimcv.plugins.imc-attestation.meas_cache_size",
+						DEFAULT_CACHE_SIZE);
+		if (cache_size)
+		{
+			cache = hashtable_create((hashtable_hash_t)cache_hash,
+									 (hashtable_equals_t)cache_equals, 128);
+			cache_mutex = mutex_create(MUTEX_TYPE_DEFAULT);
+			cache_ring = calloc(cache_size, sizeof(cache_entry_t*));
+			cache_pos = 0;
+		}
+	}
+}
+
+/**
+ * See header
+ */
+void pts_file_meas_cache_deinit(void)
+{
+	u_int i;
+
+	if (cache)
+	{
+		for (i = 0; i < cache_size; i++)
+		{
+			free(cache_ring[i]);
+		}
+		free(cache_ring);
+		cache->destroy(cache);
+		cache_mutex->destroy(cache_mutex);
+		cache = NULL;
+	}
+}
 
-	file = fopen(pathname, "rb");
-	if (!file)
+/**
+ * Hash a file with a given absolute pathname
+ */
+static bool hash_file(hasher_t *hasher, hash_algorithm_t alg, char *pathname,
+					  u_char *hash, u_char *buffer)
+{
+	cache_key_t key;
+	struct stat st;
+	ssize_t bytes_read;
+	bool success = TRUE, cacheable = FALSE;
+	int fd;
+
+	fd = open(pathname, O_RDONLY);
+	if (fd < 0)
 	{
 		DBG1(DBG_PTS,"  file '%s' can not be opened, %s", pathname,
 			 strerror(errno));
 		return FALSE;
 	}
+	if (cache && fstat(fd, &st) == 0)
+	{
+		cacheable = build_key(&key, &st, alg);
+	}
+	if (cacheable && cache_get(&key, hash, hasher->get_hash_size(hasher)))
+	{
+		close(fd);
+		return TRUE;
+	}
+#ifdef POSIX_FADV_SEQUENTIAL
+	posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
 	while (TRUE)
 	{
-		bytes_read = fread(buffer, 1, sizeof(buffer), file);
+		bytes_read = read(fd, buffer, READ_BUFFER_SIZE);
 		if (bytes_read > 0)
 		{
 			if (!hasher->get_hash(hasher, chunk_create(buffer, bytes_read), NULL))
@@ -263,6 +481,17 @@ static bool hash_file(hasher_t *hasher, char *pathname, u_char *hash)
 				break;
 			}
 		}
+		else if (bytes_read < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		else if (bytes_read < 0)
+		{
+			DBG1(DBG_PTS, "  reading file '%s' failed, %s", pathname,
+				 strerror(errno));
+			success = FALSE;
+			break;
+		}
 		else
 		{
 			if (!hasher->get_hash(hasher, chunk_empty, hash))
@@ -273,7 +502,172 @@ static bool hash_file(hasher_t *hasher, char *pathname, u_char *hash)
 			break;
 		}
 	}
-	fclose(file);
+	close(fd);
+
+	if (success && cacheable)
+	{
+		cache_put(&key, hash, hasher->get_hash_size(hasher));
+	}
+	return success;
+}
+
+/**
+ * A file to measure
+ */
+typedef struct {
+	/** absolute pathname */
+	char *pathname;
+	/** name to report */
+	char *filename;
+	/** measurement, if hashed successfully */
+	u_char hash[HASH_SIZE_SHA384];
+} meas_file_t;
+
+/**
+ * Files measured concurrently by the caller and jobs on the thread pool
+ */
+typedef struct {
+	/** files to measure */
+	meas_file_t *files;
+	/** number of files */
+	int count;
+	/** hash algorithm to use */
+	hash_algorithm_t alg;
+	/** index of the next file to measure */
+	int next;
+	/** number of measured files */
+	int done;
+	/** TRUE if measuring a file failed */
+	bool failed;
+	/** mutex to lock the counters */
+	mutex_t *mutex;
+	/** condvar signaling measured files */
+	condvar_t *condvar;
+	/** references held by the caller and queued jobs */
+	refcount_t refs;
+} meas_batch_t;
+
+/**
+ * Release a reference to a batch
+ */
+static void batch_unref(meas_batch_t *batch)
+{
+	if (ref_put(&batch->refs))
+	{
+		batch->condvar->destroy(batch->condvar);
+		batch->mutex->destroy(batch->mutex);
+		free(batch);
+	}
+}
+
+/**
+ * Measure files of a batch until none are left, returns FALSE on failure
+ */
+static bool measure_files(meas_batch_t *batch)
+{
+	hasher_t *hasher = NULL;
+	u_char *buffer = NULL;
+	bool success = TRUE;
+	int i;
+
+	while (TRUE)
+	{
+		batch->mutex->lock(batch->mutex);
+		if (batch->failed || batch->next >= batch->count)
+		{
+			batch->mutex->unlock(batch->mutex);
+			break;
+		}
+		i = batch->next++;
+		batch->mutex->unlock(batch->mutex);
+
+		if (!hasher)
+		{	/* hashers are not thread-safe, each worker uses its own */
+			hasher = lib->crypto->create_hasher(lib->crypto, batch->alg);
+			if (!hasher)
+			{
+				DBG1(DBG_PTS, "  creating hasher %N failed",
+					 hash_algorithm_names, batch->alg);
+			}
+			buffer = malloc(READ_BUFFER_SIZE);
+		}
+		success = hasher && hash_file(hasher, batch->alg,
+						batch->files[i].pathname, batch->files[i].hash, buffer);
+
+		batch->mutex->lock(batch->mutex);
+		batch->done++;
+		if (!success)
+		{
+			batch->failed = TRUE;
+		}
+		batch->condvar->signal(batch->condvar);
+		batch->mutex->unlock(batch->mutex);
+		if (!success)
+		{
+			break;
+		}
+	}
+	DESTROY_IF(hasher);
+	free(buffer);
+	return success;
+}
+
+/**
+ * Measure files on the thread pool
+ */
+static job_requeue_t measure_job(meas_batch_t *batch)
+{
+	measure_files(batch);
+	return JOB_REQUEUE_NONE;
+}
+
+/**
+ * Measure the given files, using idle threads of the thread pool
+ */
+static bool measure(meas_file_t *files, int count, hash_algorithm_t alg)
+{
+	meas_batch_t *batch;
+	callback_job_t *job;
+	bool success;
+	int i, jobs;
+
+	INIT(batch,
+		.files = files,
+		.count = count,
+		.alg = alg,
+		.mutex = mutex_create(MUTEX_TYPE_DEFAULT),
+		.condvar = condvar_create(CONDVAR_TYPE_DEFAULT),
+		.refs = 1,
+	);
+
+	jobs = min(count - 1, (int)lib->processor->get_idle_threads(lib->processor));
+	for (i = 0; i < jobs; i++)
+	{
+		ref_get(&batch->refs);
+		job = callback_job_create((callback_job_cb_t)measure_job, batch,
+								  (callback_job_cleanup_t)batch_unref, NULL);
+		lib->processor->queue_job(lib->processor, (job_t*)job);
+	}
+
+	/* we measure files ourselves, but wait for other workers to complete
+	 * theirs. Jobs that start late don't find any files left. */
+	measure_files(batch);
+	batch->mutex->lock(batch->mutex);
+	while (batch->done < batch->next ||
+		  (!batch->failed && batch->next < batch->count))
+	{
+		batch->condvar->wait(batch->condvar, batch->mutex);
+	}
+	success = !batch->failed;
+	/* prevent late jobs from accessing the files */
+	batch->next = batch->count;
+	batch->mutex->unlock(batch->mutex);
+	batch_unref(batch);
+
+	if (!success)
+	{
+		DBG1(DBG_PTS, "  measuring %d files failed", count);
+	}
 
 	return success;
 }
@@ -288,12 +682,12 @@ pts_file_meas_t *pts_file_meas_create_from_path(u_int16_t request_id,
 	private_pts_file_meas_t *this;
 	hash_algorithm_t hash_alg;
 	hasher_t *hasher;
-	u_char hash[HASH_SIZE_SHA384];
+	meas_file_t *files = NULL;
 	chunk_t measurement;
-	char* filename;
+	int count = 0, size = 0, i;
 	bool success = TRUE;
 
-	/* Create a hasher and a hash measurement buffer */
+	/* check that the hasher is available */
 	hash_alg = pts_meas_algo_to_hash(alg);
 	hasher = lib->crypto->create_hasher(lib->crypto, hash_alg);
 	if (!hasher)
@@ -301,7 +695,8 @@ pts_file_meas_t *pts_file_meas_create_from_path(u_int16_t request_id,
 		DBG1(DBG_PTS, "hasher %N not available", hash_algorithm_names, hash_alg);
 		return NULL;
 	}
-	measurement = chunk_create(hash, hasher->get_hash_size(hasher));
+	measurement.len = hasher->get_hash_size(hasher);
+	hasher->destroy(hasher);
 
 	INIT(this,
 		.public = {
@@ -336,32 +731,46 @@ pts_file_meas_t *pts_file_meas_create_from_path(u_int16_t request_id,
 			/* measure regular files only */
 			if (S_ISREG(st.st_mode) && *rel_name != '.')
 			{
-				if (!hash_file(hasher, abs_name, hash))
+				if (count == size)
 				{
-					success = FALSE;
-					break;
+					size = max(2 * size, 16);
+					files = realloc(files, size * sizeof(meas_file_t));
 				}
-				filename = use_rel_name ? rel_name : abs_name;
-				DBG2(DBG_PTS, "  %#B for '%s'", &measurement, filename);
-				add(this, filename, measurement);
+				files[count].pathname = strdup(abs_name);
+				files[count].filename = strdup(use_rel_name ? rel_name
+															: abs_name);
+				count++;
 			}
 		}
 		enumerator->destroy(enumerator);
 	}
 	else
 	{
-		if (!hash_file(hasher, pathname, hash))
+		files = malloc(sizeof(meas_file_t));
+		files[0].pathname = strdup(pathname);
+		files[0].filename = strdup(use_rel_name ? basename(pathname)
+												: pathname);
+		count = 1;
+	}
+
+	if (count)
+	{
+		success = measure(files, count, hash_alg);
+	}
+	for (i = 0; i < count; i++)
+	{
+		if (success)
 		{
-			success = FALSE;
-			goto end;
+			measurement.ptr = files[i].hash;
+			DBG2(DBG_PTS, "  %#B for '%s'", &measurement, files[i].filename);
+			add(this, files[i].filename, measurement);
 		}
-		filename = use_rel_name ? basename(pathname) : pathname;
-		DBG2(DBG_PTS, "  %#B for '%s'", &measurement, filename);
-		add(this, filename, measurement);
+		free(files[i].filename);
+		free(files[i].pathname);
 	}
+	free(files);
 
 end:
-	hasher->destroy(hasher);
 	if (success)
 	{
 		return &this->public;
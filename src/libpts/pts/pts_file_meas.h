@@ -98,6 +98,9 @@ pts_file_meas_t* pts_file_meas_create(u_int16_t request_id);
 /**
  * Creates a pts_file_meas_t object measuring a file/directory
  *
+ * The files of a directory are hashed in parallel, using idle threads of
+ * the processor's thread pool.
+ *
  * @param request_id		ID of PTS File Measurement Request
  * @param pathname			Absolute file or directory pathname
  * @param is_dir			TRUE if directory path
@@ -108,4 +111,18 @@ pts_file_meas_t* pts_file_meas_create_from_path(u_int16_t request_id,
 							char* pathname, bool is_dir, bool use_rel_name,
 							pts_meas_algorithms_t alg);
 
+/**
+ * Enable the file measurement cache, if configured.
+ *
+ * Cached measurements are keyed by device, inode, size, modification and
+ * status change time, so unchanged files are not read again. If the configured maximum
+ * number of entries is reached, the oldest entry gets evicted.
+ */
+void pts_file_meas_cache_init(void);
+
+/**
+ * Flush and disable the file measurement cache.
+ */
+void pts_file_meas_cache_deinit(void);
+
 #endif /** PTS_FILE_MEAS_H_ @}*/
@@ -0,0 +1,464 @@
+/*
+ * Copyright (C) 2013 Hochschule fuer Technik Rapperswil
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.  See <http://www.fsf.org/copyleft/gpl.txt>.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+
+#include "array.h"
+
+#include <library.h>
+
+/**
+ * Size of the inline storage in an array object, in bytes
+ */
+#define ARRAY_INLINE_SIZE 32
+
+/**
+ * Minimum number of elements to grow an array by
+ */
+#define ARRAY_MIN_GROW 4
+
+/**
+ * Data is an allocated block, with potentially unused head and tail:
+ *
+ *   "esize" each (or sizeof(void*) if esize = 0)
+ *  /-\ /-\ /-\ /-\ /-\ /-\
+ *
+ * +---------------+-------------------------------+---------------+
+ * | h | e | a | d | e | l | e | m | e | n | t | s | t | a | i | l |
+ * +---------------+-------------------------------+---------------+
+ *
+ * \--------------/ \-----------------------------/ \-------------/
+ *      unused                    used                   unused
+ *      "head"                   "count"                 "tail"
+ *
+ * Small arrays use the inline storage of the array object, larger ones a
+ * separately allocated block.
+ */
+struct array_t {
+	/** number of elements currently in array (not counting head/tail) */
+	u_int32_t count;
+	/** size of each element, 0 for a pointer based array */
+	u_int16_t esize;
+	/** allocated but unused elements at array front */
+	u_int32_t head;
+	/** allocated but unused elements at array end */
+	u_int32_t tail;
+	/** array elements, points to storage for small arrays */
+	void *data;
+	/** inline storage for small arrays */
+	u_int64_t storage[ARRAY_INLINE_SIZE / sizeof(u_int64_t)];
+};
+
+/**
+ * Get the actual size of a number of elements
+ */
+static size_t get_size(array_t *array, u_int32_t num)
+{
+	if (array->esize)
+	{
+		return array->esize * num;
+	}
+	return sizeof(void*) * num;
+}
+
+/**
+ * Get a pointer to an element, idx must be valid
+ */
+static inline void *get_elem(array_t *array, u_int32_t idx)
+{
+	return array->data + get_size(array, array->head + idx);
+}
+
+/**
+ * Get the value passed to callbacks/comparators for an element
+ */
+static inline void *get_value(array_t *array, void *elem)
+{
+	if (array->esize)
+	{
+		return elem;
+	}
+	return *(void**)elem;
+}
+
+/**
+ * Check if the array uses its inline storage
+ */
+static inline bool is_inline(array_t *array)
+{
+	return array->data == (void*)array->storage;
+}
+
+/**
+ * Relocate the used elements to a buffer with the given head/tail space.
+ * If the buffer fits into the inline storage, tail space is extended to
+ * fully use it.
+ */
+static void resize(array_t *array, u_int32_t head, u_int32_t tail)
+{
+	void *data, *old = array->data;
+	size_t size;
+
+	size = get_size(array, head + array->count + tail);
+	if (size <= sizeof(array->storage))
+	{
+		data = array->storage;
+		tail = (sizeof(array->storage) - get_size(array, head + array->count)) /
+				get_size(array, 1);
+	}
+	else if (is_inline(array))
+	{
+		data = malloc(size);
+	}
+	else if (head == array->head)
+	{	/* tail change only, realloc() can do the job */
+		array->data = realloc(array->data, size);
+		array->tail = tail;
+		return;
+	}
+	else
+	{
+		data = malloc(size);
+	}
+	if (data == old)
+	{
+		memmove(data + get_size(array, head), old + get_size(array, array->head),
+				get_size(array, array->count));
+	}
+	else
+	{
+		memcpy(data + get_size(array, head), old + get_size(array, array->head),
+			   get_size(array, array->count));
+		if (old != (void*)array->storage)
+		{
+			free(old);
+		}
+	}
+	array->data = data;
+	array->head = head;
+	array->tail = tail;
+}
+
+/**
+ * Number of elements to grow by, doubling the capacity
+ */
+static inline u_int32_t grow_by(array_t *array)
+{
+	return max(ARRAY_MIN_GROW, array->count);
+}
+
+array_t *array_create(u_int esize, u_int8_t reserve)
+{
+	array_t *array;
+
+	INIT(array,
+		.esize = esize,
+	);
+	array->data = array->storage;
+	array->tail = sizeof(array->storage) / get_size(array, 1);
+	if (reserve > array->tail)
+	{
+		resize(array, 0, reserve);
+	}
+	return array;
+}
+
+int array_count(array_t *array)
+{
+	if (array)
+	{
+		return array->count;
+	}
+	return 0;
+}
+
+void array_compress(array_t *array)
+{
+	if (array && (array->head || array->tail))
+	{
+		if (is_inline(array))
+		{
+			if (array->head)
+			{
+				resize(array, 0, 0);
+			}
+		}
+		else
+		{
+			resize(array, 0, 0);
+		}
+	}
+}
+
+/**
+ * Enumerator over an array
+ */
+typedef struct {
+	/** implements enumerator interface */
+	enumerator_t public;
+	/** enumerated array */
+	array_t *array;
+	/** index of the next element */
+	int idx;
+} array_enumerator_t;
+
+METHOD(enumerator_t, enumerate, bool,
+	array_enumerator_t *this, void **out)
+{
+	if (this->idx >= array_count(this->array))
+	{
+		return FALSE;
+	}
+	*out = get_value(this->array, get_elem(this->array, this->idx));
+	this->idx++;
+	return TRUE;
+}
+
+enumerator_t* array_create_enumerator(array_t *array)
+{
+	array_enumerator_t *enumerator;
+
+	if (!array)
+	{
+		return enumerator_create_empty();
+	}
+
+	INIT(enumerator,
+		.public = {
+			.enumerate = (void*)_enumerate,
+			.destroy = (void*)free,
+		},
+		.array = array,
+	);
+	return &enumerator->public;
+}
+
+void array_remove_at(array_t *array, enumerator_t *public)
+{
+	array_enumerator_t *enumerator = (array_enumerator_t*)public;
+
+	if (enumerator->idx)
+	{
+		array_remove(array, --enumerator->idx, NULL);
+	}
+}
+
+void array_insert(array_t *array, int idx, void *data)
+{
+	void *elem;
+
+	if (idx < 0 || idx > array->count)
+	{
+		idx = array->count;
+	}
+	if (idx == 0 && array->count)
+	{	/* prepend using head space */
+		if (!array->head)
+		{
+			resize(array, grow_by(array), array->tail);
+		}
+		array->head--;
+	}
+	else
+	{
+		if (!array->tail)
+		{
+			resize(array, array->head, grow_by(array));
+		}
+		elem = get_elem(array, idx);
+		memmove(elem + get_size(array, 1), elem,
+				get_size(array, array->count - idx));
+		array->tail--;
+	}
+	array->count++;
+
+	elem = get_elem(array, idx);
+	if (array->esize)
+	{
+		memcpy(elem, data, array->esize);
+	}
+	else
+	{
+		*(void**)elem = data;
+	}
+}
+
+void array_insert_create(array_t **array, int idx, void *ptr)
+{
+	if (*array == NULL)
+	{
+		*array = array_create(0, 0);
+	}
+	array_insert(*array, idx, ptr);
+}
+
+int array_insert_sorted(array_t *array, void *data, array_cmp_t cmp)
+{
+	int low = 0, high = array->count, mid;
+
+	while (low < high)
+	{
+		mid = low + (high - low) / 2;
+		if (cmp(data, get_value(array, get_elem(array, mid))) < 0)
+		{
+			high = mid;
+		}
+		else
+		{
+			low = mid + 1;
+		}
+	}
+	array_insert(array, low, data);
+	return low;
+}
+
+bool array_get(array_t *array, int idx, void *data)
+{
+	if (!array)
+	{
+		return FALSE;
+	}
+	if (idx >= 0 && idx >= array->count)
+	{
+		return FALSE;
+	}
+	if (idx < 0)
+	{
+		if (array->count == 0)
+		{
+			return FALSE;
+		}
+		idx = array->count - 1;
+	}
+	if (data)
+	{
+		memcpy(data, get_elem(array, idx), get_size(array, 1));
+	}
+	return TRUE;
+}
+
+bool array_remove(array_t *array, int idx, void *data)
+{
+	void *elem;
+
+	if (!array_get(array, idx, data))
+	{
+		return FALSE;
+	}
+	if (idx < 0)
+	{
+		idx = array->count - 1;
+	}
+	if (idx == 0)
+	{
+		array->head++;
+	}
+	else
+	{
+		elem = get_elem(array, idx);
+		memmove(elem, elem + get_size(array, 1),
+				get_size(array, array->count - 1 - idx));
+		array->tail++;
+	}
+	array->count--;
+	if (!array->count && array->head)
+	{	/* reuse head space for appending */
+		array->tail += array->head;
+		array->head = 0;
+	}
+	return TRUE;
+}
+
+int array_bsearch(array_t *array, const void *key, array_cmp_t cmp,
+				  void *data)
+{
+	int low = 0, high = array_count(array) - 1, mid, res;
+	void *elem;
+
+	while (low <= high)
+	{
+		mid = low + (high - low) / 2;
+		elem = get_elem(array, mid);
+		res = cmp(key, get_value(array, elem));
+		if (res == 0)
+		{
+			if (data)
+			{
+				memcpy(data, elem, get_size(array, 1));
+			}
+			return mid;
+		}
+		if (res < 0)
+		{
+			high = mid - 1;
+		}
+		else
+		{
+			low = mid + 1;
+		}
+	}
+	return -1;
+}
+
+void array_invoke(array_t *array, array_callback_t cb, void *user)
+{
+	if (array)
+	{
+		int i;
+
+		for (i = 0; i < array->count; i++)
+		{
+			cb(get_value(array, get_elem(array, i)), i, user);
+		}
+	}
+}
+
+void array_invoke_offset(array_t *array, size_t offset)
+{
+	if (array)
+	{
+		void (*method)(void *data);
+		void *obj;
+		int i;
+
+		for (i = 0; i < array->count; i++)
+		{
+			obj = get_value(array, get_elem(array, i));
+			method = *(void**)(obj + offset);
+			method(obj);
+		}
+	}
+}
+
+void array_destroy(array_t *array)
+{
+	if (array)
+	{
+		if (!is_inline(array))
+		{
+			free(array->data);
+		}
+		free(array);
+	}
+}
+
+void array_destroy_function(array_t *array, array_callback_t cb, void *user)
+{
+	array_invoke(array, cb, user);
+	array_destroy(array);
+}
+
+void array_destroy_offset(array_t *array, size_t offset)
+{
+	array_invoke_offset(array, offset);
+	array_destroy(array);
+}
@@ -20,6 +20,8 @@
 
 #include "linked_list.h"
 
+#include <utils/slab.h>
+
 typedef struct element_t element_t;
 
 /**
@@ -47,13 +49,18 @@ struct element_t {
 	element_t *next;
 };
 
+/**
+ * Slab for list elements
+ */
+SLAB_DEFINE(element_slab, element_t);
+
 /**
  * Creates an empty linked list object.
  */
 element_t *element_create(void *value)
 {
 	element_t *this;
-	INIT(this,
+	SLAB_INIT(&element_slab, this,
 		.value = value,
 	);
 	return this;
@@ -90,6 +97,11 @@ struct private_linked_list_t {
 	element_t *last;
 };
 
+/**
+ * Slab for lists
+ */
+SLAB_DEFINE(list_slab, private_linked_list_t);
+
 typedef struct private_enumerator_t private_enumerator_t;
 
 /**
@@ -118,6 +130,11 @@ struct private_enumerator_t {
 	bool finished;
 };
 
+/**
+ * Slab for list enumerators
+ */
+SLAB_DEFINE(enumerator_slab, private_enumerator_t);
+
 METHOD(enumerator_t, enumerate, bool,
 	private_enumerator_t *this, void **item)
 {
@@ -142,15 +159,21 @@ METHOD(enumerator_t, enumerate, bool,
 	return TRUE;
 }
 
+METHOD(enumerator_t, enumerator_destroy, void,
+	private_enumerator_t *this)
+{
+	slab_free(&enumerator_slab, this);
+}
+
 METHOD(linked_list_t, create_enumerator, enumerator_t*,
 	private_linked_list_t *this)
 {
 	private_enumerator_t *enumerator;
 
-	INIT(enumerator,
+	SLAB_INIT(&enumerator_slab, enumerator,
 		.enumerator = {
 			.enumerate = (void*)_enumerate,
-			.destroy = (void*)free,
+			.destroy = _enumerator_destroy,
 		},
 		.list = this,
 	);
@@ -212,7 +235,7 @@ static element_t* remove_element(private_linked_list_t *this,
 
 	next = element->next;
 	previous = element->previous;
-	free(element);
+	slab_free(&element_slab, element);
 	if (next)
 	{
 		next->previous = previous;
@@ -502,7 +525,7 @@ METHOD(linked_list_t, destroy, void,
 		/* values are not destroyed so memory leaks are possible
 		 * if list is not empty when deleting */
 	}
-	free(this);
+	slab_free(&list_slab, this);
 }
 
 METHOD(linked_list_t, destroy_offset, void,
@@ -515,10 +538,10 @@ METHOD(linked_list_t, destroy_offset, void,
 		void (**method)(void*) = current->value + offset;
 		(*method)(current->value);
 		next = current->next;
-		free(current);
+		slab_free(&element_slab, current);
 		current = next;
 	}
-	free(this);
+	slab_free(&list_slab, this);
 }
 
 METHOD(linked_list_t, destroy_function, void,
@@ -530,10 +553,10 @@ METHOD(linked_list_t, destroy_function, void,
 	{
 		fn(current->value);
 		next = current->next;
-		free(current);
+		slab_free(&element_slab, current);
 		current = next;
 	}
-	free(this);
+	slab_free(&list_slab, this);
 }
 
 /*
@@ -543,7 +566,7 @@ linked_list_t *linked_list_create()
 {
 	private_linked_list_t *this;
 
-	INIT(this,
+	SLAB_INIT(&list_slab, this,
 		.public = {
 			.get_count = _get_count,
 			.create_enumerator = _create_enumerator,
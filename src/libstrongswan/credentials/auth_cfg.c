@@ -18,7 +18,7 @@
 
 #include <library.h>
 #include <utils/debug.h>
-#include <collections/linked_list.h>
+#include <collections/array.h>
 #include <utils/identification.h>
 #include <eap/eap.h>
 #include <credentials/certificates/certificate.h>
@@ -109,9 +109,9 @@ struct private_auth_cfg_t {
 	auth_cfg_t public;
 
 	/**
-	 * list of entry_t
+	 * array of entry_t, stored by value
 	 */
-	linked_list_t *entries;
+	array_t *entries;
 };
 
 typedef struct entry_t entry_t;
@@ -129,7 +129,7 @@ struct entry_t {
 typedef struct {
 	/** implements enumerator_t */
 	enumerator_t public;
-	/** inner enumerator from linked_list_t */
+	/** inner enumerator from array_t */
 	enumerator_t *inner;
 	/** current entry */
 	entry_t *current;
@@ -184,18 +184,16 @@ METHOD(auth_cfg_t, create_enumerator, enumerator_t*,
 			.enumerate = (void*)enumerate,
 			.destroy = (void*)entry_enumerator_destroy,
 		},
-		.inner = this->entries->create_enumerator(this->entries),
+		.inner = array_create_enumerator(this->entries),
 	);
 	return &enumerator->public;
 }
 
 /**
- * Create an entry from the given arguments.
+ * Initialize an entry from the given arguments.
  */
-static entry_t *entry_create(auth_rule_t type, va_list args)
+static void init_entry(entry_t *this, auth_rule_t type, va_list args)
 {
-	entry_t *this = malloc_thing(entry_t);
-
 	this->type = type;
 	switch (type)
 	{
@@ -233,7 +231,6 @@ static entry_t *entry_create(auth_rule_t type, va_list args)
 			this->value = NULL;
 			break;
 	}
-	return this;
 }
 
 /**
@@ -363,43 +360,7 @@ static void replace(private_auth_cfg_t *this, entry_enumerator_t *enumerator,
 		va_start(args, type);
 		entry = enumerator->current;
 		destroy_entry_value(entry);
-		entry->type = type;
-		switch (type)
-		{
-			case AUTH_RULE_IDENTITY_LOOSE:
-			case AUTH_RULE_AUTH_CLASS:
-			case AUTH_RULE_EAP_TYPE:
-			case AUTH_RULE_EAP_VENDOR:
-			case AUTH_RULE_CRL_VALIDATION:
-			case AUTH_RULE_OCSP_VALIDATION:
-			case AUTH_RULE_RSA_STRENGTH:
-			case AUTH_RULE_ECDSA_STRENGTH:
-			case AUTH_RULE_SIGNATURE_SCHEME:
-				/* integer type */
-				entry->value = (void*)(uintptr_t)va_arg(args, u_int);
-				break;
-			case AUTH_RULE_IDENTITY:
-			case AUTH_RULE_EAP_IDENTITY:
-			case AUTH_RULE_AAA_IDENTITY:
-			case AUTH_RULE_XAUTH_BACKEND:
-			case AUTH_RULE_XAUTH_IDENTITY:
-			case AUTH_RULE_GROUP:
-			case AUTH_RULE_CA_CERT:
-			case AUTH_RULE_IM_CERT:
-			case AUTH_RULE_SUBJECT_CERT:
-			case AUTH_RULE_CERT_POLICY:
-			case AUTH_HELPER_IM_CERT:
-			case AUTH_HELPER_SUBJECT_CERT:
-			case AUTH_HELPER_IM_HASH_URL:
-			case AUTH_HELPER_SUBJECT_HASH_URL:
-			case AUTH_HELPER_REVOCATION_CERT:
-				/* pointer type */
-				entry->value = va_arg(args, void*);
-				break;
-			case AUTH_RULE_MAX:
-				entry->value = NULL;
-				break;
-		}
+		init_entry(entry, type, args);
 		va_end(args);
 	}
 }
@@ -407,32 +368,31 @@ static void replace(private_auth_cfg_t *this, entry_enumerator_t *enumerator,
 METHOD(auth_cfg_t, get, void*,
 	private_auth_cfg_t *this, auth_rule_t type)
 {
-	enumerator_t *enumerator;
-	void *current_value, *best_value = NULL;
-	auth_rule_t current_type;
+	void *best_value = NULL;
 	bool found = FALSE;
+	entry_t entry;
+	int i;
 
-	enumerator = create_enumerator(this);
-	while (enumerator->enumerate(enumerator, &current_type, &current_value))
+	/* iterate the array directly, as this is called very often */
+	array_foreach(this->entries, i, &entry)
 	{
-		if (type == current_type)
+		if (type == entry.type)
 		{
 			if (type == AUTH_RULE_CRL_VALIDATION ||
 				type == AUTH_RULE_OCSP_VALIDATION)
 			{	/* for CRL/OCSP validation, always get() the highest value */
-				if (!found || current_value > best_value)
+				if (!found || entry.value > best_value)
 				{
-					best_value = current_value;
+					best_value = entry.value;
 				}
 				found = TRUE;
 				continue;
 			}
-			best_value = current_value;
+			best_value = entry.value;
 			found = TRUE;
 			break;
 		}
 	}
-	enumerator->destroy(enumerator);
 	if (found)
 	{
 		return best_value;
@@ -481,21 +441,21 @@ METHOD(auth_cfg_t, get, void*,
  */
 static void add(private_auth_cfg_t *this, auth_rule_t type, ...)
 {
-	entry_t *entry;
+	entry_t entry;
 	va_list args;
 
 	va_start(args, type);
-	entry = entry_create(type, args);
+	init_entry(&entry, type, args);
 	va_end(args);
 
 	if (is_multi_value_rule(type))
 	{	/* insert rules that may occur multiple times at the end */
-		this->entries->insert_last(this->entries, entry);
+		array_insert(this->entries, ARRAY_TAIL, &entry);
 	}
 	else
 	{	/* insert rules we expect only once at the front (get() will return
 		 * the latest value) */
-		this->entries->insert_first(this->entries, entry);
+		array_insert(this->entries, ARRAY_HEAD, &entry);
 	}
 }
 
@@ -917,12 +877,11 @@ static void merge(private_auth_cfg_t *this, private_auth_cfg_t *other, bool copy
 	}
 	else
 	{
-		entry_t *entry;
+		entry_t entry;
 
-		while (other->entries->remove_first(other->entries,
-											(void**)&entry) == SUCCESS)
+		while (array_remove(other->entries, ARRAY_HEAD, &entry))
 		{
-			this->entries->insert_last(this->entries, entry);
+			array_insert(this->entries, ARRAY_TAIL, &entry);
 		}
 	}
 }
@@ -938,12 +897,12 @@ static bool auth_cfg_equals(private_auth_cfg_t *this, private_auth_cfg_t *other)
 
 	/* the rule count does not have to be equal for the two, as we only compare
 	 * the first value found for some rules */
-	e1 = this->entries->create_enumerator(this->entries);
+	e1 = array_create_enumerator(this->entries);
 	while (e1->enumerate(e1, &i1))
 	{
 		found = FALSE;
 
-		e2 = other->entries->create_enumerator(other->entries);
+		e2 = array_create_enumerator(other->entries);
 		while (e2->enumerate(e2, &i2))
 		{
 			if (entry_equals(i1, i2))
@@ -984,27 +943,20 @@ static bool equals(private_auth_cfg_t *this, private_auth_cfg_t *other)
 METHOD(auth_cfg_t, purge, void,
 	private_auth_cfg_t *this, bool keep_ca)
 {
+	enumerator_t *enumerator;
 	entry_t *entry;
-	linked_list_t *cas;
 
-	cas = linked_list_create();
-	while (this->entries->remove_last(this->entries, (void**)&entry) == SUCCESS)
+	enumerator = array_create_enumerator(this->entries);
+	while (enumerator->enumerate(enumerator, &entry))
 	{
-		if (keep_ca && entry->type == AUTH_RULE_CA_CERT)
-		{
-			cas->insert_first(cas, entry);
-		}
-		else
+		if (!keep_ca || entry->type != AUTH_RULE_CA_CERT)
 		{
 			destroy_entry_value(entry);
-			free(entry);
+			array_remove_at(this->entries, enumerator);
 		}
 	}
-	while (cas->remove_last(cas, (void**)&entry) == SUCCESS)
-	{
-		this->entries->insert_first(this->entries, entry);
-	}
-	cas->destroy(cas);
+	enumerator->destroy(enumerator);
+	array_compress(this->entries);
 }
 
 METHOD(auth_cfg_t, clone_, auth_cfg_t*,
@@ -1074,7 +1026,7 @@ METHOD(auth_cfg_t, destroy, void,
 	private_auth_cfg_t *this)
 {
 	purge(this, FALSE);
-	this->entries->destroy(this->entries);
+	array_destroy(this->entries);
 	free(this);
 }
 
@@ -1098,7 +1050,7 @@ auth_cfg_t *auth_cfg_create()
 			.clone = _clone_,
 			.destroy = _destroy,
 		},
-		.entries = linked_list_create(),
+		.entries = array_create(sizeof(entry_t), 0),
 	);
 
 	return &this->public;
@@ -153,6 +153,10 @@ enum builder_part_t {
 	BUILD_SHARES,
 	/** minimum number of participating private key shares */
 	BUILD_THRESHOLD,
+	/** raw Ed25519 public key, chunk_t */
+	BUILD_EDDSA_PUB,
+	/** raw Ed25519 private key (seed), chunk_t */
+	BUILD_EDDSA_PRIV,
 	/** end of variable argument builder list */
 	BUILD_END,
 };
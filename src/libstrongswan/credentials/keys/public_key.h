@@ -42,6 +42,8 @@ enum key_type_t {
 	KEY_ECDSA = 2,
 	/** DSA */
 	KEY_DSA   = 3,
+	/** Ed25519 PureEdDSA as in RFC 8032 */
+	KEY_ED25519 = 4,
 	/** ElGamal, ... */
 };
 
@@ -90,6 +92,8 @@ enum signature_scheme_t {
 	SIGN_ECDSA_384,
 	/** ECDSA on the P-521 curve with SHA-512 as in RFC 4754           */
 	SIGN_ECDSA_521,
+	/** PureEdDSA on Curve25519 as in RFC 8032                         */
+	SIGN_ED25519,
 };
 
 /**
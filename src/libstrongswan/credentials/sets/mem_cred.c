@@ -19,8 +19,12 @@
 
 #include <threading/rwlock.h>
 #include <collections/linked_list.h>
+#include <collections/hashtable.h>
+#include <collections/array.h>
+#include <credentials/certificates/x509.h>
 
 typedef struct private_mem_cred_t private_mem_cred_t;
+typedef struct cred_index_t cred_index_t;
 
 /**
  * Private data of an mem_cred_t object.
@@ -61,8 +65,452 @@ struct private_mem_cred_t {
 	 * List of CDPs, as cdp_t
 	 */
 	linked_list_t *cdps;
+
+	/**
+	 * Index over trusted certificates
+	 */
+	cred_index_t *trusted_index;
+
+	/**
+	 * Index over trusted and untrusted certificates
+	 */
+	cred_index_t *untrusted_index;
+
+	/**
+	 * Index over private keys
+	 */
+	cred_index_t *keys_index;
+
+	/**
+	 * Index over shared keys
+	 */
+	cred_index_t *shared_index;
+};
+
+/**
+ * Credential stored in an index
+ */
+typedef struct {
+	/** indexed credential */
+	void *cred;
+	/** position of the credential in its list, higher values come first */
+	int pos;
+} indexed_t;
+
+/**
+ * Credentials sharing an identity or key identifier
+ */
+typedef struct {
+	/** identity, if indexed by identity */
+	identification_t *id;
+	/** key identifier, if indexed by key identifier */
+	chunk_t keyid;
+	/** credentials, as indexed_t sorted by position */
+	array_t *creds;
+} bucket_t;
+
+/**
+ * Index over the credentials stored in a list.
+ *
+ * Credentials get indexed by identities and key identifiers they match
+ * exactly. Credentials that might match other identities (e.g. by wildcards)
+ * are stored in a separate array and are always considered.
+ */
+struct cred_index_t {
+	/** identification_t => bucket_t */
+	hashtable_t *ids;
+	/** key identifier, chunk_t => bucket_t */
+	hashtable_t *keyids;
+	/** credentials not indexed by identity, as indexed_t sorted by position */
+	array_t *others;
+	/** position of the first credential in the list */
+	int first;
+	/** position of the last credential in the list */
+	int last;
 };
 
+/**
+ * Hash an identity
+ */
+static u_int id_hash(identification_t *id)
+{
+	return id->hash(id, 0);
+}
+
+/**
+ * Compare two identities for equality
+ */
+static bool id_equals(identification_t *a, identification_t *b)
+{
+	return a->equals(a, b);
+}
+
+/**
+ * Hash a key identifier
+ */
+static u_int keyid_hash(chunk_t *keyid)
+{
+	return chunk_hash(*keyid);
+}
+
+/**
+ * Sort indexed credentials by position, in descending order
+ */
+static int indexed_cmp(const void *a, const void *b)
+{
+	const indexed_t *ia = a, *ib = b;
+
+	return ib->pos - ia->pos;
+}
+
+/**
+ * Create an empty index
+ */
+static cred_index_t *index_create()
+{
+	cred_index_t *index;
+
+	INIT(index,
+		.ids = hashtable_create((hashtable_hash_t)id_hash,
+								(hashtable_equals_t)id_equals, 32),
+		.keyids = hashtable_create((hashtable_hash_t)keyid_hash,
+								   (hashtable_equals_t)chunk_equals_ptr, 32),
+		.others = array_create(sizeof(indexed_t), 0),
+	);
+	return index;
+}
+
+/**
+ * Destroy a bucket
+ */
+static void bucket_destroy(bucket_t *bucket)
+{
+	DESTROY_IF(bucket->id);
+	chunk_free(&bucket->keyid);
+	array_destroy(bucket->creds);
+	free(bucket);
+}
+
+/**
+ * Destroy all buckets of a hashtable and the hashtable
+ */
+static void buckets_destroy(hashtable_t *table)
+{
+	enumerator_t *enumerator;
+	bucket_t *bucket;
+	void *key;
+
+	enumerator = table->create_enumerator(table);
+	while (enumerator->enumerate(enumerator, &key, &bucket))
+	{
+		bucket_destroy(bucket);
+	}
+	enumerator->destroy(enumerator);
+	table->destroy(table);
+}
+
+/**
+ * Destroy an index, but not the indexed credentials
+ */
+static void index_destroy(cred_index_t *index)
+{
+	buckets_destroy(index->ids);
+	buckets_destroy(index->keyids);
+	array_destroy(index->others);
+	free(index);
+}
+
+/**
+ * Get the position for a credential inserted at the start or end of a list
+ */
+static int index_pos(cred_index_t *index, bool first)
+{
+	if (first)
+	{
+		return ++index->first;
+	}
+	return index->last--;
+}
+
+/**
+ * Add a credential to an array of indexed credentials, or remove it
+ */
+static void indexed_update(array_t *creds, void *cred, int pos, bool add)
+{
+	enumerator_t *enumerator;
+	indexed_t *current, entry = {
+		.cred = cred,
+		.pos = pos,
+	};
+
+	if (add)
+	{
+		array_insert_sorted(creds, &entry, indexed_cmp);
+		return;
+	}
+	enumerator = array_create_enumerator(creds);
+	while (enumerator->enumerate(enumerator, &current))
+	{
+		if (current->cred == cred)
+		{
+			array_remove_at(creds, enumerator);
+		}
+	}
+	enumerator->destroy(enumerator);
+}
+
+/**
+ * Add a credential to (or remove it from) a bucket of a hashtable
+ */
+static void bucket_update(hashtable_t *table, void *key, bucket_t *template,
+						  void *cred, int pos, bool add)
+{
+	bucket_t *bucket;
+
+	bucket = table->get(table, key);
+	if (!bucket)
+	{
+		if (!add)
+		{
+			return;
+		}
+		INIT(bucket,
+			.id = template->id ? template->id->clone(template->id) : NULL,
+			.keyid = chunk_clone(template->keyid),
+			.creds = array_create(sizeof(indexed_t), 0),
+		);
+		table->put(table, bucket->id ?: (void*)&bucket->keyid, bucket);
+	}
+	indexed_update(bucket->creds, cred, pos, add);
+	if (!array_count(bucket->creds))
+	{
+		table->remove(table, key);
+		bucket_destroy(bucket);
+	}
+}
+
+/**
+ * Index a credential by identity, or remove it
+ */
+static void index_id(cred_index_t *index, identification_t *id, void *cred,
+					 int pos, bool add)
+{
+	bucket_t template = {
+		.id = id,
+	};
+
+	bucket_update(index->ids, id, &template, cred, pos, add);
+}
+
+/**
+ * Index a credential by key identifier, or remove it
+ */
+static void index_keyid(cred_index_t *index, chunk_t keyid, void *cred,
+						int pos, bool add)
+{
+	bucket_t template = {
+		.keyid = keyid,
+	};
+
+	if (keyid.len)
+	{
+		bucket_update(index->keyids, &keyid, &template, cred, pos, add);
+	}
+}
+
+/**
+ * Add a credential to the non-indexed credentials, or remove it
+ */
+static void index_other(cred_index_t *index, void *cred, int pos, bool add)
+{
+	indexed_update(index->others, cred, pos, add);
+}
+
+/**
+ * Merge two sorted arrays of indexed credentials, destroys both arrays
+ */
+static array_t *indexed_merge(array_t *a, array_t *b)
+{
+	array_t *merged;
+	indexed_t ia, ib;
+	int i = 0, j = 0;
+
+	merged = array_create(sizeof(indexed_t), 0);
+	while (TRUE)
+	{
+		if (!array_get(a, i, &ia))
+		{
+			while (array_get(b, j++, &ib))
+			{
+				array_insert(merged, ARRAY_TAIL, &ib);
+			}
+			break;
+		}
+		if (!array_get(b, j, &ib) || ia.pos >= ib.pos)
+		{
+			array_insert(merged, ARRAY_TAIL, &ia);
+			i++;
+		}
+		else
+		{
+			array_insert(merged, ARRAY_TAIL, &ib);
+			j++;
+		}
+	}
+	array_destroy(a);
+	array_destroy(b);
+	return merged;
+}
+
+/**
+ * Copy an array of indexed credentials, or create an empty array
+ */
+static array_t *indexed_copy(array_t *creds)
+{
+	array_t *copy;
+	indexed_t entry;
+	int i;
+
+	copy = array_create(sizeof(indexed_t), 0);
+	array_foreach(creds, i, &entry)
+	{
+		array_insert(copy, ARRAY_TAIL, &entry);
+	}
+	return copy;
+}
+
+/**
+ * Get a copy of the credentials stored in a bucket of a hashtable
+ */
+static array_t *bucket_lookup(hashtable_t *table, void *key)
+{
+	bucket_t *bucket;
+
+	bucket = table->get(table, key);
+	return indexed_copy(bucket ? bucket->creds : NULL);
+}
+
+/**
+ * Collect the credentials potentially matching one of two identities or a
+ * key identifier, returns an array of credentials in list order.
+ */
+static array_t *index_lookup(cred_index_t *index, identification_t *id,
+							 identification_t *other, chunk_t keyid)
+{
+	array_t *found, *creds;
+	indexed_t entry;
+	int i, pos = 0;
+
+	found = indexed_copy(index->others);
+	if (id)
+	{
+		found = indexed_merge(found, bucket_lookup(index->ids, id));
+	}
+	if (other)
+	{
+		found = indexed_merge(found, bucket_lookup(index->ids, other));
+	}
+	if (keyid.len)
+	{
+		found = indexed_merge(found, bucket_lookup(index->keyids, &keyid));
+	}
+	creds = array_create(0, 0);
+	array_foreach(found, i, &entry)
+	{
+		/* credentials found multiple times have the same position */
+		if (i == 0 || entry.pos != pos)
+		{
+			array_insert(creds, ARRAY_TAIL, entry.cred);
+			pos = entry.pos;
+		}
+	}
+	array_destroy(found);
+	return creds;
+}
+
+/**
+ * Add a certificate to an index, or remove it
+ */
+static void index_cert(cred_index_t *index, certificate_t *cert, int pos,
+					   bool add)
+{
+	identification_t *id;
+	enumerator_t *enumerator;
+	public_key_t *public;
+	cred_encoding_type_t type;
+	hasher_t *hasher;
+	chunk_t chunk, hash;
+	x509_t *x509;
+
+	if (cert->get_type(cert) != CERT_X509)
+	{	/* other certificate types match subjects in various ways */
+		index_other(index, cert, pos, add);
+		return;
+	}
+	x509 = (x509_t*)cert;
+
+	index_id(index, cert->get_subject(cert), cert, pos, add);
+	enumerator = x509->create_subjectAltName_enumerator(x509);
+	while (enumerator->enumerate(enumerator, &id))
+	{
+		index_id(index, id, cert, pos, add);
+	}
+	enumerator->destroy(enumerator);
+
+	/* X.509 certificates match key identifiers in several ways */
+	index_keyid(index, x509->get_subjectKeyIdentifier(x509), cert, pos, add);
+	index_keyid(index, x509->get_serial(x509), cert, pos, add);
+	public = cert->get_public_key(cert);
+	if (public)
+	{
+		for (type = 0; type < KEYID_MAX; type++)
+		{
+			if (public->get_fingerprint(public, type, &chunk))
+			{
+				index_keyid(index, chunk, cert, pos, add);
+			}
+		}
+		public->destroy(public);
+	}
+	hasher = lib->crypto->create_hasher(lib->crypto, HASH_SHA1);
+	if (hasher)
+	{
+		if (cert->get_encoding(cert, CERT_ASN1_DER, &chunk))
+		{
+			if (hasher->allocate_hash(hasher, chunk, &hash))
+			{
+				index_keyid(index, hash, cert, pos, add);
+				free(hash.ptr);
+			}
+			free(chunk.ptr);
+		}
+		hasher->destroy(hasher);
+	}
+}
+
+/**
+ * Add a private key to an index
+ */
+static void index_key(cred_index_t *index, private_key_t *key, int pos)
+{
+	cred_encoding_type_t type;
+	chunk_t keyid;
+	bool indexed = FALSE;
+
+	for (type = 0; type < KEYID_MAX; type++)
+	{
+		if (key->get_fingerprint(key, type, &keyid))
+		{
+			index_keyid(index, keyid, key, pos, TRUE);
+			indexed = TRUE;
+		}
+	}
+	if (!indexed)
+	{
+		index_other(index, key, pos, TRUE);
+	}
+}
+
 /**
  * Data for the certificate enumerator
  */
@@ -71,6 +519,7 @@ typedef struct {
 	certificate_type_t cert;
 	key_type_t key;
 	identification_t *id;
+	array_t *candidates;
 } cert_data_t;
 
 /**
@@ -79,6 +528,7 @@ typedef struct {
 static void cert_data_destroy(cert_data_t *data)
 {
 	data->lock->unlock(data->lock);
+	array_destroy(data->candidates);
 	free(data);
 }
 
@@ -126,6 +576,8 @@ METHOD(credential_set_t, create_cert_enumerator, enumerator_t*,
 {
 	cert_data_t *data;
 	enumerator_t *enumerator;
+	linked_list_t *list;
+	cred_index_t *index;
 
 	INIT(data,
 		.lock = this->lock,
@@ -136,21 +588,27 @@ METHOD(credential_set_t, create_cert_enumerator, enumerator_t*,
 	this->lock->read_lock(this->lock);
 	if (trusted)
 	{
-		enumerator = this->trusted->create_enumerator(this->trusted);
+		list = this->trusted;
+		index = this->trusted_index;
+	}
+	else
+	{
+		list = this->untrusted;
+		index = this->untrusted_index;
+	}
+	if (id && !id->contains_wildcards(id))
+	{
+		data->candidates = index_lookup(index, id, NULL, id->get_encoding(id));
+		enumerator = array_create_enumerator(data->candidates);
 	}
 	else
 	{
-		enumerator = this->untrusted->create_enumerator(this->untrusted);
+		enumerator = list->create_enumerator(list);
 	}
 	return enumerator_create_filter(enumerator, (void*)certs_filter, data,
 									(void*)cert_data_destroy);
 }
 
-static bool certificate_equals(certificate_t *item, certificate_t *cert)
-{
-	return item->equals(item, cert);
-}
-
 /**
  * Add a certificate the the cache. Returns a reference to "cert" or a
  * previously cached certificate that equals "cert".
@@ -158,21 +616,38 @@ static bool certificate_equals(certificate_t *item, certificate_t *cert)
 static certificate_t *add_cert_internal(private_mem_cred_t *this, bool trusted,
 										certificate_t *cert)
 {
-	certificate_t *cached;
+	certificate_t *cached, *found = NULL;
+	array_t *candidates;
+	int i;
+
 	this->lock->write_lock(this->lock);
-	if (this->untrusted->find_first(this->untrusted,
-									(linked_list_match_t)certificate_equals,
-									(void**)&cached, cert) == SUCCESS)
+	/* equal certificates share the same subject */
+	candidates = index_lookup(this->untrusted_index, cert->get_subject(cert),
+							  NULL, chunk_empty);
+	array_foreach(candidates, i, &cached)
+	{
+		if (cached->equals(cached, cert))
+		{
+			found = cached;
+			break;
+		}
+	}
+	array_destroy(candidates);
+	if (found)
 	{
 		cert->destroy(cert);
-		cert = cached->get_ref(cached);
+		cert = found->get_ref(found);
 	}
 	else
 	{
 		if (trusted)
 		{
+			index_cert(this->trusted_index, cert,
+					   index_pos(this->trusted_index, TRUE), TRUE);
 			this->trusted->insert_first(this->trusted, cert->get_ref(cert));
 		}
+		index_cert(this->untrusted_index, cert,
+				   index_pos(this->untrusted_index, TRUE), TRUE);
 		this->untrusted->insert_first(this->untrusted, cert->get_ref(cert));
 	}
 	this->lock->unlock(this->lock);
@@ -232,6 +707,8 @@ METHOD(mem_cred_t, add_crl, bool,
 				if (new)
 				{
 					this->untrusted->remove_at(this->untrusted, enumerator);
+					index_cert(this->untrusted_index, current, 0, FALSE);
+					current->destroy(current);
 				}
 				else
 				{
@@ -245,6 +722,8 @@ METHOD(mem_cred_t, add_crl, bool,
 
 	if (new)
 	{
+		index_cert(this->untrusted_index, cert,
+				   index_pos(this->untrusted_index, TRUE), TRUE);
 		this->untrusted->insert_first(this->untrusted, cert);
 	}
 	this->lock->unlock(this->lock);
@@ -258,6 +737,7 @@ typedef struct {
 	rwlock_t *lock;
 	key_type_t type;
 	identification_t *id;
+	array_t *candidates;
 } key_data_t;
 
 /**
@@ -266,6 +746,7 @@ typedef struct {
 static void key_data_destroy(key_data_t *data)
 {
 	data->lock->unlock(data->lock);
+	array_destroy(data->candidates);
 	free(data);
 }
 
@@ -293,6 +774,7 @@ METHOD(credential_set_t, create_private_enumerator, enumerator_t*,
 	private_mem_cred_t *this, key_type_t type, identification_t *id)
 {
 	key_data_t *data;
+	enumerator_t *enumerator;
 
 	INIT(data,
 		.lock = this->lock,
@@ -300,14 +782,25 @@ METHOD(credential_set_t, create_private_enumerator, enumerator_t*,
 		.id = id,
 	);
 	this->lock->read_lock(this->lock);
-	return enumerator_create_filter(this->keys->create_enumerator(this->keys),
-							(void*)key_filter, data, (void*)key_data_destroy);
+	if (id)
+	{
+		data->candidates = index_lookup(this->keys_index, NULL, NULL,
+										id->get_encoding(id));
+		enumerator = array_create_enumerator(data->candidates);
+	}
+	else
+	{
+		enumerator = this->keys->create_enumerator(this->keys);
+	}
+	return enumerator_create_filter(enumerator, (void*)key_filter, data,
+									(void*)key_data_destroy);
 }
 
 METHOD(mem_cred_t, add_key, void,
 	private_mem_cred_t *this, private_key_t *key)
 {
 	this->lock->write_lock(this->lock);
+	index_key(this->keys_index, key, index_pos(this->keys_index, TRUE));
 	this->keys->insert_first(this->keys, key);
 	this->lock->unlock(this->lock);
 }
@@ -333,6 +826,34 @@ static void shared_entry_destroy(shared_entry_t *entry)
 	free(entry);
 }
 
+/**
+ * Add a shared key entry to an index
+ */
+static void index_shared(cred_index_t *index, shared_entry_t *entry, int pos)
+{
+	enumerator_t *enumerator;
+	identification_t *id;
+	bool wildcards = FALSE;
+
+	enumerator = entry->owners->create_enumerator(entry->owners);
+	while (enumerator->enumerate(enumerator, &id))
+	{
+		if (id->contains_wildcards(id))
+		{
+			wildcards = TRUE;
+		}
+		else
+		{
+			index_id(index, id, entry, pos, TRUE);
+		}
+	}
+	enumerator->destroy(enumerator);
+	if (wildcards)
+	{
+		index_other(index, entry, pos, TRUE);
+	}
+}
+
 /**
  * Data for the shared_key enumerator
  */
@@ -341,6 +862,7 @@ typedef struct {
 	identification_t *me;
 	identification_t *other;
 	shared_key_type_t type;
+	array_t *candidates;
 } shared_data_t;
 
 /**
@@ -349,6 +871,7 @@ typedef struct {
 static void shared_data_destroy(shared_data_t *data)
 {
 	data->lock->unlock(data->lock);
+	array_destroy(data->candidates);
 	free(data);
 }
 
@@ -419,6 +942,7 @@ METHOD(credential_set_t, create_shared_enumerator, enumerator_t*,
 	identification_t *me, identification_t *other)
 {
 	shared_data_t *data;
+	enumerator_t *enumerator;
 
 	INIT(data,
 		.lock = this->lock,
@@ -427,9 +951,19 @@ METHOD(credential_set_t, create_shared_enumerator, enumerator_t*,
 		.type = type,
 	);
 	data->lock->read_lock(data->lock);
-	return enumerator_create_filter(
-						this->shared->create_enumerator(this->shared),
-						(void*)shared_filter, data, (void*)shared_data_destroy);
+	if ((me || other) && !(me && me->contains_wildcards(me)) &&
+		!(other && other->contains_wildcards(other)))
+	{
+		data->candidates = index_lookup(this->shared_index, me, other,
+										chunk_empty);
+		enumerator = array_create_enumerator(data->candidates);
+	}
+	else
+	{
+		enumerator = this->shared->create_enumerator(this->shared);
+	}
+	return enumerator_create_filter(enumerator, (void*)shared_filter, data,
+									(void*)shared_data_destroy);
 }
 
 METHOD(mem_cred_t, add_shared_list, void,
@@ -443,6 +977,8 @@ METHOD(mem_cred_t, add_shared_list, void,
 	);
 
 	this->lock->write_lock(this->lock);
+	index_shared(this->shared_index, entry,
+				 index_pos(this->shared_index, TRUE));
 	this->shared->insert_first(this->shared, entry);
 	this->lock->unlock(this->lock);
 }
@@ -561,6 +1097,10 @@ static void reset_secrets(private_mem_cred_t *this)
 	this->shared->destroy_function(this->shared, (void*)shared_entry_destroy);
 	this->keys = linked_list_create();
 	this->shared = linked_list_create();
+	index_destroy(this->keys_index);
+	index_destroy(this->shared_index);
+	this->keys_index = index_create();
+	this->shared_index = index_create();
 }
 
 METHOD(mem_cred_t, replace_secrets, void,
@@ -580,6 +1120,8 @@ METHOD(mem_cred_t, replace_secrets, void,
 		enumerator = other->keys->create_enumerator(other->keys);
 		while (enumerator->enumerate(enumerator, &key))
 		{
+			index_key(this->keys_index, key,
+					  index_pos(this->keys_index, FALSE));
 			this->keys->insert_last(this->keys, key->get_ref(key));
 		}
 		enumerator->destroy(enumerator);
@@ -591,6 +1133,8 @@ METHOD(mem_cred_t, replace_secrets, void,
 				.owners = entry->owners->clone_offset(entry->owners,
 											offsetof(identification_t, clone)),
 			);
+			index_shared(this->shared_index, new_entry,
+						 index_pos(this->shared_index, FALSE));
 			this->shared->insert_last(this->shared, new_entry);
 		}
 		enumerator->destroy(enumerator);
@@ -599,13 +1143,19 @@ METHOD(mem_cred_t, replace_secrets, void,
 	{
 		while (other->keys->remove_first(other->keys, (void**)&key) == SUCCESS)
 		{
+			index_key(this->keys_index, key,
+					  index_pos(this->keys_index, FALSE));
 			this->keys->insert_last(this->keys, key);
 		}
 		while (other->shared->remove_first(other->shared,
 										  (void**)&entry) == SUCCESS)
 		{
+			index_shared(this->shared_index, entry,
+						 index_pos(this->shared_index, FALSE));
 			this->shared->insert_last(this->shared, entry);
 		}
+		/* the other set does not own any secrets anymore */
+		reset_secrets(other);
 	}
 	this->lock->unlock(this->lock);
 }
@@ -630,6 +1180,10 @@ METHOD(mem_cred_t, clear_, void,
 	this->trusted = linked_list_create();
 	this->untrusted = linked_list_create();
 	this->cdps = linked_list_create();
+	index_destroy(this->trusted_index);
+	index_destroy(this->untrusted_index);
+	this->trusted_index = index_create();
+	this->untrusted_index = index_create();
 	this->lock->unlock(this->lock);
 
 	clear_secrets(this);
@@ -644,6 +1198,10 @@ METHOD(mem_cred_t, destroy, void,
 	this->keys->destroy(this->keys);
 	this->shared->destroy(this->shared);
 	this->cdps->destroy(this->cdps);
+	index_destroy(this->trusted_index);
+	index_destroy(this->untrusted_index);
+	index_destroy(this->keys_index);
+	index_destroy(this->shared_index);
 	this->lock->destroy(this->lock);
 	free(this);
 }
@@ -681,6 +1239,10 @@ mem_cred_t *mem_cred_create()
 		.keys = linked_list_create(),
 		.shared = linked_list_create(),
 		.cdps = linked_list_create(),
+		.trusted_index = index_create(),
+		.untrusted_index = index_create(),
+		.keys_index = index_create(),
+		.shared_index = index_create(),
 		.lock = rwlock_create(RWLOCK_TYPE_DEFAULT),
 	);
 
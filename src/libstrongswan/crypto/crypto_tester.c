@@ -65,6 +65,11 @@ struct private_crypto_tester_t {
 	 */
 	linked_list_t *rng;
 
+	/**
+	 * List of Diffie-Hellman test vectors
+	 */
+	linked_list_t *dh;
+
 	/**
 	 * Is a test vector required to pass a test?
 	 */
@@ -1128,6 +1133,151 @@ failure:
 	return !failed;
 }
 
+/**
+ * Benchmark a DH backend, counting full exchanges
+ */
+static u_int bench_dh(private_crypto_tester_t *this,
+					  diffie_hellman_group_t group, dh_constructor_t create)
+{
+	chunk_t pub = chunk_empty, shared = chunk_empty;
+	diffie_hellman_t *dh;
+	struct timespec start;
+	u_int runs;
+
+	if (group == MODP_CUSTOM)
+	{	/* requires explicit group parameters */
+		return 0;
+	}
+	runs = 0;
+	start_timing(&start);
+	while (end_timing(&start) < this->bench_time)
+	{
+		dh = create(group);
+		if (!dh)
+		{
+			return 0;
+		}
+		dh->get_my_public_value(dh, &pub);
+		dh->set_other_public_value(dh, pub);
+		if (dh->get_shared_secret(dh, &shared) == SUCCESS)
+		{
+			runs++;
+		}
+		chunk_free(&pub);
+		chunk_clear(&shared);
+		dh->destroy(dh);
+	}
+	return runs;
+}
+
+METHOD(crypto_tester_t, test_dh, bool,
+	private_crypto_tester_t *this, diffie_hellman_group_t group,
+	dh_constructor_t create, u_int *speed, const char *plugin_name)
+{
+	enumerator_t *enumerator;
+	dh_test_vector_t *vector;
+	bool failed = FALSE;
+	u_int tested = 0;
+
+	enumerator = this->dh->create_enumerator(this->dh);
+	while (enumerator->enumerate(enumerator, &vector))
+	{
+		diffie_hellman_t *a, *b;
+		chunk_t apub, bpub, asec, bsec;
+
+		if (vector->group != group)
+		{
+			continue;
+		}
+
+		failed = TRUE;
+		a = create(group);
+		b = create(group);
+		if (!a || !b)
+		{
+			DESTROY_IF(a);
+			DESTROY_IF(b);
+			DBG1(DBG_LIB, "disabled %N[%s]: creating instance failed",
+				 diffie_hellman_group_names, group, plugin_name);
+			break;
+		}
+		if (!a->set_private_value(a, chunk_create(vector->priv_a,
+												  vector->priv_len)) ||
+			!b->set_private_value(b, chunk_create(vector->priv_b,
+												  vector->priv_len)))
+		{	/* backend does not support explicit private values, skip */
+			a->destroy(a);
+			b->destroy(b);
+			failed = FALSE;
+			continue;
+		}
+		tested++;
+		apub = bpub = asec = bsec = chunk_empty;
+
+		a->get_my_public_value(a, &apub);
+		if (!chunk_equals(apub, chunk_create(vector->pub_a, vector->pub_len)))
+		{
+			goto failure;
+		}
+		b->get_my_public_value(b, &bpub);
+		if (!chunk_equals(bpub, chunk_create(vector->pub_b, vector->pub_len)))
+		{
+			goto failure;
+		}
+		a->set_other_public_value(a, bpub);
+		b->set_other_public_value(b, apub);
+		if (a->get_shared_secret(a, &asec) != SUCCESS ||
+			!chunk_equals(asec, chunk_create(vector->shared, vector->shared_len)))
+		{
+			goto failure;
+		}
+		if (b->get_shared_secret(b, &bsec) != SUCCESS ||
+			!chunk_equals(bsec, chunk_create(vector->shared, vector->shared_len)))
+		{
+			goto failure;
+		}
+
+		failed = FALSE;
+failure:
+		a->destroy(a);
+		b->destroy(b);
+		chunk_free(&apub);
+		chunk_free(&bpub);
+		chunk_clear(&asec);
+		chunk_clear(&bsec);
+		if (failed)
+		{
+			DBG1(DBG_LIB, "disabled %N[%s]: %s test vector failed",
+				 diffie_hellman_group_names, group, plugin_name,
+				 get_name(vector));
+			break;
+		}
+	}
+	enumerator->destroy(enumerator);
+	if (!tested)
+	{	/* vectors exist for a few groups only, and not all backends accept
+		 * explicit private values, so don't disable untested groups */
+		DBG1(DBG_LIB, "enabled  %N[%s]: no test vectors found",
+			 diffie_hellman_group_names, group, plugin_name);
+		return !failed;
+	}
+	if (!failed)
+	{
+		if (speed)
+		{
+			*speed = bench_dh(this, group, create);
+			DBG1(DBG_LIB, "enabled  %N[%s]: passed %u test vectors, %d points",
+				 diffie_hellman_group_names, group, plugin_name, tested, *speed);
+		}
+		else
+		{
+			DBG1(DBG_LIB, "enabled  %N[%s]: passed %u test vectors",
+				 diffie_hellman_group_names, group, plugin_name, tested);
+		}
+	}
+	return !failed;
+}
+
 METHOD(crypto_tester_t, add_crypter_vector, void,
 	private_crypto_tester_t *this, crypter_test_vector_t *vector)
 {
@@ -1164,6 +1314,12 @@ METHOD(crypto_tester_t, add_rng_vector, void,
 	this->rng->insert_last(this->rng, vector);
 }
 
+METHOD(crypto_tester_t, add_dh_vector, void,
+	private_crypto_tester_t *this, dh_test_vector_t *vector)
+{
+	this->dh->insert_last(this->dh, vector);
+}
+
 METHOD(crypto_tester_t, destroy, void,
 	private_crypto_tester_t *this)
 {
@@ -1173,6 +1329,7 @@ METHOD(crypto_tester_t, destroy, void,
 	this->hasher->destroy(this->hasher);
 	this->prf->destroy(this->prf);
 	this->rng->destroy(this->rng);
+	this->dh->destroy(this->dh);
 	free(this);
 }
 
@@ -1191,12 +1348,14 @@ crypto_tester_t *crypto_tester_create()
 			.test_hasher = _test_hasher,
 			.test_prf = _test_prf,
 			.test_rng = _test_rng,
+			.test_dh = _test_dh,
 			.add_crypter_vector = _add_crypter_vector,
 			.add_aead_vector = _add_aead_vector,
 			.add_signer_vector = _add_signer_vector,
 			.add_hasher_vector = _add_hasher_vector,
 			.add_prf_vector = _add_prf_vector,
 			.add_rng_vector = _add_rng_vector,
+			.add_dh_vector = _add_dh_vector,
 			.destroy = _destroy,
 		},
 		.crypter = linked_list_create(),
@@ -1205,6 +1364,7 @@ crypto_tester_t *crypto_tester_create()
 		.hasher = linked_list_create(),
 		.prf = linked_list_create(),
 		.rng = linked_list_create(),
+		.dh = linked_list_create(),
 
 		.required = lib->settings->get_bool(lib->settings,
 								"libstrongswan.crypto_test.required", FALSE),
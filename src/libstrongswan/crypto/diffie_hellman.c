@@ -38,7 +38,9 @@ ENUM_NEXT(diffie_hellman_group_names, MODP_1024_160, ECP_224_BIT, ECP_521_BIT,
 	"MODP_2048_256",
 	"ECP_192",
 	"ECP_224");
-ENUM_NEXT(diffie_hellman_group_names, MODP_NULL, MODP_CUSTOM, ECP_224_BIT,
+ENUM_NEXT(diffie_hellman_group_names, CURVE_25519, CURVE_25519, ECP_224_BIT,
+	"CURVE_25519");
+ENUM_NEXT(diffie_hellman_group_names, MODP_NULL, MODP_CUSTOM, CURVE_25519,
 	"MODP_NULL",
 	"MODP_CUSTOM");
 ENUM_END(diffie_hellman_group_names, MODP_CUSTOM);
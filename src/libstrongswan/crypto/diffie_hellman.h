@@ -36,6 +36,7 @@ typedef struct diffie_hellman_params_t diffie_hellman_params_t;
  * See IKEv2 RFC 3.3.2 and RFC 3526.
  *
  * ECP groups are defined in RFC 4753 and RFC 5114.
+ * Curve25519 is defined in RFC 8031.
  */
 enum diffie_hellman_group_t {
 	MODP_NONE     =  0,
@@ -55,6 +56,7 @@ enum diffie_hellman_group_t {
 	MODP_2048_256 = 24,
 	ECP_192_BIT   = 25,
 	ECP_224_BIT   = 26,
+	CURVE_25519   = 31,
 	/** insecure NULL diffie hellman group for testing, in PRIVATE USE */
 	MODP_NULL = 1024,
 	/** MODP group with custom generator/prime */
@@ -90,6 +92,18 @@ struct diffie_hellman_t {
 	 */
 	void (*set_other_public_value) (diffie_hellman_t *this, chunk_t value);
 
+	/**
+	 * Set an explicit own private value to use.
+	 *
+	 * Calling this method is usually not required, as the DH backend generates
+	 * an appropriate private value itself. It is optional to implement, and
+	 * used mostly for testing purposes.
+	 *
+	 * @param value		private value to set
+	 * @return			TRUE if private value set, FALSE if not supported
+	 */
+	bool (*set_private_value)(diffie_hellman_t *this, chunk_t value);
+
 	/**
 	 * Gets the own public value to transmit.
 	 *
@@ -111,6 +111,61 @@ struct database_t {
 	 */
 	int (*execute)(database_t *this, int *rowid, char *sql, ...);
 
+	/**
+	 * Execute a statement once for each of multiple sets of arguments.
+	 *
+	 * The statement is prepared once and executed count times within a
+	 * single transaction (or as part of the transaction already started by
+	 * the calling thread). Each placeholder type is followed by an array of
+	 * count values of the respective type (e.g. an "int*" for DB_INT, a
+	 * "chunk_t*" for DB_BLOB), except DB_NULL, which takes no argument.
+	 *
+	 * @code
+	int ids[] = { 1, 2 };
+	char *names[] = { "one", "two" };
+
+	db->batch(db, "INSERT INTO table VALUES (?, ?)", countof(ids),
+			  DB_INT, ids, DB_TEXT, names);
+	   @endcode
+	 *
+	 * @param sql		sql string, containing '?' placeholders
+	 * @param count		number of sets of arguments
+	 * @param ...		list of sql placeholder db_type_t followed by an array
+	 * @return			total number of affected rows, < 0 on failure, in which
+	 *					case none of the statements have been committed
+	 */
+	int (*batch)(database_t *this, char *sql, u_int count, ...);
+
+	/**
+	 * Start a transaction.
+	 *
+	 * A transaction is bound to the calling thread, all queries and statements
+	 * of that thread are executed within the transaction until it is
+	 * committed or rolled back. While a thread runs a transaction, other
+	 * threads might get blocked.
+	 *
+	 * Transactions may be nested. Only the outermost commit() actually
+	 * commits the transaction, if none of the nested transactions has been
+	 * rolled back.
+	 *
+	 * @return			TRUE if the transaction has been started
+	 */
+	bool (*transaction)(database_t *this);
+
+	/**
+	 * Commit all changes made during the current transaction.
+	 *
+	 * @return			TRUE if the transaction has been committed
+	 */
+	bool (*commit)(database_t *this);
+
+	/**
+	 * Rollback all changes made during the current transaction.
+	 *
+	 * @return			TRUE if the transaction has been rolled back
+	 */
+	bool (*rollback)(database_t *this);
+
 	/**
 	 * Get the database implementation type.
 	 *
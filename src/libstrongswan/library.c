@@ -24,6 +24,7 @@
 #include <networking/host.h>
 #include <collections/hashtable.h>
 #include <utils/backtrace.h>
+#include <utils/slab.h>
 #include <selectors/traffic_selector.h>
 
 #define CHECKSUM_LIBRARY IPSEC_LIB_DIR"/libchecksum.so"
@@ -107,6 +108,7 @@ void library_deinit()
 	}
 
 	threads_deinit();
+	slab_deinit();
 	backtrace_deinit();
 
 	free(this);
@@ -237,6 +239,7 @@ bool library_init(char *settings)
 	lib = &this->public;
 
 	backtrace_init();
+	slab_init();
 	threads_init();
 
 #ifdef LEAK_DETECTIVE
@@ -0,0 +1,281 @@
+/*
+ * Copyright (C) 2013 Hochschule fuer Technik Rapperswil
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.  See <http://www.fsf.org/copyleft/gpl.txt>.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+
+#include "af_alg_aead.h"
+#include "af_alg_ops.h"
+
+/** as defined in RFC 4106 */
+#define IV_LEN		8
+#define SALT_LEN	4
+#define NONCE_LEN	(IV_LEN + SALT_LEN)
+
+/**
+ * Kernel algorithm name. We use plain GCM and build the nonce from salt and
+ * IV ourselves, as rfc4106(gcm(aes)) accepts only associated data the size of
+ * an ESP header, but not that of an IKE header.
+ */
+#define ALG_NAME	"gcm(aes)"
+
+typedef struct private_af_alg_aead_t private_af_alg_aead_t;
+
+/**
+ * Private data of af_alg_aead_t
+ */
+struct private_af_alg_aead_t {
+
+	/**
+	 * Public part of this class.
+	 */
+	af_alg_aead_t public;
+
+	/**
+	 * AF_ALG operations
+	 */
+	af_alg_ops_t *ops;
+
+	/**
+	 * Salt value
+	 */
+	char salt[SALT_LEN];
+
+	/**
+	 * Size of the key, without salt
+	 */
+	size_t key_size;
+
+	/**
+	 * Size of the integrity check value
+	 */
+	size_t icv_size;
+};
+
+/**
+ * Algorithm database
+ */
+static struct {
+	encryption_algorithm_t id;
+	size_t key_size;
+	size_t icv_size;
+} algs[AF_ALG_AEAD] = {
+	{ENCR_AES_GCM_ICV8,		16,	 8,	},
+	{ENCR_AES_GCM_ICV8,		24,	 8,	},
+	{ENCR_AES_GCM_ICV8,		32,	 8,	},
+	{ENCR_AES_GCM_ICV12,	16,	12,	},
+	{ENCR_AES_GCM_ICV12,	24,	12,	},
+	{ENCR_AES_GCM_ICV12,	32,	12,	},
+	{ENCR_AES_GCM_ICV16,	16,	16,	},
+	{ENCR_AES_GCM_ICV16,	24,	16,	},
+	{ENCR_AES_GCM_ICV16,	32,	16,	},
+};
+
+/**
+ * See header.
+ */
+void af_alg_aead_probe(plugin_feature_t *features, int *pos)
+{
+	af_alg_ops_t *ops;
+	int i;
+
+	ops = af_alg_ops_create("aead", ALG_NAME);
+	if (ops)
+	{
+		ops->destroy(ops);
+		for (i = 0; i < countof(algs); i++)
+		{
+			features[(*pos)++] = PLUGIN_PROVIDE(AEAD,
+												algs[i].id, algs[i].key_size);
+		}
+	}
+}
+
+/**
+ * Get the ICV size for our identifier
+ */
+static size_t lookup_alg(encryption_algorithm_t algo, size_t key_size)
+{
+	int i;
+
+	for (i = 0; i < countof(algs); i++)
+	{
+		if (algs[i].id == algo && algs[i].key_size == key_size)
+		{
+			return algs[i].icv_size;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Do the actual en/decryption, passing the nonce to the kernel
+ */
+static bool crypt(private_af_alg_aead_t *this, u_int32_t type, chunk_t data,
+				  chunk_t assoc, chunk_t iv, char *out, size_t outlen)
+{
+	char nonce[NONCE_LEN];
+
+	if (iv.len != IV_LEN)
+	{
+		return FALSE;
+	}
+	memcpy(nonce, this->salt, SALT_LEN);
+	memcpy(nonce + SALT_LEN, iv.ptr, IV_LEN);
+	return this->ops->crypt_aead(this->ops, type, chunk_from_thing(nonce),
+								 assoc, data, out, outlen);
+}
+
+METHOD(aead_t, encrypt, bool,
+	private_af_alg_aead_t *this, chunk_t plain, chunk_t assoc, chunk_t iv,
+	chunk_t *encrypted)
+{
+	char *out;
+
+	out = plain.ptr;
+	if (encrypted)
+	{
+		*encrypted = chunk_alloc(plain.len + this->icv_size);
+		out = encrypted->ptr;
+	}
+	if (!crypt(this, ALG_OP_ENCRYPT, plain, assoc, iv, out,
+			   plain.len + this->icv_size))
+	{
+		if (encrypted)
+		{
+			chunk_free(encrypted);
+		}
+		return FALSE;
+	}
+	return TRUE;
+}
+
+METHOD(aead_t, decrypt, bool,
+	private_af_alg_aead_t *this, chunk_t encrypted, chunk_t assoc, chunk_t iv,
+	chunk_t *plain)
+{
+	char *out;
+
+	if (encrypted.len < this->icv_size)
+	{
+		return FALSE;
+	}
+
+	out = encrypted.ptr;
+	if (plain)
+	{
+		*plain = chunk_alloc(encrypted.len - this->icv_size);
+		out = plain->ptr;
+	}
+	if (!crypt(this, ALG_OP_DECRYPT, encrypted, assoc, iv, out,
+			   encrypted.len - this->icv_size))
+	{
+		if (plain)
+		{
+			chunk_free(plain);
+		}
+		return FALSE;
+	}
+	return TRUE;
+}
+
+METHOD(aead_t, get_block_size, size_t,
+	private_af_alg_aead_t *this)
+{
+	return 1;
+}
+
+METHOD(aead_t, get_icv_size, size_t,
+	private_af_alg_aead_t *this)
+{
+	return this->icv_size;
+}
+
+METHOD(aead_t, get_iv_size, size_t,
+	private_af_alg_aead_t *this)
+{
+	return IV_LEN;
+}
+
+METHOD(aead_t, get_key_size, size_t,
+	private_af_alg_aead_t *this)
+{
+	return this->key_size + SALT_LEN;
+}
+
+METHOD(aead_t, set_key, bool,
+	private_af_alg_aead_t *this, chunk_t key)
+{
+	if (key.len != get_key_size(this))
+	{
+		return FALSE;
+	}
+	memcpy(this->salt, key.ptr + key.len - SALT_LEN, SALT_LEN);
+	return this->ops->set_key(this->ops, chunk_create(key.ptr, this->key_size));
+}
+
+METHOD(aead_t, destroy, void,
+	private_af_alg_aead_t *this)
+{
+	this->ops->destroy(this->ops);
+	memwipe(this->salt, SALT_LEN);
+	free(this);
+}
+
+/*
+ * Described in header
+ */
+af_alg_aead_t *af_alg_aead_create(encryption_algorithm_t algo,
+								  size_t key_size)
+{
+	private_af_alg_aead_t *this;
+	size_t icv_size;
+
+	if (!key_size)
+	{
+		key_size = 16;
+	}
+	icv_size = lookup_alg(algo, key_size);
+	if (!icv_size)
+	{	/* not supported by kernel */
+		return NULL;
+	}
+
+	INIT(this,
+		.public = {
+			.aead = {
+				.encrypt = _encrypt,
+				.decrypt = _decrypt,
+				.get_block_size = _get_block_size,
+				.get_icv_size = _get_icv_size,
+				.get_iv_size = _get_iv_size,
+				.get_key_size = _get_key_size,
+				.set_key = _set_key,
+				.destroy = _destroy,
+			},
+		},
+		.key_size = key_size,
+		.icv_size = icv_size,
+		.ops = af_alg_ops_create("aead", ALG_NAME),
+	);
+
+	if (!this->ops)
+	{
+		free(this);
+		return NULL;
+	}
+	if (!this->ops->set_icv_size(this->ops, icv_size))
+	{
+		destroy(this);
+		return NULL;
+	}
+	return &this->public;
+}
@@ -185,6 +185,125 @@ METHOD(af_alg_ops_t, crypt, bool,
 	return TRUE;
 }
 
+METHOD(af_alg_ops_t, crypt_aead, bool,
+	private_af_alg_ops_t *this, u_int32_t type, chunk_t iv, chunk_t assoc,
+	chunk_t data, char *out, size_t outlen)
+{
+	struct msghdr msg = {};
+	struct cmsghdr *cmsg;
+	struct af_alg_iv *ivm;
+	struct iovec iov[2];
+	u_int32_t assoclen = assoc.len;
+	char buf[CMSG_SPACE(sizeof(type)) +
+			 CMSG_SPACE(offsetof(struct af_alg_iv, iv) + iv.len) +
+			 CMSG_SPACE(sizeof(assoclen))];
+	/* the kernel writes the associated data to the output, too */
+	char ad[assoc.len + 1];
+	ssize_t len;
+	int count = 0;
+
+	while (this->op == -1)
+	{
+		this->op = accept(this->tfm, NULL, 0);
+		if (this->op == -1 && errno != EINTR)
+		{
+			DBG1(DBG_LIB, "opening AF_ALG aead failed: %s", strerror(errno));
+			return FALSE;
+		}
+	}
+
+	memset(buf, 0, sizeof(buf));
+
+	msg.msg_control = buf;
+	msg.msg_controllen = sizeof(buf);
+
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_ALG;
+	cmsg->cmsg_type = ALG_SET_OP;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(type));
+	memcpy(CMSG_DATA(cmsg), &type, sizeof(type));
+
+	cmsg = CMSG_NXTHDR(&msg, cmsg);
+	cmsg->cmsg_level = SOL_ALG;
+	cmsg->cmsg_type = ALG_SET_IV;
+	cmsg->cmsg_len = CMSG_LEN(offsetof(struct af_alg_iv, iv) + iv.len);
+	ivm = (void*)CMSG_DATA(cmsg);
+	ivm->ivlen = iv.len;
+	memcpy(ivm->iv, iv.ptr, iv.len);
+
+	cmsg = CMSG_NXTHDR(&msg, cmsg);
+	cmsg->cmsg_level = SOL_ALG;
+	cmsg->cmsg_type = ALG_SET_AEAD_ASSOCLEN;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(assoclen));
+	memcpy(CMSG_DATA(cmsg), &assoclen, sizeof(assoclen));
+
+	if (assoc.len)
+	{
+		iov[count].iov_base = assoc.ptr;
+		iov[count++].iov_len = assoc.len;
+	}
+	iov[count].iov_base = data.ptr;
+	iov[count++].iov_len = data.len;
+
+	msg.msg_iov = iov;
+	msg.msg_iovlen = count;
+
+	do
+	{
+		len = sendmsg(this->op, &msg, 0);
+	}
+	while (len == -1 && errno == EINTR);
+	if (len != assoclen + data.len)
+	{
+		DBG1(DBG_LIB, "writing to AF_ALG aead failed: %s",
+			 len == -1 ? strerror(errno) : "short write");
+		reset(this);
+		return FALSE;
+	}
+
+	count = 0;
+	if (assoclen)
+	{
+		iov[count].iov_base = ad;
+		iov[count++].iov_len = assoclen;
+	}
+	iov[count].iov_base = out;
+	iov[count++].iov_len = outlen;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = count;
+
+	do
+	{
+		len = recvmsg(this->op, &msg, 0);
+	}
+	while (len == -1 && errno == EINTR);
+	if (len != assoclen + outlen)
+	{
+		if (len != -1 || errno != EBADMSG)
+		{	/* EBADMSG indicates a failed verification, no error as such */
+			DBG1(DBG_LIB, "reading from AF_ALG aead failed: %s",
+				 len == -1 ? strerror(errno) : "short read");
+		}
+		reset(this);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+METHOD(af_alg_ops_t, set_icv_size, bool,
+	private_af_alg_ops_t *this, size_t size)
+{
+	if (setsockopt(this->tfm, SOL_ALG, ALG_SET_AEAD_AUTHSIZE, NULL,
+				   size) == -1)
+	{
+		DBG1(DBG_LIB, "setting AF_ALG ICV size failed: %s", strerror(errno));
+		return FALSE;
+	}
+	return TRUE;
+}
+
 METHOD(af_alg_ops_t, set_key, bool,
 	private_af_alg_ops_t *this, chunk_t key)
 {
@@ -225,6 +344,8 @@ af_alg_ops_t *af_alg_ops_create(char *type, char *alg)
 			.hash = _hash,
 			.reset = _reset,
 			.crypt = _crypt,
+			.crypt_aead = _crypt_aead,
+			.set_icv_size = _set_icv_size,
 			.set_key = _set_key,
 			.destroy = _destroy,
 		},
@@ -33,6 +33,14 @@
 #define SOL_ALG 279
 #endif /* SOL_ALG */
 
+#ifndef ALG_SET_AEAD_ASSOCLEN
+#define ALG_SET_AEAD_ASSOCLEN 4
+#endif /* ALG_SET_AEAD_ASSOCLEN */
+
+#ifndef ALG_SET_AEAD_AUTHSIZE
+#define ALG_SET_AEAD_AUTHSIZE 5
+#endif /* ALG_SET_AEAD_AUTHSIZE */
+
 typedef struct af_alg_ops_t af_alg_ops_t;
 
 /**
@@ -67,6 +75,36 @@ struct af_alg_ops_t {
 	bool (*crypt)(af_alg_ops_t *this, u_int32_t type, chunk_t iv, chunk_t data,
 				  char *out);
 
+	/**
+	 * En-/Decrypt and authenticate a chunk of data using an AEAD transform.
+	 *
+	 * Associated data and data are submitted with a single sendmsg() and
+	 * the result is read with a single recvmsg(), using scatter-gather I/O
+	 * instead of copying them to a contiguous buffer. The operation socket
+	 * is kept open for subsequent operations.
+	 *
+	 * On encryption, out receives the encrypted data followed by the ICV, on
+	 * decryption, data contains the ICV and out receives the plain data.
+	 *
+	 * @param type		crypto operation (ALG_OP_DECRYPT/ALG_OP_ENCRYPT)
+	 * @param iv		iv to use
+	 * @param assoc		associated data
+	 * @param data		data to encrypt/decrypt
+	 * @param out		buffer to write processed data to
+	 * @param outlen	number of bytes to read into out
+	 * @return			TRUE if successful, FALSE also if verification failed
+	 */
+	bool (*crypt_aead)(af_alg_ops_t *this, u_int32_t type, chunk_t iv,
+					   chunk_t assoc, chunk_t data, char *out, size_t outlen);
+
+	/**
+	 * Set the size of the ICV for AEAD operations.
+	 *
+	 * @param size		ICV size in bytes
+	 * @return			TRUE if successful
+	 */
+	bool (*set_icv_size)(af_alg_ops_t *this, size_t size);
+
 	/**
 	 * Set the key for en-/decryption or HMAC/XCBC operations.
 	 *
@@ -84,7 +122,7 @@ struct af_alg_ops_t {
 /**
  * Create a af_alg_ops instance.
  *
- * @param type			algorithm type (hash, skcipher)
+ * @param type			algorithm type (hash, skcipher, aead)
  * @param alg			algorithm name
  * @return				TRUE if AF_ALG socket bound successfully
  */
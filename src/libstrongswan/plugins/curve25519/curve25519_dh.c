@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2013 Hochschule fuer Technik Rapperswil
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.  See <http://www.fsf.org/copyleft/gpl.txt>.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+
+#include "curve25519_dh.h"
+#include "curve25519_drv.h"
+
+#include <utils/debug.h>
+
+typedef struct private_curve25519_dh_t private_curve25519_dh_t;
+
+/**
+ * Private data of a curve25519_dh_t object.
+ */
+struct private_curve25519_dh_t {
+
+	/**
+	 * Public curve25519_dh_t interface.
+	 */
+	curve25519_dh_t public;
+
+	/**
+	 * Own private key
+	 */
+	u_int8_t key[CURVE25519_KEY_SIZE];
+
+	/**
+	 * Own public value
+	 */
+	u_int8_t pub[CURVE25519_KEY_SIZE];
+
+	/**
+	 * Shared secret
+	 */
+	u_int8_t shared[CURVE25519_KEY_SIZE];
+
+	/**
+	 * TRUE if shared secret is computed
+	 */
+	bool computed;
+};
+
+/**
+ * u-coordinate of the base point
+ */
+static u_int8_t base[CURVE25519_KEY_SIZE] = { 9 };
+
+METHOD(diffie_hellman_t, get_shared_secret, status_t,
+	private_curve25519_dh_t *this, chunk_t *secret)
+{
+	if (!this->computed)
+	{
+		return FAILED;
+	}
+	*secret = chunk_clone(chunk_from_thing(this->shared));
+	return SUCCESS;
+}
+
+METHOD(diffie_hellman_t, set_other_public_value, void,
+	private_curve25519_dh_t *this, chunk_t value)
+{
+	u_int8_t zero[CURVE25519_KEY_SIZE] = {};
+
+	this->computed = FALSE;
+	if (value.len != CURVE25519_KEY_SIZE)
+	{
+		DBG1(DBG_LIB, "invalid %N public value length: %u",
+			 diffie_hellman_group_names, CURVE_25519, value.len);
+		return;
+	}
+	curve25519_x25519(this->shared, this->key, value.ptr);
+	/* reject low order points, resulting in an all-zero secret */
+	if (memeq(this->shared, zero, sizeof(zero)))
+	{
+		DBG1(DBG_LIB, "%N public value verification failed: low order point",
+			 diffie_hellman_group_names, CURVE_25519);
+		return;
+	}
+	this->computed = TRUE;
+}
+
+METHOD(diffie_hellman_t, set_private_value, bool,
+	private_curve25519_dh_t *this, chunk_t value)
+{
+	if (value.len != CURVE25519_KEY_SIZE)
+	{
+		return FALSE;
+	}
+	memcpy(this->key, value.ptr, value.len);
+	curve25519_x25519(this->pub, this->key, base);
+	this->computed = FALSE;
+	return TRUE;
+}
+
+METHOD(diffie_hellman_t, get_my_public_value, void,
+	private_curve25519_dh_t *this, chunk_t *value)
+{
+	*value = chunk_clone(chunk_from_thing(this->pub));
+}
+
+METHOD(diffie_hellman_t, get_dh_group, diffie_hellman_group_t,
+	private_curve25519_dh_t *this)
+{
+	return CURVE_25519;
+}
+
+METHOD(diffie_hellman_t, destroy, void,
+	private_curve25519_dh_t *this)
+{
+	memwipe(this, sizeof(*this));
+	free(this);
+}
+
+/*
+ * Described in header.
+ */
+curve25519_dh_t *curve25519_dh_create(diffie_hellman_group_t group)
+{
+	private_curve25519_dh_t *this;
+	rng_t *rng;
+
+	if (group != CURVE_25519)
+	{
+		return NULL;
+	}
+
+	INIT(this,
+		.public = {
+			.dh = {
+				.get_shared_secret = _get_shared_secret,
+				.set_other_public_value = _set_other_public_value,
+				.set_private_value = _set_private_value,
+				.get_my_public_value = _get_my_public_value,
+				.get_dh_group = _get_dh_group,
+				.destroy = _destroy,
+			},
+		},
+	);
+
+	rng = lib->crypto->create_rng(lib->crypto, RNG_STRONG);
+	if (!rng)
+	{
+		DBG1(DBG_LIB, "no RNG found for quality %N", rng_quality_names,
+			 RNG_STRONG);
+		destroy(this);
+		return NULL;
+	}
+	if (!rng->get_bytes(rng, sizeof(this->key), this->key))
+	{
+		DBG1(DBG_LIB, "failed to allocate DH secret");
+		rng->destroy(rng);
+		destroy(this);
+		return NULL;
+	}
+	rng->destroy(rng);
+	curve25519_x25519(this->pub, this->key, base);
+
+	return &this->public;
+}
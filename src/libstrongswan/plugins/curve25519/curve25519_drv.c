@@ -0,0 +1,993 @@
+/*
+ * Copyright (C) 2013 Hochschule fuer Technik Rapperswil
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.  See <http://www.fsf.org/copyleft/gpl.txt>.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+
+#include "curve25519_drv.h"
+
+/*
+ * Arithmetic in GF(2^255-19). All field operations run in constant time, the
+ * representation depends on the availability of a 128-bit integer type.
+ */
+
+#ifdef __SIZEOF_INT128__
+
+typedef unsigned __int128 u_int128_t;
+
+/**
+ * Field element with five 51-bit limbs. Limbs of operation results are
+ * below 2^51 + 2^18, values are fully reduced during encoding only.
+ */
+typedef u_int64_t fe_t[5];
+
+#define MASK51 0x7ffffffffffffULL
+
+/**
+ * Load a little-endian 64-bit value
+ */
+static u_int64_t load_le64(u_int8_t *in)
+{
+	u_int64_t v = 0;
+	int i;
+
+	for (i = 7; i >= 0; i--)
+	{
+		v = (v << 8) | in[i];
+	}
+	return v;
+}
+
+/**
+ * Store a little-endian 64-bit value
+ */
+static void store_le64(u_int8_t *out, u_int64_t v)
+{
+	int i;
+
+	for (i = 0; i < 8; i++)
+	{
+		out[i] = v >> (8 * i);
+	}
+}
+
+/**
+ * Decode a field element, ignoring the most significant bit
+ */
+static void fe_frombytes(fe_t h, u_int8_t *s)
+{
+	h[0] = load_le64(s) & MASK51;
+	h[1] = (load_le64(s + 6) >> 3) & MASK51;
+	h[2] = (load_le64(s + 12) >> 6) & MASK51;
+	h[3] = (load_le64(s + 19) >> 1) & MASK51;
+	h[4] = (load_le64(s + 24) >> 12) & MASK51;
+}
+
+/**
+ * Propagate carries, folding the top carry back using 2^255 = 19
+ */
+static void fe_carry(fe_t h)
+{
+	h[1] += h[0] >> 51;
+	h[0] &= MASK51;
+	h[2] += h[1] >> 51;
+	h[1] &= MASK51;
+	h[3] += h[2] >> 51;
+	h[2] &= MASK51;
+	h[4] += h[3] >> 51;
+	h[3] &= MASK51;
+	h[0] += 19 * (h[4] >> 51);
+	h[4] &= MASK51;
+}
+
+/**
+ * Encode a fully reduced field element
+ */
+static void fe_tobytes(u_int8_t *s, fe_t f)
+{
+	u_int64_t t[5], q;
+	int i;
+
+	memcpy(t, f, sizeof(t));
+	fe_carry(t);
+
+	/* q is 1 if t >= p, in which case we subtract p = 2^255 - 19 */
+	q = (t[0] + 19) >> 51;
+	for (i = 1; i < 5; i++)
+	{
+		q = (t[i] + q) >> 51;
+	}
+	t[0] += 19 * q;
+	for (i = 0; i < 4; i++)
+	{
+		t[i + 1] += t[i] >> 51;
+		t[i] &= MASK51;
+	}
+	t[4] &= MASK51;
+
+	store_le64(s, t[0] | (t[1] << 51));
+	store_le64(s + 8, (t[1] >> 13) | (t[2] << 38));
+	store_le64(s + 16, (t[2] >> 26) | (t[3] << 25));
+	store_le64(s + 24, (t[3] >> 39) | (t[4] << 12));
+	memwipe(t, sizeof(t));
+}
+
+/**
+ * h = f + g
+ */
+static void fe_add(fe_t h, fe_t f, fe_t g)
+{
+	int i;
+
+	for (i = 0; i < 5; i++)
+	{
+		h[i] = f[i] + g[i];
+	}
+	fe_carry(h);
+}
+
+/**
+ * h = f - g, adding 4p to avoid underflows
+ */
+static void fe_sub(fe_t h, fe_t f, fe_t g)
+{
+	int i;
+
+	h[0] = f[0] + 0x1fffffffffffb4ULL - g[0];
+	for (i = 1; i < 5; i++)
+	{
+		h[i] = f[i] + 0x1ffffffffffffcULL - g[i];
+	}
+	fe_carry(h);
+}
+
+/**
+ * Reduce the wide limbs of a product into h
+ */
+static void fe_carry_wide(fe_t h, u_int128_t r[5])
+{
+	u_int128_t c;
+
+	r[1] += r[0] >> 51;
+	h[0] = (u_int64_t)r[0] & MASK51;
+	r[2] += r[1] >> 51;
+	h[1] = (u_int64_t)r[1] & MASK51;
+	r[3] += r[2] >> 51;
+	h[2] = (u_int64_t)r[2] & MASK51;
+	r[4] += r[3] >> 51;
+	h[3] = (u_int64_t)r[3] & MASK51;
+	c = (r[4] >> 51) * 19 + h[0];
+	h[4] = (u_int64_t)r[4] & MASK51;
+	h[0] = (u_int64_t)c & MASK51;
+	h[1] += (u_int64_t)(c >> 51);
+}
+
+/**
+ * h = f * g
+ */
+static void fe_mul(fe_t h, fe_t f, fe_t g)
+{
+	u_int64_t f0 = f[0], f1 = f[1], f2 = f[2], f3 = f[3], f4 = f[4];
+	u_int64_t g0 = g[0], g1 = g[1], g2 = g[2], g3 = g[3], g4 = g[4];
+	u_int64_t g1_19 = 19 * g1, g2_19 = 19 * g2, g3_19 = 19 * g3,
+			  g4_19 = 19 * g4;
+	u_int128_t r[5];
+
+	r[0] = (u_int128_t)f0 * g0 + (u_int128_t)f1 * g4_19 +
+		   (u_int128_t)f2 * g3_19 + (u_int128_t)f3 * g2_19 +
+		   (u_int128_t)f4 * g1_19;
+	r[1] = (u_int128_t)f0 * g1 + (u_int128_t)f1 * g0 +
+		   (u_int128_t)f2 * g4_19 + (u_int128_t)f3 * g3_19 +
+		   (u_int128_t)f4 * g2_19;
+	r[2] = (u_int128_t)f0 * g2 + (u_int128_t)f1 * g1 +
+		   (u_int128_t)f2 * g0 + (u_int128_t)f3 * g4_19 +
+		   (u_int128_t)f4 * g3_19;
+	r[3] = (u_int128_t)f0 * g3 + (u_int128_t)f1 * g2 +
+		   (u_int128_t)f2 * g1 + (u_int128_t)f3 * g0 +
+		   (u_int128_t)f4 * g4_19;
+	r[4] = (u_int128_t)f0 * g4 + (u_int128_t)f1 * g3 +
+		   (u_int128_t)f2 * g2 + (u_int128_t)f3 * g1 +
+		   (u_int128_t)f4 * g0;
+	fe_carry_wide(h, r);
+}
+
+/**
+ * h = f^2
+ */
+static void fe_sq(fe_t h, fe_t f)
+{
+	u_int64_t f0 = f[0], f1 = f[1], f2 = f[2], f3 = f[3], f4 = f[4];
+	u_int64_t d0 = 2 * f0, d1 = 2 * f1, d2 = 2 * f2, d3 = 2 * f3;
+	u_int64_t f3_19 = 19 * f3, f4_19 = 19 * f4;
+	u_int128_t r[5];
+
+	r[0] = (u_int128_t)f0 * f0 + (u_int128_t)d1 * f4_19 +
+		   (u_int128_t)d2 * f3_19;
+	r[1] = (u_int128_t)d0 * f1 + (u_int128_t)d2 * f4_19 +
+		   (u_int128_t)f3 * f3_19;
+	r[2] = (u_int128_t)d0 * f2 + (u_int128_t)f1 * f1 +
+		   (u_int128_t)d3 * f4_19;
+	r[3] = (u_int128_t)d0 * f3 + (u_int128_t)d1 * f2 +
+		   (u_int128_t)f4 * f4_19;
+	r[4] = (u_int128_t)d0 * f4 + (u_int128_t)d1 * f3 +
+		   (u_int128_t)f2 * f2;
+	fe_carry_wide(h, r);
+}
+
+/**
+ * h = f * 121665
+ */
+static void fe_mul121665(fe_t h, fe_t f)
+{
+	u_int128_t r[5];
+	int i;
+
+	for (i = 0; i < 5; i++)
+	{
+		r[i] = (u_int128_t)f[i] * 121665;
+	}
+	fe_carry_wide(h, r);
+}
+
+/**
+ * Swap f and g if b is 1, in constant time
+ */
+static void fe_cswap(fe_t f, fe_t g, u_int b)
+{
+	u_int64_t mask = 0 - (u_int64_t)b, x;
+	int i;
+
+	for (i = 0; i < 5; i++)
+	{
+		x = mask & (f[i] ^ g[i]);
+		f[i] ^= x;
+		g[i] ^= x;
+	}
+}
+
+#else /* !__SIZEOF_INT128__ */
+
+/**
+ * Field element with sixteen 16-bit limbs in signed 64-bit integers, for
+ * platforms without a 128-bit integer type.
+ */
+typedef int64_t fe_t[16];
+
+/**
+ * Propagate carries, folding the top carry back using 2^256 = 38
+ */
+static void fe_carry(fe_t h)
+{
+	int64_t c;
+	int i;
+
+	for (i = 0; i < 16; i++)
+	{
+		h[i] += 1 << 16;
+		c = h[i] >> 16;
+		if (i < 15)
+		{
+			h[i + 1] += c - 1;
+		}
+		else
+		{
+			h[0] += 38 * (c - 1);
+		}
+		h[i] -= c * 65536;
+	}
+}
+
+/**
+ * Swap f and g if b is 1, in constant time
+ */
+static void fe_cswap(fe_t f, fe_t g, u_int b)
+{
+	int64_t mask = ~((int64_t)b - 1), x;
+	int i;
+
+	for (i = 0; i < 16; i++)
+	{
+		x = mask & (f[i] ^ g[i]);
+		f[i] ^= x;
+		g[i] ^= x;
+	}
+}
+
+/**
+ * Decode a field element, ignoring the most significant bit
+ */
+static void fe_frombytes(fe_t h, u_int8_t *s)
+{
+	int i;
+
+	for (i = 0; i < 16; i++)
+	{
+		h[i] = s[2 * i] + ((int64_t)s[2 * i + 1] << 8);
+	}
+	h[15] &= 0x7fff;
+}
+
+/**
+ * Encode a fully reduced field element
+ */
+static void fe_tobytes(u_int8_t *s, fe_t f)
+{
+	fe_t m, t;
+	int i, j, b;
+
+	memcpy(t, f, sizeof(t));
+	fe_carry(t);
+	fe_carry(t);
+	fe_carry(t);
+	for (j = 0; j < 2; j++)
+	{	/* subtract p, keep the result if it did not underflow */
+		m[0] = t[0] - 0xffed;
+		for (i = 1; i < 15; i++)
+		{
+			m[i] = t[i] - 0xffff - ((m[i - 1] >> 16) & 1);
+			m[i - 1] &= 0xffff;
+		}
+		m[15] = t[15] - 0x7fff - ((m[14] >> 16) & 1);
+		b = (m[15] >> 16) & 1;
+		m[14] &= 0xffff;
+		fe_cswap(t, m, 1 - b);
+	}
+	for (i = 0; i < 16; i++)
+	{
+		s[2 * i] = t[i] & 0xff;
+		s[2 * i + 1] = t[i] >> 8;
+	}
+	memwipe(t, sizeof(t));
+	memwipe(m, sizeof(m));
+}
+
+/**
+ * h = f + g
+ */
+static void fe_add(fe_t h, fe_t f, fe_t g)
+{
+	int i;
+
+	for (i = 0; i < 16; i++)
+	{
+		h[i] = f[i] + g[i];
+	}
+}
+
+/**
+ * h = f - g
+ */
+static void fe_sub(fe_t h, fe_t f, fe_t g)
+{
+	int i;
+
+	for (i = 0; i < 16; i++)
+	{
+		h[i] = f[i] - g[i];
+	}
+}
+
+/**
+ * h = f * g
+ */
+static void fe_mul(fe_t h, fe_t f, fe_t g)
+{
+	int64_t t[31];
+	int i, j;
+
+	memset(t, 0, sizeof(t));
+	for (i = 0; i < 16; i++)
+	{
+		for (j = 0; j < 16; j++)
+		{
+			t[i + j] += f[i] * g[j];
+		}
+	}
+	for (i = 0; i < 15; i++)
+	{
+		t[i] += 38 * t[i + 16];
+	}
+	memcpy(h, t, sizeof(fe_t));
+	fe_carry(h);
+	fe_carry(h);
+}
+
+/**
+ * h = f^2
+ */
+static void fe_sq(fe_t h, fe_t f)
+{
+	fe_mul(h, f, f);
+}
+
+/**
+ * h = f * 121665
+ */
+static void fe_mul121665(fe_t h, fe_t f)
+{
+	fe_t c = { 0xdb41, 1 };
+
+	fe_mul(h, f, c);
+}
+
+#endif /* __SIZEOF_INT128__ */
+
+/**
+ * h = 0
+ */
+static void fe_0(fe_t h)
+{
+	memset(h, 0, sizeof(fe_t));
+}
+
+/**
+ * h = 1
+ */
+static void fe_1(fe_t h)
+{
+	fe_0(h);
+	h[0] = 1;
+}
+
+/**
+ * h = f
+ */
+static void fe_copy(fe_t h, fe_t f)
+{
+	memcpy(h, f, sizeof(fe_t));
+}
+
+/**
+ * h = -f
+ */
+static void fe_neg(fe_t h, fe_t f)
+{
+	fe_t zero;
+
+	fe_0(zero);
+	fe_sub(h, zero, f);
+}
+
+/**
+ * h = f^(2^n), n > 0
+ */
+static void fe_sqn(fe_t h, fe_t f, int n)
+{
+	fe_sq(h, f);
+	while (--n)
+	{
+		fe_sq(h, h);
+	}
+}
+
+/**
+ * Compute z^(2^250-1) and z^11, shared by inversion and square root
+ */
+static void fe_pow2_250_1(fe_t out, fe_t z11, fe_t z)
+{
+	fe_t z2, z9, z2_5_0, z2_10_0, z2_20_0, z2_50_0, z2_100_0, t;
+
+	fe_sq(z2, z);
+	fe_sqn(t, z2, 2);
+	fe_mul(z9, t, z);
+	fe_mul(z11, z9, z2);
+	fe_sq(t, z11);
+	fe_mul(z2_5_0, t, z9);
+	fe_sqn(t, z2_5_0, 5);
+	fe_mul(z2_10_0, t, z2_5_0);
+	fe_sqn(t, z2_10_0, 10);
+	fe_mul(z2_20_0, t, z2_10_0);
+	fe_sqn(t, z2_20_0, 20);
+	fe_mul(t, t, z2_20_0);
+	fe_sqn(t, t, 10);
+	fe_mul(z2_50_0, t, z2_10_0);
+	fe_sqn(t, z2_50_0, 50);
+	fe_mul(z2_100_0, t, z2_50_0);
+	fe_sqn(t, z2_100_0, 100);
+	fe_mul(t, t, z2_100_0);
+	fe_sqn(t, t, 50);
+	fe_mul(out, t, z2_50_0);
+}
+
+/**
+ * h = z^(p-2) = z^-1
+ */
+static void fe_invert(fe_t h, fe_t z)
+{
+	fe_t t, z11;
+
+	fe_pow2_250_1(t, z11, z);
+	fe_sqn(t, t, 5);
+	fe_mul(h, t, z11);
+}
+
+/**
+ * h = z^((p-5)/8) = z^(2^252-3)
+ */
+static void fe_pow22523(fe_t h, fe_t z)
+{
+	fe_t t, z11;
+
+	fe_pow2_250_1(t, z11, z);
+	fe_sqn(t, t, 2);
+	fe_mul(h, t, z);
+}
+
+/**
+ * Check if f is zero
+ */
+static bool fe_iszero(fe_t f)
+{
+	u_int8_t s[CURVE25519_KEY_SIZE], zero[CURVE25519_KEY_SIZE] = {};
+
+	fe_tobytes(s, f);
+	return memeq(s, zero, sizeof(s));
+}
+
+/**
+ * Check if the least significant bit of the encoded f is set
+ */
+static int fe_isnegative(fe_t f)
+{
+	u_int8_t s[CURVE25519_KEY_SIZE];
+
+	fe_tobytes(s, f);
+	return s[0] & 1;
+}
+
+/*
+ * See header
+ */
+void curve25519_x25519(u_int8_t out[CURVE25519_KEY_SIZE],
+					   u_int8_t scalar[CURVE25519_KEY_SIZE],
+					   u_int8_t u[CURVE25519_KEY_SIZE])
+{
+	fe_t x1, x2, z2, x3, z3, a, aa, b, bb, e, c, d, da, cb;
+	u_int8_t k[CURVE25519_KEY_SIZE];
+	u_int swap = 0, bit;
+	int t;
+
+	memcpy(k, scalar, sizeof(k));
+	k[0] &= 248;
+	k[31] &= 127;
+	k[31] |= 64;
+
+	/* Montgomery ladder as in RFC 7748, section 5 */
+	fe_frombytes(x1, u);
+	fe_1(x2);
+	fe_0(z2);
+	fe_copy(x3, x1);
+	fe_1(z3);
+	for (t = 254; t >= 0; t--)
+	{
+		bit = (k[t >> 3] >> (t & 7)) & 1;
+		swap ^= bit;
+		fe_cswap(x2, x3, swap);
+		fe_cswap(z2, z3, swap);
+		swap = bit;
+
+		fe_add(a, x2, z2);
+		fe_sq(aa, a);
+		fe_sub(b, x2, z2);
+		fe_sq(bb, b);
+		fe_sub(e, aa, bb);
+		fe_add(c, x3, z3);
+		fe_sub(d, x3, z3);
+		fe_mul(da, d, a);
+		fe_mul(cb, c, b);
+		fe_add(x3, da, cb);
+		fe_sq(x3, x3);
+		fe_sub(z3, da, cb);
+		fe_sq(z3, z3);
+		fe_mul(z3, z3, x1);
+		fe_mul(x2, aa, bb);
+		fe_mul121665(z2, e);
+		fe_add(z2, z2, aa);
+		fe_mul(z2, z2, e);
+	}
+	fe_cswap(x2, x3, swap);
+	fe_cswap(z2, z3, swap);
+
+	fe_invert(z2, z2);
+	fe_mul(x2, x2, z2);
+	fe_tobytes(out, x2);
+
+	memwipe(k, sizeof(k));
+	memwipe(x2, sizeof(x2));
+	memwipe(z2, sizeof(z2));
+	memwipe(x3, sizeof(x3));
+	memwipe(z3, sizeof(z3));
+}
+
+/*
+ * Arithmetic on the twisted Edwards curve -x^2 + y^2 = 1 + d x^2 y^2 using
+ * extended coordinates, as in RFC 8032.
+ */
+
+/**
+ * Curve constant d, little-endian
+ */
+static u_int8_t ed25519_d[] = {
+	0xa3,0x78,0x59,0x13,0xca,0x4d,0xeb,0x75,0xab,0xd8,0x41,0x41,0x4d,0x0a,0x70,0x00,
+	0x98,0xe8,0x79,0x77,0x79,0x40,0xc7,0x8c,0x73,0xfe,0x6f,0x2b,0xee,0x6c,0x03,0x52,
+};
+
+/**
+ * Square root of -1, little-endian
+ */
+static u_int8_t ed25519_sqrtm1[] = {
+	0xb0,0xa0,0x0e,0x4a,0x27,0x1b,0xee,0xc4,0x78,0xe4,0x2f,0xad,0x06,0x18,0x43,0x2f,
+	0xa7,0xd7,0xfb,0x3d,0x99,0x00,0x4d,0x2b,0x0b,0xdf,0xc1,0x4f,0x80,0x24,0x83,0x2b,
+};
+
+/**
+ * Affine x-coordinate of the base point, little-endian
+ */
+static u_int8_t ed25519_bx[] = {
+	0x1a,0xd5,0x25,0x8f,0x60,0x2d,0x56,0xc9,0xb2,0xa7,0x25,0x95,0x60,0xc7,0x2c,0x69,
+	0x5c,0xdc,0xd6,0xfd,0x31,0xe2,0xa4,0xc0,0xfe,0x53,0x6e,0xcd,0xd3,0x36,0x69,0x21,
+};
+
+/**
+ * Affine y-coordinate of the base point, little-endian
+ */
+static u_int8_t ed25519_by[] = {
+	0x58,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,
+	0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,
+};
+
+/**
+ * Group order L, little-endian in 64-bit integers for scalar reduction
+ */
+static const int64_t ed25519_l[32] = {
+	0xed,0xd3,0xf5,0x5c,0x1a,0x63,0x12,0x58,0xd6,0x9c,0xf7,0xa2,0xde,0xf9,0xde,0x14,
+	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x10,
+};
+
+/**
+ * Point in extended coordinates, x = X/Z, y = Y/Z, x * y = T/Z
+ */
+typedef struct {
+	fe_t X;
+	fe_t Y;
+	fe_t Z;
+	fe_t T;
+} ge_t;
+
+/**
+ * Set p to the neutral element
+ */
+static void ge_identity(ge_t *p)
+{
+	fe_0(p->X);
+	fe_1(p->Y);
+	fe_1(p->Z);
+	fe_0(p->T);
+}
+
+/**
+ * Set p to the base point
+ */
+static void ge_base(ge_t *p)
+{
+	fe_frombytes(p->X, ed25519_bx);
+	fe_frombytes(p->Y, ed25519_by);
+	fe_1(p->Z);
+	fe_mul(p->T, p->X, p->Y);
+}
+
+/**
+ * r = p + q, r may alias p or q
+ */
+static void ge_add(ge_t *r, ge_t *p, ge_t *q)
+{
+	fe_t a, b, c, d, e, f, g, h, t;
+
+	fe_sub(a, p->Y, p->X);
+	fe_sub(t, q->Y, q->X);
+	fe_mul(a, a, t);
+	fe_add(b, p->Y, p->X);
+	fe_add(t, q->Y, q->X);
+	fe_mul(b, b, t);
+	fe_frombytes(t, ed25519_d);
+	fe_add(t, t, t);
+	fe_mul(c, p->T, q->T);
+	fe_mul(c, c, t);
+	fe_mul(d, p->Z, q->Z);
+	fe_add(d, d, d);
+	fe_sub(e, b, a);
+	fe_sub(f, d, c);
+	fe_add(g, d, c);
+	fe_add(h, b, a);
+	fe_mul(r->X, e, f);
+	fe_mul(r->Y, g, h);
+	fe_mul(r->T, e, h);
+	fe_mul(r->Z, f, g);
+}
+
+/**
+ * r = 2 * p, r may alias p
+ */
+static void ge_double(ge_t *r, ge_t *p)
+{
+	fe_t a, b, c, e, f, g, h;
+
+	fe_sq(a, p->X);
+	fe_sq(b, p->Y);
+	fe_sq(c, p->Z);
+	fe_add(c, c, c);
+	fe_add(h, a, b);
+	fe_add(e, p->X, p->Y);
+	fe_sq(e, e);
+	fe_sub(e, h, e);
+	fe_sub(g, a, b);
+	fe_add(f, c, g);
+	fe_mul(r->X, e, f);
+	fe_mul(r->Y, g, h);
+	fe_mul(r->T, e, h);
+	fe_mul(r->Z, f, g);
+}
+
+/**
+ * Swap p and q if b is 1, in constant time
+ */
+static void ge_cswap(ge_t *p, ge_t *q, u_int b)
+{
+	fe_cswap(p->X, q->X, b);
+	fe_cswap(p->Y, q->Y, b);
+	fe_cswap(p->Z, q->Z, b);
+	fe_cswap(p->T, q->T, b);
+}
+
+/**
+ * Encode a point
+ */
+static void ge_tobytes(u_int8_t *s, ge_t *p)
+{
+	u_int8_t xs[CURVE25519_KEY_SIZE];
+	fe_t zi, x, y;
+
+	fe_invert(zi, p->Z);
+	fe_mul(x, p->X, zi);
+	fe_mul(y, p->Y, zi);
+	fe_tobytes(s, y);
+	fe_tobytes(xs, x);
+	s[31] |= (xs[0] & 1) << 7;
+}
+
+/**
+ * Decode a point as in RFC 8032, section 5.1.3
+ */
+static bool ge_frombytes(ge_t *p, u_int8_t *s)
+{
+	u_int8_t check[CURVE25519_KEY_SIZE];
+	fe_t u, v, v3, vxx, t;
+	int sign = s[31] >> 7;
+
+	fe_frombytes(p->Y, s);
+	fe_tobytes(check, p->Y);
+	check[31] |= s[31] & 0x80;
+	if (!memeq(check, s, sizeof(check)))
+	{	/* y is not in canonical form */
+		return FALSE;
+	}
+	fe_1(p->Z);
+
+	/* u = y^2 - 1, v = d y^2 + 1 */
+	fe_sq(u, p->Y);
+	fe_frombytes(t, ed25519_d);
+	fe_mul(v, u, t);
+	fe_sub(u, u, p->Z);
+	fe_add(v, v, p->Z);
+
+	/* x = u v^3 (u v^7)^((p-5)/8) */
+	fe_sq(v3, v);
+	fe_mul(v3, v3, v);
+	fe_sq(p->X, v3);
+	fe_mul(p->X, p->X, v);
+	fe_mul(p->X, p->X, u);
+	fe_pow22523(p->X, p->X);
+	fe_mul(p->X, p->X, v3);
+	fe_mul(p->X, p->X, u);
+
+	fe_sq(vxx, p->X);
+	fe_mul(vxx, vxx, v);
+	fe_sub(t, vxx, u);
+	if (!fe_iszero(t))
+	{
+		fe_add(t, vxx, u);
+		if (!fe_iszero(t))
+		{	/* no square root exists */
+			return FALSE;
+		}
+		fe_frombytes(t, ed25519_sqrtm1);
+		fe_mul(p->X, p->X, t);
+	}
+	if (fe_isnegative(p->X) != sign)
+	{
+		if (fe_iszero(p->X))
+		{
+			return FALSE;
+		}
+		fe_neg(p->X, p->X);
+	}
+	fe_mul(p->T, p->X, p->Y);
+	return TRUE;
+}
+
+/*
+ * See header
+ */
+void ed25519_scalarmult_base(u_int8_t out[CURVE25519_KEY_SIZE],
+							 u_int8_t s[CURVE25519_KEY_SIZE])
+{
+	ge_t r0, r1;
+	u_int bit;
+	int i;
+
+	/* Montgomery ladder, keeping r1 = r0 + B */
+	ge_identity(&r0);
+	ge_base(&r1);
+	for (i = 255; i >= 0; i--)
+	{
+		bit = (s[i >> 3] >> (i & 7)) & 1;
+		ge_cswap(&r0, &r1, bit);
+		ge_add(&r1, &r0, &r1);
+		ge_double(&r0, &r0);
+		ge_cswap(&r0, &r1, bit);
+	}
+	ge_tobytes(out, &r0);
+	memwipe(&r0, sizeof(r0));
+	memwipe(&r1, sizeof(r1));
+}
+
+/*
+ * See header
+ */
+bool ed25519_double_scalarmult_vartime(u_int8_t out[CURVE25519_KEY_SIZE],
+									   u_int8_t a[CURVE25519_KEY_SIZE],
+									   u_int8_t A[CURVE25519_KEY_SIZE],
+									   u_int8_t b[CURVE25519_KEY_SIZE])
+{
+	ge_t nA, B, sum, r;
+	u_int ba, bb;
+	int i;
+
+	if (!ge_frombytes(&nA, A))
+	{
+		return FALSE;
+	}
+	fe_neg(nA.X, nA.X);
+	fe_neg(nA.T, nA.T);
+	ge_base(&B);
+	ge_add(&sum, &nA, &B);
+
+	/* simultaneous double-and-add, operates on public data only */
+	ge_identity(&r);
+	for (i = 255; i >= 0; i--)
+	{
+		ge_double(&r, &r);
+		ba = (a[i >> 3] >> (i & 7)) & 1;
+		bb = (b[i >> 3] >> (i & 7)) & 1;
+		if (ba && bb)
+		{
+			ge_add(&r, &r, &sum);
+		}
+		else if (ba)
+		{
+			ge_add(&r, &r, &nA);
+		}
+		else if (bb)
+		{
+			ge_add(&r, &r, &B);
+		}
+	}
+	ge_tobytes(out, &r);
+	return TRUE;
+}
+
+/**
+ * Reduce the 64 signed 8-bit limbs in x modulo L
+ */
+static void mod_l(u_int8_t *r, int64_t x[64])
+{
+	int64_t carry;
+	int i, j;
+
+	for (i = 63; i >= 32; i--)
+	{
+		carry = 0;
+		for (j = i - 32; j < i - 12; j++)
+		{
+			x[j] += carry - 16 * x[i] * ed25519_l[j - (i - 32)];
+			carry = (x[j] + 128) >> 8;
+			x[j] -= carry * 256;
+		}
+		x[j] += carry;
+		x[i] = 0;
+	}
+	carry = 0;
+	for (j = 0; j < 32; j++)
+	{
+		x[j] += carry - (x[31] >> 4) * ed25519_l[j];
+		carry = x[j] >> 8;
+		x[j] &= 255;
+	}
+	for (j = 0; j < 32; j++)
+	{
+		x[j] -= carry * ed25519_l[j];
+	}
+	for (i = 0; i < 32; i++)
+	{
+		x[i + 1] += x[i] >> 8;
+		r[i] = x[i] & 255;
+	}
+}
+
+/*
+ * See header
+ */
+void ed25519_sc_reduce(u_int8_t out[CURVE25519_KEY_SIZE], u_int8_t in[64])
+{
+	int64_t x[64];
+	int i;
+
+	for (i = 0; i < 64; i++)
+	{
+		x[i] = in[i];
+	}
+	mod_l(out, x);
+	memwipe(x, sizeof(x));
+}
+
+/*
+ * See header
+ */
+void ed25519_sc_muladd(u_int8_t s[CURVE25519_KEY_SIZE],
+					   u_int8_t a[CURVE25519_KEY_SIZE],
+					   u_int8_t b[CURVE25519_KEY_SIZE],
+					   u_int8_t c[CURVE25519_KEY_SIZE])
+{
+	int64_t x[64];
+	int i, j;
+
+	memset(x, 0, sizeof(x));
+	for (i = 0; i < 32; i++)
+	{
+		x[i] = c[i];
+	}
+	for (i = 0; i < 32; i++)
+	{
+		for (j = 0; j < 32; j++)
+		{
+			x[i + j] += (int64_t)a[i] * b[j];
+		}
+	}
+	mod_l(s, x);
+	memwipe(x, sizeof(x));
+}
+
+/*
+ * See header
+ */
+bool ed25519_sc_is_canonical(u_int8_t s[CURVE25519_KEY_SIZE])
+{
+	int i;
+
+	for (i = 31; i >= 0; i--)
+	{
+		if (s[i] != ed25519_l[i])
+		{
+			return s[i] < ed25519_l[i];
+		}
+	}
+	return FALSE;
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2013 Hochschule fuer Technik Rapperswil
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.  See <http://www.fsf.org/copyleft/gpl.txt>.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+
+/**
+ * @defgroup curve25519_drv curve25519_drv
+ * @{ @ingroup curve25519_p
+ */
+
+#ifndef CURVE25519_DRV_H_
+#define CURVE25519_DRV_H_
+
+#include <library.h>
+
+/**
+ * Length of Curve25519 keys, encoded points and scalars
+ */
+#define CURVE25519_KEY_SIZE 32
+
+/**
+ * Length of an Ed25519 signature
+ */
+#define ED25519_SIG_SIZE 64
+
+/**
+ * Compute the X25519 function as defined in RFC 7748.
+ *
+ * The scalar gets clamped, the most significant bit of u is ignored. Runs in
+ * constant time.
+ *
+ * @param out		resulting u-coordinate
+ * @param scalar	scalar, private key
+ * @param u			u-coordinate of input point
+ */
+void curve25519_x25519(u_int8_t out[CURVE25519_KEY_SIZE],
+					   u_int8_t scalar[CURVE25519_KEY_SIZE],
+					   u_int8_t u[CURVE25519_KEY_SIZE]);
+
+/**
+ * Compute the encoded Ed25519 point [s]B in constant time.
+ *
+ * @param out		encoded point
+ * @param s			scalar, little-endian
+ */
+void ed25519_scalarmult_base(u_int8_t out[CURVE25519_KEY_SIZE],
+							 u_int8_t s[CURVE25519_KEY_SIZE]);
+
+/**
+ * Compute the encoded Ed25519 point [b]B - [a]A, not in constant time.
+ *
+ * @param out		encoded point
+ * @param a			scalar a, little-endian
+ * @param A			encoded point A
+ * @param b			scalar b, little-endian
+ * @return			FALSE if A is not a valid point encoding
+ */
+bool ed25519_double_scalarmult_vartime(u_int8_t out[CURVE25519_KEY_SIZE],
+									   u_int8_t a[CURVE25519_KEY_SIZE],
+									   u_int8_t A[CURVE25519_KEY_SIZE],
+									   u_int8_t b[CURVE25519_KEY_SIZE]);
+
+/**
+ * Reduce a 512-bit little-endian value modulo the group order L.
+ *
+ * @param out		reduced scalar
+ * @param in		value to reduce
+ */
+void ed25519_sc_reduce(u_int8_t out[CURVE25519_KEY_SIZE], u_int8_t in[64]);
+
+/**
+ * Compute s = (a * b + c) mod L.
+ *
+ * @param s			result
+ * @param a			scalar a
+ * @param b			scalar b
+ * @param c			scalar c
+ */
+void ed25519_sc_muladd(u_int8_t s[CURVE25519_KEY_SIZE],
+					   u_int8_t a[CURVE25519_KEY_SIZE],
+					   u_int8_t b[CURVE25519_KEY_SIZE],
+					   u_int8_t c[CURVE25519_KEY_SIZE]);
+
+/**
+ * Check if a scalar is in canonical form, that is smaller than L.
+ *
+ * @param s			scalar to check
+ * @return			TRUE if s < L
+ */
+bool ed25519_sc_is_canonical(u_int8_t s[CURVE25519_KEY_SIZE]);
+
+#endif /** CURVE25519_DRV_H_ @}*/
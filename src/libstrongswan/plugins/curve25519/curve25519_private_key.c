@@ -0,0 +1,351 @@
+/*
+ * Copyright (C) 2013 Hochschule fuer Technik Rapperswil
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.  See <http://www.fsf.org/copyleft/gpl.txt>.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+
+#include "curve25519_private_key.h"
+#include "curve25519_public_key.h"
+#include "curve25519_drv.h"
+
+#include <asn1/asn1.h>
+#include <asn1/oid.h>
+#include <utils/debug.h>
+
+typedef struct private_curve25519_private_key_t private_curve25519_private_key_t;
+
+/**
+ * Private data of a curve25519_private_key_t object.
+ */
+struct private_curve25519_private_key_t {
+
+	/**
+	 * Public interface for this signer.
+	 */
+	curve25519_private_key_t public;
+
+	/**
+	 * Private key, the seed the signing scalar and prefix are derived from
+	 */
+	u_int8_t key[CURVE25519_KEY_SIZE];
+
+	/**
+	 * Clamped secret scalar a
+	 */
+	u_int8_t scalar[CURVE25519_KEY_SIZE];
+
+	/**
+	 * Prefix used to derive the deterministic nonce
+	 */
+	u_int8_t prefix[CURVE25519_KEY_SIZE];
+
+	/**
+	 * Encoded public point A = [a]B
+	 */
+	u_int8_t pubkey[CURVE25519_KEY_SIZE];
+
+	/**
+	 * Reference count
+	 */
+	refcount_t ref;
+};
+
+METHOD(private_key_t, get_type, key_type_t,
+	private_curve25519_private_key_t *this)
+{
+	return KEY_ED25519;
+}
+
+METHOD(private_key_t, sign, bool,
+	private_curve25519_private_key_t *this, signature_scheme_t scheme,
+	chunk_t data, chunk_t *signature)
+{
+	u_int8_t r[HASH_SIZE_SHA512], k[HASH_SIZE_SHA512];
+	hasher_t *hasher;
+	chunk_t sig;
+
+	if (scheme != SIGN_ED25519)
+	{
+		DBG1(DBG_LIB, "signature scheme %N not supported by %N",
+			 signature_scheme_names, scheme, key_type_names, KEY_ED25519);
+		return FALSE;
+	}
+	hasher = lib->crypto->create_hasher(lib->crypto, HASH_SHA512);
+	if (!hasher)
+	{
+		DBG1(DBG_LIB, "%N not supported, unable to create %N signature",
+			 hash_algorithm_names, HASH_SHA512, key_type_names, KEY_ED25519);
+		return FALSE;
+	}
+	sig = chunk_alloc(ED25519_SIG_SIZE);
+
+	/* r = SHA512(prefix || M) mod L, R = [r]B */
+	if (!hasher->get_hash(hasher, chunk_from_thing(this->prefix), NULL) ||
+		!hasher->get_hash(hasher, data, r))
+	{
+		goto failed;
+	}
+	ed25519_sc_reduce(r, r);
+	ed25519_scalarmult_base(sig.ptr, r);
+
+	/* k = SHA512(R || A || M) mod L, S = (r + k * a) mod L */
+	if (!hasher->get_hash(hasher, chunk_create(sig.ptr, CURVE25519_KEY_SIZE),
+						  NULL) ||
+		!hasher->get_hash(hasher, chunk_from_thing(this->pubkey), NULL) ||
+		!hasher->get_hash(hasher, data, k))
+	{
+		goto failed;
+	}
+	ed25519_sc_reduce(k, k);
+	ed25519_sc_muladd(sig.ptr + CURVE25519_KEY_SIZE, k, this->scalar, r);
+
+	hasher->destroy(hasher);
+	memwipe(r, sizeof(r));
+	*signature = sig;
+	return TRUE;
+
+failed:
+	hasher->destroy(hasher);
+	memwipe(r, sizeof(r));
+	chunk_free(&sig);
+	return FALSE;
+}
+
+METHOD(private_key_t, decrypt, bool,
+	private_curve25519_private_key_t *this, encryption_scheme_t scheme,
+	chunk_t crypto, chunk_t *plain)
+{
+	DBG1(DBG_LIB, "encryption scheme %N not supported",
+		 encryption_scheme_names, scheme);
+	return FALSE;
+}
+
+METHOD(private_key_t, get_keysize, int,
+	private_curve25519_private_key_t *this)
+{
+	return 8 * CURVE25519_KEY_SIZE;
+}
+
+METHOD(private_key_t, get_public_key, public_key_t*,
+	private_curve25519_private_key_t *this)
+{
+	return lib->creds->create(lib->creds, CRED_PUBLIC_KEY, KEY_ED25519,
+							  BUILD_EDDSA_PUB, chunk_from_thing(this->pubkey),
+							  BUILD_END);
+}
+
+METHOD(private_key_t, get_encoding, bool,
+	private_curve25519_private_key_t *this, cred_encoding_type_t type,
+	chunk_t *encoding)
+{
+	bool success = TRUE;
+
+	switch (type)
+	{
+		case PRIVKEY_ASN1_DER:
+		case PRIVKEY_PEM:
+			/* PKCS#8 PrivateKeyInfo wrapping a CurvePrivateKey */
+			*encoding = asn1_wrap(ASN1_SEQUENCE, "cms",
+							ASN1_INTEGER_0,
+							asn1_wrap(ASN1_SEQUENCE, "m",
+								asn1_build_known_oid(OID_ED25519)),
+							asn1_wrap(ASN1_OCTET_STRING, "m",
+								asn1_simple_object(ASN1_OCTET_STRING,
+											chunk_from_thing(this->key))));
+			if (type == PRIVKEY_PEM)
+			{
+				chunk_t asn1_encoding = *encoding;
+
+				success = lib->encoding->encode(lib->encoding, PRIVKEY_PEM,
+								NULL, encoding, CRED_PART_EDDSA_PRIV_ASN1_DER,
+								asn1_encoding, CRED_PART_END);
+				chunk_clear(&asn1_encoding);
+			}
+			return success;
+		default:
+			return FALSE;
+	}
+}
+
+METHOD(private_key_t, get_fingerprint, bool,
+	private_curve25519_private_key_t *this, cred_encoding_type_t type,
+	chunk_t *fingerprint)
+{
+	return curve25519_public_key_fingerprint(chunk_from_thing(this->pubkey),
+											 type, fingerprint);
+}
+
+METHOD(private_key_t, get_ref, private_key_t*,
+	private_curve25519_private_key_t *this)
+{
+	ref_get(&this->ref);
+	return &this->public.key;
+}
+
+METHOD(private_key_t, destroy, void,
+	private_curve25519_private_key_t *this)
+{
+	if (ref_put(&this->ref))
+	{
+		lib->encoding->clear_cache(lib->encoding, this->pubkey);
+		memwipe(this, sizeof(*this));
+		free(this);
+	}
+}
+
+/**
+ * Create a key object from the given private key, deriving scalar, prefix
+ * and public key as in RFC 8032, section 5.1.5.
+ */
+static private_curve25519_private_key_t *curve25519_private_key_create(
+																chunk_t key)
+{
+	private_curve25519_private_key_t *this;
+	u_int8_t h[HASH_SIZE_SHA512];
+	hasher_t *hasher;
+
+	if (key.len != CURVE25519_KEY_SIZE)
+	{
+		return NULL;
+	}
+	hasher = lib->crypto->create_hasher(lib->crypto, HASH_SHA512);
+	if (!hasher)
+	{
+		DBG1(DBG_LIB, "%N not supported, unable to use %N key",
+			 hash_algorithm_names, HASH_SHA512, key_type_names, KEY_ED25519);
+		return NULL;
+	}
+	if (!hasher->get_hash(hasher, key, h))
+	{
+		hasher->destroy(hasher);
+		return NULL;
+	}
+	hasher->destroy(hasher);
+
+	INIT(this,
+		.public = {
+			.key = {
+				.get_type = _get_type,
+				.sign = _sign,
+				.decrypt = _decrypt,
+				.get_keysize = _get_keysize,
+				.get_public_key = _get_public_key,
+				.equals = private_key_equals,
+				.belongs_to = private_key_belongs_to,
+				.get_fingerprint = _get_fingerprint,
+				.has_fingerprint = private_key_has_fingerprint,
+				.get_encoding = _get_encoding,
+				.get_ref = _get_ref,
+				.destroy = _destroy,
+			},
+		},
+		.ref = 1,
+	);
+	memcpy(this->key, key.ptr, sizeof(this->key));
+	memcpy(this->scalar, h, sizeof(this->scalar));
+	memcpy(this->prefix, h + CURVE25519_KEY_SIZE, sizeof(this->prefix));
+	memwipe(h, sizeof(h));
+
+	this->scalar[0] &= 248;
+	this->scalar[31] &= 127;
+	this->scalar[31] |= 64;
+	ed25519_scalarmult_base(this->pubkey, this->scalar);
+
+	return this;
+}
+
+/**
+ * See header.
+ */
+curve25519_private_key_t *curve25519_private_key_gen(key_type_t type,
+													 va_list args)
+{
+	private_curve25519_private_key_t *this;
+	u_int8_t key[CURVE25519_KEY_SIZE];
+	u_int key_size = 0;
+	rng_t *rng;
+
+	while (TRUE)
+	{
+		switch (va_arg(args, builder_part_t))
+		{
+			case BUILD_KEY_SIZE:
+				key_size = va_arg(args, u_int);
+				continue;
+			case BUILD_END:
+				break;
+			default:
+				return NULL;
+		}
+		break;
+	}
+	if (key_size && key_size != 8 * CURVE25519_KEY_SIZE)
+	{
+		DBG1(DBG_LIB, "%N key size %d not supported",
+			 key_type_names, KEY_ED25519, key_size);
+		return NULL;
+	}
+
+	rng = lib->crypto->create_rng(lib->crypto, RNG_TRUE);
+	if (!rng)
+	{
+		DBG1(DBG_LIB, "no RNG of quality %N found", rng_quality_names,
+			 RNG_TRUE);
+		return NULL;
+	}
+	if (!rng->get_bytes(rng, sizeof(key), key))
+	{
+		rng->destroy(rng);
+		return NULL;
+	}
+	rng->destroy(rng);
+
+	this = curve25519_private_key_create(chunk_from_thing(key));
+	memwipe(key, sizeof(key));
+
+	return this ? &this->public : NULL;
+}
+
+/**
+ * See header.
+ */
+curve25519_private_key_t *curve25519_private_key_load(key_type_t type,
+													  va_list args)
+{
+	private_curve25519_private_key_t *this;
+	chunk_t blob = chunk_empty, priv = chunk_empty;
+
+	while (TRUE)
+	{
+		switch (va_arg(args, builder_part_t))
+		{
+			case BUILD_BLOB_ASN1_DER:
+				blob = va_arg(args, chunk_t);
+				continue;
+			case BUILD_EDDSA_PRIV:
+				priv = va_arg(args, chunk_t);
+				continue;
+			case BUILD_END:
+				break;
+			default:
+				return NULL;
+		}
+		break;
+	}
+	if (blob.len &&
+		asn1_unwrap(&blob, &priv) != ASN1_OCTET_STRING)
+	{	/* CurvePrivateKey ::= OCTET STRING */
+		return NULL;
+	}
+	this = curve25519_private_key_create(priv);
+
+	return this ? &this->public : NULL;
+}
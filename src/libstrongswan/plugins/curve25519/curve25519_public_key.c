@@ -0,0 +1,296 @@
+/*
+ * Copyright (C) 2013 Hochschule fuer Technik Rapperswil
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.  See <http://www.fsf.org/copyleft/gpl.txt>.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+
+#include "curve25519_public_key.h"
+#include "curve25519_drv.h"
+
+#include <asn1/asn1.h>
+#include <asn1/oid.h>
+#include <utils/debug.h>
+
+typedef struct private_curve25519_public_key_t private_curve25519_public_key_t;
+
+/**
+ * Private data structure with signing context.
+ */
+struct private_curve25519_public_key_t {
+
+	/**
+	 * Public interface for this signer.
+	 */
+	curve25519_public_key_t public;
+
+	/**
+	 * Encoded Ed25519 point A
+	 */
+	u_int8_t key[CURVE25519_KEY_SIZE];
+
+	/**
+	 * Reference counter
+	 */
+	refcount_t ref;
+};
+
+METHOD(public_key_t, get_type, key_type_t,
+	private_curve25519_public_key_t *this)
+{
+	return KEY_ED25519;
+}
+
+METHOD(public_key_t, verify, bool,
+	private_curve25519_public_key_t *this, signature_scheme_t scheme,
+	chunk_t data, chunk_t signature)
+{
+	u_int8_t k[HASH_SIZE_SHA512], r[CURVE25519_KEY_SIZE];
+	hasher_t *hasher;
+	chunk_t R, S;
+
+	if (scheme != SIGN_ED25519)
+	{
+		DBG1(DBG_LIB, "signature scheme %N not supported by %N",
+			 signature_scheme_names, scheme, key_type_names, KEY_ED25519);
+		return FALSE;
+	}
+	if (signature.len != ED25519_SIG_SIZE)
+	{
+		DBG1(DBG_LIB, "invalid %N signature length: %u",
+			 key_type_names, KEY_ED25519, signature.len);
+		return FALSE;
+	}
+	R = chunk_create(signature.ptr, CURVE25519_KEY_SIZE);
+	S = chunk_skip(signature, CURVE25519_KEY_SIZE);
+	/* reject non-canonical S to prevent signature malleability */
+	if (!ed25519_sc_is_canonical(S.ptr))
+	{
+		return FALSE;
+	}
+
+	hasher = lib->crypto->create_hasher(lib->crypto, HASH_SHA512);
+	if (!hasher)
+	{
+		DBG1(DBG_LIB, "%N not supported, unable to verify %N signature",
+			 hash_algorithm_names, HASH_SHA512, key_type_names, KEY_ED25519);
+		return FALSE;
+	}
+	if (!hasher->get_hash(hasher, R, NULL) ||
+		!hasher->get_hash(hasher, chunk_from_thing(this->key), NULL) ||
+		!hasher->get_hash(hasher, data, k))
+	{
+		hasher->destroy(hasher);
+		return FALSE;
+	}
+	hasher->destroy(hasher);
+
+	/* check R == [S]B - [k]A */
+	ed25519_sc_reduce(k, k);
+	if (!ed25519_double_scalarmult_vartime(r, k, this->key, S.ptr))
+	{
+		return FALSE;
+	}
+	return memeq(r, R.ptr, sizeof(r));
+}
+
+METHOD(public_key_t, encrypt, bool,
+	private_curve25519_public_key_t *this, encryption_scheme_t scheme,
+	chunk_t plain, chunk_t *crypto)
+{
+	DBG1(DBG_LIB, "encryption scheme %N not supported",
+		 encryption_scheme_names, scheme);
+	return FALSE;
+}
+
+METHOD(public_key_t, get_keysize, int,
+	private_curve25519_public_key_t *this)
+{
+	return 8 * CURVE25519_KEY_SIZE;
+}
+
+/*
+ * See header.
+ */
+chunk_t curve25519_public_key_info_encode(chunk_t pubkey)
+{
+	return asn1_wrap(ASN1_SEQUENCE, "mm",
+				asn1_wrap(ASN1_SEQUENCE, "m",
+					asn1_build_known_oid(OID_ED25519)),
+				asn1_bitstring("c", pubkey));
+}
+
+/*
+ * See header.
+ */
+bool curve25519_public_key_fingerprint(chunk_t pubkey,
+									   cred_encoding_type_t type, chunk_t *fp)
+{
+	hasher_t *hasher;
+	chunk_t key;
+
+	if (lib->encoding->get_cache(lib->encoding, type, pubkey.ptr, fp))
+	{
+		return TRUE;
+	}
+	switch (type)
+	{
+		case KEYID_PUBKEY_SHA1:
+			key = chunk_clone(pubkey);
+			break;
+		case KEYID_PUBKEY_INFO_SHA1:
+			key = curve25519_public_key_info_encode(pubkey);
+			break;
+		default:
+			return FALSE;
+	}
+	hasher = lib->crypto->create_hasher(lib->crypto, HASH_SHA1);
+	if (!hasher || !hasher->allocate_hash(hasher, key, fp))
+	{
+		DBG1(DBG_LIB, "SHA1 hash algorithm not supported, fingerprinting failed");
+		DESTROY_IF(hasher);
+		free(key.ptr);
+		return FALSE;
+	}
+	hasher->destroy(hasher);
+	free(key.ptr);
+	lib->encoding->cache(lib->encoding, type, pubkey.ptr, *fp);
+	return TRUE;
+}
+
+METHOD(public_key_t, get_fingerprint, bool,
+	private_curve25519_public_key_t *this, cred_encoding_type_t type,
+	chunk_t *fingerprint)
+{
+	return curve25519_public_key_fingerprint(chunk_from_thing(this->key),
+											 type, fingerprint);
+}
+
+METHOD(public_key_t, get_encoding, bool,
+	private_curve25519_public_key_t *this, cred_encoding_type_t type,
+	chunk_t *encoding)
+{
+	bool success = TRUE;
+
+	switch (type)
+	{
+		case PUBKEY_SPKI_ASN1_DER:
+		case PUBKEY_PEM:
+			*encoding = curve25519_public_key_info_encode(
+											chunk_from_thing(this->key));
+			if (type == PUBKEY_PEM)
+			{
+				chunk_t asn1_encoding = *encoding;
+
+				success = lib->encoding->encode(lib->encoding, PUBKEY_PEM,
+								NULL, encoding, CRED_PART_EDDSA_PUB_ASN1_DER,
+								asn1_encoding, CRED_PART_END);
+				chunk_free(&asn1_encoding);
+			}
+			return success;
+		default:
+			return FALSE;
+	}
+}
+
+METHOD(public_key_t, get_ref, public_key_t*,
+	private_curve25519_public_key_t *this)
+{
+	ref_get(&this->ref);
+	return &this->public.key;
+}
+
+METHOD(public_key_t, destroy, void,
+	private_curve25519_public_key_t *this)
+{
+	if (ref_put(&this->ref))
+	{
+		lib->encoding->clear_cache(lib->encoding, this->key);
+		free(this);
+	}
+}
+
+/**
+ * Extract the raw key from a subjectPublicKeyInfo
+ */
+static bool parse_public_key_info(chunk_t blob, chunk_t *key)
+{
+	chunk_t spki, algid, oid;
+
+	if (asn1_unwrap(&blob, &spki) != ASN1_SEQUENCE ||
+		asn1_unwrap(&spki, &algid) != ASN1_SEQUENCE ||
+		asn1_unwrap(&algid, &oid) != ASN1_OID ||
+		asn1_known_oid(oid) != OID_ED25519 || algid.len ||
+		asn1_unwrap(&spki, key) != ASN1_BIT_STRING ||
+		key->len != CURVE25519_KEY_SIZE + 1 || key->ptr[0] != 0x00)
+	{
+		return FALSE;
+	}
+	/* skip the number of unused bits */
+	*key = chunk_skip(*key, 1);
+	return TRUE;
+}
+
+/**
+ * See header.
+ */
+curve25519_public_key_t *curve25519_public_key_load(key_type_t type,
+													va_list args)
+{
+	private_curve25519_public_key_t *this;
+	chunk_t blob = chunk_empty, pub = chunk_empty;
+
+	while (TRUE)
+	{
+		switch (va_arg(args, builder_part_t))
+		{
+			case BUILD_BLOB_ASN1_DER:
+				blob = va_arg(args, chunk_t);
+				continue;
+			case BUILD_EDDSA_PUB:
+				pub = va_arg(args, chunk_t);
+				continue;
+			case BUILD_END:
+				break;
+			default:
+				return NULL;
+		}
+		break;
+	}
+	if (blob.len && !parse_public_key_info(blob, &pub))
+	{
+		return NULL;
+	}
+	if (pub.len != CURVE25519_KEY_SIZE)
+	{
+		return NULL;
+	}
+
+	INIT(this,
+		.public = {
+			.key = {
+				.get_type = _get_type,
+				.verify = _verify,
+				.encrypt = _encrypt,
+				.equals = public_key_equals,
+				.get_keysize = _get_keysize,
+				.get_fingerprint = _get_fingerprint,
+				.has_fingerprint = public_key_has_fingerprint,
+				.get_encoding = _get_encoding,
+				.get_ref = _get_ref,
+				.destroy = _destroy,
+			},
+		},
+		.ref = 1,
+	);
+	memcpy(this->key, pub.ptr, sizeof(this->key));
+
+	return &this->public;
+}
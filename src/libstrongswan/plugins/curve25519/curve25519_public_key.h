@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2013 Hochschule fuer Technik Rapperswil
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.  See <http://www.fsf.org/copyleft/gpl.txt>.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+
+/**
+ * @defgroup curve25519_public_key curve25519_public_key
+ * @{ @ingroup curve25519_p
+ */
+
+#ifndef CURVE25519_PUBLIC_KEY_H_
+#define CURVE25519_PUBLIC_KEY_H_
+
+#include <credentials/builder.h>
+#include <credentials/cred_encoding.h>
+#include <credentials/keys/public_key.h>
+
+typedef struct curve25519_public_key_t curve25519_public_key_t;
+
+/**
+ * public_key_t implementation of Ed25519 signature verification.
+ */
+struct curve25519_public_key_t {
+
+	/**
+	 * Implements the public_key_t interface
+	 */
+	public_key_t key;
+};
+
+/**
+ * Load an Ed25519 public key.
+ *
+ * Accepts a BUILD_BLOB_ASN1_DER argument containing a subjectPublicKeyInfo,
+ * or a BUILD_EDDSA_PUB argument containing the raw 32 byte key.
+ *
+ * @param type		type of the key, must be KEY_ED25519
+ * @param args		builder_part_t argument list
+ * @return 			loaded key, NULL on failure
+ */
+curve25519_public_key_t *curve25519_public_key_load(key_type_t type,
+													va_list args);
+
+/**
+ * Encode a raw Ed25519 public key as subjectPublicKeyInfo.
+ *
+ * @param pubkey	raw 32 byte public key
+ * @return			allocated DER encoding
+ */
+chunk_t curve25519_public_key_info_encode(chunk_t pubkey);
+
+/**
+ * Generate a fingerprint of a raw Ed25519 public key.
+ *
+ * @param pubkey	raw 32 byte public key
+ * @param type		type of fingerprint, KEYID_PUBKEY_*
+ * @param fp		fingerprint, not allocated, cached
+ * @return			TRUE if fingerprint generated
+ */
+bool curve25519_public_key_fingerprint(chunk_t pubkey,
+									   cred_encoding_type_t type, chunk_t *fp);
+
+#endif /** CURVE25519_PUBLIC_KEY_H_ @}*/
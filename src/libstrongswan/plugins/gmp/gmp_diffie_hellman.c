@@ -22,12 +22,22 @@
 #include "gmp_diffie_hellman.h"
 
 #include <utils/debug.h>
+#include <threading/mutex.h>
+#include <collections/linked_list.h>
 
 #ifdef HAVE_MPZ_POWM_SEC
 # undef mpz_powm
 # define mpz_powm mpz_powm_sec
 #endif
 
+/**
+ * The side-channel silent mpn_sec functions used for fixed-base
+ * exponentiation are available since GMP 6
+ */
+#if __GNU_MP_VERSION >= 6
+# define HAVE_FIXED_BASE
+#endif
+
 typedef struct private_gmp_diffie_hellman_t private_gmp_diffie_hellman_t;
 
 /**
@@ -85,6 +95,352 @@ struct private_gmp_diffie_hellman_t {
 	bool computed;
 };
 
+#ifdef HAVE_FIXED_BASE
+
+typedef struct comb_t comb_t;
+
+/**
+ * Precomputed table for fixed-base exponentiation of a DH group.
+ *
+ * The exponent is written as a matrix of rows x cols bits, row i holding
+ * bits i*cols to (i+1)*cols-1. The table holds the 2^rows products of
+ * g^(2^(i*cols)) selected by the bits of the table index, so g^x is
+ * computed with cols squarings and multiplications (Lim/Lee comb). Values
+ * are kept in Montgomery representation.
+ */
+struct comb_t {
+
+	/**
+	 * DH group this table is for
+	 */
+	diffie_hellman_group_t group;
+
+	/**
+	 * Number of limbs of the modulus
+	 */
+	mp_size_t n;
+
+	/**
+	 * Modulus p, n limbs
+	 */
+	mp_limb_t *p;
+
+	/**
+	 * -p^-1 mod 2^GMP_NUMB_BITS
+	 */
+	mp_limb_t pinv;
+
+	/**
+	 * Number of comb rows, the table has 2^rows entries
+	 */
+	int rows;
+
+	/**
+	 * Number of comb columns
+	 */
+	int cols;
+
+	/**
+	 * Table of 2^rows entries with n limbs each
+	 */
+	mp_limb_t *table;
+};
+
+/**
+ * Tables built so far, as comb_t
+ */
+static linked_list_t *combs;
+
+/**
+ * Mutex to lock tables
+ */
+static mutex_t *comb_mutex;
+
+/**
+ * Montgomery reduction of the 2n limbs in up, which get overwritten.
+ * Returns the carry of the n limbs written to rp.
+ */
+static mp_limb_t redc(comb_t *c, mp_limb_t *rp, mp_limb_t *up)
+{
+	mp_limb_t q;
+	mp_size_t j;
+
+	for (j = 0; j < c->n; j++)
+	{	/* store carries in the limbs eliminated, and add them at the end */
+		q = up[0] * c->pinv;
+		up[0] = mpn_addmul_1(up, c->p, c->n, q);
+		up++;
+	}
+	return mpn_add_n(rp, up, up - c->n, c->n);
+}
+
+/**
+ * Montgomery multiplication, rp = ap * bp / R, all values < R
+ */
+static void mont_mul(comb_t *c, mp_limb_t *rp, mp_limb_t *ap, mp_limb_t *bp,
+					 mp_limb_t *tp)
+{
+	mp_limb_t cy;
+
+	mpn_sec_mul(tp, ap, c->n, bp, c->n, tp + 2 * c->n);
+	cy = redc(c, rp, tp);
+	mpn_cnd_sub_n(cy, rp, rp, c->p, c->n);
+}
+
+/**
+ * Montgomery squaring, rp = ap * ap / R, all values < R
+ */
+static void mont_sqr(comb_t *c, mp_limb_t *rp, mp_limb_t *ap, mp_limb_t *tp)
+{
+	mp_limb_t cy;
+
+	mpn_sec_sqr(tp, ap, c->n, tp + 2 * c->n);
+	cy = redc(c, rp, tp);
+	mpn_cnd_sub_n(cy, rp, rp, c->p, c->n);
+}
+
+/**
+ * Export the n least significant limbs of an mpz, zero padded
+ */
+static void export_limbs(mpz_t x, mp_limb_t *rp, mp_size_t n)
+{
+	mp_size_t i;
+
+	for (i = 0; i < n; i++)
+	{
+		rp[i] = mpz_getlimbn(x, i);
+	}
+}
+
+/**
+ * Build the table for a group, for exponents up to the size of p
+ */
+static comb_t *comb_create(diffie_hellman_group_t group, mpz_t g, mpz_t p)
+{
+	size_t exp_bits = mpz_sizeinbase(p, 2);
+	comb_t *c;
+	mpz_t base[8], entry;
+	mp_limb_t inv;
+	int i, j, low;
+
+	INIT(c,
+		.group = group,
+		.n = mpz_size(p),
+	);
+	/* tabselect reads the whole table for every column, larger tables pay
+	 * off for larger moduli only */
+	c->rows = c->n <= 32 ? 6 : (c->n <= 64 ? 7 : 8);
+	c->cols = (exp_bits + c->rows - 1) / c->rows;
+	c->p = malloc(c->n * sizeof(mp_limb_t));
+	c->table = malloc((1 << c->rows) * c->n * sizeof(mp_limb_t));
+	export_limbs(p, c->p, c->n);
+
+	/* Newton iteration for p^-1 mod 2^GMP_NUMB_BITS, p is odd */
+	inv = 1;
+	for (i = 0; i < 7; i++)
+	{
+		inv *= 2 - c->p[0] * inv;
+	}
+	c->pinv = -inv;
+
+	/* base[i] = g^(2^(i*cols)) mod p */
+	mpz_init_set(base[0], g);
+	for (i = 1; i < c->rows; i++)
+	{
+		mpz_init(base[i]);
+		mpz_powm_ui(base[i], base[i-1], 2, p);
+		for (j = 1; j < c->cols; j++)
+		{
+			mpz_powm_ui(base[i], base[i], 2, p);
+		}
+	}
+	mpz_init(entry);
+	for (i = 0; i < (1 << c->rows); i++)
+	{
+		mpz_set_ui(entry, 1);
+		for (j = 0, low = i; low; j++, low >>= 1)
+		{
+			if (low & 1)
+			{
+				mpz_mul(entry, entry, base[j]);
+				mpz_mod(entry, entry, p);
+			}
+		}
+		/* convert to Montgomery representation */
+		mpz_mul_2exp(entry, entry, c->n * GMP_NUMB_BITS);
+		mpz_mod(entry, entry, p);
+		export_limbs(entry, c->table + i * c->n, c->n);
+	}
+	mpz_clear(entry);
+	for (i = 0; i < c->rows; i++)
+	{
+		mpz_clear(base[i]);
+	}
+	DBG2(DBG_LIB, "built %d x %d bit DH comb table for %N", c->rows, c->cols,
+		 diffie_hellman_group_names, group);
+	return c;
+}
+
+/**
+ * Destroy a comb_t
+ */
+static void comb_destroy(comb_t *c)
+{
+	free(c->table);
+	free(c->p);
+	free(c);
+}
+
+/**
+ * Get the table for a group, built on first use
+ */
+static comb_t *comb_get(diffie_hellman_group_t group, mpz_t g, mpz_t p,
+						size_t exp_bits)
+{
+	enumerator_t *enumerator;
+	comb_t *c, *found = NULL;
+
+	if (!combs)
+	{	/* the plugin is not initialized */
+		return NULL;
+	}
+	comb_mutex->lock(comb_mutex);
+	enumerator = combs->create_enumerator(combs);
+	while (enumerator->enumerate(enumerator, &c))
+	{
+		if (c->group == group)
+		{
+			found = c;
+			break;
+		}
+	}
+	enumerator->destroy(enumerator);
+	if (!found)
+	{
+		found = comb_create(group, g, p);
+		combs->insert_last(combs, found);
+	}
+	comb_mutex->unlock(comb_mutex);
+
+	if (found->rows * found->cols < exp_bits)
+	{
+		return NULL;
+	}
+	return found;
+}
+
+/**
+ * Compute r = g^x mod p using the comb of a group, in constant time
+ */
+static void comb_powm(comb_t *c, mpz_t r, mpz_t x)
+{
+	mp_limb_t *xp, *rp, *sel, *tp;
+	mp_size_t xn, tn;
+	int i, k, bit;
+	u_int index;
+
+	xn = (c->rows * c->cols + GMP_NUMB_BITS - 1) / GMP_NUMB_BITS;
+	tn = 2 * c->n + max(mpn_sec_mul_itch(c->n, c->n), mpn_sec_sqr_itch(c->n));
+	xp = malloc(xn * sizeof(mp_limb_t));
+	rp = malloc(c->n * sizeof(mp_limb_t));
+	sel = malloc(c->n * sizeof(mp_limb_t));
+	tp = malloc(tn * sizeof(mp_limb_t));
+	export_limbs(x, xp, xn);
+
+	/* table entry 0 is 1 in Montgomery representation */
+	memcpy(rp, c->table, c->n * sizeof(mp_limb_t));
+	for (k = c->cols - 1; k >= 0; k--)
+	{
+		mont_sqr(c, rp, rp, tp);
+		for (i = 0, index = 0; i < c->rows; i++)
+		{
+			bit = i * c->cols + k;
+			index |= ((xp[bit / GMP_NUMB_BITS] >> (bit % GMP_NUMB_BITS)) & 1) << i;
+		}
+		mpn_sec_tabselect(sel, c->table, c->n, 1 << c->rows, index);
+		mont_mul(c, rp, rp, sel, tp);
+	}
+
+	/* convert back from Montgomery representation and reduce fully */
+	memcpy(tp, rp, c->n * sizeof(mp_limb_t));
+	memset(tp + c->n, 0, c->n * sizeof(mp_limb_t));
+	redc(c, rp, tp);
+	mpn_cnd_sub_n(mpn_sub_n(sel, rp, c->p, c->n) == 0, rp, rp, c->p, c->n);
+	mpz_import(r, c->n, -1, sizeof(mp_limb_t), 0, 0, rp);
+
+	memwipe(xp, xn * sizeof(mp_limb_t));
+	memwipe(tp, tn * sizeof(mp_limb_t));
+	memwipe(sel, c->n * sizeof(mp_limb_t));
+	free(xp);
+	free(rp);
+	free(sel);
+	free(tp);
+}
+
+/**
+ * See header
+ */
+void gmp_diffie_hellman_init()
+{
+	combs = linked_list_create();
+	comb_mutex = mutex_create(MUTEX_TYPE_DEFAULT);
+}
+
+/**
+ * See header
+ */
+void gmp_diffie_hellman_deinit()
+{
+	if (combs)
+	{
+		combs->destroy_function(combs, (void*)comb_destroy);
+		comb_mutex->destroy(comb_mutex);
+		combs = NULL;
+	}
+}
+
+#else /* !HAVE_FIXED_BASE */
+
+void gmp_diffie_hellman_init()
+{
+}
+
+void gmp_diffie_hellman_deinit()
+{
+}
+
+#endif /* HAVE_FIXED_BASE */
+
+/**
+ * Compute our public value ya = g^xa mod p, for an exponent of exp_bits
+ */
+static void compute_public(private_gmp_diffie_hellman_t *this, size_t exp_bits)
+{
+#ifdef HAVE_FIXED_BASE
+	if (this->group != MODP_CUSTOM && mpz_odd_p(this->p))
+	{
+		comb_t *comb;
+
+		comb = comb_get(this->group, this->g, this->p, exp_bits);
+		if (comb)
+		{
+			comb_powm(comb, this->ya, this->xa);
+			return;
+		}
+	}
+#endif /* HAVE_FIXED_BASE */
+	mpz_powm(this->ya, this->g, this->xa, this->p);
+}
+
+METHOD(diffie_hellman_t, set_private_value, bool,
+	private_gmp_diffie_hellman_t *this, chunk_t value)
+{
+	mpz_import(this->xa, value.len, 1, 1, 1, 0, value.ptr);
+	compute_public(this, value.len * 8);
+	this->computed = FALSE;
+	return TRUE;
+}
+
 METHOD(diffie_hellman_t, set_other_public_value, void,
 	private_gmp_diffie_hellman_t *this, chunk_t value)
 {
@@ -204,6 +560,7 @@ static gmp_diffie_hellman_t *create_generic(diffie_hellman_group_t group,
 			.dh = {
 				.get_shared_secret = _get_shared_secret,
 				.set_other_public_value = _set_other_public_value,
+				.set_private_value = _set_private_value,
 				.get_my_public_value = _get_my_public_value,
 				.get_dh_group = _get_dh_group,
 				.destroy = _destroy,
@@ -249,7 +606,7 @@ static gmp_diffie_hellman_t *create_generic(diffie_hellman_group_t group,
 	DBG2(DBG_LIB, "size of DH secret exponent: %u bits",
 		 mpz_sizeinbase(this->xa, 2));
 
-	mpz_powm(this->ya, this->g, this->xa, this->p);
+	compute_public(this, exp_len * 8);
 
 	return &this->public;
 }
@@ -56,5 +56,15 @@ gmp_diffie_hellman_t *gmp_diffie_hellman_create(diffie_hellman_group_t group);
 gmp_diffie_hellman_t *gmp_diffie_hellman_create_custom(
 							diffie_hellman_group_t group, chunk_t g, chunk_t p);
 
+/**
+ * Initialize the fixed-base exponentiation tables, built lazily per group.
+ */
+void gmp_diffie_hellman_init();
+
+/**
+ * Release the fixed-base exponentiation tables.
+ */
+void gmp_diffie_hellman_deinit();
+
 #endif /** GMP_DIFFIE_HELLMAN_H_ @}*/
 
@@ -24,6 +24,7 @@
 #include <threading/thread_value.h>
 #include <threading/mutex.h>
 #include <collections/linked_list.h>
+#include <collections/hashtable.h>
 
 /* Older mysql.h headers do not define it, but we need it. It is not returned
  * in in MySQL 4 by default, but by MySQL 5. To avoid this problem, we catch
@@ -32,6 +33,11 @@
 #define MYSQL_DATA_TRUNCATED 101
 #endif
 
+/**
+ * Maximum number of prepared statements to cache per connection
+ */
+#define MAX_CACHED_STATEMENTS 32
+
 typedef struct private_mysql_database_t private_mysql_database_t;
 
 /**
@@ -78,6 +84,11 @@ struct private_mysql_database_t {
 	 * tcp port
 	 */
 	int port;
+
+	/**
+	 * transaction of the current thread, transaction_t
+	 */
+	thread_value_t *transaction;
 };
 
 typedef struct conn_t conn_t;
@@ -96,14 +107,47 @@ struct conn_t {
 	 * connection in use?
 	 */
 	bool in_use;
+
+	/**
+	 * prepared statements not currently in use, stmt_entry_t indexed by SQL
+	 */
+	hashtable_t *stmts;
 };
 
 /**
- * Release a mysql connection
+ * A prepared statement, along with the SQL string it got prepared from
  */
-static void conn_release(conn_t *conn)
+typedef struct {
+	/** SQL string, key in the statement cache */
+	char *sql;
+	/** prepared MySQL statement */
+	MYSQL_STMT *stmt;
+} stmt_entry_t;
+
+/**
+ * Database transaction of a thread
+ */
+typedef struct {
+	/** connection the transaction runs on, reserved for the thread */
+	conn_t *conn;
+	/** number of nested transactions */
+	u_int refs;
+	/** TRUE if one of the nested transactions has been rolled back */
+	bool rollback;
+} transaction_t;
+
+/**
+ * Release a mysql connection, unless it is used by a transaction
+ */
+static void conn_release(private_mysql_database_t *this, conn_t *conn)
 {
-	conn->in_use = FALSE;
+	transaction_t *trans;
+
+	trans = this->transaction->get(this->transaction);
+	if (!trans || trans->conn != conn)
+	{
+		conn->in_use = FALSE;
+	}
 }
 
 /**
@@ -146,11 +190,48 @@ void mysql_database_deinit()
 	mysql_library_end();
 }
 
+/**
+ * Hash an SQL string
+ */
+static u_int hash(char *key)
+{
+	return chunk_hash(chunk_create(key, strlen(key)));
+}
+
+/**
+ * Compare SQL strings
+ */
+static bool equals(char *a, char *b)
+{
+	return streq(a, b);
+}
+
+/**
+ * Destroy a statement entry, closing the statement
+ */
+static void stmt_entry_destroy(stmt_entry_t *entry)
+{
+	mysql_stmt_close(entry->stmt);
+	free(entry->sql);
+	free(entry);
+}
+
 /**
  * Destroy a mysql connection
  */
 static void conn_destroy(conn_t *this)
 {
+	enumerator_t *enumerator;
+	stmt_entry_t *entry;
+	char *sql;
+
+	enumerator = this->stmts->create_enumerator(this->stmts);
+	while (enumerator->enumerate(enumerator, &sql, &entry))
+	{
+		stmt_entry_destroy(entry);
+	}
+	enumerator->destroy(enumerator);
+	this->stmts->destroy(this->stmts);
 	mysql_close(this->mysql);
 	free(this);
 }
@@ -162,6 +243,13 @@ static conn_t *conn_get(private_mysql_database_t *this)
 {
 	conn_t *current, *found = NULL;
 	enumerator_t *enumerator;
+	transaction_t *trans;
+
+	trans = this->transaction->get(this->transaction);
+	if (trans)
+	{
+		return trans->conn;
+	}
 
 	thread_initialize();
 
@@ -197,9 +285,12 @@ static conn_t *conn_get(private_mysql_database_t *this)
 	}
 	if (found == NULL)
 	{
-		found = malloc_thing(conn_t);
-		found->in_use = TRUE;
-		found->mysql = mysql_init(NULL);
+		INIT(found,
+			.in_use = TRUE,
+			.mysql = mysql_init(NULL),
+			.stmts = hashtable_create((hashtable_hash_t)hash,
+									  (hashtable_equals_t)equals, 8),
+		);
 		if (!mysql_real_connect(found->mysql, this->host, this->username,
 								this->password, this->database, this->port,
 								NULL, 0))
@@ -223,18 +314,23 @@ static conn_t *conn_get(private_mysql_database_t *this)
 }
 
 /**
- * Create and run a MySQL stmt using a sql string and args
+ * Get a prepared statement from the cache of a connection, or prepare one
  */
-static MYSQL_STMT* run(MYSQL *mysql, char *sql, va_list *args)
+static stmt_entry_t* get_stmt(conn_t *conn, char *sql)
 {
+	stmt_entry_t *entry;
 	MYSQL_STMT *stmt;
-	int params;
 
-	stmt = mysql_stmt_init(mysql);
+	entry = conn->stmts->remove(conn->stmts, sql);
+	if (entry)
+	{
+		return entry;
+	}
+	stmt = mysql_stmt_init(conn->mysql);
 	if (stmt == NULL)
 	{
 		DBG1(DBG_LIB, "creating MySQL statement failed: %s",
-			 mysql_error(mysql));
+			 mysql_error(conn->mysql));
 		return NULL;
 	}
 	if (mysql_stmt_prepare(stmt, sql, strlen(sql)))
@@ -244,6 +340,44 @@ static MYSQL_STMT* run(MYSQL *mysql, char *sql, va_list *args)
 		mysql_stmt_close(stmt);
 		return NULL;
 	}
+	INIT(entry,
+		.sql = strdup(sql),
+		.stmt = stmt,
+	);
+	return entry;
+}
+
+/**
+ * Reset a prepared statement and return it to the cache, if possible
+ */
+static void release_stmt(conn_t *conn, stmt_entry_t *entry)
+{
+	mysql_stmt_free_result(entry->stmt);
+	if (mysql_stmt_reset(entry->stmt) == 0 &&
+		conn->stmts->get_count(conn->stmts) < MAX_CACHED_STATEMENTS &&
+		!conn->stmts->get(conn->stmts, entry->sql))
+	{
+		conn->stmts->put(conn->stmts, entry->sql, entry);
+		return;
+	}
+	stmt_entry_destroy(entry);
+}
+
+/**
+ * Create and run a MySQL stmt using a sql string and args
+ */
+static stmt_entry_t* run(conn_t *conn, char *sql, va_list *args)
+{
+	stmt_entry_t *entry;
+	MYSQL_STMT *stmt;
+	int params;
+
+	entry = get_stmt(conn, sql);
+	if (!entry)
+	{
+		return NULL;
+	}
+	stmt = entry->stmt;
 	params = mysql_stmt_param_count(stmt);
 	if (params > 0)
 	{
@@ -307,7 +441,7 @@ static MYSQL_STMT* run(MYSQL *mysql, char *sql, va_list *args)
 				}
 				default:
 					DBG1(DBG_LIB, "invalid data type supplied");
-					mysql_stmt_close(stmt);
+					release_stmt(conn, entry);
 					return NULL;
 			}
 		}
@@ -315,7 +449,7 @@ static MYSQL_STMT* run(MYSQL *mysql, char *sql, va_list *args)
 		{
 			DBG1(DBG_LIB, "binding MySQL param failed: %s",
 				 mysql_stmt_error(stmt));
-			mysql_stmt_close(stmt);
+			release_stmt(conn, entry);
 			return NULL;
 		}
 	}
@@ -323,10 +457,59 @@ static MYSQL_STMT* run(MYSQL *mysql, char *sql, va_list *args)
 	{
 		DBG1(DBG_LIB, "executing MySQL statement failed: %s",
 			 mysql_stmt_error(stmt));
-		mysql_stmt_close(stmt);
+		release_stmt(conn, entry);
 		return NULL;
 	}
-	return stmt;
+	return entry;
+}
+
+/**
+ * Bind the value at index row of an argument array of the given type
+ */
+static bool bind_array(MYSQL_BIND *bind, db_type_t type, u_int row,
+					   va_list *args)
+{
+	switch (type)
+	{
+		case DB_INT:
+			bind->buffer_type = MYSQL_TYPE_LONG;
+			bind->buffer = (char*)&va_arg(*args, int*)[row];
+			bind->buffer_length = sizeof(int);
+			return TRUE;
+		case DB_UINT:
+			bind->buffer_type = MYSQL_TYPE_LONG;
+			bind->buffer = (char*)&va_arg(*args, u_int*)[row];
+			bind->buffer_length = sizeof(u_int);
+			bind->is_unsigned = TRUE;
+			return TRUE;
+		case DB_TEXT:
+			bind->buffer_type = MYSQL_TYPE_STRING;
+			bind->buffer = va_arg(*args, char**)[row];
+			if (bind->buffer)
+			{
+				bind->buffer_length = strlen(bind->buffer);
+			}
+			return TRUE;
+		case DB_BLOB:
+		{
+			chunk_t chunk = va_arg(*args, chunk_t*)[row];
+			bind->buffer_type = MYSQL_TYPE_BLOB;
+			bind->buffer = chunk.ptr;
+			bind->buffer_length = chunk.len;
+			return TRUE;
+		}
+		case DB_DOUBLE:
+			bind->buffer_type = MYSQL_TYPE_DOUBLE;
+			bind->buffer = (char*)&va_arg(*args, double*)[row];
+			bind->buffer_length = sizeof(double);
+			return TRUE;
+		case DB_NULL:
+			bind->buffer_type = MYSQL_TYPE_NULL;
+			return TRUE;
+		default:
+			DBG1(DBG_LIB, "invalid data type supplied");
+			return FALSE;
+	}
 }
 
 typedef struct {
@@ -334,10 +517,14 @@ typedef struct {
 	enumerator_t public;
 	/** associated MySQL statement */
 	MYSQL_STMT *stmt;
+	/** statement cache entry of stmt */
+	stmt_entry_t *entry;
 	/** result bindings */
 	MYSQL_BIND *bind;
 	/** pooled connection handle */
 	conn_t *conn;
+	/** back reference to parent */
+	private_mysql_database_t *database;
 	/** value for INT, UINT, double */
 	union {
 		void *p_void;;
@@ -372,8 +559,8 @@ static void mysql_enumerator_destroy(mysql_enumerator_t *this)
 				break;
 		}
 	}
-	mysql_stmt_close(this->stmt);
-	conn_release(this->conn);
+	release_stmt(this->conn, this->entry);
+	conn_release(this->database, this->conn);
 	free(this->bind);
 	free(this->val.p_void);
 	free(this->length);
@@ -479,6 +666,7 @@ static bool mysql_enumerator_enumerate(mysql_enumerator_t *this, ...)
 METHOD(database_t, query, enumerator_t*,
 	private_mysql_database_t *this, char *sql, ...)
 {
+	stmt_entry_t *entry;
 	MYSQL_STMT *stmt;
 	va_list args;
 	mysql_enumerator_t *enumerator = NULL;
@@ -491,16 +679,19 @@ METHOD(database_t, query, enumerator_t*,
 	}
 
 	va_start(args, sql);
-	stmt = run(conn->mysql, sql, &args);
-	if (stmt)
+	entry = run(conn, sql, &args);
+	if (entry)
 	{
 		int columns, i;
 
+		stmt = entry->stmt;
 		enumerator = malloc_thing(mysql_enumerator_t);
 		enumerator->public.enumerate = (void*)mysql_enumerator_enumerate;
 		enumerator->public.destroy = (void*)mysql_enumerator_destroy;
 		enumerator->stmt = stmt;
+		enumerator->entry = entry;
 		enumerator->conn = conn;
+		enumerator->database = this;
 		columns = mysql_stmt_field_count(stmt);
 		enumerator->bind = calloc(columns, sizeof(MYSQL_BIND));
 		enumerator->length = calloc(columns, sizeof(unsigned long));
@@ -557,7 +748,7 @@ METHOD(database_t, query, enumerator_t*,
 	}
 	else
 	{
-		conn_release(conn);
+		conn_release(this, conn);
 	}
 	va_end(args);
 	return (enumerator_t*)enumerator;
@@ -566,7 +757,7 @@ METHOD(database_t, query, enumerator_t*,
 METHOD(database_t, execute, int,
 	private_mysql_database_t *this, int *rowid, char *sql, ...)
 {
-	MYSQL_STMT *stmt;
+	stmt_entry_t *entry;
 	va_list args;
 	conn_t *conn;
 	int affected = -1;
@@ -577,18 +768,178 @@ METHOD(database_t, execute, int,
 		return -1;
 	}
 	va_start(args, sql);
-	stmt = run(conn->mysql, sql, &args);
-	if (stmt)
+	entry = run(conn, sql, &args);
+	if (entry)
 	{
 		if (rowid)
 		{
-			*rowid = mysql_stmt_insert_id(stmt);
+			*rowid = mysql_stmt_insert_id(entry->stmt);
 		}
-		affected = mysql_stmt_affected_rows(stmt);
-		mysql_stmt_close(stmt);
+		affected = mysql_stmt_affected_rows(entry->stmt);
+		release_stmt(conn, entry);
 	}
 	va_end(args);
-	conn_release(conn);
+	conn_release(this, conn);
+	return affected;
+}
+
+METHOD(database_t, transaction, bool,
+	private_mysql_database_t *this)
+{
+	transaction_t *trans;
+	conn_t *conn;
+
+	trans = this->transaction->get(this->transaction);
+	if (trans)
+	{
+		trans->refs++;
+		return TRUE;
+	}
+	conn = conn_get(this);
+	if (!conn)
+	{
+		return FALSE;
+	}
+	if (mysql_query(conn->mysql, "START TRANSACTION"))
+	{
+		DBG1(DBG_LIB, "starting MySQL transaction failed: %s",
+			 mysql_error(conn->mysql));
+		conn_release(this, conn);
+		return FALSE;
+	}
+	/* the connection is reserved for this thread until the transaction is
+	 * committed or rolled back. As MySQL does not support multiple active
+	 * result sets, queries have to be completed before executing further
+	 * statements within the transaction. */
+	INIT(trans,
+		.conn = conn,
+		.refs = 1,
+	);
+	this->transaction->set(this->transaction, trans);
+	return TRUE;
+}
+
+/**
+ * Commit or rollback the current transaction, if it is the outermost one
+ */
+static bool finalize_transaction(private_mysql_database_t *this,
+								 bool rollback)
+{
+	transaction_t *trans;
+	bool success = TRUE;
+
+	trans = this->transaction->get(this->transaction);
+	if (!trans)
+	{
+		DBG1(DBG_LIB, "no database transaction found");
+		return FALSE;
+	}
+	if (--trans->refs == 0)
+	{
+		if (rollback || trans->rollback)
+		{
+			/* report a failed commit if a nested transaction rolled back */
+			success = rollback;
+			if (mysql_rollback(trans->conn->mysql))
+			{
+				DBG1(DBG_LIB, "rolling back MySQL transaction failed: %s",
+					 mysql_error(trans->conn->mysql));
+				success = FALSE;
+			}
+		}
+		else if (mysql_commit(trans->conn->mysql))
+		{
+			DBG1(DBG_LIB, "committing MySQL transaction failed: %s",
+				 mysql_error(trans->conn->mysql));
+			success = FALSE;
+		}
+		this->transaction->set(this->transaction, NULL);
+		conn_release(this, trans->conn);
+		free(trans);
+	}
+	else if (rollback)
+	{
+		trans->rollback = TRUE;
+	}
+	return success;
+}
+
+METHOD(database_t, commit, bool,
+	private_mysql_database_t *this)
+{
+	return finalize_transaction(this, FALSE);
+}
+
+METHOD(database_t, rollback, bool,
+	private_mysql_database_t *this)
+{
+	return finalize_transaction(this, TRUE);
+}
+
+METHOD(database_t, batch, int,
+	private_mysql_database_t *this, char *sql, u_int count, ...)
+{
+	stmt_entry_t *entry;
+	MYSQL_BIND *bind;
+	va_list args;
+	conn_t *conn;
+	int params, i, affected = 0;
+	bool success = TRUE;
+	u_int row;
+
+	if (!transaction(this))
+	{
+		return -1;
+	}
+	conn = conn_get(this);
+	entry = get_stmt(conn, sql);
+	if (!entry)
+	{
+		rollback(this);
+		return -1;
+	}
+	params = mysql_stmt_param_count(entry->stmt);
+	bind = alloca(sizeof(MYSQL_BIND) * params);
+	for (row = 0; row < count && success; row++)
+	{
+		memset(bind, 0, sizeof(MYSQL_BIND) * params);
+		va_start(args, count);
+		for (i = 0; i < params && success; i++)
+		{
+			success = bind_array(&bind[i], va_arg(args, db_type_t), row,
+								 &args);
+		}
+		va_end(args);
+		if (!success)
+		{
+			break;
+		}
+		if (params > 0 && mysql_stmt_bind_param(entry->stmt, bind))
+		{
+			DBG1(DBG_LIB, "binding MySQL param failed: %s",
+				 mysql_stmt_error(entry->stmt));
+			success = FALSE;
+			break;
+		}
+		if (mysql_stmt_execute(entry->stmt))
+		{
+			DBG1(DBG_LIB, "executing MySQL batch statement failed: %s",
+				 mysql_stmt_error(entry->stmt));
+			success = FALSE;
+			break;
+		}
+		affected += mysql_stmt_affected_rows(entry->stmt);
+	}
+	release_stmt(conn, entry);
+	if (!success)
+	{
+		rollback(this);
+		return -1;
+	}
+	if (!commit(this))
+	{
+		return -1;
+	}
 	return affected;
 }
 
@@ -603,6 +954,7 @@ METHOD(database_t, destroy, void,
 {
 	this->pool->destroy_function(this->pool, (void*)conn_destroy);
 	this->mutex->destroy(this->mutex);
+	this->transaction->destroy(this->transaction);
 	free(this->host);
 	free(this->username);
 	free(this->password);
@@ -676,6 +1028,10 @@ mysql_database_t *mysql_database_create(char *uri)
 			.db = {
 				.query = _query,
 				.execute = _execute,
+				.batch = _batch,
+				.transaction = _transaction,
+				.commit = _commit,
+				.rollback = _rollback,
 				.get_driver = _get_driver,
 				.destroy = _destroy,
 			},
@@ -689,6 +1045,7 @@ mysql_database_t *mysql_database_create(char *uri)
 	}
 	this->mutex = mutex_create(MUTEX_TYPE_DEFAULT);
 	this->pool = linked_list_create();
+	this->transaction = thread_value_create(free);
 
 	/* check connectivity */
 	conn = conn_get(this);
@@ -697,7 +1054,7 @@ mysql_database_t *mysql_database_create(char *uri)
 		destroy(this);
 		return NULL;
 	}
-	conn_release(conn);
+	conn_release(this, conn);
 	return &this->public;
 }
 
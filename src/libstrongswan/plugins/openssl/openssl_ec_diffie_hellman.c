@@ -273,6 +273,7 @@ openssl_ec_diffie_hellman_t *openssl_ec_diffie_hellman_create(diffie_hellman_gro
 			.dh = {
 				.get_shared_secret = _get_shared_secret,
 				.set_other_public_value = _set_other_public_value,
+				.set_private_value = (void*)return_false,
 				.get_my_public_value = _get_my_public_value,
 				.get_dh_group = _get_dh_group,
 				.destroy = _destroy,
@@ -37,6 +37,8 @@ bool pem_encoder_encode(cred_encoding_type_t type, chunk_t *encoding,
 			if (cred_encoding_args(args, CRED_PART_RSA_PUB_ASN1_DER,
 									&asn1, CRED_PART_END) ||
 				cred_encoding_args(args, CRED_PART_ECDSA_PUB_ASN1_DER,
+									&asn1, CRED_PART_END) ||
+				cred_encoding_args(args, CRED_PART_EDDSA_PUB_ASN1_DER,
 									&asn1, CRED_PART_END))
 			{
 				break;
@@ -86,6 +88,12 @@ bool pem_encoder_encode(cred_encoding_type_t type, chunk_t *encoding,
 				label ="EC PRIVATE KEY";
 				break;
 			}
+			if (cred_encoding_args(args, CRED_PART_EDDSA_PRIV_ASN1_DER,
+								   &asn1, CRED_PART_END))
+			{
+				label ="PRIVATE KEY";
+				break;
+			}
 			return FALSE;
 		case CERT_PEM:
 			if (cred_encoding_args(args, CRED_PART_X509_ASN1_DER,
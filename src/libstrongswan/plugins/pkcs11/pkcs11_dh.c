@@ -325,6 +325,7 @@ static private_pkcs11_dh_t *create_generic(diffie_hellman_group_t group,
 			.dh = {
 				.get_shared_secret = _get_shared_secret,
 				.set_other_public_value = _set_other_public_value,
+				.set_private_value = (void*)return_false,
 				.get_my_public_value = _get_my_public_value,
 				.get_dh_group = _get_dh_group,
 				.destroy = _destroy,
@@ -68,6 +68,9 @@ static private_key_t *parse_private_key(chunk_t blob)
 					case OID_EC_PUBLICKEY:
 						type = KEY_ECDSA;
 						break;
+					case OID_ED25519:
+						type = KEY_ED25519;
+						break;
 					default:
 						/* key type not supported */
 						goto end;
@@ -0,0 +1,242 @@
+/*
+ * Copyright (C) 2013 Hochschule fuer Technik Rapperswil
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.  See <http://www.fsf.org/copyleft/gpl.txt>.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+
+#include "random_drbg.h"
+
+#include <unistd.h>
+#include <errno.h>
+
+#include <utils/debug.h>
+#include <threading/thread.h>
+
+/**
+ * Output length of HMAC-SHA-256
+ */
+#define DRBG_OUTLEN 32
+
+/**
+ * Bytes of entropy input read from the random device (security strength)
+ */
+#define DRBG_ENTROPY 32
+
+/**
+ * Bytes of nonce read from the random device during instantiation
+ */
+#define DRBG_NONCE 16
+
+/**
+ * Maximum number of bytes generated per request, 2^19 bits
+ */
+#define DRBG_MAX_REQUEST 65536
+
+typedef struct private_random_drbg_t private_random_drbg_t;
+
+/**
+ * Private data of an random_drbg_t object.
+ */
+struct private_random_drbg_t {
+
+	/**
+	 * Public random_drbg_t interface.
+	 */
+	random_drbg_t public;
+
+	/**
+	 * HMAC-SHA-256
+	 */
+	prf_t *prf;
+
+	/**
+	 * Key of internal state
+	 */
+	u_int8_t key[DRBG_OUTLEN];
+
+	/**
+	 * Value of internal state
+	 */
+	u_int8_t value[DRBG_OUTLEN];
+
+	/**
+	 * Random device to read entropy input from
+	 */
+	int fd;
+
+	/**
+	 * Number of requests since last (re)seeding
+	 */
+	u_int counter;
+
+	/**
+	 * Number of requests after which we reseed
+	 */
+	u_int reseed;
+};
+
+/**
+ * Read entropy input from the random device
+ */
+static void read_entropy(private_random_drbg_t *this, size_t len,
+						 u_int8_t *buffer)
+{
+	ssize_t got;
+
+	while (len)
+	{
+		got = read(this->fd, buffer, len);
+		if (got <= 0)
+		{
+			DBG1(DBG_LIB, "reading from random FD %d failed: %s, retrying...",
+				 this->fd, strerror(errno));
+			sleep(1);
+			continue;
+		}
+		buffer += got;
+		len -= got;
+	}
+}
+
+/**
+ * Compute V = HMAC(K, V), the PRF is always keyed with K
+ */
+static bool update_value(private_random_drbg_t *this)
+{
+	return this->prf->get_bytes(this->prf, chunk_from_thing(this->value),
+								this->value);
+}
+
+/**
+ * HMAC_DRBG_Update(), data may be chunk_empty
+ */
+static bool update(private_random_drbg_t *this, chunk_t data)
+{
+	u_int8_t round = 0x00;
+
+	while (TRUE)
+	{
+		if (!this->prf->get_bytes(this->prf, chunk_from_thing(this->value),
+								  NULL) ||
+			!this->prf->get_bytes(this->prf, chunk_from_thing(round), NULL) ||
+			!this->prf->get_bytes(this->prf, data, this->key) ||
+			!this->prf->set_key(this->prf, chunk_from_thing(this->key)) ||
+			!update_value(this))
+		{
+			return FALSE;
+		}
+		if (!data.len || round++)
+		{
+			return TRUE;
+		}
+	}
+}
+
+/**
+ * (Re-)seed the DRBG, HMAC_DRBG_Reseed()
+ */
+static bool reseed(private_random_drbg_t *this)
+{
+	u_int8_t entropy[DRBG_ENTROPY];
+	bool success;
+
+	read_entropy(this, sizeof(entropy), entropy);
+	success = update(this, chunk_from_thing(entropy));
+	memwipe(entropy, sizeof(entropy));
+	this->counter = 0;
+	return success;
+}
+
+METHOD(random_drbg_t, generate, bool,
+	private_random_drbg_t *this, size_t len, u_int8_t *buffer)
+{
+	size_t request, done;
+
+	while (len)
+	{
+		if (this->counter >= this->reseed && !reseed(this))
+		{
+			return FALSE;
+		}
+		request = min(len, DRBG_MAX_REQUEST);
+		for (done = 0; done < request; done += DRBG_OUTLEN)
+		{
+			if (!update_value(this))
+			{
+				return FALSE;
+			}
+			memcpy(buffer + done, this->value, min(request - done, DRBG_OUTLEN));
+		}
+		if (!update(this, chunk_empty))
+		{
+			return FALSE;
+		}
+		this->counter++;
+		buffer += request;
+		len -= request;
+	}
+	return TRUE;
+}
+
+METHOD(random_drbg_t, destroy, void,
+	private_random_drbg_t *this)
+{
+	this->prf->destroy(this->prf);
+	memwipe(this, sizeof(*this));
+	free(this);
+}
+
+/**
+ * See header
+ */
+random_drbg_t *random_drbg_create(int fd, u_int reseed)
+{
+	private_random_drbg_t *this;
+	u_int8_t seed[DRBG_ENTROPY + DRBG_NONCE + sizeof(u_int) + sizeof(void*)];
+	u_int tid;
+	prf_t *prf;
+
+	prf = lib->crypto->create_prf(lib->crypto, PRF_HMAC_SHA2_256);
+	if (!prf)
+	{
+		return NULL;
+	}
+
+	INIT(this,
+		.public = {
+			.generate = _generate,
+			.destroy = _destroy,
+		},
+		.prf = prf,
+		.fd = fd,
+		.reseed = max(reseed, 1),
+	);
+	memset(this->value, 0x01, sizeof(this->value));
+	if (!prf->set_key(prf, chunk_from_thing(this->key)))
+	{
+		destroy(this);
+		return NULL;
+	}
+
+	/* entropy input and nonce, personalized with thread ID and instance */
+	read_entropy(this, DRBG_ENTROPY + DRBG_NONCE, seed);
+	tid = thread_current_id();
+	memcpy(seed + DRBG_ENTROPY + DRBG_NONCE, &tid, sizeof(tid));
+	memcpy(seed + DRBG_ENTROPY + DRBG_NONCE + sizeof(tid), &this, sizeof(this));
+	if (!update(this, chunk_from_thing(seed)))
+	{
+		memwipe(seed, sizeof(seed));
+		destroy(this);
+		return NULL;
+	}
+	memwipe(seed, sizeof(seed));
+	return &this->public;
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2013 Hochschule fuer Technik Rapperswil
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.  See <http://www.fsf.org/copyleft/gpl.txt>.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+
+/**
+ * @defgroup random_drbg random_drbg
+ * @{ @ingroup random_p
+ */
+
+#ifndef RANDOM_DRBG_H_
+#define RANDOM_DRBG_H_
+
+typedef struct random_drbg_t random_drbg_t;
+
+#include <library.h>
+
+/**
+ * HMAC_DRBG using HMAC-SHA-256 as specified in NIST SP 800-90A.
+ *
+ * The DRBG is seeded from a random device and reseeds itself after a
+ * configurable number of requests. An instance is not thread safe, the
+ * random plugin keeps one instance per thread.
+ */
+struct random_drbg_t {
+
+	/**
+	 * Generate pseudo random bytes.
+	 *
+	 * @param len		number of bytes to generate
+	 * @param buffer	buffer receiving generated bytes
+	 * @return			TRUE if bytes generated successfully
+	 */
+	bool (*generate)(random_drbg_t *this, size_t len, u_int8_t *buffer);
+
+	/**
+	 * Destroy a random_drbg_t.
+	 */
+	void (*destroy)(random_drbg_t *this);
+};
+
+/**
+ * Create and instantiate a random_drbg_t.
+ *
+ * @param fd		random device to read entropy input from
+ * @param reseed	number of requests after which the DRBG gets reseeded
+ * @return			random_drbg_t, NULL if HMAC-SHA-256 not supported
+ */
+random_drbg_t *random_drbg_create(int fd, u_int reseed);
+
+#endif /** RANDOM_DRBG_H_ @}*/
@@ -23,6 +23,7 @@
 
 #include <library.h>
 #include <utils/debug.h>
+#include <threading/thread_value.h>
 #include "random_rng.h"
 
 #ifndef DEV_RANDOM
@@ -50,6 +51,10 @@ struct private_random_plugin_t {
 static int dev_random = -1;
 /** /dev/urandom file descriptor */
 static int dev_urandom = -1;
+/** per-thread random_drbg_t instances, NULL if DRBG disabled */
+static thread_value_t *drbgs = NULL;
+/** number of requests after which DRBG instances reseed */
+static u_int drbg_reseed;
 
 /**
  * See header.
@@ -67,6 +72,37 @@ int random_plugin_get_dev_urandom()
 	return dev_urandom;
 }
 
+/**
+ * Destroy the DRBG instance of a terminating thread
+ */
+static void drbg_destroy(random_drbg_t *drbg)
+{
+	drbg->destroy(drbg);
+}
+
+/**
+ * See header.
+ */
+random_drbg_t *random_plugin_get_drbg()
+{
+	random_drbg_t *drbg;
+
+	if (!drbgs)
+	{
+		return NULL;
+	}
+	drbg = drbgs->get(drbgs);
+	if (!drbg)
+	{
+		drbg = random_drbg_create(dev_urandom, drbg_reseed);
+		if (drbg)
+		{
+			drbgs->set(drbgs, drbg);
+		}
+	}
+	return drbg;
+}
+
 /**
  * Open a random device file
  */
@@ -92,7 +128,10 @@ METHOD(plugin_t, get_features, int,
 {
 	static plugin_feature_t f[] = {
 		PLUGIN_REGISTER(RNG, random_rng_create),
+			PLUGIN_PROVIDE(RNG, RNG_WEAK),
+				PLUGIN_SDEPEND(PRF, PRF_HMAC_SHA2_256),
 			PLUGIN_PROVIDE(RNG, RNG_STRONG),
+				PLUGIN_SDEPEND(PRF, PRF_HMAC_SHA2_256),
 			PLUGIN_PROVIDE(RNG, RNG_TRUE),
 	};
 	*features = f;
@@ -102,6 +141,18 @@ METHOD(plugin_t, get_features, int,
 METHOD(plugin_t, destroy, void,
 	private_random_plugin_t *this)
 {
+	random_drbg_t *drbg;
+
+	if (drbgs)
+	{
+		drbg = drbgs->get(drbgs);
+		if (drbg)
+		{
+			drbg->destroy(drbg);
+		}
+		drbgs->destroy(drbgs);
+		drbgs = NULL;
+	}
 	if (dev_random != -1)
 	{
 		close(dev_random);
@@ -141,6 +192,13 @@ plugin_t *random_plugin_create()
 		destroy(this);
 		return NULL;
 	}
+	if (lib->settings->get_bool(lib->settings,
+						"libstrongswan.plugins.random.drbg", FALSE))
+	{
+		drbg_reseed = lib->settings->get_int(lib->settings,
+						"libstrongswan.plugins.random.drbg_reseed", 4096);
+		drbgs = thread_value_create((thread_cleanup_t)drbg_destroy);
+	}
 
 	return &this->public.plugin;
 }
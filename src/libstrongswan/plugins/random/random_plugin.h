@@ -26,10 +26,15 @@
 
 #include <plugins/plugin.h>
 
+#include "random_drbg.h"
+
 typedef struct random_plugin_t random_plugin_t;
 
 /**
  * Plugin implementing a RNG reading from /dev/[u]random.
+ *
+ * Weak and strong random bytes are generated by a per-thread HMAC_DRBG
+ * seeded from /dev/urandom, if enabled and HMAC-SHA-256 is available.
  */
 struct random_plugin_t {
 
@@ -49,4 +54,11 @@ int random_plugin_get_dev_random();
  */
 int random_plugin_get_dev_urandom();
 
+/**
+ * Get the DRBG instance of the calling thread, created on first use.
+ *
+ * @return			random_drbg_t, NULL if DRBG disabled or not available
+ */
+random_drbg_t *random_plugin_get_drbg();
+
 #endif /** RANDOM_PLUGIN_H_ @}*/
@@ -38,14 +38,29 @@ struct private_random_rng_t {
 	 * random device, depends on quality
 	 */
 	int fd;
+
+	/**
+	 * use the per-thread DRBG, if available
+	 */
+	bool drbg;
 };
 
 METHOD(rng_t, get_bytes, bool,
 	private_random_rng_t *this, size_t bytes, u_int8_t *buffer)
 {
+	random_drbg_t *drbg;
 	size_t done;
 	ssize_t got;
 
+	if (this->drbg)
+	{
+		drbg = random_plugin_get_drbg();
+		if (drbg)
+		{
+			return drbg->generate(drbg, bytes, buffer);
+		}
+	}
+
 	done = 0;
 
 	while (done < bytes)
@@ -66,7 +81,11 @@ METHOD(rng_t, allocate_bytes, bool,
 	private_random_rng_t *this, size_t bytes, chunk_t *chunk)
 {
 	*chunk = chunk_alloc(bytes);
-	get_bytes(this, chunk->len, chunk->ptr);
+	if (!get_bytes(this, chunk->len, chunk->ptr))
+	{
+		chunk_clear(chunk);
+		return FALSE;
+	}
 	return TRUE;
 }
 
@@ -102,6 +121,7 @@ random_rng_t *random_rng_create(rng_quality_t quality)
 		case RNG_WEAK:
 		default:
 			this->fd = random_plugin_get_dev_urandom();
+			this->drbg = TRUE;
 			break;
 	}
 
@@ -22,6 +22,14 @@
 
 #include "sha1_hasher.h"
 
+#include <utils/cpu_feature.h>
+#include <crypto/prfs/mac_prf.h>
+#include <crypto/signers/mac_signer.h>
+
+#ifdef HAVE_SHA_NI
+#include <immintrin.h>
+#endif
+
 /*
  * ugly macro stuff
  */
@@ -63,6 +71,86 @@ struct private_sha1_hasher_t {
 	u_int8_t buffer[64];
 };
 
+#ifdef HAVE_SHA_NI
+
+/**
+ * Use the SHA extensions of the CPU, if available
+ */
+static bool sha_ni = FALSE;
+
+/**
+ * Check if the CPU supports the SHA extensions
+ */
+static void check_sha_ni()
+{
+	sha_ni = cpu_feature_available(CPU_FEATURE_SHA | CPU_FEATURE_SSSE3 |
+								   CPU_FEATURE_SSE41);
+}
+
+/**
+ * Hash a single 512-bit block using the x86 SHA extensions
+ */
+__attribute__((target("sha,sse4.1")))
+static void SHA1TransformNI(u_int32_t state[5], const unsigned char buffer[64])
+{
+	__m128i abcd, abcd_save, e0, e1, e_save, w[4];
+	const __m128i mask = _mm_set_epi64x(0x0001020304050607ULL,
+										0x08090a0b0c0d0e0fULL);
+	int i;
+
+	abcd = _mm_shuffle_epi32(_mm_loadu_si128((__m128i*)state), 0x1B);
+	e0 = _mm_set_epi32(state[4], 0, 0, 0);
+	abcd_save = abcd;
+	e_save = e0;
+
+	/* 20 groups of 4 rounds each */
+	for (i = 0; i < 20; i++)
+	{
+		if (i < 4)
+		{
+			w[i] = _mm_shuffle_epi8(
+						_mm_loadu_si128((__m128i*)(buffer + i * 16)), mask);
+			e1 = i ? _mm_sha1nexte_epu32(e0, w[i]) : _mm_add_epi32(e0, w[i]);
+		}
+		else
+		{
+			w[i & 3] = _mm_sha1msg2_epu32(
+						_mm_xor_si128(_mm_sha1msg1_epu32(w[i & 3],
+												w[(i + 1) & 3]),
+									  w[(i + 2) & 3]),
+						w[(i + 3) & 3]);
+			e1 = _mm_sha1nexte_epu32(e0, w[i & 3]);
+		}
+		e0 = abcd;
+		switch (i / 5)
+		{	/* round function must be an immediate */
+			case 0:
+				abcd = _mm_sha1rnds4_epu32(abcd, e1, 0);
+				break;
+			case 1:
+				abcd = _mm_sha1rnds4_epu32(abcd, e1, 1);
+				break;
+			case 2:
+				abcd = _mm_sha1rnds4_epu32(abcd, e1, 2);
+				break;
+			default:
+				abcd = _mm_sha1rnds4_epu32(abcd, e1, 3);
+				break;
+		}
+	}
+
+	e0 = _mm_sha1nexte_epu32(e0, e_save);
+	abcd = _mm_add_epi32(abcd, abcd_save);
+	_mm_storeu_si128((__m128i*)state, _mm_shuffle_epi32(abcd, 0x1B));
+	state[4] = _mm_extract_epi32(e0, 3);
+}
+
+#else /* !HAVE_SHA_NI */
+
+#define check_sha_ni()
+
+#endif /* HAVE_SHA_NI */
+
 /*
  * Hash a single 512-bit block. This is the core of the algorithm. *
  */
@@ -74,6 +162,15 @@ static void SHA1Transform(u_int32_t state[5], const unsigned char buffer[64])
 		u_int32_t l[16];
 	} CHAR64LONG16;
 	CHAR64LONG16 block[1];  /* use array to appear as a pointer */
+
+#ifdef HAVE_SHA_NI
+	if (sha_ni)
+	{
+		SHA1TransformNI(state, buffer);
+		return;
+	}
+#endif /* HAVE_SHA_NI */
+
 	memcpy(block, buffer, 64);
 
 	/* Copy context->state[] to working vars */
@@ -239,6 +336,7 @@ sha1_hasher_t *sha1_hasher_create(hash_algorithm_t algo)
 	{
 		return NULL;
 	}
+	check_sha_ni();
 
 	INIT(this,
 		.public = {
@@ -258,3 +356,155 @@ sha1_hasher_t *sha1_hasher_create(hash_algorithm_t algo)
 	return &(this->public);
 }
 
+
+typedef struct private_sha1_hmac_t private_sha1_hmac_t;
+
+/**
+ * HMAC-SHA1 with precomputed inner and outer pad state
+ */
+struct private_sha1_hmac_t {
+
+	/**
+	 * Implements mac_t
+	 */
+	mac_t public;
+
+	/**
+	 * Hash state after processing the inner pad
+	 */
+	private_sha1_hasher_t inner;
+
+	/**
+	 * Hash state after processing the outer pad
+	 */
+	private_sha1_hasher_t outer;
+
+	/**
+	 * Current hash state
+	 */
+	private_sha1_hasher_t ctx;
+};
+
+METHOD(mac_t, get_mac, bool,
+	private_sha1_hmac_t *this, chunk_t data, u_int8_t *out)
+{
+	u_int8_t inner[HASH_SIZE_SHA1];
+
+	SHA1Update(&this->ctx, data.ptr, data.len);
+	if (out)
+	{
+		SHA1Final(&this->ctx, inner);
+		this->ctx = this->outer;
+		SHA1Update(&this->ctx, inner, sizeof(inner));
+		SHA1Final(&this->ctx, out);
+		this->ctx = this->inner;
+	}
+	return TRUE;
+}
+
+METHOD(mac_t, get_mac_size, size_t,
+	private_sha1_hmac_t *this)
+{
+	return HASH_SIZE_SHA1;
+}
+
+METHOD(mac_t, set_key, bool,
+	private_sha1_hmac_t *this, chunk_t key)
+{
+	u_int8_t pad[sizeof(this->ctx.buffer)];
+	int i;
+
+	memset(pad, 0, sizeof(pad));
+	if (key.len > sizeof(pad))
+	{
+		reset(&this->ctx);
+		SHA1Update(&this->ctx, key.ptr, key.len);
+		SHA1Final(&this->ctx, pad);
+	}
+	else
+	{
+		memcpy(pad, key.ptr, key.len);
+	}
+	for (i = 0; i < sizeof(pad); i++)
+	{
+		pad[i] ^= 0x36;
+	}
+	reset(&this->inner);
+	SHA1Update(&this->inner, pad, sizeof(pad));
+	for (i = 0; i < sizeof(pad); i++)
+	{
+		pad[i] ^= 0x36 ^ 0x5C;
+	}
+	reset(&this->outer);
+	SHA1Update(&this->outer, pad, sizeof(pad));
+	memwipe(pad, sizeof(pad));
+
+	this->ctx = this->inner;
+	return TRUE;
+}
+
+METHOD(mac_t, destroy_hmac, void,
+	private_sha1_hmac_t *this)
+{
+	memwipe(this, sizeof(*this));
+	free(this);
+}
+
+/**
+ * Create a HMAC-SHA1 mac_t
+ */
+static mac_t *hmac_create(hash_algorithm_t algo)
+{
+	private_sha1_hmac_t *this;
+
+	if (algo != HASH_SHA1)
+	{
+		return NULL;
+	}
+	check_sha_ni();
+
+	INIT(this,
+		.public = {
+			.get_mac = _get_mac,
+			.get_mac_size = _get_mac_size,
+			.set_key = _set_key,
+			.destroy = _destroy_hmac,
+		},
+	);
+	reset(&this->inner);
+	reset(&this->outer);
+	this->ctx = this->inner;
+
+	return &this->public;
+}
+
+/*
+ * Described in header.
+ */
+prf_t *sha1_hmac_prf_create(pseudo_random_function_t algo)
+{
+	mac_t *hmac;
+
+	hmac = hmac_create(hasher_algorithm_from_prf(algo));
+	if (hmac)
+	{
+		return mac_prf_create(hmac);
+	}
+	return NULL;
+}
+
+/*
+ * Described in header.
+ */
+signer_t *sha1_hmac_signer_create(integrity_algorithm_t algo)
+{
+	mac_t *hmac;
+	size_t trunc;
+
+	hmac = hmac_create(hasher_algorithm_from_integrity(algo, &trunc));
+	if (hmac)
+	{
+		return mac_signer_create(hmac, trunc);
+	}
+	return NULL;
+}
@@ -25,6 +25,8 @@
 typedef struct sha1_hasher_t sha1_hasher_t;
 
 #include <crypto/hashers/hasher.h>
+#include <crypto/prfs/prf.h>
+#include <crypto/signers/signer.h>
 
 /**
  * Implementation of hasher_t interface using the SHA1 algorithm.
@@ -45,4 +47,23 @@ struct sha1_hasher_t {
  */
 sha1_hasher_t *sha1_hasher_create(hash_algorithm_t algo);
 
+/**
+ * Creates a HMAC-SHA1 based prf_t.
+ *
+ * The hash state after processing the inner and outer key pads is computed
+ * once in set_key(), saving two compression function calls per message.
+ *
+ * @param algo		algorithm, must be PRF_HMAC_SHA1
+ * @return			prf_t object, NULL if not supported
+ */
+prf_t *sha1_hmac_prf_create(pseudo_random_function_t algo);
+
+/**
+ * Creates a HMAC-SHA1 based signer_t, see sha1_hmac_prf_create().
+ *
+ * @param algo		AUTH_HMAC_SHA1_* algorithm
+ * @return			signer_t object, NULL if not supported
+ */
+signer_t *sha1_hmac_signer_create(integrity_algorithm_t algo);
+
 #endif /** SHA1_HASHER_H_ @}*/
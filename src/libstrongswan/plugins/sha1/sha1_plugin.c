@@ -46,6 +46,12 @@ METHOD(plugin_t, get_features, int,
 			PLUGIN_PROVIDE(HASHER, HASH_SHA1),
 		PLUGIN_REGISTER(PRF, sha1_prf_create),
 			PLUGIN_PROVIDE(PRF, PRF_KEYED_SHA1),
+		PLUGIN_REGISTER(PRF, sha1_hmac_prf_create),
+			PLUGIN_PROVIDE(PRF, PRF_HMAC_SHA1),
+		PLUGIN_REGISTER(SIGNER, sha1_hmac_signer_create),
+			PLUGIN_PROVIDE(SIGNER, AUTH_HMAC_SHA1_96),
+			PLUGIN_PROVIDE(SIGNER, AUTH_HMAC_SHA1_128),
+			PLUGIN_PROVIDE(SIGNER, AUTH_HMAC_SHA1_160),
 	};
 	*features = f;
 	return countof(f);
@@ -29,7 +29,7 @@
 typedef struct sha1_plugin_t sha1_plugin_t;
 
 /**
- * Plugin implementing the SHA1 algorithm in software.
+ * Plugin implementing the SHA1 algorithm and HMAC-SHA1 in software.
  */
 struct sha1_plugin_t {
 
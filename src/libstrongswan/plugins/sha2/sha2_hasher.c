@@ -20,6 +20,14 @@
 
 #include "sha2_hasher.h"
 
+#include <utils/cpu_feature.h>
+#include <crypto/prfs/mac_prf.h>
+#include <crypto/signers/mac_signer.h>
+
+#ifdef HAVE_SHA_NI
+#include <immintrin.h>
+#endif
+
 
 typedef struct private_sha512_hasher_t private_sha512_hasher_t;
 
@@ -136,6 +144,77 @@ static const u_int64_t sha512_K[80] = {
 #define lSig0(x)    ((S(7,(x))) ^ (S(18,(x))) ^ (R(3,(x))))
 #define lSig1(x)    ((S(17,(x))) ^ (S(19,(x))) ^ (R(10,(x))))
 
+#ifdef HAVE_SHA_NI
+
+/**
+ * Use the SHA extensions of the CPU, if available
+ */
+static bool sha_ni = FALSE;
+
+/**
+ * Check if the CPU supports the SHA extensions
+ */
+static void check_sha_ni()
+{
+	sha_ni = cpu_feature_available(CPU_FEATURE_SHA | CPU_FEATURE_SSSE3 |
+								   CPU_FEATURE_SSE41);
+}
+
+/**
+ * Single block SHA256 transformation using the x86 SHA extensions
+ */
+__attribute__((target("sha,sse4.1")))
+static void sha256_transform_ni(u_int32_t H[8], const unsigned char *datap)
+{
+	__m128i state0, state1, abef, cdgh, msg, tmp, w[4];
+	const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL,
+										0x0405060700010203ULL);
+	int j;
+
+	/* reorder state to ABEF/CDGH as used by sha256rnds2 */
+	tmp = _mm_shuffle_epi32(_mm_loadu_si128((__m128i*)&H[0]), 0xB1);
+	state1 = _mm_shuffle_epi32(_mm_loadu_si128((__m128i*)&H[4]), 0x1B);
+	state0 = _mm_alignr_epi8(tmp, state1, 8);
+	state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+	abef = state0;
+	cdgh = state1;
+
+	for (j = 0; j < 16; j++)
+	{
+		if (j < 4)
+		{	/* read the data, big endian byte order */
+			w[j] = _mm_shuffle_epi8(
+						_mm_loadu_si128((__m128i*)(datap + j * 16)), mask);
+		}
+		else
+		{	/* message schedule, four words at a time */
+			tmp = _mm_sha256msg1_epu32(w[j & 3], w[(j + 1) & 3]);
+			tmp = _mm_add_epi32(tmp,
+						_mm_alignr_epi8(w[(j + 3) & 3], w[(j + 2) & 3], 4));
+			w[j & 3] = _mm_sha256msg2_epu32(tmp, w[(j + 3) & 3]);
+		}
+		msg = _mm_add_epi32(w[j & 3],
+							_mm_loadu_si128((__m128i*)&sha256_K[j * 4]));
+		state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+		state0 = _mm_sha256rnds2_epu32(state0, state1,
+									   _mm_shuffle_epi32(msg, 0x0E));
+	}
+
+	/* compute intermediate hash value, back in ABCD/EFGH order */
+	state0 = _mm_add_epi32(state0, abef);
+	state1 = _mm_add_epi32(state1, cdgh);
+	tmp = _mm_shuffle_epi32(state0, 0x1B);
+	state1 = _mm_shuffle_epi32(state1, 0xB1);
+	_mm_storeu_si128((__m128i*)&H[0], _mm_blend_epi16(tmp, state1, 0xF0));
+	_mm_storeu_si128((__m128i*)&H[4], _mm_alignr_epi8(state1, tmp, 8));
+}
+
+#else /* !HAVE_SHA_NI */
+
+#define check_sha_ni()
+
+#endif /* HAVE_SHA_NI */
+
 /**
  * Single block SHA256 transformation
  */
@@ -146,6 +225,15 @@ static void sha256_transform(private_sha256_hasher_t *ctx,
 	u_int32_t       a, b, c, d, e, f, g, h;
 	u_int32_t       T1, T2, W[64], Wm2, Wm15;
 
+#ifdef HAVE_SHA_NI
+	if (sha_ni)
+	{
+		sha256_transform_ni(ctx->sha_H, datap);
+		ctx->sha_blocks++;
+		return;
+	}
+#endif /* HAVE_SHA_NI */
+
 	/* read the data, big endian byte order */
 	j = 0;
 	do {
@@ -623,6 +711,8 @@ METHOD(hasher_t, destroy, void,
  */
 sha2_hasher_t *sha2_hasher_create(hash_algorithm_t algorithm)
 {
+	check_sha_ni();
+
 	switch (algorithm)
 	{
 		case HASH_SHA224:
@@ -701,3 +791,292 @@ sha2_hasher_t *sha2_hasher_create(hash_algorithm_t algorithm)
 			return NULL;
 	}
 }
+
+typedef struct private_sha256_hmac_t private_sha256_hmac_t;
+
+/**
+ * HMAC-SHA-256 with precomputed inner and outer pad state
+ */
+struct private_sha256_hmac_t {
+
+	/**
+	 * Implements mac_t
+	 */
+	mac_t public;
+
+	/**
+	 * Hash state after processing the inner pad
+	 */
+	private_sha256_hasher_t inner;
+
+	/**
+	 * Hash state after processing the outer pad
+	 */
+	private_sha256_hasher_t outer;
+
+	/**
+	 * Current hash state
+	 */
+	private_sha256_hasher_t ctx;
+};
+
+typedef struct private_sha512_hmac_t private_sha512_hmac_t;
+
+/**
+ * HMAC-SHA-384/512 with precomputed inner and outer pad state
+ */
+struct private_sha512_hmac_t {
+
+	/**
+	 * Implements mac_t
+	 */
+	mac_t public;
+
+	/**
+	 * Reset function of the hash algorithm
+	 */
+	bool (*reset)(private_sha512_hasher_t *ctx);
+
+	/**
+	 * Output length of the hash algorithm
+	 */
+	size_t size;
+
+	/**
+	 * Hash state after processing the inner pad
+	 */
+	private_sha512_hasher_t inner;
+
+	/**
+	 * Hash state after processing the outer pad
+	 */
+	private_sha512_hasher_t outer;
+
+	/**
+	 * Current hash state
+	 */
+	private_sha512_hasher_t ctx;
+};
+
+METHOD(mac_t, get_mac256, bool,
+	private_sha256_hmac_t *this, chunk_t data, u_int8_t *out)
+{
+	u_int8_t inner[HASH_SIZE_SHA256];
+
+	sha256_write(&this->ctx, data.ptr, data.len);
+	if (out)
+	{
+		sha256_final(&this->ctx);
+		memcpy(inner, this->ctx.sha_out, sizeof(inner));
+		this->ctx = this->outer;
+		sha256_write(&this->ctx, inner, sizeof(inner));
+		sha256_final(&this->ctx);
+		memcpy(out, this->ctx.sha_out, HASH_SIZE_SHA256);
+		this->ctx = this->inner;
+	}
+	return TRUE;
+}
+
+METHOD(mac_t, get_mac512, bool,
+	private_sha512_hmac_t *this, chunk_t data, u_int8_t *out)
+{
+	u_int8_t inner[this->size];
+
+	sha512_write(&this->ctx, data.ptr, data.len);
+	if (out)
+	{
+		sha512_final(&this->ctx);
+		memcpy(inner, this->ctx.sha_out, sizeof(inner));
+		this->ctx = this->outer;
+		sha512_write(&this->ctx, inner, sizeof(inner));
+		sha512_final(&this->ctx);
+		memcpy(out, this->ctx.sha_out, this->size);
+		this->ctx = this->inner;
+	}
+	return TRUE;
+}
+
+METHOD(mac_t, get_mac_size256, size_t,
+	private_sha256_hmac_t *this)
+{
+	return HASH_SIZE_SHA256;
+}
+
+METHOD(mac_t, get_mac_size512, size_t,
+	private_sha512_hmac_t *this)
+{
+	return this->size;
+}
+
+METHOD(mac_t, set_key256, bool,
+	private_sha256_hmac_t *this, chunk_t key)
+{
+	u_int8_t pad[sizeof(this->ctx.sha_out)];
+	int i;
+
+	memset(pad, 0, sizeof(pad));
+	if (key.len > sizeof(pad))
+	{
+		reset256(&this->ctx);
+		sha256_write(&this->ctx, key.ptr, key.len);
+		sha256_final(&this->ctx);
+		memcpy(pad, this->ctx.sha_out, HASH_SIZE_SHA256);
+	}
+	else
+	{
+		memcpy(pad, key.ptr, key.len);
+	}
+	for (i = 0; i < sizeof(pad); i++)
+	{
+		pad[i] ^= 0x36;
+	}
+	reset256(&this->inner);
+	sha256_write(&this->inner, pad, sizeof(pad));
+	for (i = 0; i < sizeof(pad); i++)
+	{
+		pad[i] ^= 0x36 ^ 0x5C;
+	}
+	reset256(&this->outer);
+	sha256_write(&this->outer, pad, sizeof(pad));
+	memwipe(pad, sizeof(pad));
+
+	this->ctx = this->inner;
+	return TRUE;
+}
+
+METHOD(mac_t, set_key512, bool,
+	private_sha512_hmac_t *this, chunk_t key)
+{
+	u_int8_t pad[sizeof(this->ctx.sha_out)];
+	int i;
+
+	memset(pad, 0, sizeof(pad));
+	if (key.len > sizeof(pad))
+	{
+		this->reset(&this->ctx);
+		sha512_write(&this->ctx, key.ptr, key.len);
+		sha512_final(&this->ctx);
+		memcpy(pad, this->ctx.sha_out, this->size);
+	}
+	else
+	{
+		memcpy(pad, key.ptr, key.len);
+	}
+	for (i = 0; i < sizeof(pad); i++)
+	{
+		pad[i] ^= 0x36;
+	}
+	this->reset(&this->inner);
+	sha512_write(&this->inner, pad, sizeof(pad));
+	for (i = 0; i < sizeof(pad); i++)
+	{
+		pad[i] ^= 0x36 ^ 0x5C;
+	}
+	this->reset(&this->outer);
+	sha512_write(&this->outer, pad, sizeof(pad));
+	memwipe(pad, sizeof(pad));
+
+	this->ctx = this->inner;
+	return TRUE;
+}
+
+METHOD(mac_t, destroy_hmac256, void,
+	private_sha256_hmac_t *this)
+{
+	memwipe(this, sizeof(*this));
+	free(this);
+}
+
+METHOD(mac_t, destroy_hmac512, void,
+	private_sha512_hmac_t *this)
+{
+	memwipe(this, sizeof(*this));
+	free(this);
+}
+
+/**
+ * Create a HMAC mac_t for a SHA-2 algorithm
+ */
+static mac_t *hmac_create(hash_algorithm_t algorithm)
+{
+	check_sha_ni();
+
+	switch (algorithm)
+	{
+		case HASH_SHA256:
+		{
+			private_sha256_hmac_t *this;
+
+			INIT(this,
+				.public = {
+					.get_mac = _get_mac256,
+					.get_mac_size = _get_mac_size256,
+					.set_key = _set_key256,
+					.destroy = _destroy_hmac256,
+				},
+			);
+			reset256(&this->inner);
+			reset256(&this->outer);
+			this->ctx = this->inner;
+			return &this->public;
+		}
+		case HASH_SHA384:
+		case HASH_SHA512:
+		{
+			private_sha512_hmac_t *this;
+
+			INIT(this,
+				.public = {
+					.get_mac = _get_mac512,
+					.get_mac_size = _get_mac_size512,
+					.set_key = _set_key512,
+					.destroy = _destroy_hmac512,
+				},
+				.reset = reset512,
+				.size = HASH_SIZE_SHA512,
+			);
+			if (algorithm == HASH_SHA384)
+			{
+				this->reset = reset384;
+				this->size = HASH_SIZE_SHA384;
+			}
+			this->reset(&this->inner);
+			this->reset(&this->outer);
+			this->ctx = this->inner;
+			return &this->public;
+		}
+		default:
+			return NULL;
+	}
+}
+
+/*
+ * Described in header.
+ */
+prf_t *sha2_hmac_prf_create(pseudo_random_function_t algo)
+{
+	mac_t *hmac;
+
+	hmac = hmac_create(hasher_algorithm_from_prf(algo));
+	if (hmac)
+	{
+		return mac_prf_create(hmac);
+	}
+	return NULL;
+}
+
+/*
+ * Described in header.
+ */
+signer_t *sha2_hmac_signer_create(integrity_algorithm_t algo)
+{
+	mac_t *hmac;
+	size_t trunc;
+
+	hmac = hmac_create(hasher_algorithm_from_integrity(algo, &trunc));
+	if (hmac)
+	{
+		return mac_signer_create(hmac, trunc);
+	}
+	return NULL;
+}
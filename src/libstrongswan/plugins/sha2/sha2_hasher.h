@@ -24,6 +24,8 @@
 typedef struct sha2_hasher_t sha2_hasher_t;
 
 #include <crypto/hashers/hasher.h>
+#include <crypto/prfs/prf.h>
+#include <crypto/signers/signer.h>
 
 /**
  * Implementation of hasher_t interface using the SHA2 algorithms.
@@ -47,4 +49,23 @@ struct sha2_hasher_t {
  */
 sha2_hasher_t *sha2_hasher_create(hash_algorithm_t algorithm);
 
+/**
+ * Creates a HMAC-SHA-256/384/512 based prf_t.
+ *
+ * The hash state after processing the inner and outer key pads is computed
+ * once in set_key(), saving two compression function calls per message.
+ *
+ * @param algo		PRF_HMAC_SHA2_256, PRF_HMAC_SHA2_384 or PRF_HMAC_SHA2_512
+ * @return			prf_t object, NULL if not supported
+ */
+prf_t *sha2_hmac_prf_create(pseudo_random_function_t algo);
+
+/**
+ * Creates a HMAC-SHA-256/384/512 based signer_t, see sha2_hmac_prf_create().
+ *
+ * @param algo		AUTH_HMAC_SHA2_* algorithm
+ * @return			signer_t object, NULL if not supported
+ */
+signer_t *sha2_hmac_signer_create(integrity_algorithm_t algo);
+
 #endif /** SHA2_HASHER_H_ @}*/
@@ -29,7 +29,8 @@
 typedef struct sha2_plugin_t sha2_plugin_t;
 
 /**
- * Plugin implementing the SHA256, SHA384 and SHA512 algorithms in software.
+ * Plugin implementing the SHA256, SHA384 and SHA512 algorithms and HMAC based
+ * on them in software.
  */
 struct sha2_plugin_t {
 
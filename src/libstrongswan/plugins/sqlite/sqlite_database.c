@@ -20,6 +20,18 @@
 #include <library.h>
 #include <utils/debug.h>
 #include <threading/mutex.h>
+#include <threading/thread_value.h>
+#include <collections/hashtable.h>
+
+#ifdef HAVE_SQLITE3_PREPARE_V2
+/**
+ * Maximum number of prepared statements to cache. Statements prepared with
+ * the legacy interface get invalid on schema changes, so don't cache them.
+ */
+#define MAX_CACHED_STATEMENTS 32
+#else
+#define MAX_CACHED_STATEMENTS 0
+#endif
 
 typedef struct private_sqlite_database_t private_sqlite_database_t;
 
@@ -39,88 +51,209 @@ struct private_sqlite_database_t {
 	sqlite3 *db;
 
 	/**
-	 * mutex used to lock execute()
+	 * mutex used to lock execute(), the statement cache and transactions
 	 */
 	mutex_t *mutex;
+
+	/**
+	 * prepared statements not currently in use, stmt_entry_t indexed by SQL
+	 */
+	hashtable_t *stmts;
+
+	/**
+	 * transaction of the current thread, transaction_t
+	 */
+	thread_value_t *transaction;
 };
 
 /**
- * Create and run a sqlite stmt using a sql string and args
+ * A prepared statement, along with the SQL string it got prepared from
  */
-static sqlite3_stmt* run(private_sqlite_database_t *this, char *sql,
-						 va_list *args)
+typedef struct {
+	/** SQL string, key in the statement cache */
+	char *sql;
+	/** prepared sqlite statement */
+	sqlite3_stmt *stmt;
+} stmt_entry_t;
+
+/**
+ * Database transaction of a thread
+ */
+typedef struct {
+	/** number of nested transactions */
+	u_int refs;
+	/** TRUE if one of the nested transactions has been rolled back */
+	bool rollback;
+} transaction_t;
+
+/**
+ * Hash an SQL string
+ */
+static u_int hash(char *key)
 {
-	sqlite3_stmt *stmt = NULL;
-	int params, i, res = SQLITE_OK;
+	return chunk_hash(chunk_create(key, strlen(key)));
+}
+
+/**
+ * Compare SQL strings
+ */
+static bool equals(char *a, char *b)
+{
+	return streq(a, b);
+}
 
+/**
+ * Destroy a statement entry, finalizing the statement
+ */
+static void stmt_entry_destroy(stmt_entry_t *entry)
+{
+	sqlite3_finalize(entry->stmt);
+	free(entry->sql);
+	free(entry);
+}
+
+/**
+ * Get a prepared statement from the cache, or prepare a new one
+ */
+static stmt_entry_t* get_stmt(private_sqlite_database_t *this, char *sql)
+{
+	stmt_entry_t *entry;
+	sqlite3_stmt *stmt;
+
+	this->mutex->lock(this->mutex);
+	entry = this->stmts->remove(this->stmts, sql);
+	this->mutex->unlock(this->mutex);
+	if (entry)
+	{
+		return entry;
+	}
 #ifdef HAVE_SQLITE3_PREPARE_V2
-	if (sqlite3_prepare_v2(this->db, sql, -1, &stmt, NULL) == SQLITE_OK)
+	if (sqlite3_prepare_v2(this->db, sql, -1, &stmt, NULL) != SQLITE_OK)
 #else
-	if (sqlite3_prepare(this->db, sql, -1, &stmt, NULL) == SQLITE_OK)
+	if (sqlite3_prepare(this->db, sql, -1, &stmt, NULL) != SQLITE_OK)
 #endif
 	{
-		params = sqlite3_bind_parameter_count(stmt);
-		for (i = 1; i <= params; i++)
+		DBG1(DBG_LIB, "preparing sqlite statement failed: %s",
+			 sqlite3_errmsg(this->db));
+		return NULL;
+	}
+	INIT(entry,
+		.sql = strdup(sql),
+		.stmt = stmt,
+	);
+	return entry;
+}
+
+/**
+ * Reset a prepared statement and return it to the cache, if possible
+ */
+static void release_stmt(private_sqlite_database_t *this, stmt_entry_t *entry)
+{
+	sqlite3_reset(entry->stmt);
+	sqlite3_clear_bindings(entry->stmt);
+
+	this->mutex->lock(this->mutex);
+	if (this->stmts->get_count(this->stmts) < MAX_CACHED_STATEMENTS &&
+		!this->stmts->get(this->stmts, entry->sql))
+	{
+		this->stmts->put(this->stmts, entry->sql, entry);
+		entry = NULL;
+	}
+	this->mutex->unlock(this->mutex);
+	if (entry)
+	{
+		stmt_entry_destroy(entry);
+	}
+}
+
+/**
+ * Bind a single value of the given type to a statement
+ */
+static int bind_value(sqlite3_stmt *stmt, int i, db_type_t type, va_list *args)
+{
+	switch (type)
+	{
+		case DB_INT:
+			return sqlite3_bind_int(stmt, i, va_arg(*args, int));
+		case DB_UINT:
+			return sqlite3_bind_int64(stmt, i, va_arg(*args, u_int));
+		case DB_TEXT:
+			return sqlite3_bind_text(stmt, i, va_arg(*args, const char*), -1,
+									 SQLITE_STATIC);
+		case DB_BLOB:
 		{
-			switch (va_arg(*args, db_type_t))
-			{
-				case DB_INT:
-				{
-					res = sqlite3_bind_int(stmt, i, va_arg(*args, int));
-					break;
-				}
-				case DB_UINT:
-				{
-					res = sqlite3_bind_int64(stmt, i, va_arg(*args, u_int));
-					break;
-				}
-				case DB_TEXT:
-				{
-					const char *text = va_arg(*args, const char*);
-					res = sqlite3_bind_text(stmt, i, text, -1, SQLITE_STATIC);
-					break;
-				}
-				case DB_BLOB:
-				{
-					chunk_t c = va_arg(*args, chunk_t);
-					res = sqlite3_bind_blob(stmt, i, c.ptr, c.len, SQLITE_STATIC);
-					break;
-				}
-				case DB_DOUBLE:
-				{
-					res = sqlite3_bind_double(stmt, i, va_arg(*args, double));
-					break;
-				}
-				case DB_NULL:
-				{
-					res = sqlite3_bind_null(stmt, i);
-					break;
-				}
-				default:
-				{
-					res = SQLITE_MISUSE;
-					break;
-				}
-			}
-			if (res != SQLITE_OK)
-			{
-				break;
-			}
+			chunk_t c = va_arg(*args, chunk_t);
+			return sqlite3_bind_blob(stmt, i, c.ptr, c.len, SQLITE_STATIC);
 		}
+		case DB_DOUBLE:
+			return sqlite3_bind_double(stmt, i, va_arg(*args, double));
+		case DB_NULL:
+			return sqlite3_bind_null(stmt, i);
+		default:
+			return SQLITE_MISUSE;
 	}
-	else
+}
+
+/**
+ * Bind the value at index row of an argument array of the given type
+ */
+static int bind_array(sqlite3_stmt *stmt, int i, db_type_t type, u_int row,
+					  va_list *args)
+{
+	switch (type)
 	{
-		DBG1(DBG_LIB, "preparing sqlite statement failed: %s",
-			 sqlite3_errmsg(this->db));
+		case DB_INT:
+			return sqlite3_bind_int(stmt, i, va_arg(*args, int*)[row]);
+		case DB_UINT:
+			return sqlite3_bind_int64(stmt, i, va_arg(*args, u_int*)[row]);
+		case DB_TEXT:
+			return sqlite3_bind_text(stmt, i, va_arg(*args, char**)[row], -1,
+									 SQLITE_STATIC);
+		case DB_BLOB:
+		{
+			chunk_t c = va_arg(*args, chunk_t*)[row];
+			return sqlite3_bind_blob(stmt, i, c.ptr, c.len, SQLITE_STATIC);
+		}
+		case DB_DOUBLE:
+			return sqlite3_bind_double(stmt, i, va_arg(*args, double*)[row]);
+		case DB_NULL:
+			return sqlite3_bind_null(stmt, i);
+		default:
+			return SQLITE_MISUSE;
+	}
+}
+
+/**
+ * Get a sqlite stmt for a sql string and bind args
+ */
+static stmt_entry_t* run(private_sqlite_database_t *this, char *sql,
+						 va_list *args)
+{
+	stmt_entry_t *entry;
+	int params, i, res = SQLITE_OK;
+
+	entry = get_stmt(this, sql);
+	if (!entry)
+	{
+		return NULL;
+	}
+	params = sqlite3_bind_parameter_count(entry->stmt);
+	for (i = 1; i <= params; i++)
+	{
+		res = bind_value(entry->stmt, i, va_arg(*args, db_type_t), args);
+		if (res != SQLITE_OK)
+		{
+			break;
+		}
 	}
 	if (res != SQLITE_OK)
 	{
 		DBG1(DBG_LIB, "binding sqlite statement failed: %s",
 			 sqlite3_errmsg(this->db));
-		sqlite3_finalize(stmt);
+		release_stmt(this, entry);
 		return NULL;
 	}
-	return stmt;
+	return entry;
 }
 
 typedef struct {
@@ -128,6 +261,8 @@ typedef struct {
 	enumerator_t public;
 	/** associated sqlite statement */
 	sqlite3_stmt *stmt;
+	/** statement cache entry of stmt */
+	stmt_entry_t *entry;
 	/** number of result columns */
 	int count;
 	/** column types */
@@ -141,7 +276,7 @@ typedef struct {
  */
 static void sqlite_enumerator_destroy(sqlite_enumerator_t *this)
 {
-	sqlite3_finalize(this->stmt);
+	release_stmt(this->database, this->entry);
 #if SQLITE_VERSION_NUMBER < 3005000
 	this->database->mutex->unlock(this->database->mutex);
 #endif
@@ -217,25 +352,29 @@ static bool sqlite_enumerator_enumerate(sqlite_enumerator_t *this, ...)
 METHOD(database_t, query, enumerator_t*,
 	private_sqlite_database_t *this, char *sql, ...)
 {
-	sqlite3_stmt *stmt;
+	stmt_entry_t *entry;
 	va_list args;
 	sqlite_enumerator_t *enumerator = NULL;
 	int i;
 
-#if SQLITE_VERSION_NUMBER < 3005000
-	/* sqlite connections prior to 3.5 may be used by a single thread only, */
+	/* wait for transactions of other threads to complete */
 	this->mutex->lock(this->mutex);
+#if SQLITE_VERSION_NUMBER >= 3005000
+	this->mutex->unlock(this->mutex);
+#else
+	/* sqlite connections prior to 3.5 may be used by a single thread only */
 #endif
 
 	va_start(args, sql);
-	stmt = run(this, sql, &args);
-	if (stmt)
+	entry = run(this, sql, &args);
+	if (entry)
 	{
 		enumerator = malloc_thing(sqlite_enumerator_t);
 		enumerator->public.enumerate = (void*)sqlite_enumerator_enumerate;
 		enumerator->public.destroy = (void*)sqlite_enumerator_destroy;
-		enumerator->stmt = stmt;
-		enumerator->count = sqlite3_column_count(stmt);
+		enumerator->entry = entry;
+		enumerator->stmt = entry->stmt;
+		enumerator->count = sqlite3_column_count(entry->stmt);
 		enumerator->columns = malloc(sizeof(db_type_t) * enumerator->count);
 		enumerator->database = this;
 		for (i = 0; i < enumerator->count; i++)
@@ -243,6 +382,12 @@ METHOD(database_t, query, enumerator_t*,
 			enumerator->columns[i] = va_arg(args, db_type_t);
 		}
 	}
+#if SQLITE_VERSION_NUMBER < 3005000
+	else
+	{
+		this->mutex->unlock(this->mutex);
+	}
+#endif
 	va_end(args);
 	return (enumerator_t*)enumerator;
 }
@@ -250,18 +395,18 @@ METHOD(database_t, query, enumerator_t*,
 METHOD(database_t, execute, int,
 	private_sqlite_database_t *this, int *rowid, char *sql, ...)
 {
-	sqlite3_stmt *stmt;
+	stmt_entry_t *entry;
 	int affected = -1;
 	va_list args;
 
 	/* we need a lock to get our rowid/changes correctly */
 	this->mutex->lock(this->mutex);
 	va_start(args, sql);
-	stmt = run(this, sql, &args);
+	entry = run(this, sql, &args);
 	va_end(args);
-	if (stmt)
+	if (entry)
 	{
-		if (sqlite3_step(stmt) == SQLITE_DONE)
+		if (sqlite3_step(entry->stmt) == SQLITE_DONE)
 		{
 			if (rowid)
 			{
@@ -274,12 +419,150 @@ METHOD(database_t, execute, int,
 			DBG1(DBG_LIB, "sqlite execute failed: %s",
 				 sqlite3_errmsg(this->db));
 		}
-		sqlite3_finalize(stmt);
+		release_stmt(this, entry);
 	}
 	this->mutex->unlock(this->mutex);
 	return affected;
 }
 
+METHOD(database_t, transaction, bool,
+	private_sqlite_database_t *this)
+{
+	transaction_t *trans;
+
+	/* the mutex is held until the transaction is committed or rolled back,
+	 * as statements of other threads would end up in our transaction */
+	this->mutex->lock(this->mutex);
+	trans = this->transaction->get(this->transaction);
+	if (trans)
+	{
+		trans->refs++;
+		return TRUE;
+	}
+	if (execute(this, NULL, "BEGIN TRANSACTION") == -1)
+	{
+		this->mutex->unlock(this->mutex);
+		return FALSE;
+	}
+	INIT(trans,
+		.refs = 1,
+	);
+	this->transaction->set(this->transaction, trans);
+	return TRUE;
+}
+
+/**
+ * Commit or rollback the current transaction, if it is the outermost one
+ */
+static bool finalize_transaction(private_sqlite_database_t *this,
+								 bool rollback)
+{
+	transaction_t *trans;
+	char *command = "COMMIT TRANSACTION";
+	bool success = TRUE;
+
+	trans = this->transaction->get(this->transaction);
+	if (!trans)
+	{
+		DBG1(DBG_LIB, "no database transaction found");
+		return FALSE;
+	}
+	if (--trans->refs == 0)
+	{
+		if (rollback || trans->rollback)
+		{
+			command = "ROLLBACK TRANSACTION";
+			/* report a failed commit if a nested transaction rolled back */
+			success = rollback;
+		}
+		if (execute(this, NULL, command) == -1)
+		{
+			success = FALSE;
+		}
+		this->transaction->set(this->transaction, NULL);
+		free(trans);
+	}
+	else if (rollback)
+	{
+		trans->rollback = TRUE;
+	}
+	this->mutex->unlock(this->mutex);
+	return success;
+}
+
+METHOD(database_t, commit, bool,
+	private_sqlite_database_t *this)
+{
+	return finalize_transaction(this, FALSE);
+}
+
+METHOD(database_t, rollback, bool,
+	private_sqlite_database_t *this)
+{
+	return finalize_transaction(this, TRUE);
+}
+
+METHOD(database_t, batch, int,
+	private_sqlite_database_t *this, char *sql, u_int count, ...)
+{
+	stmt_entry_t *entry;
+	va_list args;
+	int params, i, res = SQLITE_OK, affected = 0;
+	u_int row;
+
+	if (!transaction(this))
+	{
+		return -1;
+	}
+	entry = get_stmt(this, sql);
+	if (!entry)
+	{
+		rollback(this);
+		return -1;
+	}
+	params = sqlite3_bind_parameter_count(entry->stmt);
+	for (row = 0; row < count; row++)
+	{
+		va_start(args, count);
+		for (i = 1; i <= params; i++)
+		{
+			res = bind_array(entry->stmt, i, va_arg(args, db_type_t), row,
+							 &args);
+			if (res != SQLITE_OK)
+			{
+				break;
+			}
+		}
+		va_end(args);
+		if (res != SQLITE_OK)
+		{
+			DBG1(DBG_LIB, "binding sqlite statement failed: %s",
+				 sqlite3_errmsg(this->db));
+			break;
+		}
+		if (sqlite3_step(entry->stmt) != SQLITE_DONE)
+		{
+			DBG1(DBG_LIB, "sqlite batch execute failed: %s",
+				 sqlite3_errmsg(this->db));
+			res = SQLITE_ERROR;
+			break;
+		}
+		affected += sqlite3_changes(this->db);
+		sqlite3_reset(entry->stmt);
+	}
+	release_stmt(this, entry);
+	if (res != SQLITE_OK)
+	{
+		rollback(this);
+		return -1;
+	}
+	if (!commit(this))
+	{
+		return -1;
+	}
+	return affected;
+}
+
 METHOD(database_t, get_driver, db_driver_t,
 	private_sqlite_database_t *this)
 {
@@ -300,6 +583,18 @@ static int busy_handler(private_sqlite_database_t *this, int count)
 METHOD(database_t, destroy, void,
 	private_sqlite_database_t *this)
 {
+	enumerator_t *enumerator;
+	stmt_entry_t *entry;
+	char *sql;
+
+	enumerator = this->stmts->create_enumerator(this->stmts);
+	while (enumerator->enumerate(enumerator, &sql, &entry))
+	{
+		stmt_entry_destroy(entry);
+	}
+	enumerator->destroy(enumerator);
+	this->stmts->destroy(this->stmts);
+	this->transaction->destroy(this->transaction);
 	if (sqlite3_close(this->db) == SQLITE_BUSY)
 	{
 		DBG1(DBG_LIB, "sqlite close failed because database is busy");
@@ -330,11 +625,18 @@ sqlite_database_t *sqlite_database_create(char *uri)
 			.db = {
 				.query = _query,
 				.execute = _execute,
+				.batch = _batch,
+				.transaction = _transaction,
+				.commit = _commit,
+				.rollback = _rollback,
 				.get_driver = _get_driver,
 				.destroy = _destroy,
 			},
 		},
 		.mutex = mutex_create(MUTEX_TYPE_RECURSIVE),
+		.stmts = hashtable_create((hashtable_hash_t)hash,
+								  (hashtable_equals_t)equals, 8),
+		.transaction = thread_value_create(free),
 	);
 
 	if (sqlite3_open(file, &this->db) != SQLITE_OK)
@@ -221,3 +221,5 @@ TEST_VECTOR_RNG(rng_runs_1)
 TEST_VECTOR_RNG(rng_runs_2)
 TEST_VECTOR_RNG(rng_runs_3)
 
+TEST_VECTOR_DH(curve25519_1)
+
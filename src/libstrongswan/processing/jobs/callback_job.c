@@ -22,6 +22,7 @@
 #include <threading/semaphore.h>
 #include <threading/mutex.h>
 #include <collections/linked_list.h>
+#include <utils/slab.h>
 
 typedef struct private_callback_job_t private_callback_job_t;
 
@@ -61,6 +62,11 @@ struct private_callback_job_t {
 	job_priority_t prio;
 };
 
+/**
+ * Slab for callback jobs
+ */
+SLAB_DEFINE(job_slab, private_callback_job_t);
+
 METHOD(job_t, destroy, void,
 	private_callback_job_t *this)
 {
@@ -68,7 +74,7 @@ METHOD(job_t, destroy, void,
 	{
 		this->cleanup(this->data);
 	}
-	free(this);
+	slab_free(&job_slab, this);
 }
 
 METHOD(job_t, execute, job_requeue_t,
@@ -98,7 +104,7 @@ callback_job_t *callback_job_create_with_prio(callback_job_cb_t cb, void *data,
 {
 	private_callback_job_t *this;
 
-	INIT(this,
+	SLAB_INIT(&job_slab, this,
 		.public = {
 			.job = {
 				.execute = _execute,
@@ -77,6 +77,8 @@ enum job_requeue_type_t {
 	JOB_REQUEUE_TYPE_DIRECT,
 	/** Rescheduled the job via scheduler_t */
 	JOB_REQUEUE_TYPE_SCHEDULE,
+	/** Job has been handed over to another facility during execution */
+	JOB_REQUEUE_TYPE_DEFERRED,
 };
 
 /**
@@ -108,6 +110,7 @@ struct job_requeue_t {
 #define JOB_REQUEUE_NONE			__JOB_REQUEUE(JOB_REQUEUE_TYPE_NONE)
 #define JOB_REQUEUE_FAIR			__JOB_REQUEUE(JOB_REQUEUE_TYPE_FAIR)
 #define JOB_REQUEUE_DIRECT			__JOB_REQUEUE(JOB_REQUEUE_TYPE_DIRECT)
+#define JOB_REQUEUE_DEFERRED		__JOB_REQUEUE(JOB_REQUEUE_TYPE_DEFERRED)
 #define __JOB_RESCHEDULE(t, ...)	(job_requeue_t){ .type = JOB_REQUEUE_TYPE_SCHEDULE, .schedule = t, { __VA_ARGS__ } }
 #define JOB_RESCHEDULE(s)			__JOB_RESCHEDULE(JOB_SCHEDULE, .rel = s)
 #define JOB_RESCHEDULE_MS(ms)		__JOB_RESCHEDULE(JOB_SCHEDULE_MS, .rel = ms)
@@ -130,6 +133,11 @@ struct job_t {
 	 * one-shot, they are destroyed after execution (depending on the return
 	 * value here), so don't use a job once it has been queued.
 	 *
+	 * A job that hands itself over to another facility (which queues it
+	 * again later, possibly before execute() returns) has to release itself
+	 * with processor_t.release_job() before, and return JOB_REQUEUE_DEFERRED
+	 * without accessing itself afterwards.
+	 *
 	 * @return			policy how to requeue the job
 	 */
 	job_requeue_t (*execute) (job_t *this);
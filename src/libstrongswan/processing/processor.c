@@ -86,6 +86,11 @@ struct private_processor_t {
 	 * Condvar to wait for terminated threads
 	 */
 	condvar_t *thread_terminated;
+
+	/**
+	 * The worker_thread_t of the calling worker thread
+	 */
+	thread_value_t *current;
 };
 
 /**
@@ -129,9 +134,12 @@ static void restart(worker_thread_t *worker)
 	this->mutex->lock(this->mutex);
 	/* cleanup worker thread  */
 	this->working_threads[worker->priority]--;
-	worker->job->status = JOB_STATUS_CANCELED;
-	worker->job->destroy(worker->job);
-	worker->job = NULL;
+	if (worker->job)
+	{
+		worker->job->status = JOB_STATUS_CANCELED;
+		worker->job->destroy(worker->job);
+		worker->job = NULL;
+	}
 
 	/* respawn thread if required */
 	if (this->desired_threads >= this->total_threads)
@@ -180,6 +188,7 @@ static void process_jobs(worker_thread_t *worker)
 
 	/* worker threads are not cancelable by default */
 	thread_cancelability(FALSE);
+	this->current->set(this->current, worker);
 
 	DBG2(DBG_JOB, "started worker thread %.2u", thread_current_id());
 
@@ -187,6 +196,7 @@ static void process_jobs(worker_thread_t *worker)
 	while (this->desired_threads >= this->total_threads)
 	{
 		int i, reserved = 0, idle;
+		bool deferred = FALSE;
 
 		idle = get_idle_threads_nolock(this);
 
@@ -230,6 +240,13 @@ static void process_jobs(worker_thread_t *worker)
 				thread_cleanup_pop(FALSE);
 				this->mutex->lock(this->mutex);
 				this->working_threads[i]--;
+				if (requeue.type == JOB_REQUEUE_TYPE_DEFERRED)
+				{	/* job has been released with release_job() and is owned by
+					 * someone else, it might even have been executed already */
+					worker->job = NULL;
+					deferred = TRUE;
+					break;
+				}
 				if (worker->job->status == JOB_STATUS_CANCELED)
 				{	/* job was canceled via a custom cancel() method or did not
 					 * use JOB_REQUEUE_TYPE_DIRECT */
@@ -273,7 +290,7 @@ static void process_jobs(worker_thread_t *worker)
 				break;
 			}
 		}
-		if (!worker->job)
+		if (!worker->job && !deferred)
 		{
 			this->job_added->wait(this->job_added, this->mutex);
 		}
@@ -341,6 +358,20 @@ METHOD(processor_t, get_job_load, u_int,
 	return load;
 }
 
+METHOD(processor_t, release_job, void,
+	private_processor_t *this, job_t *job)
+{
+	worker_thread_t *worker;
+
+	worker = this->current->get(this->current);
+	if (worker && worker->job == job)
+	{	/* don't let cancel() access it once handed over */
+		this->mutex->lock(this->mutex);
+		worker->job = NULL;
+		this->mutex->unlock(this->mutex);
+	}
+}
+
 METHOD(processor_t, queue_job, void,
 	private_processor_t *this, job_t *job)
 {
@@ -437,6 +468,7 @@ METHOD(processor_t, destroy, void,
 	this->thread_terminated->destroy(this->thread_terminated);
 	this->job_added->destroy(this->job_added);
 	this->mutex->destroy(this->mutex);
+	this->current->destroy(this->current);
 	for (i = 0; i < JOB_PRIO_MAX; i++)
 	{
 		this->jobs[i]->destroy_offset(this->jobs[i], offsetof(job_t, destroy));
@@ -460,12 +492,14 @@ processor_t *processor_create()
 			.get_working_threads = _get_working_threads,
 			.get_job_load = _get_job_load,
 			.queue_job = _queue_job,
+			.release_job = _release_job,
 			.set_threads = _set_threads,
 			.cancel = _cancel,
 			.destroy = _destroy,
 		},
 		.threads = linked_list_create(),
 		.mutex = mutex_create(MUTEX_TYPE_DEFAULT),
+		.current = thread_value_create(NULL),
 		.job_added = condvar_create(CONDVAR_TYPE_DEFAULT),
 		.thread_terminated = condvar_create(CONDVAR_TYPE_DEFAULT),
 	);
@@ -74,6 +74,16 @@ struct processor_t {
 	 */
 	void (*queue_job) (processor_t *this, job_t *job);
 
+	/**
+	 * Release a job currently executed by a worker thread.
+	 *
+	 * A job handing itself over to another facility during execute() has to
+	 * call this before doing so, and return JOB_REQUEUE_DEFERRED.
+	 *
+	 * @param job			job to release, executed by the calling thread
+	 */
+	void (*release_job)(processor_t *this, job_t *job);
+
 	/**
 	 * Set the number of threads to use in the processor.
 	 *
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2013 Hochschule fuer Technik Rapperswil
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.  See <http://www.fsf.org/copyleft/gpl.txt>.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+
+#include "cpu_feature.h"
+
+#if defined(__i386__) || defined(__x86_64__)
+
+/**
+ * Get cpuid for info and subleaf, return eax, ebx, ecx and edx.
+ * -fPIC requires to save ebx on IA-32.
+ */
+static void cpuid(u_int op, u_int sub, u_int *a, u_int *b, u_int *c, u_int *d)
+{
+#ifdef __x86_64__
+	asm("cpuid" : "=a" (*a), "=b" (*b), "=c" (*c), "=d" (*d)
+		: "a" (op), "c" (sub));
+#else /* __i386__ */
+	asm("pushl %%ebx;"
+		"cpuid;"
+		"movl %%ebx, %1;"
+		"popl %%ebx;"
+		: "=a" (*a), "=r" (*b), "=c" (*c), "=d" (*d) : "a" (op), "c" (sub));
+#endif /* __x86_64__ / __i386__*/
+}
+
+/**
+ * Detect features supported by an x86/x64 CPU
+ */
+static cpu_feature_t detect()
+{
+	cpu_feature_t f = 0;
+	u_int a, b, c, d, max;
+
+	cpuid(0, 0, &max, &b, &c, &d);
+	if (max < 1)
+	{
+		return f;
+	}
+	cpuid(1, 0, &a, &b, &c, &d);
+	if (c & (1 << 9))
+	{
+		f |= CPU_FEATURE_SSSE3;
+	}
+	if (c & (1 << 19))
+	{
+		f |= CPU_FEATURE_SSE41;
+	}
+	if (max >= 7)
+	{
+		cpuid(7, 0, &a, &b, &c, &d);
+		if (b & (1 << 29))
+		{
+			f |= CPU_FEATURE_SHA;
+		}
+	}
+	return f;
+}
+
+#else /* !__i386__ && !__x86_64__ */
+
+/**
+ * No features detected on other platforms
+ */
+static cpu_feature_t detect()
+{
+	return 0;
+}
+
+#endif /* __i386__ || __x86_64__ */
+
+/**
+ * See header
+ */
+cpu_feature_t cpu_feature_get_all()
+{
+	static cpu_feature_t features;
+	static bool detected = FALSE;
+
+	if (!detected)
+	{	/* racing threads detect the same features, no locking required */
+		features = detect();
+		detected = TRUE;
+	}
+	return features;
+}
+
+/**
+ * See header
+ */
+bool cpu_feature_available(cpu_feature_t feature)
+{
+	return (cpu_feature_get_all() & feature) == feature;
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2013 Hochschule fuer Technik Rapperswil
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.  See <http://www.fsf.org/copyleft/gpl.txt>.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+
+/**
+ * @defgroup cpu_feature cpu_feature
+ * @{ @ingroup utils
+ */
+
+#ifndef CPU_FEATURE_H_
+#define CPU_FEATURE_H_
+
+#include <library.h>
+
+typedef enum cpu_feature_t cpu_feature_t;
+
+/**
+ * CPU feature flags, as detected at runtime
+ */
+enum cpu_feature_t {
+	/** x86/x64 Supplemental SSE3 */
+	CPU_FEATURE_SSSE3 =					(1<<0),
+	/** x86/x64 SSE 4.1 */
+	CPU_FEATURE_SSE41 =					(1<<1),
+	/** x86/x64 SHA-1/SHA-256 extensions */
+	CPU_FEATURE_SHA =					(1<<2),
+};
+
+/**
+ * Get a bitmask of all features supported by the CPU.
+ *
+ * @return			bitmask of cpu_feature_t
+ */
+cpu_feature_t cpu_feature_get_all();
+
+/**
+ * Check if the CPU supports all of the given features.
+ *
+ * @param feature	bitmask of features to check
+ * @return			TRUE if all features supported
+ */
+bool cpu_feature_available(cpu_feature_t feature);
+
+#endif /** CPU_FEATURE_H_ @}*/
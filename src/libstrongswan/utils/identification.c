@@ -21,12 +21,14 @@
 #include <arpa/inet.h>
 #include <string.h>
 #include <stdio.h>
+#include <ctype.h>
 
 #include "identification.h"
 
 #include <asn1/oid.h>
 #include <asn1/asn1.h>
 #include <crypto/hashers/hasher.h>
+#include <utils/slab.h>
 
 ENUM_BEGIN(id_match_names, ID_MATCH_NONE, ID_MATCH_MAX_WILDCARDS,
 	"MATCH_NONE",
@@ -103,6 +105,24 @@ static const x501rdn_t x501rdns[] = {
 
 typedef struct private_identification_t private_identification_t;
 
+/**
+ * Parsed RDN of a DN, as offsets into the DN encoding
+ */
+typedef struct {
+	/** offset of the OID */
+	u_int oid;
+	/** length of the OID */
+	u_int oid_len;
+	/** offset of the value */
+	u_int data;
+	/** length of the value */
+	u_int data_len;
+	/** ASN.1 string type of the value */
+	u_char type;
+	/** TRUE if the value gets compared case insensitive */
+	bool icase;
+} rdn_t;
+
 /**
  * Private data of an identification_t object.
  */
@@ -121,8 +141,28 @@ struct private_identification_t {
 	 * Type of this ID.
 	 */
 	id_type_t type;
+
+	/**
+	 * Parsed RDNs of a DN, NULL if not a DN or not a valid DN
+	 */
+	rdn_t *rdns;
+
+	/**
+	 * Number of parsed RDNs
+	 */
+	u_int rdn_count;
+
+	/**
+	 * Precomputed hash of a DN
+	 */
+	u_int hash;
 };
 
+/**
+ * Slab for identification objects
+ */
+SLAB_DEFINE(id_slab, private_identification_t);
+
 /**
  * Enumerator over RDNs
  */
@@ -502,6 +542,84 @@ static status_t atodn(char *src, chunk_t *dn)
 	return status;
 }
 
+/**
+ * Hash data case insensitively
+ */
+static u_int hash_lower(chunk_t data, u_int hash)
+{
+	u_char buf[64];
+	int i, len;
+
+	while (data.len)
+	{
+		len = min(data.len, sizeof(buf));
+		for (i = 0; i < len; i++)
+		{
+			buf[i] = tolower(data.ptr[i]);
+		}
+		hash = chunk_hash_inc(chunk_create(buf, len), hash);
+		data = chunk_skip(data, len);
+	}
+	return hash;
+}
+
+/**
+ * Parse the RDNs of a DN once and precompute its hash.
+ *
+ * The hash covers the OIDs and the lowercase values, as some string types
+ * are compared case insensitive. DNs that can't be parsed completely are
+ * equal to binary identical DNs only, their hash covers the encoding.
+ */
+static void parse_dn(private_identification_t *this)
+{
+	enumerator_t *enumerator;
+	chunk_t oid, data;
+	u_int size = 0;
+	bool finished = FALSE;
+	u_char type;
+	rdn_t *rdn;
+
+	enumerator = create_rdn_enumerator(this->encoded);
+	while (enumerator->enumerate(enumerator, &oid, &type, &data))
+	{
+		if (this->rdn_count == size)
+		{
+			size = max(size * 2, 4);
+			this->rdns = realloc(this->rdns, size * sizeof(rdn_t));
+		}
+		rdn = &this->rdns[this->rdn_count++];
+		*rdn = (rdn_t){
+			.oid = oid.ptr - this->encoded.ptr,
+			.oid_len = oid.len,
+			.data = data.ptr - this->encoded.ptr,
+			.data_len = data.len,
+			.type = type,
+			.icase = type == ASN1_PRINTABLESTRING ||
+					 (type == ASN1_IA5STRING &&
+					  asn1_known_oid(oid) == OID_EMAIL_ADDRESS),
+		};
+		finished = data.ptr + data.len == this->encoded.ptr + this->encoded.len;
+	}
+	enumerator->destroy(enumerator);
+
+	this->hash = chunk_hash(chunk_from_thing(this->type));
+	if (!finished)
+	{
+		free(this->rdns);
+		this->rdns = NULL;
+		this->rdn_count = 0;
+		this->hash = chunk_hash_inc(this->encoded, this->hash);
+		return;
+	}
+	for (rdn = this->rdns; rdn < this->rdns + this->rdn_count; rdn++)
+	{
+		this->hash = chunk_hash_inc(chunk_create(this->encoded.ptr + rdn->oid,
+												 rdn->oid_len), this->hash);
+		this->hash = hash_lower(chunk_create(this->encoded.ptr + rdn->data,
+											 rdn->data_len), this->hash);
+	}
+}
+
 METHOD(identification_t, get_encoding, chunk_t,
 	private_identification_t *this)
 {
@@ -521,7 +639,20 @@ METHOD(identification_t, contains_wildcards_dn, bool,
 	bool contains = FALSE;
 	id_part_t type;
 	chunk_t data;
+	u_int i;
 
+	if (this->rdns)
+	{
+		for (i = 0; i < this->rdn_count; i++)
+		{
+			if (this->rdns[i].data_len == 1 &&
+				this->encoded.ptr[this->rdns[i].data] == '*')
+			{
+				return TRUE;
+			}
+		}
+		return FALSE;
+	}
 	enumerator = create_part_enumerator(this);
 	while (enumerator->enumerate(enumerator, &type, &data))
 	{
@@ -577,7 +708,7 @@ static bool compare_dn(chunk_t t_dn, chunk_t o_dn, int *wc)
 		}
 	}
 	/* try a binary compare */
-	if (memeq(t_dn.ptr, o_dn.ptr, t_dn.len))
+	if (t_dn.len == o_dn.len && memeq(t_dn.ptr, o_dn.ptr, t_dn.len))
 	{
 		return TRUE;
 	}
@@ -643,9 +774,77 @@ static bool compare_dn(chunk_t t_dn, chunk_t o_dn, int *wc)
 	return finished;
 }
 
+/**
+ * Compare two DNs using their parsed RDNs, same semantics as compare_dn()
+ */
+static bool compare_rdns(private_identification_t *t,
+						 private_identification_t *o, int *wc)
+{
+	chunk_t t_data, o_data;
+	rdn_t *t_rdn, *o_rdn;
+	u_int i;
+
+	if (wc)
+	{
+		*wc = 0;
+	}
+	else if (t->hash != o->hash)
+	{	/* the encoding length differs for equal DNs grouping their RDNs into
+		 * multi-valued RDNs differently, the hash does not */
+		return FALSE;
+	}
+	if (t->encoded.len == o->encoded.len &&
+		memeq(t->encoded.ptr, o->encoded.ptr, t->encoded.len))
+	{
+		return TRUE;
+	}
+	if (!t->rdns || !o->rdns || t->rdn_count != o->rdn_count)
+	{
+		return FALSE;
+	}
+	for (i = 0; i < t->rdn_count; i++)
+	{
+		t_rdn = &t->rdns[i];
+		o_rdn = &o->rdns[i];
+		if (t_rdn->oid_len != o_rdn->oid_len ||
+			!memeq(t->encoded.ptr + t_rdn->oid, o->encoded.ptr + o_rdn->oid,
+				   t_rdn->oid_len))
+		{
+			return FALSE;
+		}
+		t_data = chunk_create(t->encoded.ptr + t_rdn->data, t_rdn->data_len);
+		o_data = chunk_create(o->encoded.ptr + o_rdn->data, o_rdn->data_len);
+		if (wc && o_data.len == 1 && o_data.ptr[0] == '*')
+		{
+			(*wc)++;
+			continue;
+		}
+		if (t_data.len != o_data.len)
+		{
+			return FALSE;
+		}
+		if (t_rdn->type == o_rdn->type && t_rdn->icase)
+		{
+			if (strncasecmp(t_data.ptr, o_data.ptr, t_data.len) != 0)
+			{
+				return FALSE;
+			}
+		}
+		else if (!memeq(t_data.ptr, o_data.ptr, t_data.len))
+		{
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
 METHOD(identification_t, equals_dn, bool,
 	private_identification_t *this, identification_t *other)
 {
+	if (other->equals == this->public.equals)
+	{	/* a DN of our own implementation, use the parsed RDNs */
+		return compare_rdns(this, (private_identification_t*)other, NULL);
+	}
 	return compare_dn(this->encoded, other->get_encoding(other), NULL);
 }
 
@@ -666,6 +865,30 @@ METHOD(identification_t, equals_strcasecmp,  bool,
 	return FALSE;
 }
 
+METHOD(identification_t, hash_binary, u_int,
+	private_identification_t *this, u_int inc)
+{
+	inc = chunk_hash_inc(chunk_from_thing(this->type), inc);
+	if (this->type == ID_ANY)
+	{
+		return inc;
+	}
+	return chunk_hash_inc(this->encoded, inc);
+}
+
+METHOD(identification_t, hash_lowercase, u_int,
+	private_identification_t *this, u_int inc)
+{
+	inc = chunk_hash_inc(chunk_from_thing(this->type), inc);
+	return hash_lower(this->encoded, inc);
+}
+
+METHOD(identification_t, hash_dn, u_int,
+	private_identification_t *this, u_int inc)
+{
+	return chunk_hash_inc(chunk_from_thing(this->hash), inc);
+}
+
 METHOD(identification_t, matches_binary, id_match_t,
 	private_identification_t *this, identification_t *other)
 {
@@ -744,7 +967,9 @@ METHOD(identification_t, matches_dn, id_match_t,
 
 	if (this->type == other->get_type(other))
 	{
-		if (compare_dn(this->encoded, other->get_encoding(other), &wc))
+		if (other->equals == this->public.equals ?
+				compare_rdns(this, (private_identification_t*)other, &wc) :
+				compare_dn(this->encoded, other->get_encoding(other), &wc))
 		{
 			wc = min(wc, ID_MATCH_ONE_WILDCARD - ID_MATCH_MAX_WILDCARDS);
 			return ID_MATCH_PERFECT - wc;
@@ -827,13 +1052,18 @@ int identification_printf_hook(printf_hook_data_t *data,
 METHOD(identification_t, clone_, identification_t*,
 	private_identification_t *this)
 {
-	private_identification_t *clone = malloc_thing(private_identification_t);
+	private_identification_t *clone = slab_alloc(&id_slab);
 
 	memcpy(clone, this, sizeof(private_identification_t));
 	if (this->encoded.len)
 	{
 		clone->encoded = chunk_clone(this->encoded);
 	}
+	if (this->rdns)
+	{	/* RDNs are stored as offsets, a plain copy is fine */
+		clone->rdns = malloc(this->rdn_count * sizeof(rdn_t));
+		memcpy(clone->rdns, this->rdns, this->rdn_count * sizeof(rdn_t));
+	}
 	return &clone->public;
 }
 
@@ -841,7 +1071,8 @@ METHOD(identification_t, destroy, void,
 	private_identification_t *this)
 {
 	chunk_free(&this->encoded);
-	free(this);
+	free(this->rdns);
+	slab_free(&id_slab, this);
 }
 
 /**
@@ -851,7 +1082,7 @@ static private_identification_t *identification_create(id_type_t type)
 {
 	private_identification_t *this;
 
-	INIT(this,
+	SLAB_INIT(&id_slab, this,
 		.public = {
 			.get_encoding = _get_encoding,
 			.get_type = _get_type,
@@ -867,6 +1098,7 @@ static private_identification_t *identification_create(id_type_t type)
 		case ID_ANY:
 			this->public.matches = _matches_any;
 			this->public.equals = _equals_binary;
+			this->public.hash = _hash_binary;
 			this->public.contains_wildcards = return_true;
 			break;
 		case ID_FQDN:
@@ -874,16 +1106,19 @@ static private_identification_t *identification_create(id_type_t type)
 		case ID_USER_ID:
 			this->public.matches = _matches_string;
 			this->public.equals = _equals_strcasecmp;
+			this->public.hash = _hash_lowercase;
 			this->public.contains_wildcards = _contains_wildcards_memchr;
 			break;
 		case ID_DER_ASN1_DN:
 			this->public.equals = _equals_dn;
 			this->public.matches = _matches_dn;
+			this->public.hash = _hash_dn;
 			this->public.contains_wildcards = _contains_wildcards_dn;
 			break;
 		default:
 			this->public.equals = _equals_binary;
 			this->public.matches = _matches_binary;
+			this->public.hash = _hash_binary;
 			this->public.contains_wildcards = return_false;
 			break;
 	}
@@ -911,6 +1146,7 @@ identification_t *identification_create_from_string(char *string)
 		{
 			this = identification_create(ID_DER_ASN1_DN);
 			this->encoded = encoded;
+			parse_dn(this);
 		}
 		else
 		{
@@ -1047,6 +1283,10 @@ identification_t *identification_create_from_encoding(id_type_t type,
 	{
 		this->encoded = chunk_clone(encoded);
 	}
+	if (type == ID_DER_ASN1_DN)
+	{
+		parse_dn(this);
+	}
 	return &(this->public);
 }
 
@@ -226,6 +226,17 @@ struct identification_t {
 	 */
 	bool (*equals) (identification_t *this, identification_t *other);
 
+	/**
+	 * Hash this identity, consistent with equals().
+	 *
+	 * Identities considered equal produce the same hash value, which makes
+	 * it suitable as hashtable key.
+	 *
+	 * @param inc		optional value for incremental hashing
+	 * @return			hash value
+	 */
+	u_int (*hash) (identification_t *this, u_int inc);
+
 	/**
 	 * Check if an ID matches a wildcard ID.
 	 *
@@ -0,0 +1,594 @@
+/*
+ * Copyright (C) 2013 Hochschule fuer Technik Rapperswil
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.  See <http://www.fsf.org/copyleft/gpl.txt>.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+
+#include "slab.h"
+
+#include <utils/debug.h>
+#include <threading/mutex.h>
+#include <threading/thread_value.h>
+
+/**
+ * Number of objects a thread caches at most
+ */
+#define CACHE_SIZE 64
+
+/**
+ * Number of objects exchanged with the depot if a cache runs empty/full
+ */
+#define CACHE_BATCH (CACHE_SIZE / 2)
+
+/**
+ * Minimum size of a block objects get carved from, blocks are aligned to
+ * their size
+ */
+#define BLOCK_SIZE 16384
+
+/**
+ * Alignment of objects
+ */
+#define SLAB_ALIGN (2 * sizeof(void*))
+
+typedef struct cache_t cache_t;
+typedef struct block_t block_t;
+typedef struct free_t free_t;
+
+/**
+ * A freed object in the depot, links to the next one
+ */
+struct free_t {
+	free_t *next;
+};
+
+/**
+ * A block of memory objects get carved from, the header size is SLAB_ALIGN
+ */
+struct block_t {
+	/** depot the block belongs to, NULL if allocated without a depot */
+	slab_depot_t *depot;
+	/** next block of the same depot */
+	block_t *next;
+	/** objects */
+	char objs[];
+};
+
+/**
+ * Shared state of a slab
+ */
+struct slab_depot_t {
+
+	/** slab this depot belongs to */
+	slab_t *slab;
+
+	/** aligned object size */
+	size_t size;
+
+	/** size and alignment of blocks */
+	size_t block_size;
+
+	/** number of objects per block */
+	u_int per_block;
+
+	/** mutex protecting depot state */
+	mutex_t *mutex;
+
+	/** thread local cache_t */
+	thread_value_t *local;
+
+	/** freed objects not cached by any thread */
+	free_t *free;
+
+	/** allocated blocks */
+	block_t *blocks;
+
+	/** number of objects carved from blocks */
+	u_int total;
+
+	/** list of active thread caches */
+	cache_t *caches;
+
+	/** allocations done by threads that exited */
+	u_int64_t retired_allocs;
+
+	/** frees done by threads that exited, or directly in the depot */
+	u_int64_t retired_frees;
+
+	/** unregistered by slab_deinit() with objects in use */
+	bool orphaned;
+
+	/** next depot in registry */
+	slab_depot_t *next;
+};
+
+/**
+ * Per-thread object cache
+ */
+struct cache_t {
+
+	/** depot this cache belongs to */
+	slab_depot_t *depot;
+
+	/** previous and next cache in list of depot */
+	cache_t *prev, *next;
+
+	/** allocations done by this thread */
+	u_int64_t allocs;
+
+	/** frees done by this thread */
+	u_int64_t frees;
+
+	/** number of cached objects */
+	u_int count;
+
+	/** cached objects */
+	void *objs[CACHE_SIZE];
+};
+
+/**
+ * Lock for the registry of depots
+ */
+static mutex_t *registry_lock = NULL;
+
+/**
+ * Registered depots
+ */
+static slab_depot_t *registry = NULL;
+
+/**
+ * Get the rounded object size of a slab
+ */
+static inline size_t get_size(slab_t *slab)
+{
+	size_t size = max(slab->size, sizeof(free_t));
+
+	return (size + SLAB_ALIGN - 1) & ~(SLAB_ALIGN - 1);
+}
+
+/**
+ * Get the size and alignment of the blocks of a slab
+ */
+static size_t get_block_size(slab_t *slab)
+{
+	size_t size = BLOCK_SIZE;
+
+	while ((size - sizeof(block_t)) / get_size(slab) < CACHE_SIZE)
+	{
+		size <<= 1;
+	}
+	return size;
+}
+
+/**
+ * Get the block an object has been carved from
+ */
+static inline block_t *get_block(void *ptr, size_t block_size)
+{
+	return (block_t*)((uintptr_t)ptr & ~(block_size - 1));
+}
+
+/**
+ * Allocate a block of a depot, or one for a single object if depot is NULL
+ */
+static block_t *block_create(slab_t *slab, slab_depot_t *depot)
+{
+	block_t *block;
+	size_t size = sizeof(block_t) + get_size(slab);
+
+	if (depot)
+	{
+		size = depot->block_size;
+	}
+	if (posix_memalign((void**)&block, get_block_size(slab), size) != 0)
+	{
+		return NULL;
+	}
+	block->depot = depot;
+	block->next = NULL;
+	return block;
+}
+
+/**
+ * Move objects from the depot into a cache, carve a new block if necessary.
+ * Depot must be locked.
+ */
+static void refill(slab_depot_t *depot, cache_t *cache)
+{
+	block_t *block;
+	free_t *obj;
+	u_int i;
+
+	if (!depot->free)
+	{
+		block = block_create(depot->slab, depot);
+		block->next = depot->blocks;
+		depot->blocks = block;
+		for (i = 0; i < depot->per_block; i++)
+		{
+			obj = (free_t*)(block->objs + i * depot->size);
+			obj->next = depot->free;
+			depot->free = obj;
+		}
+		depot->total += depot->per_block;
+	}
+	while (depot->free && cache->count < CACHE_BATCH)
+	{
+		obj = depot->free;
+		depot->free = obj->next;
+		cache->objs[cache->count++] = obj;
+	}
+}
+
+/**
+ * Move objects from a cache back to the depot. Depot must be locked.
+ */
+static void flush(slab_depot_t *depot, cache_t *cache, u_int keep)
+{
+	free_t *obj;
+
+	while (cache->count > keep)
+	{
+		obj = cache->objs[--cache->count];
+		obj->next = depot->free;
+		depot->free = obj;
+	}
+}
+
+/**
+ * Check if an orphaned depot has no more objects in use. Depot must be locked.
+ */
+static inline bool orphan_unused(slab_depot_t *depot)
+{
+	return depot->orphaned && !depot->caches &&
+		   depot->retired_allocs == depot->retired_frees;
+}
+
+/**
+ * Release the memory of a depot without any objects in use
+ */
+static void depot_free(slab_depot_t *depot)
+{
+	block_t *block;
+
+	while (depot->blocks)
+	{
+		block = depot->blocks;
+		depot->blocks = block->next;
+		free(block);
+	}
+	depot->slab->depot = NULL;
+	depot->local->destroy(depot->local);
+	depot->mutex->destroy(depot->mutex);
+	free(depot);
+}
+
+/**
+ * Thread exit handler, returns cached objects to the depot
+ */
+static void cache_destroy(cache_t *cache)
+{
+	slab_depot_t *depot = cache->depot;
+	bool release;
+
+	depot->mutex->lock(depot->mutex);
+	flush(depot, cache, 0);
+	depot->retired_allocs += cache->allocs;
+	depot->retired_frees += cache->frees;
+	if (cache->prev)
+	{
+		cache->prev->next = cache->next;
+	}
+	else
+	{
+		depot->caches = cache->next;
+	}
+	if (cache->next)
+	{
+		cache->next->prev = cache->prev;
+	}
+	release = orphan_unused(depot);
+	depot->mutex->unlock(depot->mutex);
+	free(cache);
+	if (release)
+	{
+		depot_free(depot);
+	}
+}
+
+/**
+ * Get the cache of the calling thread, create one if requested
+ */
+static cache_t *get_cache(slab_depot_t *depot, bool create)
+{
+	cache_t *cache;
+
+	cache = depot->local->get(depot->local);
+	if (!cache && create)
+	{
+		INIT(cache,
+			.depot = depot,
+		);
+		depot->mutex->lock(depot->mutex);
+		cache->next = depot->caches;
+		if (cache->next)
+		{
+			cache->next->prev = cache;
+		}
+		depot->caches = cache;
+		depot->mutex->unlock(depot->mutex);
+		depot->local->set(depot->local, cache);
+	}
+	return cache;
+}
+
+/**
+ * Get the depot of a slab, create and register it on first use
+ */
+static slab_depot_t *get_depot(slab_t *slab)
+{
+	slab_depot_t *depot;
+
+	if (slab->depot && !slab->depot->orphaned)
+	{
+		return slab->depot;
+	}
+	if (!registry_lock)
+	{	/* not initialized, fall back to malloc() */
+		return NULL;
+	}
+	registry_lock->lock(registry_lock);
+	depot = slab->depot;
+	if (depot && depot->orphaned)
+	{	/* reinitialized, register the depot again */
+		depot->orphaned = FALSE;
+		depot->next = registry;
+		registry = depot;
+	}
+	else if (!depot)
+	{
+		INIT(depot,
+			.slab = slab,
+			.size = get_size(slab),
+			.mutex = mutex_create(MUTEX_TYPE_DEFAULT),
+			.local = thread_value_create((thread_cleanup_t)cache_destroy),
+			.next = registry,
+		);
+		depot->block_size = get_block_size(slab);
+		depot->per_block = (depot->block_size - sizeof(block_t)) / depot->size;
+		registry = depot;
+#ifdef HAVE_GCC_ATOMIC_OPERATIONS
+		__sync_synchronize();
+#endif
+		slab->depot = depot;
+	}
+	registry_lock->unlock(registry_lock);
+	return depot;
+}
+
+/**
+ * See header
+ */
+void *slab_alloc(slab_t *slab)
+{
+#ifdef LEAK_DETECTIVE
+	return malloc(slab->size);
+#else /* !LEAK_DETECTIVE */
+	slab_depot_t *depot;
+	cache_t *cache;
+
+	depot = get_depot(slab);
+	if (!depot)
+	{	/* slab_free() tells these apart from objects of a depot by the
+		 * block header */
+		ref_get(&slab->unmanaged);
+		return block_create(slab, NULL)->objs;
+	}
+	cache = get_cache(depot, TRUE);
+	if (!cache->count)
+	{
+		depot->mutex->lock(depot->mutex);
+		refill(depot, cache);
+		depot->mutex->unlock(depot->mutex);
+	}
+	cache->allocs++;
+	return cache->objs[--cache->count];
+#endif /* LEAK_DETECTIVE */
+}
+
+/**
+ * See header
+ */
+void slab_free(slab_t *slab, void *ptr)
+{
+#ifdef LEAK_DETECTIVE
+	free(ptr);
+#else /* !LEAK_DETECTIVE */
+	slab_depot_t *depot = slab->depot;
+	cache_t *cache;
+	free_t *obj;
+	bool release;
+
+	if (!ptr)
+	{
+		return;
+	}
+	if (!depot ||
+		(slab->unmanaged && !get_block(ptr, depot->block_size)->depot))
+	{	/* allocated while no depot was available */
+		ignore_result(ref_put(&slab->unmanaged));
+		free(get_block(ptr, get_block_size(slab)));
+		return;
+	}
+	/* do not create a cache here, we might get called from thread exit
+	 * handlers after the cache of this thread has been destroyed */
+	cache = get_cache(depot, FALSE);
+	if (!cache)
+	{
+		obj = ptr;
+		depot->mutex->lock(depot->mutex);
+		obj->next = depot->free;
+		depot->free = obj;
+		depot->retired_frees++;
+		release = orphan_unused(depot);
+		depot->mutex->unlock(depot->mutex);
+		if (release)
+		{	/* last object of a depot unregistered by slab_deinit() */
+			depot_free(depot);
+		}
+		return;
+	}
+	if (cache->count == CACHE_SIZE)
+	{
+		depot->mutex->lock(depot->mutex);
+		flush(depot, cache, CACHE_SIZE - CACHE_BATCH);
+		depot->mutex->unlock(depot->mutex);
+	}
+	cache->frees++;
+	cache->objs[cache->count++] = ptr;
+#endif /* LEAK_DETECTIVE */
+}
+
+/**
+ * See header
+ */
+void slab_get_stats(slab_t *slab, slab_stats_t *stats)
+{
+	slab_depot_t *depot = slab->depot;
+	u_int64_t frees;
+	cache_t *cache;
+
+	*stats = (slab_stats_t){};
+	if (!depot)
+	{
+		return;
+	}
+	depot->mutex->lock(depot->mutex);
+	stats->total = depot->total;
+	stats->allocs = depot->retired_allocs;
+	frees = depot->retired_frees;
+	for (cache = depot->caches; cache; cache = cache->next)
+	{
+		stats->allocs += cache->allocs;
+		frees += cache->frees;
+		stats->threads++;
+	}
+	depot->mutex->unlock(depot->mutex);
+	stats->in_use = stats->allocs - frees;
+}
+
+/**
+ * Enumerator over registered slabs
+ */
+typedef struct {
+	/** implements enumerator_t */
+	enumerator_t public;
+	/** next depot to enumerate */
+	slab_depot_t *next;
+} slab_enumerator_t;
+
+METHOD(enumerator_t, enumerate, bool,
+	slab_enumerator_t *this, slab_t **slab)
+{
+	if (this->next)
+	{
+		*slab = this->next->slab;
+		this->next = this->next->next;
+		return TRUE;
+	}
+	return FALSE;
+}
+
+METHOD(enumerator_t, enumerator_destroy, void,
+	slab_enumerator_t *this)
+{
+	registry_lock->unlock(registry_lock);
+	free(this);
+}
+
+/**
+ * See header
+ */
+enumerator_t *slab_create_enumerator()
+{
+	slab_enumerator_t *enumerator;
+
+	if (!registry_lock)
+	{
+		return enumerator_create_empty();
+	}
+	INIT(enumerator,
+		.public = {
+			.enumerate = (void*)_enumerate,
+			.destroy = _enumerator_destroy,
+		},
+	);
+	registry_lock->lock(registry_lock);
+	enumerator->next = registry;
+	return &enumerator->public;
+}
+
+/**
+ * Destroy a depot if it has no objects in use, orphan it otherwise
+ */
+static void depot_destroy(slab_depot_t *depot)
+{
+	slab_stats_t stats;
+	cache_t *cache;
+
+	/* return the cache of the calling thread to the depot */
+	cache = depot->local->get(depot->local);
+	if (cache)
+	{
+		depot->local->set(depot->local, NULL);
+		cache_destroy(cache);
+	}
+	slab_get_stats(depot->slab, &stats);
+	if (stats.in_use || stats.threads)
+	{	/* keep the depot for objects freed later, it gets released once the
+		 * last of them is returned */
+		DBG2(DBG_LIB, "%d objects of %s still in use, releasing slab later",
+			 stats.in_use, depot->slab->name);
+		depot->mutex->lock(depot->mutex);
+		depot->orphaned = TRUE;
+		depot->mutex->unlock(depot->mutex);
+		return;
+	}
+	depot_free(depot);
+}
+
+/**
+ * See header
+ */
+void slab_init()
+{
+	registry_lock = mutex_create(MUTEX_TYPE_DEFAULT);
+}
+
+/**
+ * See header
+ */
+void slab_deinit()
+{
+	slab_depot_t *depot;
+	mutex_t *lock = registry_lock;
+
+	lock->lock(lock);
+	registry_lock = NULL;
+	while (registry)
+	{
+		depot = registry;
+		registry = depot->next;
+		depot_destroy(depot);
+	}
+	lock->unlock(lock);
+	lock->destroy(lock);
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2013 Hochschule fuer Technik Rapperswil
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.  See <http://www.fsf.org/copyleft/gpl.txt>.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ */
+
+/**
+ * @defgroup slab slab
+ * @{ @ingroup utils
+ */
+
+#ifndef SLAB_H_
+#define SLAB_H_
+
+#include <utils/utils.h>
+#include <collections/enumerator.h>
+
+typedef struct slab_t slab_t;
+typedef struct slab_depot_t slab_depot_t;
+
+/**
+ * Thread caching allocator for fixed size objects.
+ *
+ * A slab is usually defined statically for a frequently allocated object
+ * type using SLAB_DEFINE(). Objects get carved from larger blocks, and freed
+ * objects are kept in a small per-thread cache to serve subsequent
+ * allocations without taking any lock. Only if a thread cache runs empty or
+ * full, objects are exchanged with a shared depot.
+ *
+ * Memory of a slab is never returned to the system while objects are in use,
+ * freed objects are reused for the same type only.
+ *
+ * If strongSwan is built with leak detective, all functions fall back to
+ * plain malloc()/free() to keep leak reports meaningful.
+ */
+struct slab_t {
+
+	/**
+	 * Name of the object type, used for statistics
+	 */
+	const char *name;
+
+	/**
+	 * Size of each object
+	 */
+	size_t size;
+
+	/**
+	 * Internal state, created on first use
+	 */
+	slab_depot_t *depot;
+
+	/**
+	 * Number of objects allocated while no depot was available
+	 */
+	refcount_t unmanaged;
+};
+
+/**
+ * Define a static slab for a type.
+ *
+ * @param var			variable name of the slab
+ * @param type			type of the objects allocated from the slab
+ */
+#define SLAB_DEFINE(var, type) \
+	static slab_t var = { .name = #type, .size = sizeof(type), }
+
+/**
+ * Allocate and initialize an object from a slab, similar to INIT().
+ *
+ * @param slab			slab to allocate from
+ * @param this			pointer to assign the object to
+ * @param ...			initializer for the object members
+ */
+#define SLAB_INIT(slab, this, ...) { (this) = slab_alloc(slab); \
+						   *(this) = (typeof(*(this))){ __VA_ARGS__ }; }
+
+/**
+ * Allocate an (uninitialized) object from a slab.
+ *
+ * @param slab			slab to allocate from
+ * @return				allocated object
+ */
+void *slab_alloc(slab_t *slab);
+
+/**
+ * Return an object to the slab it has been allocated from.
+ *
+ * @param slab			slab the object has been allocated from
+ * @param ptr			object to free, or NULL
+ */
+void slab_free(slab_t *slab, void *ptr);
+
+/**
+ * Statistics of a slab
+ */
+typedef struct {
+	/** number of objects currently in use */
+	int in_use;
+	/** number of objects carved from allocated blocks */
+	u_int total;
+	/** total number of allocations served */
+	u_int64_t allocs;
+	/** number of threads owning a cache */
+	u_int threads;
+} slab_stats_t;
+
+/**
+ * Get statistics of a slab.
+ *
+ * Counters of other threads are read without synchronization, the values
+ * are therefore a snapshot that is not necessarily consistent.
+ *
+ * @param slab			slab to get statistics for
+ * @param stats			receives statistics
+ */
+void slab_get_stats(slab_t *slab, slab_stats_t *stats);
+
+/**
+ * Create an enumerator over all slabs in use.
+ *
+ * @return				enumerator over slab_t*
+ */
+enumerator_t *slab_create_enumerator();
+
+/**
+ * Initialize the slab allocator, called by library_init().
+ */
+void slab_init();
+
+/**
+ * Deinitialize the slab allocator, called by library_deinit().
+ *
+ * Slabs having no objects in use get released, others once the last of
+ * their objects gets freed.
+ */
+void slab_deinit();
+
+#endif /** SLAB_H_ @}*/
@@ -30,7 +30,7 @@
 #include "collections/enumerator.h"
 #include "utils/debug.h"
 
-ENUM(status_names, SUCCESS, NEED_MORE,
+ENUM(status_names, SUCCESS, DEFERRED,
 	"SUCCESS",
 	"FAILED",
 	"OUT_OF_RES",
@@ -43,6 +43,7 @@ ENUM(status_names, SUCCESS, NEED_MORE,
 	"INVALID_STATE",
 	"DESTROY_ME",
 	"NEED_MORE",
+	"DEFERRED",
 );
 
 /**
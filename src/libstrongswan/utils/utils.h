@@ -307,6 +307,11 @@ enum status_t {
 	 * Another call to the method is required.
 	 */
 	NEED_MORE,
+
+	/**
+	 * Operation continues asynchronously, the method gets called again.
+	 */
+	DEFERRED,
 };
 
 /**
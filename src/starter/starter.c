@@ -828,6 +828,9 @@ int main (int argc, char **argv)
 		 */
 		if (starter_charon_pid())
 		{
+			/* send all sections over a single stroke connection */
+			starter_stroke_batch_begin();
+
 			for (ca = cfg->ca_first; ca; ca = ca->next)
 			{
 				if (ca->state == STATE_TO_ADD)
@@ -853,6 +856,15 @@ int main (int argc, char **argv)
 					{
 						starter_stroke_add_conn(cfg, conn);
 					}
+				}
+			}
+
+			/* route/initiate after all conns got added, so charon adds them
+			 * at once and not one by one before each route/initiate */
+			for (conn = cfg->conn_first; conn; conn = conn->next)
+			{
+				if (conn->state == STATE_TO_ADD)
+				{
 					conn->state = STATE_ADDED;
 
 					if (conn->startup == STARTUP_START)
@@ -871,6 +883,8 @@ int main (int argc, char **argv)
 					}
 				}
 			}
+
+			starter_stroke_batch_end();
 		}
 
 		/*
@@ -54,20 +54,20 @@ static char* push_string(stroke_msg_t *msg, char *string)
 	}
 }
 
-static int send_stroke_msg (stroke_msg_t *msg)
+/**
+ * Socket of an open batch session, -1 if none
+ */
+static int batch_sock = -1;
+
+static int connect_stroke(void)
 {
 	struct sockaddr_un ctl_addr;
-	int byte_count;
-	char buffer[64];
+	int sock;
 
 	ctl_addr.sun_family = AF_UNIX;
 	strcpy(ctl_addr.sun_path, CHARON_CTL_FILE);
 
-	/* starter is not called from commandline, and therefore absolutely silent */
-	msg->output_verbosity = -1;
-
-	int sock = socket(AF_UNIX, SOCK_STREAM, 0);
-
+	sock = socket(AF_UNIX, SOCK_STREAM, 0);
 	if (sock < 0)
 	{
 		DBG1(DBG_APP, "socket() failed: %s", strerror(errno));
@@ -79,25 +79,98 @@ static int send_stroke_msg (stroke_msg_t *msg)
 		close(sock);
 		return -1;
 	}
+	return sock;
+}
+
+/**
+ * Log output received from charon, if block is FALSE only what is available
+ */
+static void read_output(int sock, bool block)
+{
+	int byte_count;
+	char buffer[64];
+
+	while ((byte_count = recv(sock, buffer, sizeof(buffer)-1,
+							  block ? 0 : MSG_DONTWAIT)) > 0)
+	{
+		buffer[byte_count] = '\0';
+		DBG1(DBG_APP, "%s", buffer);
+	}
+	if (byte_count < 0 && (block || (errno != EAGAIN && errno != EWOULDBLOCK)))
+	{
+		DBG1(DBG_APP, "read() failed: %s", strerror(errno));
+	}
+}
+
+static int send_stroke_msg (stroke_msg_t *msg)
+{
+	int sock;
+
+	/* starter is not called from commandline, and therefore absolutely silent */
+	msg->output_verbosity = -1;
+
+	sock = batch_sock;
+	if (sock < 0)
+	{
+		sock = connect_stroke();
+		if (sock < 0)
+		{
+			return -1;
+		}
+	}
+	else
+	{	/* drain pending output so charon never blocks writing it */
+		read_output(sock, FALSE);
+	}
 
 	/* send message */
 	if (write(sock, msg, msg->length) != msg->length)
 	{
 		DBG1(DBG_APP, "write(charon_ctl) failed: %s", strerror(errno));
+		if (sock == batch_sock)
+		{
+			batch_sock = -1;
+		}
 		close(sock);
 		return -1;
 	}
-	while ((byte_count = read(sock, buffer, sizeof(buffer)-1)) > 0)
+	if (sock != batch_sock)
 	{
-		buffer[byte_count] = '\0';
-		DBG1(DBG_APP, "%s", buffer);
+		read_output(sock, TRUE);
+		close(sock);
+	}
+	return 0;
+}
+
+int starter_stroke_batch_begin(void)
+{
+	stroke_msg_t msg;
+
+	if (batch_sock >= 0)
+	{
+		return 0;
 	}
-	if (byte_count < 0)
+	batch_sock = connect_stroke();
+	if (batch_sock < 0)
 	{
-		DBG1(DBG_APP, "read() failed: %s", strerror(errno));
+		return -1;
 	}
+	msg.type = STR_BATCH;
+	msg.length = offsetof(stroke_msg_t, buffer);
+	return send_stroke_msg(&msg);
+}
 
-	close(sock);
+int starter_stroke_batch_end(void)
+{
+	if (batch_sock < 0)
+	{
+		return -1;
+	}
+	/* charon processes the batch until we close our end */
+	shutdown(batch_sock, SHUT_WR);
+	read_output(batch_sock, TRUE);
+	close(batch_sock);
+	batch_sock = -1;
 	return 0;
 }
 
@@ -26,5 +26,7 @@ int starter_stroke_initiate_conn(starter_conn_t *conn);
 int starter_stroke_add_ca(starter_ca_t *ca);
 int starter_stroke_del_ca(starter_ca_t *ca);
 int starter_stroke_configure(starter_config_t *cfg);
+int starter_stroke_batch_begin(void);
+int starter_stroke_batch_end(void);
 
 #endif /* _STARTER_STROKE_H_ */
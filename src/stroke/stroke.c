@@ -234,9 +234,36 @@ static int unroute_connection(char *name)
 	return send_stroke_msg(&msg);
 }
 
-static int show_status(stroke_keyword_t kw, char *connection)
+static int show_status(stroke_keyword_t kw, int argc, char *argv[])
 {
 	stroke_msg_t msg;
+	char *connection = NULL, *id = NULL, *address = NULL;
+	u_int32_t offset = 0, limit = 0;
+	int i;
+
+	for (i = 0; i < argc; i++)
+	{
+		if (i + 1 < argc && streq(argv[i], "--id"))
+		{
+			id = argv[++i];
+		}
+		else if (i + 1 < argc && streq(argv[i], "--address"))
+		{
+			address = argv[++i];
+		}
+		else if (i + 1 < argc && streq(argv[i], "--offset"))
+		{
+			offset = strtoul(argv[++i], NULL, 10);
+		}
+		else if (i + 1 < argc && streq(argv[i], "--limit"))
+		{
+			limit = strtoul(argv[++i], NULL, 10);
+		}
+		else if (!connection)
+		{
+			connection = argv[i];
+		}
+	}
 
 	switch (kw)
 	{
@@ -252,6 +279,19 @@ static int show_status(stroke_keyword_t kw, char *connection)
 	}
 	msg.length = offsetof(stroke_msg_t, buffer);
 	msg.status.name = push_string(&msg, connection);
+	msg.status.id = push_string(&msg, id);
+	msg.status.address = push_string(&msg, address);
+	msg.status.offset = offset;
+	msg.status.limit = limit;
+	return send_stroke_msg(&msg);
+}
+
+static int show_status_summary()
+{
+	stroke_msg_t msg;
+
+	msg.type = STR_STATUS_SUMMARY;
+	msg.length = offsetof(stroke_msg_t, buffer);
 	return send_stroke_msg(&msg);
 }
 
@@ -424,11 +464,18 @@ static void exit_usage(char *error)
 	printf("    where: TYPE is any|dmn|mgr|ike|chd|job|cfg|knl|net|asn|enc|tnc|imc|imv|pts|tls|esp|lib\n");
 	printf("           LEVEL is -1|0|1|2|3|4\n");
 	printf("  Show connection status:\n");
-	printf("    stroke status\n");
+	printf("    stroke status [NAME] [--id ID] [--address ADDR]\n");
+	printf("           [--offset N] [--limit N]\n");
+	printf("    where: NAME is a connection name to show\n");
+	printf("           ID is a remote identity to match, may contain wildcards\n");
+	printf("           ADDR is a remote IP address to match\n");
+	printf("           N skips or limits the number of listed IKE_SAs\n");
 	printf("  Show extended status information:\n");
-	printf("    stroke statusall\n");
+	printf("    stroke statusall [NAME] [OPTIONS as for status]\n");
 	printf("  Show extended status information without blocking:\n");
-	printf("    stroke statusallnb\n");
+	printf("    stroke statusallnb [NAME] [OPTIONS as for status]\n");
+	printf("  Show a summary of SA counters only:\n");
+	printf("    stroke statussummary\n");
 	printf("  Show list of authority and attribute certificates:\n");
 	printf("    stroke listcacerts|listocspcerts|listaacerts|listacerts\n");
 	printf("  Show list of end entity certificates, ca info records  and crls:\n");
@@ -555,7 +602,10 @@ int main(int argc, char *argv[])
 		case STROKE_STATUS:
 		case STROKE_STATUSALL:
 		case STROKE_STATUSALL_NOBLK:
-			res = show_status(token->kw, argc > 2 ? argv[2] : NULL);
+			res = show_status(token->kw, argc - 2, &argv[2]);
+			break;
+		case STROKE_STATUS_SUMMARY:
+			res = show_status_summary();
 			break;
 		case STROKE_LIST_PUBKEYS:
 		case STROKE_LIST_CERTS:
@@ -30,6 +30,7 @@ typedef enum {
 	STROKE_STATUS,
 	STROKE_STATUSALL,
 	STROKE_STATUSALL_NOBLK,
+	STROKE_STATUS_SUMMARY,
 	STROKE_LIST_PUBKEYS,
 	STROKE_LIST_CERTS,
 	STROKE_LIST_CACERTS,
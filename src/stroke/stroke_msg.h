@@ -226,6 +226,10 @@ struct stroke_msg_t {
 		STR_USER_CREDS,
 		/* print/reset counters */
 		STR_COUNTERS,
+		/* show a counters-only status summary */
+		STR_STATUS_SUMMARY,
+		/* process all stroke messages following on this connection */
+		STR_BATCH,
 		/* more to come */
 	} type;
 
@@ -236,7 +240,21 @@ struct stroke_msg_t {
 		/* data for STR_INITIATE, STR_ROUTE, STR_UP, STR_DOWN, ... */
 		struct {
 			char *name;
-		} initiate, route, unroute, terminate, rekey, status, del_conn, del_ca;
+		} initiate, route, unroute, terminate, rekey, del_conn, del_ca;
+
+		/* data for STR_STATUS, STR_STATUS_ALL, STR_STATUS_ALL_NOBLK */
+		struct {
+			/* connection name filter, or NULL */
+			char *name;
+			/* remote identity filter (may contain wildcards), or NULL */
+			char *id;
+			/* remote address filter, or NULL */
+			char *address;
+			/* number of matching IKE_SAs to skip */
+			u_int32_t offset;
+			/* maximum number of IKE_SAs to show, 0 for unlimited */
+			u_int32_t limit;
+		} status;
 
 		/* data for STR_TERMINATE_SRCIP */
 		struct {